@@ -221,6 +221,11 @@ class MockWriteStream : public WriteStream {
     sent_mutations_.push(mutations);
   }
 
+  /** Spec tests acknowledge and fail writes one batch at a time. */
+  bool CanCoalesceBatches() const override {
+    return false;
+  }
+
   /** Injects a write ack as though it had come from the backend in response to a write. */
   void AckWrite(const SnapshotVersion& commitVersion, std::vector<MutationResult> results) {
     callback_->OnWriteStreamMutationResult(commitVersion, std::move(results));
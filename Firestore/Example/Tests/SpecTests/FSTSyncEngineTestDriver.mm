@@ -508,8 +508,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)loadBundleWithReader:(std::shared_ptr<BundleReader>)reader
                         task:(std::shared_ptr<LoadBundleTask>)task {
-  _workerQueue->EnqueueBlocking(
-      [=] { _syncEngine->LoadBundle(std::move(reader), std::move(task)); });
+  _workerQueue->EnqueueBlocking([=] {
+    auto loader = _syncEngine->LoadBundle(reader, task);
+    while (loader && _syncEngine->ContinueLoadBundle(*loader, *reader, *task)) {
+    }
+  });
 }
 
 - (void)writeUserMutation:(Mutation)mutation {
@@ -339,6 +339,16 @@ std::shared_ptr<LoadBundleTask> Firestore::LoadBundle(
   return task;
 }
 
+std::shared_ptr<LoadBundleTask> Firestore::LoadBundle(
+    const util::Path& bundle_path) {
+  EnsureClientConfigured();
+
+  auto task = std::make_shared<LoadBundleTask>(user_executor_);
+  client_->LoadBundle(bundle_path, task);
+
+  return task;
+}
+
 void Firestore::GetNamedQuery(const std::string& name,
                               api::QueryCallback callback) {
   EnsureClientConfigured();
@@ -28,6 +28,7 @@
 #include "Firestore/core/src/credentials/credentials_fwd.h"
 #include "Firestore/core/src/model/database_id.h"
 #include "Firestore/core/src/util/byte_stream.h"
+#include "Firestore/core/src/util/path.h"
 #include "Firestore/core/src/util/status_fwd.h"
 
 namespace firebase {
@@ -117,6 +118,8 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
 
   std::shared_ptr<api::LoadBundleTask> LoadBundle(
       std::unique_ptr<util::ByteStream> bundle_data);
+  std::shared_ptr<api::LoadBundleTask> LoadBundle(
+      const util::Path& bundle_path);
   void GetNamedQuery(const std::string& name, api::QueryCallback callback);
 
   /**
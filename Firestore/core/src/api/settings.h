@@ -46,6 +46,7 @@ class Settings {
   static constexpr int64_t DefaultCacheSizeBytes = 100 * 1024 * 1024;
   static constexpr int64_t MinimumCacheSizeBytes = 1 * 1024 * 1024;
   static constexpr int64_t CacheSizeUnlimited = -1;
+  static constexpr bool DefaultLimboLookupsEnabled = false;
 
   Settings() = default;
   Settings(const Settings& other);
@@ -68,6 +69,17 @@ class Settings {
     return ssl_enabled_;
   }
 
+  /**
+   * Whether documents in limbo are looked up in batches through
+   * `BatchGetDocuments` rather than listened to one target at a time.
+   */
+  void set_limbo_lookups_enabled(bool value) {
+    limbo_lookups_enabled_ = value;
+  }
+  bool limbo_lookups_enabled() const {
+    return limbo_lookups_enabled_;
+  }
+
   void set_persistence_enabled(bool value);
   bool persistence_enabled() const;
 
@@ -91,6 +103,7 @@ class Settings {
   bool persistence_enabled_ = DefaultPersistenceEnabled;
   int64_t cache_size_bytes_ = DefaultCacheSizeBytes;
   std::unique_ptr<LocalCacheSettings> cache_settings_ = nullptr;
+  bool limbo_lookups_enabled_ = DefaultLimboLookupsEnabled;
 };
 
 class LocalCacheSettings {
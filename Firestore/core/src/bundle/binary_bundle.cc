@@ -0,0 +1,130 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/bundle/binary_bundle.h"
+
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/src/util/string_format.h"
+#include "absl/strings/match.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+const absl::string_view kBinaryBundleMagic = "FSTB";
+
+namespace {
+
+const size_t kHeaderSize = 16;
+const size_t kTableEntrySize = 16;
+
+// Integers are read and written a byte at a time so that the layout does not
+// depend on the endianness or alignment requirements of the platform.
+
+uint64_t ReadLittleEndian(absl::string_view data, size_t offset, size_t size) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < size; ++i) {
+    result |= static_cast<uint64_t>(static_cast<uint8_t>(data[offset + i]))
+              << (8 * i);
+  }
+  return result;
+}
+
+void WriteLittleEndian(std::string& out, uint64_t value, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+Status Corrupt(const std::string& message) {
+  return Status(Error::kErrorDataLoss,
+                StringFormat("Invalid binary bundle: %s", message));
+}
+
+}  // namespace
+
+bool IsBinaryBundle(absl::string_view data) {
+  return absl::StartsWith(data, kBinaryBundleMagic);
+}
+
+StatusOr<std::vector<absl::string_view>> ParseBinaryBundle(
+    absl::string_view data) {
+  if (data.size() < kHeaderSize || !IsBinaryBundle(data)) {
+    return Corrupt("missing header");
+  }
+
+  uint64_t version = ReadLittleEndian(data, 4, 4);
+  if (version != kBinaryBundleVersion) {
+    return Corrupt(StringFormat("unsupported version %s", version));
+  }
+
+  uint64_t count = ReadLittleEndian(data, 8, 4);
+  if (count == 0) {
+    return Corrupt("missing metadata");
+  }
+  // Checked by division so that a corrupt count cannot overflow.
+  if (count > (data.size() - kHeaderSize) / kTableEntrySize) {
+    return Corrupt(StringFormat("offset table for %s elements is truncated",
+                                count));
+  }
+
+  std::vector<absl::string_view> elements;
+  elements.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    size_t entry = kHeaderSize + i * kTableEntrySize;
+    uint64_t offset = ReadLittleEndian(data, entry, 8);
+    uint64_t size = ReadLittleEndian(data, entry + 8, 8);
+    if (offset > data.size() || size > data.size() - offset) {
+      return Corrupt(StringFormat("element %s is out of bounds", i));
+    }
+    elements.push_back(data.substr(offset, size));
+  }
+  return elements;
+}
+
+std::string WriteBinaryBundle(const std::vector<std::string>& elements) {
+  size_t offset = kHeaderSize + elements.size() * kTableEntrySize;
+  size_t total_size = offset;
+  for (const std::string& element : elements) {
+    total_size += element.size();
+  }
+
+  std::string result;
+  result.reserve(total_size);
+  result.append(kBinaryBundleMagic.data(), kBinaryBundleMagic.size());
+  WriteLittleEndian(result, kBinaryBundleVersion, 4);
+  WriteLittleEndian(result, elements.size(), 4);
+  WriteLittleEndian(result, 0, 4);
+
+  for (const std::string& element : elements) {
+    WriteLittleEndian(result, offset, 8);
+    WriteLittleEndian(result, element.size(), 8);
+    offset += element.size();
+  }
+  for (const std::string& element : elements) {
+    result.append(element);
+  }
+  return result;
+}
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
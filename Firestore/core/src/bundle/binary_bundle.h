@@ -0,0 +1,73 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_H_
+#define FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/util/status_fwd.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+/**
+ * The layout of binary bundles, a compact alternative to the length-prefixed
+ * JSON bundle format that can be read without copying or parsing JSON.
+ *
+ * A binary bundle consists of:
+ *
+ *   - a 16-byte header: the magic bytes "FSTB", the format version and the
+ *     number of elements, both as little-endian `uint32_t`s, and four reserved
+ *     bytes;
+ *   - an offset table with a 16-byte entry per element: the offset of the
+ *     element from the start of the bundle and its size, both as little-endian
+ *     `uint64_t`s;
+ *   - the elements, each a serialized `firestore_BundleElement` proto.
+ *
+ * The first element is always the bundle metadata.
+ *
+ * Because every element is located through the offset table, elements can be
+ * decoded in any order, and in parallel, straight out of a memory-mapped file.
+ */
+extern const absl::string_view kBinaryBundleMagic;
+
+/** The version of the binary bundle format written by this SDK. */
+constexpr uint32_t kBinaryBundleVersion = 1;
+
+/** Returns whether `data` starts with the binary bundle magic bytes. */
+bool IsBinaryBundle(absl::string_view data);
+
+/**
+ * Validates the header and offset table of the binary bundle in `data`, and
+ * returns the serialized elements in bundle order. The returned views point
+ * into `data`.
+ */
+util::StatusOr<std::vector<absl::string_view>> ParseBinaryBundle(
+    absl::string_view data);
+
+/** Lays out the given serialized elements as a binary bundle. */
+std::string WriteBinaryBundle(const std::vector<std::string>& elements);
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_H_
@@ -44,6 +44,17 @@ class BundleCallback {
       const model::MutableDocumentMap& documents,
       const std::string& bundle_id) = 0;
 
+  /**
+   * Applies one chunk of the documents from a bundle that is loaded in
+   * several chunks. Behaves like `ApplyBundledDocuments`, except that the
+   * documents of the previous chunks of the bundle are kept, unless this is
+   * its `first_chunk`.
+   */
+  virtual model::DocumentMap ApplyBundledDocumentsChunk(
+      const model::MutableDocumentMap& documents,
+      const std::string& bundle_id,
+      bool first_chunk) = 0;
+
   /** Saves the given NamedQuery to local persistence. */
   virtual void SaveNamedQuery(const NamedQuery& query,
                               const model::DocumentKeySet& keys) = 0;
@@ -18,6 +18,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <utility>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/api/load_bundle_task.h"
@@ -35,7 +36,7 @@ namespace bundle {
 using firestore::Error;
 using firestore::api::LoadBundleTaskProgress;
 using firestore::api::LoadBundleTaskState;
-using model::DocumentKeySet;
+using model::DocumentKey;
 using model::DocumentMap;
 using model::MutableDocument;
 using util::Status;
@@ -55,13 +56,16 @@ Status BundleLoader::AddElementInternal(const BundleElement& element) {
       const auto& document_metadata =
           static_cast<const BundledDocumentMetadata&>(element);
       current_document_ = document_metadata.key();
-      documents_metadata_.emplace(document_metadata.key(), document_metadata);
+      for (const auto& query : document_metadata.queries()) {
+        auto inserted =
+            query_documents_[query].insert(document_metadata.key());
+        query_documents_[query] = std::move(inserted);
+      }
 
       if (!document_metadata.exists()) {
-        documents_ = documents_.insert(
-            document_metadata.key(),
-            MutableDocument::NoDocument(document_metadata.key(),
-                                        document_metadata.read_time()));
+        AddDocument(document_metadata.key(),
+                    MutableDocument::NoDocument(document_metadata.key(),
+                                                document_metadata.read_time()));
         current_document_ = absl::nullopt;
       }
       break;
@@ -76,7 +80,7 @@ Status BundleLoader::AddElementInternal(const BundleElement& element) {
             "The document being added does not match the stored metadata.")};
       }
 
-      documents_ = documents_.insert(document.key(), document.document());
+      AddDocument(document.key(), document.document());
       current_document_ = absl::nullopt;
       break;
     }
@@ -90,12 +94,23 @@ Status BundleLoader::AddElementInternal(const BundleElement& element) {
   return Status::OK();
 }
 
+void BundleLoader::AddDocument(const DocumentKey& key,
+                               MutableDocument document) {
+  size_t before_count = documents_.size();
+  documents_ = documents_.insert(key, std::move(document));
+  if (documents_.size() != before_count) {
+    ++documents_loaded_;
+  }
+}
+
 StatusOr<absl::optional<LoadBundleTaskProgress>> BundleLoader::AddElement(
     std::unique_ptr<BundleElement> element_ptr, uint64_t byte_size) {
   HARD_ASSERT(element_ptr->element_type() != BundleElement::Type::Metadata,
               "Unexpected bundle metadata element.");
+  HARD_ASSERT(!chunk_ready(),
+              "The buffered chunk must be applied before adding elements.");
 
-  auto before_count = documents_.size();
+  auto before_count = documents_loaded_;
 
   auto result = AddElementInternal(*element_ptr);
   if (!result.ok()) {
@@ -104,15 +119,28 @@ StatusOr<absl::optional<LoadBundleTaskProgress>> BundleLoader::AddElement(
 
   bytes_loaded_ += byte_size;
 
-  // Document has only been partially loaded, no progress to report.
-  if (before_count == documents_.size()) {
+  // Document has only been partially loaded, no progress to report. Streaming
+  // loaders only report progress once a chunk has been applied.
+  if (before_count == documents_loaded_ || chunk_size_ > 0) {
     return {absl::nullopt};
   }
 
-  LoadBundleTaskProgress progress{
-      documents_.size(), metadata_.total_documents(), bytes_loaded_,
-      metadata_.total_bytes(), LoadBundleTaskState::kInProgress};
-  return {absl::make_optional(std::move(progress))};
+  return {absl::make_optional(progress())};
+}
+
+LoadBundleTaskProgress BundleLoader::progress() const {
+  return {documents_loaded_, metadata_.total_documents(), bytes_loaded_,
+          metadata_.total_bytes(), LoadBundleTaskState::kInProgress};
+}
+
+DocumentMap BundleLoader::ApplyChunk() {
+  HARD_ASSERT(chunk_size_ > 0, "Only streaming loaders apply chunks");
+
+  auto changes = callback_->ApplyBundledDocumentsChunk(
+      documents_, metadata_.bundle_id(), /*first_chunk=*/!applied_chunk_);
+  applied_chunk_ = true;
+  documents_ = model::MutableDocumentMap{};
+  return changes;
 }
 
 StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
@@ -122,17 +150,19 @@ StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
                "Bundled documents end with a document metadata "
                "element instead of a document."));
   }
-  if (metadata_.total_documents() != documents_.size()) {
+  if (metadata_.total_documents() != documents_loaded_) {
     return StatusOr<DocumentMap>(
         Status(Error::kErrorInvalidArgument,
                "Loaded documents count is not the same as in metadata."));
   }
 
   auto changes =
-      callback_->ApplyBundledDocuments(documents_, metadata_.bundle_id());
-  auto query_document_map = GetQueryDocumentMapping();
+      chunk_size_ > 0
+          ? ApplyChunk()
+          : callback_->ApplyBundledDocuments(documents_, metadata_.bundle_id());
   for (const auto& named_query : queries_) {
-    const auto& matching_keys = query_document_map[named_query.query_name()];
+    // Queries without matching documents still get saved, with no keys.
+    const auto& matching_keys = query_documents_[named_query.query_name()];
     callback_->SaveNamedQuery(named_query, matching_keys);
   }
 
@@ -141,24 +171,6 @@ StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
   return changes;
 }
 
-std::unordered_map<std::string, DocumentKeySet>
-BundleLoader::GetQueryDocumentMapping() {
-  std::unordered_map<std::string, DocumentKeySet> result;
-  for (const auto& named_query : queries_) {
-    result.emplace(named_query.query_name(), DocumentKeySet{});
-  }
-
-  for (const auto& doc_metadata : documents_metadata_) {
-    const auto& metadata = doc_metadata.second;
-    for (const auto& query : doc_metadata.second.queries()) {
-      auto inserted = result[query].insert(metadata.key());
-      result[query] = std::move(inserted);
-    }
-  }
-
-  return result;
-}
-
 }  // namespace bundle
 }  // namespace firestore
 }  // namespace firebase
@@ -29,7 +29,10 @@
 #include "Firestore/core/src/bundle/bundled_document_metadata.h"
 #include "Firestore/core/src/immutable/sorted_map.h"
 #include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "absl/types/optional.h"
 
@@ -50,6 +53,12 @@ inline api::LoadBundleTaskProgress InitialProgress(
           api::LoadBundleTaskState::kInProgress};
 }
 
+/**
+ * The number of documents a streaming `BundleLoader` commits to local store at
+ * a time. Bundles with no more documents than this are loaded in one go.
+ */
+constexpr size_t kBundleChunkSize = 1000;
+
 class BundleLoader {
  public:
   using AddElementResult =
@@ -59,45 +68,100 @@ class BundleLoader {
       : callback_(callback), metadata_(std::move(metadata)) {
   }
 
+  /**
+   * Creates a streaming loader, which only holds up to `chunk_size` documents
+   * in memory. Once `chunk_ready()` returns true, the caller must commit the
+   * buffered documents with `ApplyChunk()` before adding more elements.
+   *
+   * Unlike a regular loader, a streaming loader commits documents before the
+   * whole bundle has been verified, so a bundle that turns out to be invalid
+   * can leave some of its documents in the cache. Its metadata is only saved
+   * once all documents have been applied, so loading it again redoes the work.
+   */
+  BundleLoader(BundleCallback* callback,
+               BundleMetadata metadata,
+               size_t chunk_size)
+      : callback_(callback),
+        metadata_(std::move(metadata)),
+        chunk_size_(chunk_size) {
+    HARD_ASSERT(chunk_size_ > 0, "Chunk size must be positive");
+  }
+
   /**
    * Adds an element from the bundle to the loader.
    *
    * @return a new progress if adding the element leads to a new progress,
-   * otherwise returns `nullopt`. If an error occurred, returns a not `ok()`
-   * status.
+   * otherwise returns `nullopt`. Streaming loaders report progress per chunk
+   * through `progress()` instead, and always return `nullopt`. If an error
+   * occurred, returns a not `ok()` status.
    */
   AddElementResult AddElement(std::unique_ptr<BundleElement> element,
                               uint64_t byte_size);
 
+  /**
+   * Returns whether a streaming loader has buffered a full chunk of documents,
+   * which must be applied before adding more elements.
+   */
+  bool chunk_ready() const {
+    return chunk_size_ > 0 && documents_.size() >= chunk_size_;
+  }
+
+  /**
+   * Applies the buffered documents of a streaming loader to local store and
+   * releases them. Returns the document view changes.
+   */
+  model::DocumentMap ApplyChunk();
+
   /**
    * Applies the loaded documents and queries to local store. Returns the
    * document view changes. If an error occurred, returns a not `ok()` status.
+   *
+   * For a streaming loader, this applies the remaining buffered documents,
+   * and the returned changes only cover those.
    */
   util::StatusOr<model::DocumentMap> ApplyChanges();
 
- private:
-  /**
-   * @return A map whose keys are the query names in the loading bundle, and
-   * values are matching document keys.
-   */
-  std::unordered_map<std::string, model::DocumentKeySet>
-  GetQueryDocumentMapping();
+  /** Returns the progress made so far, in the `kInProgress` state. */
+  api::LoadBundleTaskProgress progress() const;
+
+  const BundleMetadata& metadata() const {
+    return metadata_;
+  }
+
+  /** The number of bytes of the bundle added to the loader so far. */
+  uint64_t bytes_loaded() const {
+    return bytes_loaded_;
+  }
 
+ private:
   /**
    * Adds the given BundleElement to the internal containers, depending on the
    * element type.
    */
   util::Status AddElementInternal(const BundleElement& element);
 
+  /** Adds a loaded document to the buffered documents. */
+  void AddDocument(const model::DocumentKey& key,
+                   model::MutableDocument document);
+
   BundleCallback* callback_ = nullptr;
   BundleMetadata metadata_;
   std::vector<NamedQuery> queries_;
-  std::unordered_map<model::DocumentKey,
-                     BundledDocumentMetadata,
-                     model::DocumentKeyHash>
-      documents_metadata_;
+
+  /**
+   * The keys of the loaded documents that match each named query, keyed by
+   * query name.
+   */
+  std::unordered_map<std::string, model::DocumentKeySet> query_documents_;
+
+  /** The loaded documents that have not been applied yet. */
   model::MutableDocumentMap documents_;
 
+  /** The maximum number of documents to buffer, or 0 to buffer all. */
+  size_t chunk_size_ = 0;
+  bool applied_chunk_ = false;
+
+  uint32_t documents_loaded_ = 0;
   uint64_t bytes_loaded_ = 0;
   absl::optional<model::DocumentKey> current_document_;
 };
@@ -17,7 +17,12 @@
 #include "Firestore/core/src/bundle/bundle_reader.h"
 
 #include <algorithm>
+#include <vector>
 
+#include "Firestore/core/src/bundle/binary_bundle.h"
+#include "Firestore/core/src/nanopb/reader.h"
+#include "Firestore/core/src/util/background_queue.h"
+#include "Firestore/core/src/util/statusor.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/string_view.h"
@@ -27,16 +32,56 @@ namespace firestore {
 namespace bundle {
 
 using nlohmann::json;
+using util::BackgroundQueue;
 using util::ByteStream;
+using util::JsonReader;
+using util::MappedFile;
+using util::Status;
+using util::StatusOr;
 using util::StreamReadResult;
 
 namespace {
 
+// The maximum number of elements `ReadAhead` reads at a time. Bounds the
+// memory held by elements that have been decoded but not consumed yet.
+const size_t kReadAheadElements = 64;
+
+// The number of elements decoded by each task on the worker pool.
+const size_t kDecodeChunkSize = 8;
+
+// The largest read `ReadJsonToBuffer` issues to the underlying stream.
+const size_t kMaxReadSize = 1024 * 1024;
+
 json Parse(absl::string_view s) {
   return json::parse(s.begin(), s.end(), /*callback=*/nullptr,
                      /*allow_exceptions=*/false);
 }
 
+/**
+ * Calls `decode` with every index in [0, count), in chunks of
+ * `kDecodeChunkSize` spread over the shared worker pool.
+ */
+template <typename F>
+void DecodeInParallel(size_t count, const F& decode) {
+  auto decode_chunk = [&decode](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      decode(i);
+    }
+  };
+
+  if (count <= kDecodeChunkSize) {
+    decode_chunk(0, count);
+    return;
+  }
+
+  BackgroundQueue tasks;
+  for (size_t begin = 0; begin < count; begin += kDecodeChunkSize) {
+    size_t end = std::min(begin + kDecodeChunkSize, count);
+    tasks.Execute([&decode_chunk, begin, end] { decode_chunk(begin, end); });
+  }
+  tasks.AwaitAll();
+}
+
 }  // namespace
 
 BundleReader::BundleReader(BundleSerializer serializer,
@@ -44,12 +89,25 @@ BundleReader::BundleReader(BundleSerializer serializer,
     : serializer_(std::move(serializer)), input_(std::move(input)) {
 }
 
+BundleReader::BundleReader(BundleSerializer serializer,
+                           std::unique_ptr<MappedFile> file)
+    : serializer_(std::move(serializer)), mapped_file_(std::move(file)) {
+  StatusOr<std::vector<absl::string_view>> elements =
+      ParseBinaryBundle(mapped_file_->data());
+  if (elements.ok()) {
+    binary_elements_ = std::move(elements).ValueOrDie();
+  } else {
+    reader_status_.Update(elements.status());
+  }
+}
+
 BundleMetadata BundleReader::GetBundleMetadata() {
   if (metadata_loaded_) {
     return metadata_;
   }
 
-  std::unique_ptr<BundleElement> element = ReadNextElement();
+  std::unique_ptr<BundleElement> element =
+      mapped_file_ ? ReadNextBinaryElement() : ReadNextElement();
   if (!element || element->element_type() != BundleElement::Type::Metadata) {
     Fail("Failed to get bundle metadata");
     return {};
@@ -64,36 +122,131 @@ std::unique_ptr<BundleElement> BundleReader::GetNextElement() {
   // Makes sure metadata is read before proceeding. The metadata element is the
   // first element in the bundle stream.
   GetBundleMetadata();
-  return ReadNextElement();
+  if (!reader_status_.ok()) {
+    return nullptr;
+  }
+
+  if (read_ahead_.empty()) {
+    ReadAhead();
+  }
+  if (read_ahead_.empty()) {
+    return nullptr;
+  }
+
+  ReadAheadElement next = std::move(read_ahead_.front());
+  read_ahead_.pop_front();
+  bytes_read_ += next.byte_size;
+  reader_status_.Update(next.status);
+  if (!reader_status_.ok()) {
+    read_ahead_.clear();
+    return nullptr;
+  }
+
+  return std::move(next.element);
 }
 
 std::unique_ptr<BundleElement> BundleReader::ReadNextElement() {
+  if (!ReadNextElementToBuffer().has_value()) {
+    return nullptr;
+  }
+
+  auto result = DecodeBundleElement(buffer_, json_reader_);
+  reader_status_.Update(json_reader_.status());
+
+  return result;
+}
+
+std::unique_ptr<BundleElement> BundleReader::ReadNextBinaryElement() {
+  if (!reader_status_.ok() ||
+      next_binary_element_ == binary_elements_.size()) {
+    return nullptr;
+  }
+
+  Status status;
+  auto result = DecodeBinaryElement(binary_elements_[next_binary_element_++],
+                                    &status);
+  reader_status_.Update(status);
+  return result;
+}
+
+absl::optional<std::string> BundleReader::ReadNextElementToBuffer() {
   auto length_prefix = ReadLengthPrefix();
   if (!length_prefix.has_value()) {
-    return nullptr;
+    return absl::nullopt;
   }
 
   size_t prefix_value = 0;
   auto ok = absl::SimpleAtoi<size_t>(length_prefix.value(), &prefix_value);
   if (!ok) {
     Fail("Prefix string is not a valid number");
-    return nullptr;
+    return absl::nullopt;
   }
 
   buffer_.clear();
   ReadJsonToBuffer(prefix_value);
   if (!reader_status_.ok()) {
-    return nullptr;
+    return absl::nullopt;
   }
 
-  // metadata's size does not count in `bytes_read_`.
-  if (metadata_loaded_) {
-    bytes_read_ += length_prefix.value().size() + buffer_.size();
+  return length_prefix;
+}
+
+void BundleReader::ReadAhead() {
+  if (mapped_file_) {
+    ReadAheadBinary();
+    return;
   }
-  auto result = DecodeBundleElementFromBuffer();
-  reader_status_.Update(json_reader_.status());
 
-  return result;
+  std::vector<std::string> json_strings;
+  std::vector<int64_t> byte_sizes;
+  while (json_strings.size() < kReadAheadElements) {
+    auto length_prefix = ReadNextElementToBuffer();
+    if (!length_prefix.has_value()) {
+      break;
+    }
+    byte_sizes.push_back(
+        static_cast<int64_t>(length_prefix.value().size() + buffer_.size()));
+    json_strings.push_back(std::move(buffer_));
+    buffer_ = std::string();
+  }
+
+  // Errors are reported once the elements read before them are consumed.
+  Status read_status = reader_status_;
+  reader_status_ = Status::OK();
+
+  std::vector<ReadAheadElement> decoded(json_strings.size());
+  DecodeInParallel(decoded.size(), [&](size_t i) {
+    JsonReader reader;
+    decoded[i].element = DecodeBundleElement(json_strings[i], reader);
+    decoded[i].status = reader.status();
+    decoded[i].byte_size = byte_sizes[i];
+  });
+
+  for (ReadAheadElement& element : decoded) {
+    read_ahead_.push_back(std::move(element));
+  }
+  if (!read_status.ok()) {
+    ReadAheadElement failure;
+    failure.status = std::move(read_status);
+    read_ahead_.push_back(std::move(failure));
+  }
+}
+
+void BundleReader::ReadAheadBinary() {
+  size_t begin = next_binary_element_;
+  size_t end = std::min(begin + kReadAheadElements, binary_elements_.size());
+  next_binary_element_ = end;
+
+  std::vector<ReadAheadElement> decoded(end - begin);
+  DecodeInParallel(decoded.size(), [&](size_t i) {
+    absl::string_view bytes = binary_elements_[begin + i];
+    decoded[i].element = DecodeBinaryElement(bytes, &decoded[i].status);
+    decoded[i].byte_size = static_cast<int64_t>(bytes.size());
+  });
+
+  for (ReadAheadElement& element : decoded) {
+    read_ahead_.push_back(std::move(element));
+  }
 }
 
 absl::optional<std::string> BundleReader::ReadLengthPrefix() {
@@ -119,9 +272,12 @@ void BundleReader::ReadJsonToBuffer(size_t required_size) {
     return;
   }
   while (buffer_.size() < required_size) {
-    // Read at most 1024 bytes every time, to avoid allocating a huge buffer
-    // when corruption leads to large `required_size`.
-    auto size = std::min<size_t>(1024ul, required_size - buffer_.size());
+    // Start with a 1024 byte read and at most double the buffer every time, to
+    // avoid allocating a huge buffer when corruption leads to large
+    // `required_size`, while still reading large elements in few calls.
+    auto size = std::min<size_t>(
+        std::max<size_t>(1024ul, std::min(buffer_.size(), kMaxReadSize)),
+        required_size - buffer_.size());
     StreamReadResult result = input_->Read(size);
     if (!result.ok()) {
       reader_status_.Update(result.status());
@@ -139,33 +295,41 @@ void BundleReader::ReadJsonToBuffer(size_t required_size) {
   }
 }
 
-std::unique_ptr<BundleElement> BundleReader::DecodeBundleElementFromBuffer() {
-  auto json_object = Parse(buffer_);
+std::unique_ptr<BundleElement> BundleReader::DecodeBundleElement(
+    absl::string_view json_string, JsonReader& reader) const {
+  auto json_object = Parse(json_string);
   if (json_object.is_discarded()) {
-    Fail("Failed to parse string into json");
+    reader.Fail("Failed to parse string into json");
     return nullptr;
   }
 
   if (json_object.contains("metadata")) {
     return absl::make_unique<BundleMetadata>(serializer_.DecodeBundleMetadata(
-        json_reader_, json_object.at("metadata")));
+        reader, json_object.at("metadata")));
   } else if (json_object.contains("namedQuery")) {
-    auto q = serializer_.DecodeNamedQuery(json_reader_,
-                                          json_object.at("namedQuery"));
+    auto q = serializer_.DecodeNamedQuery(reader, json_object.at("namedQuery"));
     return absl::make_unique<NamedQuery>(std::move(q));
   } else if (json_object.contains("documentMetadata")) {
     return absl::make_unique<BundledDocumentMetadata>(
-        serializer_.DecodeDocumentMetadata(json_reader_,
-                                           json_object.at("documentMetadata")));
+        serializer_.DecodeDocumentMetadata(
+            reader, json_object.at("documentMetadata")));
   } else if (json_object.contains("document")) {
     return absl::make_unique<BundleDocument>(
-        serializer_.DecodeDocument(json_reader_, json_object.at("document")));
+        serializer_.DecodeDocument(reader, json_object.at("document")));
   } else {
-    Fail("Unrecognized BundleElement");
+    reader.Fail("Unrecognized BundleElement");
     return nullptr;
   }
 }
 
+std::unique_ptr<BundleElement> BundleReader::DecodeBinaryElement(
+    absl::string_view bytes, Status* status) const {
+  nanopb::StringReader reader(bytes);
+  auto result = serializer_.DecodeBinaryElement(&reader);
+  *status = reader.status();
+  return reader.ok() ? std::move(result) : nullptr;
+}
+
 }  // namespace bundle
 }  // namespace firestore
 }  // namespace firebase
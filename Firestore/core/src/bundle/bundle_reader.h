@@ -17,14 +17,18 @@
 #define FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_READER_H_
 
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/bundle/bundle_metadata.h"
 #include "Firestore/core/src/bundle/bundle_serializer.h"
 #include "Firestore/core/src/util/byte_stream.h"
 #include "Firestore/core/src/util/json_reader.h"
+#include "Firestore/core/src/util/mapped_file.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 
 namespace firebase {
@@ -36,12 +40,25 @@ namespace bundle {
  *
  * The class takes a bundle stream and presents abstractions to read bundled
  * elements out of the underlying content.
+ *
+ * Elements are read ahead in batches: the JSON strings of a batch are split
+ * out of the stream on the calling thread, parsed and decoded in parallel on
+ * the shared `util::WorkStealingPool`, and then handed out in bundle order by
+ * `GetNextElement`.
+ *
+ * Binary bundles (see binary_bundle.h) are read from a memory-mapped file
+ * instead: their elements are decoded straight out of the mapping, so no JSON
+ * is parsed and the bundle is never copied as a whole.
  */
 class BundleReader {
  public:
   BundleReader(BundleSerializer serializer,
                std::unique_ptr<util::ByteStream> input);
 
+  /** Creates a reader for the binary bundle held by `file`. */
+  BundleReader(BundleSerializer serializer,
+               std::unique_ptr<util::MappedFile> file);
+
   /**
    * Returns the metadata element from the bundle.
    *
@@ -76,6 +93,44 @@ class BundleReader {
   }
 
  private:
+  /** An element that has been read ahead, but not returned yet. */
+  struct ReadAheadElement {
+    std::unique_ptr<BundleElement> element;
+
+    /** The error reading or decoding the element ran into, if any. */
+    util::Status status;
+
+    /** The number of bytes of the bundle the element takes up. */
+    int64_t byte_size = 0;
+  };
+
+  /**
+   * Reads up to a batch of elements from the underlying stream, decodes them
+   * and appends them to `read_ahead_`. An error is appended as an element with
+   * a not `ok()` status, after the elements that precede it.
+   */
+  void ReadAhead();
+
+  /** Like `ReadAhead`, for binary bundles. */
+  void ReadAheadBinary();
+
+  /**
+   * Decodes the next element of a binary bundle. Returns null at the end of
+   * the bundle or if decoding fails.
+   */
+  std::unique_ptr<BundleElement> ReadNextBinaryElement();
+
+  /** Decodes the given serialized element of a binary bundle. */
+  std::unique_ptr<BundleElement> DecodeBinaryElement(
+      absl::string_view bytes, util::Status* status) const;
+
+  /**
+   * Reads the length prefix and JSON string of the next element into
+   * `buffer_`. Returns the length prefix, or `nullopt` at the end of the
+   * stream or if reading failed.
+   */
+  absl::optional<std::string> ReadNextElementToBuffer();
+
   /**
    * Reads from the head of internal buffer, pulls more data from underlying
    * stream until a complete element is found (including the prefixed length and
@@ -104,12 +159,15 @@ class BundleReader {
   void ReadJsonToBuffer(size_t required_size);
 
   /**
-   * Decodes internal `buffer_` into a `BundleElement`, returned as a unique_ptr
-   * pointing to the element. Returns nullptr if fails.
+   * Decodes the given JSON string into a `BundleElement`, returned as a
+   * unique_ptr pointing to the element. Returns nullptr and fails `reader` if
+   * decoding fails.
    *
-   * Note this method will leave `buffer_` unchanged.
+   * Only reads the serializer, so may be called from several threads at once
+   * with distinct `reader`s.
    */
-  std::unique_ptr<BundleElement> DecodeBundleElementFromBuffer();
+  std::unique_ptr<BundleElement> DecodeBundleElement(
+      absl::string_view json_string, util::JsonReader& reader) const;
 
   BundleSerializer serializer_;
   util::JsonReader json_reader_;
@@ -124,6 +182,15 @@ class BundleReader {
   // Internal buffer, cleared every time a complete element is parsed from this.
   std::string buffer_;
 
+  // The mapped binary bundle, if this reader reads one, and views of its
+  // elements in bundle order.
+  std::unique_ptr<util::MappedFile> mapped_file_;
+  std::vector<absl::string_view> binary_elements_;
+  size_t next_binary_element_ = 0;
+
+  // Decoded elements that have not been returned by `GetNextElement` yet.
+  std::deque<ReadAheadElement> read_ahead_;
+
   util::Status reader_status_;
   int64_t bytes_read_ = 0;
 };
@@ -19,6 +19,7 @@
 #include <memory>
 #include <vector>
 
+#include "Firestore/core/src/bundle/binary_bundle.h"
 #include "Firestore/core/src/core/bound.h"
 #include "Firestore/core/src/core/direction.h"
 #include "Firestore/core/src/core/field_filter.h"
@@ -38,6 +39,7 @@
 #include "Firestore/core/src/util/statusor.h"
 #include "Firestore/core/src/util/string_format.h"
 #include "Firestore/core/src/util/string_util.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/numbers.h"
 #include "absl/time/time.h"
@@ -67,10 +69,13 @@ using model::ResourcePath;
 using model::SnapshotVersion;
 using nanopb::ByteString;
 using nanopb::MakeSharedMessage;
+using nanopb::MakeStdString;
 using nanopb::Message;
+using nanopb::Reader;
 using nanopb::SetRepeatedField;
 using nanopb::SharedMessage;
 using nlohmann::json;
+using remote::Serializer;
 using util::JsonReader;
 using util::NoDestructor;
 using util::StatusOr;
@@ -690,6 +695,169 @@ BundleDocument BundleSerializer::DecodeDocument(JsonReader& reader,
       ObjectValue::FromMapValue(std::move(map_value))));
 }
 
+std::string BundleSerializer::EncodeBinaryElement(
+    const BundleElement& element) const {
+  Message<firestore_BundleElement> result;
+
+  switch (element.element_type()) {
+    case BundleElement::Type::Metadata: {
+      const auto& metadata = static_cast<const BundleMetadata&>(element);
+      result->which_element_type = firestore_BundleElement_metadata_tag;
+      firestore_BundleMetadata& proto = result->metadata;
+      proto.id = Serializer::EncodeString(metadata.bundle_id());
+      proto.create_time = Serializer::EncodeVersion(metadata.create_time());
+      proto.version = metadata.version();
+      proto.total_documents = metadata.total_documents();
+      proto.total_bytes = metadata.total_bytes();
+      break;
+    }
+
+    case BundleElement::Type::NamedQuery: {
+      const auto& named_query = static_cast<const NamedQuery&>(element);
+      const BundledQuery& bundled_query = named_query.bundled_query();
+      result->which_element_type = firestore_BundleElement_named_query_tag;
+      firestore_NamedQuery& proto = result->named_query;
+      proto.name = Serializer::EncodeString(named_query.query_name());
+      proto.read_time = Serializer::EncodeVersion(named_query.read_time());
+
+      auto query_target =
+          rpc_serializer_.EncodeQueryTarget(bundled_query.target());
+      proto.bundled_query.parent = query_target.parent;
+      proto.bundled_query.which_query_type =
+          firestore_BundledQuery_structured_query_tag;
+      proto.bundled_query.structured_query = query_target.structured_query;
+      proto.bundled_query.limit_type =
+          bundled_query.limit_type() == LimitType::First
+              ? firestore_BundledQuery_LimitType_FIRST
+              : firestore_BundledQuery_LimitType_LAST;
+      break;
+    }
+
+    case BundleElement::Type::DocumentMetadata: {
+      const auto& metadata =
+          static_cast<const BundledDocumentMetadata&>(element);
+      result->which_element_type =
+          firestore_BundleElement_document_metadata_tag;
+      firestore_BundledDocumentMetadata& proto = result->document_metadata;
+      proto.name = rpc_serializer_.EncodeKey(metadata.key());
+      proto.read_time = Serializer::EncodeVersion(metadata.read_time());
+      proto.exists = metadata.exists();
+      SetRepeatedField(&proto.queries, &proto.queries_count,
+                       metadata.queries(), [](const std::string& query) {
+                         return Serializer::EncodeString(query);
+                       });
+      break;
+    }
+
+    case BundleElement::Type::Document: {
+      const MutableDocument& document =
+          static_cast<const BundleDocument&>(element).document();
+      result->which_element_type = firestore_BundleElement_document_tag;
+      result->document =
+          rpc_serializer_.EncodeDocument(document.key(), document.data());
+      result->document.has_update_time = true;
+      result->document.update_time =
+          Serializer::EncodeVersion(document.version());
+      break;
+    }
+  }
+
+  return MakeStdString(result);
+}
+
+std::unique_ptr<BundleElement> BundleSerializer::DecodeBinaryElement(
+    Reader* reader) const {
+  auto proto = Message<firestore_BundleElement>::TryParse(reader);
+  if (!reader->ok()) {
+    return nullptr;
+  }
+
+  switch (proto->which_element_type) {
+    case firestore_BundleElement_metadata_tag: {
+      const firestore_BundleMetadata& metadata = proto->metadata;
+      return absl::make_unique<BundleMetadata>(
+          Serializer::DecodeString(metadata.id), metadata.version,
+          Serializer::DecodeVersion(reader->context(), metadata.create_time),
+          metadata.total_documents, metadata.total_bytes);
+    }
+
+    case firestore_BundleElement_named_query_tag: {
+      firestore_NamedQuery& named_query = proto->named_query;
+      firestore_BundledQuery& query = named_query.bundled_query;
+      if (query.which_query_type !=
+          firestore_BundledQuery_structured_query_tag) {
+        reader->Fail(StringFormat("Unknown bundled query_type: %s",
+                                  query.which_query_type));
+        return nullptr;
+      }
+      LimitType limit_type =
+          query.limit_type == firestore_BundledQuery_LimitType_FIRST
+              ? LimitType::First
+              : LimitType::Last;
+      Target target = rpc_serializer_.DecodeStructuredQuery(
+          reader->context(), query.parent, query.structured_query);
+      return absl::make_unique<NamedQuery>(
+          Serializer::DecodeString(named_query.name),
+          BundledQuery(std::move(target), limit_type),
+          Serializer::DecodeVersion(reader->context(), named_query.read_time));
+    }
+
+    case firestore_BundleElement_document_metadata_tag: {
+      const firestore_BundledDocumentMetadata& metadata =
+          proto->document_metadata;
+      DocumentKey key = rpc_serializer_.DecodeKey(reader->context(),
+                                                  metadata.name);
+      std::vector<std::string> queries;
+      queries.reserve(metadata.queries_count);
+      for (pb_size_t i = 0; i < metadata.queries_count; ++i) {
+        queries.push_back(Serializer::DecodeString(metadata.queries[i]));
+      }
+      return absl::make_unique<BundledDocumentMetadata>(
+          std::move(key),
+          Serializer::DecodeVersion(reader->context(), metadata.read_time),
+          metadata.exists, std::move(queries));
+    }
+
+    case firestore_BundleElement_document_tag: {
+      google_firestore_v1_Document& document = proto->document;
+      DocumentKey key = rpc_serializer_.DecodeKey(reader->context(),
+                                                  document.name);
+      SnapshotVersion version =
+          Serializer::DecodeVersion(reader->context(), document.update_time);
+      ObjectValue fields =
+          ObjectValue::FromFieldsEntry(document.fields, document.fields_count);
+      return absl::make_unique<BundleDocument>(MutableDocument::FoundDocument(
+          std::move(key), version, std::move(fields)));
+    }
+
+    default:
+      reader->Fail(StringFormat("Unknown bundle element type: %s",
+                                proto->which_element_type));
+      return nullptr;
+  }
+}
+
+std::string BundleSerializer::EncodeBinaryBundle(
+    const BundleMetadata& metadata,
+    const std::vector<std::unique_ptr<BundleElement>>& elements) const {
+  std::vector<std::string> encoded;
+  encoded.reserve(elements.size() + 1);
+  // Leave room for the metadata, which is encoded once the total is known.
+  encoded.emplace_back();
+
+  uint64_t total_bytes = 0;
+  for (const auto& element : elements) {
+    encoded.push_back(EncodeBinaryElement(*element));
+    total_bytes += encoded.back().size();
+  }
+
+  encoded[0] = EncodeBinaryElement(
+      BundleMetadata(metadata.bundle_id(), metadata.version(),
+                     metadata.create_time(), metadata.total_documents(),
+                     total_bytes));
+  return WriteBinaryBundle(encoded);
+}
+
 }  // namespace bundle
 }  // namespace firestore
 }  // namespace firebase
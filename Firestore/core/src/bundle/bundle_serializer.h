@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_SERIALIZER_H_
 #define FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_SERIALIZER_H_
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -30,6 +31,7 @@
 #include "Firestore/core/src/model/resource_path.h"
 #include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/src/util/json_reader.h"
 #include "Firestore/core/src/util/read_context.h"
@@ -58,6 +60,31 @@ class BundleSerializer {
   BundleDocument DecodeDocument(util::JsonReader& reader,
                                 const nlohmann::json& document) const;
 
+  /**
+   * Encodes `element` as a serialized `firestore_BundleElement` proto, the
+   * representation of elements in binary bundles (see binary_bundle.h).
+   */
+  std::string EncodeBinaryElement(const BundleElement& element) const;
+
+  /**
+   * Decodes an element of a binary bundle from `reader`. Returns nullptr and
+   * fails `reader` if decoding fails.
+   *
+   * Only reads the serializer, so may be called from several threads at once
+   * with distinct `reader`s.
+   */
+  std::unique_ptr<BundleElement> DecodeBinaryElement(
+      nanopb::Reader* reader) const;
+
+  /**
+   * Writes `metadata` followed by `elements` as a binary bundle. The total
+   * size recorded in the metadata is replaced with the combined size of the
+   * encoded `elements`, which is what loading the bundle reports progress in.
+   */
+  std::string EncodeBinaryBundle(
+      const BundleMetadata& metadata,
+      const std::vector<std::unique_ptr<BundleElement>>& elements) const;
+
  private:
   BundledQuery DecodeBundledQuery(util::JsonReader& reader,
                                   const nlohmann::json& query) const;
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/core/firestore_client.h"
 
+#include <cerrno>
+#include <fstream>
 #include <functional>
 #include <future>  // NOLINT(build/c++11)
 #include <memory>
@@ -27,6 +29,8 @@
 #include "Firestore/core/src/api/query_core.h"
 #include "Firestore/core/src/api/query_snapshot.h"
 #include "Firestore/core/src/api/settings.h"
+#include "Firestore/core/src/bundle/binary_bundle.h"
+#include "Firestore/core/src/bundle/bundle_loader.h"
 #include "Firestore/core/src/bundle/bundle_reader.h"
 #include "Firestore/core/src/core/database_info.h"
 #include "Firestore/core/src/core/event_manager.h"
@@ -56,13 +60,16 @@
 #include "Firestore/core/src/remote/remote_store.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/byte_stream_cpp.h"
 #include "Firestore/core/src/util/delayed_constructor.h"
 #include "Firestore/core/src/util/exception.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
+#include "Firestore/core/src/util/mapped_file.h"
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "Firestore/core/src/util/string_apple.h"
+#include "Firestore/core/src/util/string_format.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
@@ -114,6 +121,11 @@ static const size_t kMaxConcurrentLimboResolutions = 100;
 
 static const auto kInitialGCDelay = std::chrono::minutes(1);
 static const auto kRegularGCDelay = std::chrono::minutes(5);
+/**
+ * How long a single step of garbage collection may run before yielding the
+ * worker queue to other operations.
+ */
+static const auto kGCStepDuration = std::chrono::milliseconds(50);
 
 /** How long we wait to try running index backfill after SDK initialization. */
 static const auto kInitialBackfillDelay = std::chrono::seconds(15);
@@ -207,8 +219,10 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
   if (settings.persistence_enabled()) {
     LevelDbOpener opener(database_info_);
 
-    auto created =
-        opener.Create(LruParams::WithCacheSize(settings.cache_size_bytes()));
+    LruParams lru_params =
+        LruParams::WithCacheSize(settings.cache_size_bytes());
+    lru_params.use_sequence_number_histogram = true;
+    auto created = opener.Create(lru_params);
     // If leveldb fails to start then just throw up our hands: the error is
     // unrecoverable. There's nothing an end-user can do and nearly all
     // failures indicate the developer is doing something grossly wrong so we
@@ -244,6 +258,7 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
   query_engine_ = absl::make_unique<QueryEngine>();
   local_store_ = absl::make_unique<LocalStore>(persistence_.get(),
                                                query_engine_.get(), user);
+  local_store_->SetQueryResultCacheEnabled(true);
   connectivity_monitor_ = ConnectivityMonitor::Create(worker_queue_);
   auto datastore = std::make_shared<Datastore>(
       database_info_, worker_queue_, auth_credentials_provider_,
@@ -256,9 +271,11 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
         sync_engine_->HandleOnlineStateChange(online_state);
       });
 
-  sync_engine_ =
-      absl::make_unique<SyncEngine>(local_store_.get(), remote_store_.get(),
-                                    user, kMaxConcurrentLimboResolutions);
+  sync_engine_ = absl::make_unique<SyncEngine>(
+      local_store_.get(), remote_store_.get(), user,
+      kMaxConcurrentLimboResolutions,
+      settings.limbo_lookups_enabled() ? LimboResolutionMode::kBatchedLookup
+                                       : LimboResolutionMode::kListen);
 
   event_manager_ = absl::make_unique<EventManager>(sync_engine_.get());
 
@@ -349,11 +366,23 @@ void FirestoreClient::ScheduleLruGarbageCollection() {
       gc_has_run_ ? kRegularGCDelay : kInitialGCDelay;
 
   lru_callback_ = worker_queue_->EnqueueAfterDelay(
-      delay, TimerId::GarbageCollectionDelay, [this] {
-        local_store_->CollectGarbage(lru_delegate_->garbage_collector());
-        gc_has_run_ = true;
-        ScheduleLruGarbageCollection();
-      });
+      delay, TimerId::GarbageCollectionDelay,
+      [this] { RunLruGarbageCollectionStep(); });
+}
+
+void FirestoreClient::RunLruGarbageCollectionStep() {
+  auto results = local_store_->CollectGarbageStep(
+      lru_delegate_->garbage_collector(), kGCStepDuration);
+  if (!results) {
+    // Let other operations on the worker queue run before continuing.
+    lru_callback_ = worker_queue_->EnqueueAfterDelay(
+        std::chrono::milliseconds(0), TimerId::GarbageCollectionDelay,
+        [this] { RunLruGarbageCollectionStep(); });
+    return;
+  }
+
+  gc_has_run_ = true;
+  ScheduleLruGarbageCollection();
 }
 
 void FirestoreClient::ScheduleIndexBackfiller() {
@@ -619,7 +648,80 @@ void FirestoreClient::LoadBundle(
   auto reader = std::make_shared<bundle::BundleReader>(
       std::move(bundle_serializer), std::move(bundle_data));
   worker_queue_->Enqueue([this, reader, result_task] {
-    sync_engine_->LoadBundle(std::move(reader), std::move(result_task));
+    StartLoadBundle(std::move(reader), std::move(result_task));
+  });
+}
+
+void FirestoreClient::LoadBundle(
+    const util::Path& bundle_path,
+    std::shared_ptr<api::LoadBundleTask> result_task) {
+  VerifyNotTerminated();
+
+  worker_queue_->Enqueue([this, bundle_path, result_task] {
+    // The first bytes tell the formats apart, so only binary bundles, which
+    // are read at random offsets, get mapped into memory.
+    auto input = absl::make_unique<std::ifstream>(
+        bundle_path.native_value(), std::ios::in | std::ios::binary);
+    if (!input->is_open()) {
+      Status status = Status::FromErrno(
+          errno, util::StringFormat("Could not open file '%s'",
+                                    bundle_path.ToUtf8String()));
+      LOG_WARN("Failed to open bundle file with error %s",
+               status.error_message());
+      result_task->SetError(status);
+      return;
+    }
+
+    std::string magic(bundle::kBinaryBundleMagic.size(), '\0');
+    input->read(&magic[0], static_cast<std::streamsize>(magic.size()));
+    magic.resize(static_cast<size_t>(input->gcount()));
+
+    bundle::BundleSerializer bundle_serializer(
+        remote::Serializer(database_info_.database_id()));
+    std::shared_ptr<bundle::BundleReader> reader;
+    if (bundle::IsBinaryBundle(magic)) {
+      input.reset();
+      StatusOr<std::unique_ptr<util::MappedFile>> file =
+          util::MappedFile::Open(bundle_path);
+      if (!file.ok()) {
+        LOG_WARN("Failed to open bundle file with error %s",
+                 file.status().error_message());
+        result_task->SetError(file.status());
+        return;
+      }
+      reader = std::make_shared<bundle::BundleReader>(
+          std::move(bundle_serializer), std::move(file).ValueOrDie());
+    } else {
+      input->clear();
+      input->seekg(0);
+      reader = std::make_shared<bundle::BundleReader>(
+          std::move(bundle_serializer),
+          absl::make_unique<util::ByteStreamCpp>(std::move(input)));
+    }
+    StartLoadBundle(std::move(reader), std::move(result_task));
+  });
+}
+
+void FirestoreClient::StartLoadBundle(
+    std::shared_ptr<bundle::BundleReader> reader,
+    std::shared_ptr<api::LoadBundleTask> result_task) {
+  auto loader = sync_engine_->LoadBundle(reader, result_task);
+  if (loader) {
+    ContinueLoadBundle(std::move(loader), std::move(reader),
+                       std::move(result_task));
+  }
+}
+
+void FirestoreClient::ContinueLoadBundle(
+    std::shared_ptr<bundle::BundleLoader> loader,
+    std::shared_ptr<bundle::BundleReader> reader,
+    std::shared_ptr<api::LoadBundleTask> result_task) {
+  // Let other operations on the worker queue run between chunks. Nothing is
+  // enqueued once the client is terminated, which abandons the load.
+  worker_queue_->Enqueue([this, loader, reader, result_task] {
+    if (sync_engine_->ContinueLoadBundle(*loader, *reader, *result_task)) {
+      ContinueLoadBundle(loader, reader, result_task);
+    }
   });
 }
 
@@ -34,11 +34,17 @@
 #include "Firestore/core/src/util/empty.h"
 #include "Firestore/core/src/util/executor.h"
 #include "Firestore/core/src/util/nullability.h"
+#include "Firestore/core/src/util/path.h"
 #include "Firestore/core/src/util/status_fwd.h"
 
 namespace firebase {
 namespace firestore {
 
+namespace bundle {
+class BundleLoader;
+class BundleReader;
+}  // namespace bundle
+
 namespace local {
 class LocalStore;
 class LruDelegate;
@@ -194,6 +200,14 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   void LoadBundle(std::unique_ptr<util::ByteStream> bundle_data,
                   std::shared_ptr<api::LoadBundleTask> result_task);
 
+  /**
+   * Loads the bundle stored in the file at `bundle_path`. Binary bundles are
+   * decoded straight from a memory mapping of the file; other bundles are
+   * streamed from it.
+   */
+  void LoadBundle(const util::Path& bundle_path,
+                  std::shared_ptr<api::LoadBundleTask> result_task);
+
   void GetNamedQuery(const std::string& name, api::QueryCallback callback);
 
   /** For usage in this class and testing only. */
@@ -225,12 +239,33 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
    */
   void ScheduleLruGarbageCollection();
 
+  /**
+   * Runs a slice of garbage collection, and schedules either the next slice or
+   * the next collection.
+   */
+  void RunLruGarbageCollectionStep();
+
   /**
    * Schedules a callback to try running index backfiller. Reschedules
    * itself after the backfiller has run.
    */
   void ScheduleIndexBackfiller();
 
+  /**
+   * Starts loading the bundle read by `reader`. Must be called on the worker
+   * queue.
+   */
+  void StartLoadBundle(std::shared_ptr<bundle::BundleReader> reader,
+                       std::shared_ptr<api::LoadBundleTask> result_task);
+
+  /**
+   * Schedules loading the next chunk of a bundle that is loaded in chunks.
+   * Reschedules itself until the whole bundle has been loaded.
+   */
+  void ContinueLoadBundle(std::shared_ptr<bundle::BundleLoader> loader,
+                          std::shared_ptr<bundle::BundleReader> reader,
+                          std::shared_ptr<api::LoadBundleTask> result_task);
+
   DatabaseInfo database_info_;
   std::shared_ptr<credentials::AppCheckCredentialsProvider>
       app_check_credentials_provider_;
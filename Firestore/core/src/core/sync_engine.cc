@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/core/sync_engine.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/bundle/bundle_element.h"
 #include "Firestore/core/src/bundle/bundle_loader.h"
@@ -29,12 +32,14 @@
 #include "Firestore/core/src/local/query_result.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/aggregate_field.h"
+#include "Firestore/core/src/model/document.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/mutation_batch_result.h"
 #include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/background_queue.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/status.h"
 #include "absl/strings/match.h"
@@ -59,6 +64,7 @@ using local::QueryResult;
 using local::TargetData;
 using model::AggregateField;
 using model::BatchId;
+using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
@@ -66,18 +72,30 @@ using model::DocumentUpdateMap;
 using model::kBatchIdUnknown;
 using model::ListenSequenceNumber;
 using model::MutableDocument;
+using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetId;
 using remote::RemoteEvent;
 using remote::TargetChange;
 using util::AsyncQueue;
+using util::BackgroundQueue;
 using util::Status;
 using util::StatusCallback;
+using util::StatusOr;
 
 // Limbo documents don't use persistence, and are eagerly GC'd. So, listens for
 // them don't need real sequence numbers.
 const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
+// The number of changed documents, summed over the views they are routed to,
+// from which the changes of the views are computed in parallel. Below it, the
+// cost of scheduling the work outweighs the gains.
+const size_t kMinChangesToComputeViewsInParallel = 1000;
+
+// The maximum number of documents in limbo looked up with a single
+// BatchGetDocuments request in `LimboResolutionMode::kBatchedLookup`.
+const size_t kMaxLimboDocumentsPerLookup = 500;
+
 bool ErrorIsInteresting(const Status& error) {
   bool missing_index =
       (error.code() == Error::kErrorFailedPrecondition &&
@@ -91,12 +109,14 @@ bool ErrorIsInteresting(const Status& error) {
 SyncEngine::SyncEngine(LocalStore* local_store,
                        remote::RemoteStore* remote_store,
                        const credentials::User& initial_user,
-                       size_t max_concurrent_limbo_resolutions)
+                       size_t max_concurrent_limbo_resolutions,
+                       LimboResolutionMode limbo_resolution_mode)
     : local_store_(local_store),
       remote_store_(remote_store),
       current_user_(initial_user),
       target_id_generator_(TargetIdGenerator::SyncEngineTargetIdGenerator()),
-      max_concurrent_limbo_resolutions_(max_concurrent_limbo_resolutions) {
+      max_concurrent_limbo_resolutions_(max_concurrent_limbo_resolutions),
+      limbo_resolution_mode_(limbo_resolution_mode) {
 }
 
 void SyncEngine::AssertCallbackExists(absl::string_view source) {
@@ -154,6 +174,7 @@ ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(
   auto query_view =
       std::make_shared<QueryView>(query, target_id, std::move(view));
   query_views_by_query_[query] = query_view;
+  AddToViewIndex(query_view);
 
   queries_by_target_[target_id].push_back(query);
 
@@ -188,6 +209,7 @@ void SyncEngine::StopListeningAndReleaseTarget(
   HARD_ASSERT(query_view, "Trying to stop listening to a query not found");
 
   if (last_listen) {
+    RemoveFromViewIndex(*query_view);
     query_views_by_query_.erase(query);
   }
 
@@ -211,7 +233,11 @@ void SyncEngine::StopListeningAndReleaseTarget(
 
 void SyncEngine::RemoveAndCleanupTarget(TargetId target_id, Status status) {
   for (const Query& query : queries_by_target_.at(target_id)) {
-    query_views_by_query_.erase(query);
+    auto query_view = query_views_by_query_.find(query);
+    if (query_view != query_views_by_query_.end()) {
+      RemoveFromViewIndex(*query_view->second);
+      query_views_by_query_.erase(query_view);
+    }
     if (!status.ok()) {
       sync_engine_callback_->OnError(query, status);
       if (ErrorIsInteresting(status)) {
@@ -505,19 +531,106 @@ void SyncEngine::FailOutstandingPendingWriteCallbacks(
 void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
     const DocumentMap& changes,
     const absl::optional<RemoteEvent>& maybe_remote_event) {
+  // Split the changes by the collections and collection groups that have
+  // views. Views on the same collection share their changes.
+  std::map<ResourcePath, DocumentMap> changes_by_collection;
+  std::unordered_map<std::string, DocumentMap> changes_by_collection_group;
+  for (const auto& kv : changes) {
+    ResourcePath collection = kv.first.path().PopLast();
+    if (query_views_by_collection_.count(collection) > 0) {
+      DocumentMap& collection_changes = changes_by_collection[collection];
+      collection_changes = collection_changes.insert(kv.first, kv.second);
+    }
+    const std::string& collection_id = collection.last_segment();
+    if (query_views_by_collection_group_.count(collection_id) > 0) {
+      DocumentMap& group_changes = changes_by_collection_group[collection_id];
+      group_changes = group_changes.insert(kv.first, kv.second);
+    }
+  }
+
+  // Collect the views that are affected, with the changes that apply to them.
+  const DocumentMap no_changes;
+  std::vector<std::pair<std::shared_ptr<QueryView>, const DocumentMap*>>
+      affected_views;
+  std::unordered_set<const QueryView*> seen_views;
+  auto add_views = [&](const std::vector<std::shared_ptr<QueryView>>& views,
+                       const DocumentMap& view_changes) {
+    for (const auto& query_view : views) {
+      if (seen_views.insert(query_view.get()).second) {
+        affected_views.emplace_back(query_view, &view_changes);
+      }
+    }
+  };
+  for (const auto& entry : changes_by_collection) {
+    add_views(query_views_by_collection_.at(entry.first), entry.second);
+  }
+  for (const auto& entry : changes_by_collection_group) {
+    add_views(query_views_by_collection_group_.at(entry.first), entry.second);
+  }
+  if (maybe_remote_event.has_value()) {
+    const RemoteEvent& remote_event = maybe_remote_event.value();
+    for (const auto& entry : remote_event.target_changes()) {
+      auto views = query_views_by_target_.find(entry.first);
+      if (views != query_views_by_target_.end()) {
+        add_views(views->second, no_changes);
+      }
+    }
+    for (const auto& entry : remote_event.target_mismatches()) {
+      auto views = query_views_by_target_.find(entry.first);
+      if (views != query_views_by_target_.end()) {
+        add_views(views->second, no_changes);
+      }
+    }
+  }
+  std::stable_sort(
+      affected_views.begin(), affected_views.end(),
+      [](const std::pair<std::shared_ptr<QueryView>, const DocumentMap*>& lhs,
+         const std::pair<std::shared_ptr<QueryView>, const DocumentMap*>& rhs) {
+        return lhs.first->target_id() < rhs.first->target_id();
+      });
+
+  // Computing the changes of a view only reads the view and its changes, so
+  // with enough work the views are computed in parallel. They are still
+  // updated, and their snapshots raised, one after another in the order above.
+  std::vector<absl::optional<ViewDocumentChanges>> computed_changes(
+      affected_views.size());
+  auto compute_changes = [&](size_t i) {
+    const View& view = affected_views[i].first->view();
+    computed_changes[i] =
+        view.ComputeDocumentChanges(*affected_views[i].second);
+  };
+  size_t routed_changes = 0;
+  for (const auto& entry : affected_views) {
+    routed_changes += entry.second->size();
+  }
+  if (affected_views.size() > 1 &&
+      routed_changes >= kMinChangesToComputeViewsInParallel) {
+    BackgroundQueue tasks;
+    for (size_t i = 0; i < affected_views.size(); ++i) {
+      tasks.Execute([&compute_changes, i] { compute_changes(i); });
+    }
+    tasks.AwaitAll();
+  } else {
+    for (size_t i = 0; i < affected_views.size(); ++i) {
+      compute_changes(i);
+    }
+  }
+
   std::vector<ViewSnapshot> new_snapshots;
   std::vector<LocalViewChanges> document_changes_in_all_views;
 
-  for (const auto& entry : query_views_by_query_) {
-    const auto& query_view = entry.second;
+  for (size_t i = 0; i < affected_views.size(); ++i) {
+    const auto& query_view = affected_views[i].first;
     View& view = query_view->view();
-    ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(changes);
+    ViewDocumentChanges view_doc_changes = *std::move(computed_changes[i]);
     if (view_doc_changes.needs_refill()) {
       // The query has a limit and some docs were removed/updated, so we need to
       // re-run the query against the local store to make sure we didn't lose
-      // any good docs that had been past the limit.
+      // any good docs that had been past the limit. The refill also reads the
+      // docs past the limit to fill the view's spill buffer, so that later
+      // removals can be handled without another refill.
       QueryResult query_result = local_store_->ExecuteQuery(
-          query_view->query(), /* use_previous_results= */ false);
+          view.RefillQuery(), /* use_previous_results= */ false);
       view_doc_changes = view.ComputeDocumentChanges(query_result.documents(),
                                                      view_doc_changes);
     }
@@ -557,6 +670,45 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
   local_store_->NotifyLocalViewChanges(document_changes_in_all_views);
 }
 
+void SyncEngine::AddToViewIndex(const std::shared_ptr<QueryView>& query_view) {
+  const Query& query = query_view->query();
+  if (query.IsCollectionGroupQuery()) {
+    query_views_by_collection_group_[*query.collection_group()].push_back(
+        query_view);
+  } else if (DocumentKey::IsDocumentKey(query.path())) {
+    query_views_by_collection_[query.path().PopLast()].push_back(query_view);
+  } else {
+    query_views_by_collection_[query.path()].push_back(query_view);
+  }
+  query_views_by_target_[query_view->target_id()].push_back(query_view);
+}
+
+void SyncEngine::RemoveFromViewIndex(const QueryView& query_view) {
+  auto remove_from = [&query_view](auto& index, const auto& key) {
+    auto entry = index.find(key);
+    HARD_ASSERT(entry != index.end(), "QueryView is not indexed");
+    auto& views = entry->second;
+    views.erase(std::remove_if(views.begin(), views.end(),
+                               [&query_view](const auto& view) {
+                                 return view.get() == &query_view;
+                               }),
+                views.end());
+    if (views.empty()) {
+      index.erase(entry);
+    }
+  };
+
+  const Query& query = query_view.query();
+  if (query.IsCollectionGroupQuery()) {
+    remove_from(query_views_by_collection_group_, *query.collection_group());
+  } else if (DocumentKey::IsDocumentKey(query.path())) {
+    remove_from(query_views_by_collection_, query.path().PopLast());
+  } else {
+    remove_from(query_views_by_collection_, query.path());
+  }
+  remove_from(query_views_by_target_, query_view.target_id());
+}
+
 void SyncEngine::UpdateTrackedLimboDocuments(
     const std::vector<LimboDocumentChange>& limbo_changes, TargetId target_id) {
   for (const LimboDocumentChange& limbo_change : limbo_changes) {
@@ -584,15 +736,29 @@ void SyncEngine::UpdateTrackedLimboDocuments(
 
 void SyncEngine::TrackLimboChange(const LimboDocumentChange& limbo_change) {
   const DocumentKey& key = limbo_change.key();
-  if (active_limbo_targets_by_key_.find(key) ==
-          active_limbo_targets_by_key_.end() &&
-      enqueued_limbo_resolutions_.push_back(key)) {
+  if (active_limbo_targets_by_key_.find(key) !=
+          active_limbo_targets_by_key_.end() ||
+      active_limbo_lookup_keys_.contains(key) ||
+      enqueued_limbo_resolutions_.contains(key)) {
+    return;
+  }
+
+  auto& queue = limbo_resolution_mode_ == LimboResolutionMode::kBatchedLookup
+                    ? enqueued_limbo_lookups_
+                    : enqueued_limbo_resolutions_;
+  if (queue.push_back(key)) {
     LOG_DEBUG("New document in limbo: %s", key.ToString());
     PumpEnqueuedLimboResolutions();
   }
 }
 
 void SyncEngine::PumpEnqueuedLimboResolutions() {
+  if (limbo_resolution_mode_ == LimboResolutionMode::kBatchedLookup) {
+    LookUpEnqueuedLimboDocuments();
+  }
+
+  // Even when looking up documents in batches, documents whose lookup failed
+  // are resolved with listens.
   while (!enqueued_limbo_resolutions_.empty() &&
          active_limbo_targets_by_key_.size() <
              max_concurrent_limbo_resolutions_) {
@@ -608,8 +774,68 @@ void SyncEngine::PumpEnqueuedLimboResolutions() {
   }
 }
 
+void SyncEngine::LookUpEnqueuedLimboDocuments() {
+  if (!active_limbo_lookup_keys_.empty() || enqueued_limbo_lookups_.empty()) {
+    return;
+  }
+
+  std::vector<DocumentKey> keys;
+  while (!enqueued_limbo_lookups_.empty() &&
+         keys.size() < kMaxLimboDocumentsPerLookup) {
+    keys.push_back(enqueued_limbo_lookups_.front());
+    enqueued_limbo_lookups_.pop_front();
+    active_limbo_lookup_keys_ = active_limbo_lookup_keys_.insert(keys.back());
+  }
+
+  LOG_DEBUG("Looking up %s documents in limbo", keys.size());
+  remote_store_->LookupDocuments(
+      keys, [this](const StatusOr<std::vector<Document>>& result) {
+        HandleLimboLookupResult(result);
+      });
+}
+
+void SyncEngine::HandleLimboLookupResult(
+    const StatusOr<std::vector<Document>>& result) {
+  DocumentKeySet lookup_keys = active_limbo_lookup_keys_;
+  active_limbo_lookup_keys_ = DocumentKeySet{};
+
+  if (!result.ok()) {
+    LOG_DEBUG("Lookup of documents in limbo failed, resolving with listens: %s",
+              result.status().ToString());
+    for (const DocumentKey& key : lookup_keys) {
+      // The document may have left limbo while the lookup was running.
+      if (limbo_document_refs_.ContainsKey(key)) {
+        enqueued_limbo_resolutions_.push_back(key);
+      }
+    }
+    PumpEnqueuedLimboResolutions();
+    return;
+  }
+
+  // Unlike the events of limbo targets, this one has no snapshot version: the
+  // lookup isn't part of the watch stream's consistent snapshots, so it must
+  // not advance the global snapshot version. The documents are instead stored
+  // at the read time of the lookup, which the `Datastore` sets on each.
+  DocumentKeySet limbo_documents;
+  RemoteEvent::TargetChangeMap target_changes;
+  RemoteEvent::TargetMismatchMap target_mismatches;
+  DocumentUpdateMap document_updates;
+  for (const Document& doc : result.ValueOrDie()) {
+    limbo_documents = limbo_documents.insert(doc->key());
+    document_updates.emplace(doc->key(), doc.get());
+  }
+
+  RemoteEvent event{SnapshotVersion::None(), std::move(target_changes),
+                    std::move(target_mismatches), std::move(document_updates),
+                    std::move(limbo_documents)};
+  ApplyRemoteEvent(event);
+
+  PumpEnqueuedLimboResolutions();
+}
+
 void SyncEngine::RemoveLimboTarget(const DocumentKey& key) {
   enqueued_limbo_resolutions_.remove(key);
+  enqueued_limbo_lookups_.remove(key);
   auto it = active_limbo_targets_by_key_.find(key);
   if (it == active_limbo_targets_by_key_.end()) {
     // This target already got removed, because the query failed.
@@ -664,42 +890,93 @@ absl::optional<BundleLoader> SyncEngine::ReadIntoLoader(
   return loader;
 }
 
-void SyncEngine::LoadBundle(std::shared_ptr<bundle::BundleReader> reader,
-                            std::shared_ptr<api::LoadBundleTask> result_task) {
+std::shared_ptr<BundleLoader> SyncEngine::LoadBundle(
+    std::shared_ptr<bundle::BundleReader> reader,
+    std::shared_ptr<api::LoadBundleTask> result_task) {
   auto bundle_metadata = reader->GetBundleMetadata();
   if (!reader->reader_status().ok()) {
     LOG_WARN("Failed to GetBundleMetadata() for bundle with error %s",
              reader->reader_status().error_message());
     result_task->SetError(reader->reader_status());
-    return;
+    return nullptr;
   }
 
   bool has_newer_bundle = local_store_->HasNewerBundle(bundle_metadata);
   if (has_newer_bundle) {
     result_task->SetSuccess(SuccessProgress(bundle_metadata));
-    return;
+    return nullptr;
   }
 
   result_task->UpdateProgress(InitialProgress(bundle_metadata));
+
+  if (bundle_metadata.total_documents() > bundle::kBundleChunkSize) {
+    auto loader = std::make_shared<BundleLoader>(
+        local_store_, bundle_metadata, bundle::kBundleChunkSize);
+    if (!ContinueLoadBundle(*loader, *reader, *result_task)) {
+      return nullptr;
+    }
+    return loader;
+  }
+
   auto maybe_loader = ReadIntoLoader(bundle_metadata, *reader, *result_task);
   if (!maybe_loader.has_value()) {
     // `ReadIntoLoader` would call `result_task.SetError` should there be an
     // error, so we do not need set it here.
-    return;
+    return nullptr;
   }
 
-  util::StatusOr<DocumentMap> changes = maybe_loader.value().ApplyChanges();
+  FinishLoadBundle(maybe_loader.value(), *result_task);
+  return nullptr;
+}
+
+bool SyncEngine::ContinueLoadBundle(BundleLoader& loader,
+                                    bundle::BundleReader& reader,
+                                    api::LoadBundleTask& result_task) {
+  while (!loader.chunk_ready()) {
+    auto element = reader.GetNextElement();
+    if (!reader.reader_status().ok()) {
+      LOG_WARN("Failed to GetNextElement() from bundle with error %s",
+               reader.reader_status().error_message());
+      result_task.SetError(reader.reader_status());
+      return false;
+    }
+
+    // No more elements from reader.
+    if (element == nullptr) {
+      FinishLoadBundle(loader, result_task);
+      return false;
+    }
+
+    auto maybe_progress = loader.AddElement(
+        std::move(element),
+        static_cast<uint64_t>(reader.bytes_read()) - loader.bytes_loaded());
+    if (!maybe_progress.ok()) {
+      LOG_WARN("Failed to AddElement() to bundle loader with error %s",
+               maybe_progress.status().error_message());
+      result_task.SetError(maybe_progress.status());
+      return false;
+    }
+  }
+
+  EmitNewSnapshotsAndNotifyLocalStore(loader.ApplyChunk(), absl::nullopt);
+  result_task.UpdateProgress(loader.progress());
+  return true;
+}
+
+void SyncEngine::FinishLoadBundle(BundleLoader& loader,
+                                  api::LoadBundleTask& result_task) {
+  util::StatusOr<DocumentMap> changes = loader.ApplyChanges();
   if (!changes.ok()) {
     LOG_WARN("Failed to ApplyChanges() for bundle elements with error %s",
              changes.status().error_message());
-    result_task->SetError(changes.status());
+    result_task.SetError(changes.status());
     return;
   }
 
   EmitNewSnapshotsAndNotifyLocalStore(changes.ConsumeValueOrDie(),
                                       absl::nullopt);
 
-  result_task->SetSuccess(SuccessProgress(bundle_metadata));
+  result_task.SetSuccess(SuccessProgress(loader.metadata()));
 }
 
 }  // namespace core
@@ -37,6 +37,7 @@
 #include "Firestore/core/src/remote/remote_store.h"
 #include "Firestore/core/src/util/random_access_queue.h"
 #include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/statusor.h"
 #include "absl/strings/string_view.h"
 
 namespace firebase {
@@ -56,6 +57,22 @@ namespace core {
 class SyncEngineCallback;
 class ViewSnapshot;
 
+/** How `SyncEngine` resolves documents in limbo. */
+enum class LimboResolutionMode {
+  /**
+   * Listens to each document in limbo with a watch target of its own, with at
+   * most `max_concurrent_limbo_resolutions` targets at a time.
+   */
+  kListen,
+
+  /**
+   * Looks up documents in limbo in batches through `BatchGetDocuments`, and
+   * applies the result of each batch as a single synthetic `RemoteEvent`.
+   * Documents whose lookup fails fall back to `kListen`.
+   */
+  kBatchedLookup,
+};
+
 /**
  * Interface implemented by `SyncEngine` to receive requests from
  * `EventManager`.
@@ -118,7 +135,9 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   SyncEngine(local::LocalStore* local_store,
              remote::RemoteStore* remote_store,
              const credentials::User& initial_user,
-             size_t max_concurrent_limbo_resolutions);
+             size_t max_concurrent_limbo_resolutions,
+             LimboResolutionMode limbo_resolution_mode =
+                 LimboResolutionMode::kListen);
 
   // Implements `QueryEventSource`.
   void SetCallback(SyncEngineCallback* callback) override {
@@ -182,8 +201,27 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   void HandleOnlineStateChange(model::OnlineState online_state) override;
   model::DocumentKeySet GetRemoteKeys(model::TargetId target_id) const override;
 
-  void LoadBundle(std::shared_ptr<bundle::BundleReader> reader,
-                  std::shared_ptr<api::LoadBundleTask> result_task);
+  /**
+   * Loads the given bundle and applies it to local store.
+   *
+   * Bundles with more than `bundle::kBundleChunkSize` documents are applied in
+   * chunks, each in its own transaction. In that case, this only applies the
+   * first chunk and returns a loader holding the progress so far. The caller
+   * must pass it to `ContinueLoadBundle` until that returns false, and can let
+   * other work run in between. Otherwise, returns nullptr.
+   */
+  std::shared_ptr<bundle::BundleLoader> LoadBundle(
+      std::shared_ptr<bundle::BundleReader> reader,
+      std::shared_ptr<api::LoadBundleTask> result_task);
+
+  /**
+   * Reads and applies the next chunk of a bundle whose loading was started by
+   * `LoadBundle`. Returns whether there are more chunks to load; once it
+   * returns false, `result_task` has been completed.
+   */
+  bool ContinueLoadBundle(bundle::BundleLoader& loader,
+                          bundle::BundleReader& reader,
+                          api::LoadBundleTask& result_task);
 
   // For tests only
   std::map<model::DocumentKey, model::TargetId>
@@ -197,6 +235,16 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
     return enqueued_limbo_resolutions_.elements();
   }
 
+  // For tests only
+  model::DocumentKeySet GetActiveLimboDocumentLookups() const {
+    return active_limbo_lookup_keys_;
+  }
+
+  // For tests only
+  std::vector<model::DocumentKey> GetEnqueuedLimboDocumentLookups() const {
+    return enqueued_limbo_lookups_.elements();
+  }
+
  private:
   /**
    * QueryView contains all of the info that SyncEngine needs to track for a
@@ -271,10 +319,25 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   void RemoveLimboTarget(const model::DocumentKey& key);
 
+  /**
+   * Applies `changes` and `maybe_remote_event` to the views they affect, emits
+   * the resulting snapshots and notifies the local store of them.
+   *
+   * Each changed document is only matched against the views that could
+   * contain it, found through `query_views_by_collection_` and
+   * `query_views_by_collection_group_`. Views without such documents are only
+   * updated if `maybe_remote_event` changes their target.
+   */
   void EmitNewSnapshotsAndNotifyLocalStore(
       const model::DocumentMap& changes,
       const absl::optional<remote::RemoteEvent>& maybe_remote_event);
 
+  /** Adds `query_view` to the indexes used to route changes to views. */
+  void AddToViewIndex(const std::shared_ptr<QueryView>& query_view);
+
+  /** Removes `query_view` from the indexes used to route changes to views. */
+  void RemoveFromViewIndex(const QueryView& query_view);
+
   /** Updates the limbo document state for the given target_id. */
   void UpdateTrackedLimboDocuments(
       const std::vector<LimboDocumentChange>& limbo_changes,
@@ -295,6 +358,15 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
    */
   void PumpEnqueuedLimboResolutions();
 
+  /**
+   * Starts a lookup for up to `kMaxLimboDocumentsPerLookup` documents that are
+   * enqueued for a batched limbo resolution, unless one is already running.
+   */
+  void LookUpEnqueuedLimboDocuments();
+
+  void HandleLimboLookupResult(
+      const util::StatusOr<std::vector<model::Document>>& result);
+
   void NotifyUser(model::BatchId batch_id, util::Status status);
 
   /**
@@ -309,6 +381,12 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
       bundle::BundleReader& reader,
       api::LoadBundleTask& result_task);
 
+  /**
+   * Applies the rest of the loaded bundle and completes `result_task`.
+   */
+  void FinishLoadBundle(bundle::BundleLoader& loader,
+                        api::LoadBundleTask& result_task);
+
   /** The local store, used to persist mutations and cached documents. */
   local::LocalStore* local_store_ = nullptr;
 
@@ -342,7 +420,23 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   /** Queries mapped to Targets, indexed by target ID. */
   std::unordered_map<model::TargetId, std::vector<Query>> queries_by_target_;
 
+  /**
+   * QueryViews of collection queries, and of queries for a single document,
+   * indexed by the path of the collection that holds their documents.
+   */
+  std::map<model::ResourcePath, std::vector<std::shared_ptr<QueryView>>>
+      query_views_by_collection_;
+
+  /** QueryViews of collection group queries, indexed by collection ID. */
+  std::unordered_map<std::string, std::vector<std::shared_ptr<QueryView>>>
+      query_views_by_collection_group_;
+
+  /** QueryViews for all active queries, indexed by target ID. */
+  std::unordered_map<model::TargetId, std::vector<std::shared_ptr<QueryView>>>
+      query_views_by_target_;
+
   const size_t max_concurrent_limbo_resolutions_;
+  const LimboResolutionMode limbo_resolution_mode_;
 
   /**
    * The keys of documents that are in limbo for which we haven't yet started a
@@ -364,6 +458,16 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   std::map<model::TargetId, LimboResolution>
       active_limbo_resolutions_by_target_;
 
+  /**
+   * The keys of documents in limbo waiting for a batched lookup. Only used in
+   * `LimboResolutionMode::kBatchedLookup`.
+   */
+  util::RandomAccessQueue<model::DocumentKey, model::DocumentKeyHash>
+      enqueued_limbo_lookups_;
+
+  /** The keys of documents in limbo included in the running lookup. */
+  model::DocumentKeySet active_limbo_lookup_keys_;
+
   /** Used to track any documents that are currently in limbo. */
   local::ReferenceSet limbo_document_refs_;
 };
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/core/view.h"
 
+#include <algorithm>
+#include <limits>
 #include <utility>
 
 #include "Firestore/core/src/core/target.h"
@@ -50,10 +52,12 @@ bool operator==(const LimboDocumentChange& lhs,
 // MARK: - ViewDocumentChanges
 
 ViewDocumentChanges::ViewDocumentChanges(model::DocumentSet new_documents,
+                                         model::DocumentSet spilled_documents,
                                          DocumentViewChangeSet changes,
                                          model::DocumentKeySet mutated_keys,
                                          bool needs_refill)
     : document_set_(std::move(new_documents)),
+      spilled_documents_(std::move(spilled_documents)),
       change_set_(std::move(changes)),
       mutated_keys_(std::move(mutated_keys)),
       needs_refill_(needs_refill) {
@@ -63,6 +67,13 @@ ViewDocumentChanges::ViewDocumentChanges(model::DocumentSet new_documents,
 
 namespace {
 
+/** The maximum number of docs kept in the spill buffer of a limit query. */
+const int32_t kMaxSpilledDocuments = 100;
+
+size_t SpillCapacity(int32_t limit) {
+  return static_cast<size_t>(std::min(limit, kMaxSpilledDocuments));
+}
+
 int GetDocumentViewChangeTypePosition(DocumentViewChange::Type change_type) {
   switch (change_type) {
     case DocumentViewChange::Type::Removed:
@@ -85,6 +96,7 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type change_type) {
 View::View(Query query, DocumentKeySet remote_documents)
     : query_(std::move(query)),
       document_set_(query_.Comparator()),
+      spilled_documents_(query_.Comparator()),
       synced_documents_(std::move(remote_documents)) {
 }
 
@@ -92,6 +104,37 @@ ComparisonResult View::Compare(const Document& lhs, const Document& rhs) const {
   return document_set_.comparator().Compare(lhs, rhs);
 }
 
+bool View::IsAfterInLimitOrder(const Document& lhs, const Document& rhs) const {
+  return query_.has_limit_to_last() ? util::Ascending(Compare(lhs, rhs))
+                                    : util::Descending(Compare(lhs, rhs));
+}
+
+absl::optional<Document> View::FirstInLimitOrder(
+    const DocumentSet& documents) const {
+  return query_.has_limit_to_last() ? documents.GetLastDocument()
+                                    : documents.GetFirstDocument();
+}
+
+absl::optional<Document> View::LastInLimitOrder(
+    const DocumentSet& documents) const {
+  return query_.has_limit_to_last() ? documents.GetFirstDocument()
+                                    : documents.GetLastDocument();
+}
+
+Query View::RefillQuery() const {
+  if (!query_.has_limit()) {
+    return query_;
+  }
+
+  int32_t limit = query_.limit();
+  int32_t capacity = static_cast<int32_t>(SpillCapacity(limit));
+  if (limit > std::numeric_limits<int32_t>::max() - capacity) {
+    return query_;
+  }
+  return query_.has_limit_to_last() ? query_.WithLimitToLast(limit + capacity)
+                                    : query_.WithLimitToFirst(limit + capacity);
+}
+
 ViewDocumentChanges View::ComputeDocumentChanges(
     const DocumentMap& doc_changes,
     const absl::optional<ViewDocumentChanges>& previous_changes) const {
@@ -101,6 +144,9 @@ ViewDocumentChanges View::ComputeDocumentChanges(
   }
   DocumentSet old_document_set =
       previous_changes ? previous_changes->document_set() : document_set_;
+  DocumentSet new_spilled_documents =
+      previous_changes ? previous_changes->spilled_documents()
+                       : spilled_documents_;
 
   DocumentKeySet new_mutated_keys =
       previous_changes ? previous_changes->mutated_keys() : mutated_keys_;
@@ -108,29 +154,50 @@ ViewDocumentChanges View::ComputeDocumentChanges(
   DocumentSet new_document_set = old_document_set;
   bool needs_refill = false;
 
-  // Track the last doc in a (full) limit. This is necessary, because some
-  // update (a delete, or an update moving a doc past the old limit) might mean
-  // there is some other document in the local cache that either should come (1)
-  // between the old last limit doc and the new last document, in the case of
-  // updates, or (2) after the new last document, in the case of deletes. So we
-  // keep this doc at the old limit to compare the updates to.
+  bool has_limit = query_.limit_type() != LimitType::None;
+  auto limit = has_limit ? static_cast<size_t>(query_.limit()) : 0;
+
+  // The view and the spill buffer together always hold a gapless prefix of
+  // the matching docs in the local cache, up to `last_known_doc`. Docs that
+  // end up past it may have other docs from the local cache in between, so
+  // they can neither be spilled nor stay in a full view without a refill.
   //
-  // Note that this should never get used in a refill (when previous_changes is
-  // set), because there will only be adds -- no deletes or updates.
-  absl::optional<Document> last_doc_in_limit;
-  if (query_.has_limit_to_first() &&
-      old_document_set.size() == static_cast<size_t>(query_.limit())) {
-    last_doc_in_limit = old_document_set.GetLastDocument();
-  }
-  absl::optional<Document> first_doc_in_limit;
-  if (query_.has_limit_to_last() &&
-      old_document_set.size() == static_cast<size_t>(query_.limit())) {
-    first_doc_in_limit = old_document_set.GetFirstDocument();
+  // If the view is full, that prefix ends with the last doc in the spill
+  // buffer, or in the view if the buffer is empty. A refill (when
+  // previous_changes is set) runs `RefillQuery()` against the local cache, so
+  // its first limit + capacity matching docs are known. Any other results,
+  // such as the initial ones, may come from previous remote keys or an index
+  // and skip docs past the limit, so nothing is spilled from them.
+  bool was_full = has_limit && !previous_changes &&
+                  old_document_set.size() == limit;
+  bool can_spill = was_full || (has_limit && previous_changes);
+  absl::optional<Document> last_known_doc;
+  if (was_full) {
+    last_known_doc = new_spilled_documents.empty()
+                         ? LastInLimitOrder(old_document_set)
+                         : LastInLimitOrder(new_spilled_documents);
+  } else if (has_limit && previous_changes) {
+    DocumentSet refilled_documents(query_.Comparator());
+    for (const auto& kv : doc_changes) {
+      if (query_.Matches(kv.second)) {
+        refilled_documents = refilled_documents.insert(kv.second);
+      }
+    }
+    size_t known_count = limit + SpillCapacity(query_.limit());
+    while (refilled_documents.size() > known_count) {
+      refilled_documents = refilled_documents.erase(
+          (*LastInLimitOrder(refilled_documents))->key());
+    }
+    last_known_doc = LastInLimitOrder(refilled_documents);
   }
 
   for (const auto& kv : doc_changes) {
     const DocumentKey& key = kv.first;
 
+    // A changed doc from the spill buffer is re-added below if it still
+    // matches, and then placed like any other doc.
+    new_spilled_documents = new_spilled_documents.erase(key);
+
     absl::optional<Document> old_doc = old_document_set.GetDocument(key);
     absl::optional<Document> new_doc = query_.Matches(kv.second)
                                            ? absl::optional<Document>{kv.second}
@@ -155,19 +222,6 @@ ViewDocumentChanges View::ComputeDocumentChanges(
           change_set.AddChange(
               DocumentViewChange{*new_doc, DocumentViewChange::Type::Modified});
           change_applied = true;
-
-          bool outside_limit =
-              last_doc_in_limit &&
-              util::Descending(Compare(*new_doc, *last_doc_in_limit));
-          bool outside_limit_to_last =
-              first_doc_in_limit &&
-              util::Ascending(Compare(*new_doc, *first_doc_in_limit));
-          if (outside_limit || outside_limit_to_last) {
-            // This doc moved from inside the limit to after the limit. That
-            // means there may be some doc in the local cache that's actually
-            // less than this one.
-            needs_refill = true;
-          }
         }
       } else if (old_doc_had_pending_mutations !=
                  new_doc_has_pending_mutations) {
@@ -184,13 +238,6 @@ ViewDocumentChanges View::ComputeDocumentChanges(
       change_set.AddChange(
           DocumentViewChange{*old_doc, DocumentViewChange::Type::Removed});
       change_applied = true;
-
-      if (last_doc_in_limit || first_doc_in_limit) {
-        // A doc was removed from a full limit query. We'll need to re-query
-        // from the local cache to see if we know about some other doc that
-        // should be in the results.
-        needs_refill = true;
-      }
     }
 
     if (change_applied) {
@@ -208,28 +255,79 @@ ViewDocumentChanges View::ComputeDocumentChanges(
     }
   }
 
-  // Drop documents out to meet limitToFirst/limitToLast requirement.
-  if (query_.limit_type() != LimitType::None) {
-    auto limit = static_cast<size_t>(query_.limit());
-    if (limit < new_document_set.size()) {
-      for (size_t i = new_document_set.size() - limit; i > 0; --i) {
-        absl::optional<Document> found =
-            query_.has_limit_to_first() ? new_document_set.GetLastDocument()
-                                        : new_document_set.GetFirstDocument();
-        const Document& old_doc = *found;
-        new_document_set = new_document_set.erase(old_doc->key());
-        new_mutated_keys = new_mutated_keys.erase(old_doc->key());
-        change_set.AddChange(
-            DocumentViewChange{old_doc, DocumentViewChange::Type::Removed});
+  if (has_limit) {
+    // Remove docs to meet the limitToFirst/limitToLast requirement, keeping
+    // them in the spill buffer where it is known to stay gapless.
+    while (new_document_set.size() > limit) {
+      Document doc = *LastInLimitOrder(new_document_set);
+      RemoveFromLimit(doc, &new_document_set, &new_mutated_keys, &change_set);
+      if (can_spill) {
+        new_spilled_documents = new_spilled_documents.insert(doc);
       }
     }
+
+    // Promote docs from the spill buffer until the view is full and no spilled
+    // doc belongs before the last doc in the view.
+    while (!new_spilled_documents.empty()) {
+      Document spilled = *FirstInLimitOrder(new_spilled_documents);
+      if (new_document_set.size() == limit) {
+        Document last = *LastInLimitOrder(new_document_set);
+        if (!IsAfterInLimitOrder(last, spilled)) {
+          break;
+        }
+        RemoveFromLimit(last, &new_document_set, &new_mutated_keys,
+                        &change_set);
+        new_spilled_documents = new_spilled_documents.insert(last);
+      }
+
+      new_spilled_documents = new_spilled_documents.erase(spilled->key());
+      new_document_set = new_document_set.insert(spilled);
+      if (spilled->has_local_mutations()) {
+        new_mutated_keys = new_mutated_keys.insert(spilled->key());
+      }
+      change_set.AddChange(
+          DocumentViewChange{spilled, DocumentViewChange::Type::Added});
+    }
+
+    // Drop spilled docs past the last known doc, and trim the buffer to its
+    // capacity.
+    while (!new_spilled_documents.empty()) {
+      Document doc = *LastInLimitOrder(new_spilled_documents);
+      if (new_spilled_documents.size() <= SpillCapacity(query_.limit()) &&
+          last_known_doc && !IsAfterInLimitOrder(doc, *last_known_doc)) {
+        break;
+      }
+      new_spilled_documents = new_spilled_documents.erase(doc->key());
+    }
+
+    // A full view needs to re-query the local cache if it lost docs that the
+    // spill buffer could not replace, or if one of its docs moved past the
+    // last known doc: the local cache may have docs that belong before it.
+    if (was_full) {
+      needs_refill =
+          new_document_set.size() < limit ||
+          IsAfterInLimitOrder(*LastInLimitOrder(new_document_set),
+                              *last_known_doc);
+    }
   }
 
   HARD_ASSERT(!needs_refill || !previous_changes,
               "View was refilled using docs that themselves needed refilling.");
 
-  return ViewDocumentChanges(std::move(new_document_set), std::move(change_set),
-                             new_mutated_keys, needs_refill);
+  return ViewDocumentChanges(std::move(new_document_set),
+                             std::move(new_spilled_documents),
+                             std::move(change_set), new_mutated_keys,
+                             needs_refill);
+}
+
+void View::RemoveFromLimit(const Document& doc,
+                           DocumentSet* document_set,
+                           DocumentKeySet* mutated_keys,
+                           DocumentViewChangeSet* change_set) const {
+  *document_set = document_set->erase(doc->key());
+  *mutated_keys = mutated_keys->erase(doc->key());
+  change_set->AddChange(
+      DocumentViewChange{doc, DocumentViewChange::Type::Removed});
 }
 
 bool View::ShouldWaitForSyncedDocument(const Document& new_doc,
@@ -254,6 +352,7 @@ ViewChange View::ApplyChanges(const ViewDocumentChanges& doc_changes,
 
   DocumentSet old_documents = document_set_;
   document_set_ = doc_changes.document_set();
+  spilled_documents_ = doc_changes.spilled_documents();
   mutated_keys_ = doc_changes.mutated_keys();
 
   // Sort changes based on type and query comparator.
@@ -311,8 +410,9 @@ ViewChange View::ApplyOnlineStateChange(OnlineState online_state) {
     // once the client is back online.
     current_ = false;
     return ApplyChanges(
-        ViewDocumentChanges(document_set_, DocumentViewChangeSet{},
-                            mutated_keys_, /* needs_refill= */ false));
+        ViewDocumentChanges(document_set_, spilled_documents_,
+                            DocumentViewChangeSet{}, mutated_keys_,
+                            /* needs_refill= */ false));
   } else {
     // No effect, just return a no-op ViewChange.
     return ViewChange(absl::nullopt, {});
@@ -68,6 +68,7 @@ class LimboDocumentChange {
 class ViewDocumentChanges {
  public:
   ViewDocumentChanges(model::DocumentSet new_documents,
+                      model::DocumentSet spilled_documents,
                       DocumentViewChangeSet changes,
                       model::DocumentKeySet mutated_keys,
                       bool needs_refill);
@@ -77,6 +78,14 @@ class ViewDocumentChanges {
     return document_set_;
   }
 
+  /**
+   * For limit queries, the matching docs that directly follow the limit (see
+   * `View`).
+   */
+  const model::DocumentSet& spilled_documents() const {
+    return spilled_documents_;
+  }
+
   /** The diff of these docs with the previous set of docs. */
   const core::DocumentViewChangeSet& change_set() const {
     return change_set_;
@@ -97,6 +106,7 @@ class ViewDocumentChanges {
 
  private:
   model::DocumentSet document_set_;
+  model::DocumentSet spilled_documents_;
   core::DocumentViewChangeSet change_set_;
   model::DocumentKeySet mutated_keys_;
   bool needs_refill_ = false;
@@ -132,6 +142,15 @@ class ViewChange {
  * View is responsible for computing the final merged truth of what docs are in
  * a query. It gets notified of local and remote changes to docs, and applies
  * the query filters and limits to determine the most correct possible results.
+ *
+ * For limit queries, the view also keeps a bounded "spill buffer" of the
+ * matching docs that directly follow the limit, i.e. the docs that would be
+ * next in line to enter the results. When docs are deleted or move past the
+ * limit, the view promotes docs from the spill buffer instead of asking for a
+ * refill from the local cache. A refill is only needed once the spill buffer
+ * runs out. The buffer is filled by refills, which read past the limit (see
+ * `RefillQuery()`), and by docs that leave a full view; the initial results of
+ * a query may skip docs past the limit and are never spilled.
  */
 class View {
  public:
@@ -188,10 +207,36 @@ class View {
     return sync_state_;
   }
 
+  /**
+   * Returns the query to run against the local cache when
+   * `ViewDocumentChanges::needs_refill()` is set. For limit queries, it reads
+   * enough docs to fill up the spill buffer as well.
+   */
+  Query RefillQuery() const;
+
  private:
   util::ComparisonResult Compare(const model::Document& lhs,
                                  const model::Document& rhs) const;
 
+  /**
+   * Returns whether a limit includes `lhs` later than `rhs`. For limitToFirst
+   * queries this follows the query order, for limitToLast queries the reverse.
+   */
+  bool IsAfterInLimitOrder(const model::Document& lhs,
+                           const model::Document& rhs) const;
+
+  absl::optional<model::Document> FirstInLimitOrder(
+      const model::DocumentSet& documents) const;
+
+  absl::optional<model::Document> LastInLimitOrder(
+      const model::DocumentSet& documents) const;
+
+  /** Removes `doc` from the docs within the limit. */
+  void RemoveFromLimit(const model::Document& doc,
+                       model::DocumentSet* document_set,
+                       model::DocumentKeySet* mutated_keys,
+                       DocumentViewChangeSet* change_set) const;
+
   bool ShouldBeInLimbo(const model::DocumentKey& key) const;
 
   bool ShouldWaitForSyncedDocument(const model::Document& new_doc,
@@ -206,6 +251,12 @@ class View {
 
   model::DocumentSet document_set_;
 
+  /**
+   * For limit queries, the matching docs that directly follow
+   * `document_set_`, without gaps.
+   */
+  model::DocumentSet spilled_documents_;
+
   /** Documents included in the remote target. */
   model::DocumentKeySet synced_documents_;
 
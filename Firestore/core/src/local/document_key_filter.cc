@@ -0,0 +1,154 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/document_key_filter.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/resource_path.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::DocumentKey;
+
+// About 1% false positives with the optimal number of hash functions.
+const uint64_t kBitsPerEntry = 10;
+const uint32_t kHashCount = 7;
+const uint64_t kMinBitCount = 1024;
+
+// The encoding is the hash count (4 bytes), the added count (8 bytes), both
+// little-endian, followed by the bitmap.
+const size_t kHeaderSize = 12;
+const uint32_t kMaxHashCount = 32;
+
+struct Hash {
+  uint64_t h1;
+  uint64_t h2;
+};
+
+/**
+ * Hashes the path segments of `key` with 64-bit FNV-1a, and derives a second
+ * hash from the first for double hashing.
+ */
+Hash HashKey(const DocumentKey& key) {
+  uint64_t h = 14695981039346656037ULL;
+  for (const std::string& segment : key.path()) {
+    for (char c : segment) {
+      h ^= static_cast<uint8_t>(c);
+      h *= 1099511628211ULL;
+    }
+    // Separate segments so that "a/bc" and "ab/c" hash differently.
+    h ^= '/';
+    h *= 1099511628211ULL;
+  }
+
+  // Finalize with the splitmix64 mixer to derive an independent-looking step.
+  uint64_t z = h + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+
+  // An odd step visits distinct bits for each hash function.
+  return Hash{h, z | 1};
+}
+
+void AppendLittleEndian(std::string* out, uint64_t value, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint64_t ReadLittleEndian(absl::string_view in, size_t size) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+DocumentKeyFilter::DocumentKeyFilter(size_t expected_entries) {
+  uint64_t bit_count =
+      std::max<uint64_t>(expected_entries * kBitsPerEntry, kMinBitCount);
+  bitmap_.assign((bit_count + 7) / 8, '\0');
+  bit_count_ = bitmap_.size() * 8;
+  hash_count_ = kHashCount;
+}
+
+DocumentKeyFilter::DocumentKeyFilter(std::string bitmap,
+                                     uint32_t hash_count,
+                                     uint64_t added_count)
+    : bitmap_(std::move(bitmap)),
+      bit_count_(bitmap_.size() * 8),
+      hash_count_(hash_count),
+      added_count_(added_count) {
+}
+
+absl::optional<DocumentKeyFilter> DocumentKeyFilter::Decode(
+    absl::string_view encoded) {
+  if (encoded.size() <= kHeaderSize) {
+    return absl::nullopt;
+  }
+
+  auto hash_count = static_cast<uint32_t>(ReadLittleEndian(encoded, 4));
+  uint64_t added_count = ReadLittleEndian(encoded.substr(4), 8);
+  if (hash_count == 0 || hash_count > kMaxHashCount) {
+    return absl::nullopt;
+  }
+
+  return DocumentKeyFilter(std::string(encoded.substr(kHeaderSize)),
+                           hash_count, added_count);
+}
+
+void DocumentKeyFilter::Add(const DocumentKey& key) {
+  Hash hash = HashKey(key);
+  for (uint32_t i = 0; i < hash_count_; ++i) {
+    uint64_t bit = (hash.h1 + i * hash.h2) % bit_count_;
+    char& byte = bitmap_[bit / 8];
+    byte = static_cast<char>(static_cast<uint8_t>(byte) | (1u << (bit % 8)));
+  }
+  added_count_++;
+}
+
+bool DocumentKeyFilter::MightContain(const DocumentKey& key) const {
+  Hash hash = HashKey(key);
+  for (uint32_t i = 0; i < hash_count_; ++i) {
+    uint64_t bit = (hash.h1 + i * hash.h2) % bit_count_;
+    if ((static_cast<uint8_t>(bitmap_[bit / 8]) & (1u << (bit % 8))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string DocumentKeyFilter::Encode() const {
+  std::string result;
+  result.reserve(kHeaderSize + bitmap_.size());
+  AppendLittleEndian(&result, hash_count_, 4);
+  AppendLittleEndian(&result, added_count_, 8);
+  result.append(bitmap_);
+  return result;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
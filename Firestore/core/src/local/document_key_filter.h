@@ -0,0 +1,87 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_DOCUMENT_KEY_FILTER_H_
+#define FIRESTORE_CORE_SRC_LOCAL_DOCUMENT_KEY_FILTER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "Firestore/core/src/model/model_fwd.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A Bloom filter over document keys.
+ *
+ * Keys can be added but never removed, so `MightContain` has no false
+ * negatives for any key added since the filter was created, but its false
+ * positive rate grows as more keys are added than the filter was sized for.
+ *
+ * Unlike `remote::BloomFilter`, which checks membership in filters sent by the
+ * backend, this filter is built locally. It uses a cheap, non-cryptographic
+ * hash that is stable across processes, so that an encoded filter can be
+ * persisted and decoded again later.
+ */
+class DocumentKeyFilter {
+ public:
+  /**
+   * Creates an empty filter sized to hold `expected_entries` keys at a false
+   * positive rate of about 1%.
+   */
+  explicit DocumentKeyFilter(size_t expected_entries);
+
+  /**
+   * Decodes a filter previously produced by `Encode`, or returns `nullopt` if
+   * `encoded` is not a valid encoding.
+   */
+  static absl::optional<DocumentKeyFilter> Decode(absl::string_view encoded);
+
+  void Add(const model::DocumentKey& key);
+
+  /**
+   * Returns false if `key` has definitely not been added to this filter, or
+   * true if it might have been.
+   */
+  bool MightContain(const model::DocumentKey& key) const;
+
+  std::string Encode() const;
+
+  /** The number of keys added to this filter, including repeated keys. */
+  uint64_t added_count() const {
+    return added_count_;
+  }
+
+ private:
+  DocumentKeyFilter(std::string bitmap,
+                    uint32_t hash_count,
+                    uint64_t added_count);
+
+  std::string bitmap_;
+  uint64_t bit_count_ = 0;
+  uint32_t hash_count_ = 0;
+  uint64_t added_count_ = 0;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_DOCUMENT_KEY_FILTER_H_
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_H_
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -39,6 +41,42 @@ class ResourcePath;
 
 namespace local {
 
+/**
+ * Cardinality statistics for a single field index, maintained incrementally as
+ * index entries are written. Used by the QueryEngine to cost index scans.
+ */
+struct IndexStatistics {
+  /** The number of documents that have at least one entry in the index. */
+  int64_t document_count = 0;
+
+  /**
+   * The number of entries in the index. Array indexes contain one entry per
+   * array element, so this can exceed `document_count`.
+   */
+  int64_t entry_count = 0;
+};
+
+/**
+ * A pull-based cursor over the document keys of an index scan.
+ *
+ * Keys are produced lazily in the order of the index, which matches the order
+ * of the target the cursor was created for. A cursor reads from the current
+ * persistence transaction and must not outlive it.
+ */
+class IndexCursor {
+ public:
+  virtual ~IndexCursor() = default;
+
+  /** Returns true if the cursor points at a document key. */
+  virtual bool Valid() const = 0;
+
+  /** Returns the current document key. Requires `Valid()`. */
+  virtual const model::DocumentKey& key() const = 0;
+
+  /** Advances to the next document key. Requires `Valid()`. */
+  virtual void Next() = 0;
+};
+
 /**
  * Represents a set of indexes that are used to execute queries efficiently.
  *
@@ -140,6 +178,39 @@ class IndexManager {
   virtual absl::optional<std::vector<model::DocumentKey>>
   GetDocumentsMatchingTarget(const core::Target& target) = 0;
 
+  /**
+   * Returns a cursor over the documents that match the given target, ordered
+   * by the target's order-bys. Each document key is produced at most once.
+   *
+   * Only targets with a `FULL` index type are supported, since only those are
+   * served in order from a single index. Returns `nullptr` otherwise.
+   */
+  virtual std::unique_ptr<IndexCursor> CreateIndexCursor(
+      const core::Target& target) = 0;
+
+  /**
+   * Returns the cardinality statistics for the given field index, or `nullopt`
+   * if no statistics have been collected for it.
+   */
+  virtual absl::optional<IndexStatistics> GetIndexStatistics(
+      const model::FieldIndex& index) const = 0;
+
+  /**
+   * Returns an estimate of the number of documents in the given collection
+   * group, derived from the statistics of its field indexes. Returns `nullopt`
+   * if the collection group has no indexes with statistics.
+   */
+  virtual absl::optional<size_t> GetCollectionGroupSizeEstimate(
+      const std::string& collection_group) const = 0;
+
+  /**
+   * Returns an estimate of the number of documents `GetDocumentsMatchingTarget`
+   * reads for the given target, or `nullopt` if the target cannot be served
+   * from an index or no statistics are available for the indexes it uses.
+   */
+  virtual absl::optional<size_t> EstimateDocumentsMatchingTarget(
+      const core::Target& target) = 0;
+
   /**
    * Returns the next collection group to update. Returns `nullopt` if no
    * group exists.
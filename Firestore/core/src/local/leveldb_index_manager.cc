@@ -17,15 +17,16 @@
 #include "Firestore/core/src/local/leveldb_index_manager.h"
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <memory>
-#include <set>
 #include <string>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/core/composite_filter.h"
+#include "Firestore/core/src/core/field_filter.h"
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/index/firestore_index_value_writer.h"
@@ -33,28 +34,27 @@
 #include "Firestore/core/src/index/index_entry.h"
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
-#include "Firestore/core/src/local/leveldb_util.h"
 #include "Firestore/core/src/local/local_serializer.h"
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/resource_path.h"
 #include "Firestore/core/src/model/target_index_matcher.h"
+#include "Firestore/core/src/util/background_queue.h"
 #include "Firestore/core/src/util/comparison.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/logic_utils.h"
-#include "Firestore/core/src/util/set_util.h"
-#include "Firestore/core/src/util/string_util.h"
 #include "Firestore/third_party/nlohmann_json/json.hpp"
+#include "absl/memory/memory.h"
 #include "absl/strings/match.h"
-#include "leveldb/iterator.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
 using core::CompositeFilter;
+using core::FieldFilter;
 using core::Filter;
 using core::Target;
 using credentials::User;
@@ -73,12 +73,29 @@ using util::LogicUtils;
 
 namespace {
 
+/**
+ * Selectivity assumed for equality-style filters. Without per-value histograms
+ * the planner falls back to the classic textbook defaults.
+ */
+const double kEqualitySelectivity = 0.1;
+
+/** Selectivity assumed for range filters. */
+const double kRangeSelectivity = 1.0 / 3.0;
+
+/**
+ * The number of (document, index) pairs whose entries are computed by a single
+ * task in `UpdateIndexEntries`. Smaller updates are computed inline.
+ */
+const size_t kComputeChunkSize = 32;
+
 struct DbIndexState {
   int64_t seconds;
   int32_t nanos;
   std::string key;
   model::ListenSequenceNumber sequence_number;
   model::BatchId largest_batch_id;
+  // Not present in states written by older SDK versions.
+  absl::optional<IndexStatistics> statistics;
 };
 
 void from_json(const json& j, DbIndexState& s) {
@@ -87,25 +104,85 @@ void from_json(const json& j, DbIndexState& s) {
   j.at("key").get_to(s.key);
   j.at("seq_num").get_to(s.sequence_number);
   j.at("largest_batch").get_to(s.largest_batch_id);
+  if (j.find("doc_count") != j.end() && j.find("entry_count") != j.end()) {
+    IndexStatistics statistics;
+    j.at("doc_count").get_to(statistics.document_count);
+    j.at("entry_count").get_to(statistics.entry_count);
+    s.statistics = statistics;
+  }
 }
 
-IndexState DecodeIndexState(const std::string& encoded) {
+IndexState DecodeIndexState(const std::string& encoded,
+                            absl::optional<IndexStatistics>* statistics) {
   auto j = json::parse(encoded.begin(), encoded.end(), /*callback=*/nullptr,
                        /*allow_exceptions=*/false);
   auto db_state = j.get<DbIndexState>();
+  *statistics = db_state.statistics;
   return {db_state.sequence_number,
           SnapshotVersion(Timestamp(db_state.seconds, db_state.nanos)),
           DocumentKey::FromPathString(db_state.key), db_state.largest_batch_id};
 }
 
-std::string EncodeIndexState(const IndexState& state) {
-  return json{
-      {"seconds", state.index_offset().read_time().timestamp().seconds()},
-      {"nanos", state.index_offset().read_time().timestamp().nanoseconds()},
-      {"key", state.index_offset().document_key().ToString()},
-      {"seq_num", state.sequence_number()},
-      {"largest_batch", state.index_offset().largest_batch_id()}}
-      .dump();
+std::string EncodeIndexState(
+    const IndexState& state,
+    const absl::optional<IndexStatistics>& statistics) {
+  json j{{"seconds", state.index_offset().read_time().timestamp().seconds()},
+         {"nanos", state.index_offset().read_time().timestamp().nanoseconds()},
+         {"key", state.index_offset().document_key().ToString()},
+         {"seq_num", state.sequence_number()},
+         {"largest_batch", state.index_offset().largest_batch_id()}};
+  if (statistics.has_value()) {
+    j["doc_count"] = statistics->document_count;
+    j["entry_count"] = statistics->entry_count;
+  }
+  return j.dump();
+}
+
+/** Returns the fraction of index entries expected to match `filter`. */
+double EstimateFilterSelectivity(const FieldFilter& filter) {
+  switch (filter.op()) {
+    case FieldFilter::Operator::Equal:
+    case FieldFilter::Operator::ArrayContains:
+      return kEqualitySelectivity;
+    case FieldFilter::Operator::In:
+    case FieldFilter::Operator::ArrayContainsAny:
+      return std::min(1.0, kEqualitySelectivity *
+                               filter.value().array_value.values_count);
+    case FieldFilter::Operator::NotEqual:
+      return 1.0 - kEqualitySelectivity;
+    case FieldFilter::Operator::NotIn:
+      return std::max(0.0, 1.0 - kEqualitySelectivity *
+                                     filter.value().array_value.values_count);
+    case FieldFilter::Operator::LessThan:
+    case FieldFilter::Operator::LessThanOrEqual:
+    case FieldFilter::Operator::GreaterThan:
+    case FieldFilter::Operator::GreaterThanOrEqual:
+      return kRangeSelectivity;
+  }
+
+  UNREACHABLE();
+}
+
+/**
+ * Returns the fraction of the documents in `index` expected to be read when
+ * serving `sub_target`. Filters on fields that are not part of the index
+ * (partial indexes) are applied after the scan and do not reduce the cost.
+ */
+double EstimateSelectivity(const Target& sub_target, const FieldIndex& index) {
+  double selectivity = 1.0;
+  for (const auto& filter : sub_target.filters()) {
+    if (!filter.IsAFieldFilter()) {
+      continue;
+    }
+    const FieldFilter field_filter(filter);
+    for (const auto& segment : index.segments()) {
+      if (segment.field_path() == field_filter.field()) {
+        selectivity *= EstimateFilterSelectivity(field_filter);
+        break;
+      }
+    }
+  }
+  return selectivity;
 }
 
 bool IsInFilter(const Target& target, const model::FieldPath& field_path) {
@@ -179,8 +256,105 @@ IndexEntry GenerateUpperBound(int32_t index_id,
   return inclusive ? entry.Successor() : entry;
 }
 
+/**
+ * Sorts `entries` in index order and drops duplicates, such as repeated
+ * values of an array-contains field.
+ */
+void SortAndDeduplicate(std::vector<IndexEntry>* entries) {
+  std::sort(entries->begin(), entries->end());
+  entries->erase(std::unique(entries->begin(), entries->end()),
+                 entries->end());
+}
+
 }  // namespace
 
+/**
+ * Merges the entries of several ranges of the same index into one stream
+ * ordered by directional value and document key, which is the order of the
+ * target the ranges were generated for. Entries are read lazily, one per range
+ * at a time, and each document key is returned only once.
+ */
+class LevelDbIndexManager::RangeCursor : public IndexCursor {
+ public:
+  RangeCursor(LevelDbTransaction* transaction, std::vector<IndexRange> ranges) {
+    for (auto& range : ranges) {
+      RangeState state{transaction->NewIterator(), std::move(range.upper), {}};
+      state.iter->Seek(range.lower);
+      if (Load(state)) {
+        ranges_.push_back(std::move(state));
+      }
+    }
+    Advance();
+  }
+
+  bool Valid() const override {
+    return current_.has_value();
+  }
+
+  const DocumentKey& key() const override {
+    HARD_ASSERT(Valid(), "key() called on an invalid cursor");
+    return current_.value();
+  }
+
+  void Next() override {
+    HARD_ASSERT(Valid(), "Next() called on an invalid cursor");
+    Advance();
+  }
+
+ private:
+  struct RangeState {
+    std::unique_ptr<LevelDbTransaction::Iterator> iter;
+    std::string upper;
+    LevelDbIndexEntryKey entry;
+  };
+
+  /**
+   * Decodes the entry the iterator of `state` points at. Returns false once
+   * the range is exhausted.
+   */
+  static bool Load(RangeState& state) {
+    return state.iter->Valid() && state.iter->key() <= state.upper &&
+           state.entry.Decode(state.iter->key());
+  }
+
+  static bool Before(const LevelDbIndexEntryKey& lhs,
+                     const LevelDbIndexEntryKey& rhs) {
+    if (lhs.directional_value() != rhs.directional_value()) {
+      return lhs.directional_value() < rhs.directional_value();
+    }
+    return lhs.ordered_document_key() < rhs.ordered_document_key();
+  }
+
+  void Advance() {
+    current_ = absl::nullopt;
+    while (!ranges_.empty()) {
+      // The number of ranges is bounded by the number of IN and
+      // array-contains-any values, so a linear scan finds the next entry.
+      auto next = ranges_.begin();
+      for (auto it = ranges_.begin() + 1; it != ranges_.end(); ++it) {
+        if (Before(it->entry, next->entry)) {
+          next = it;
+        }
+      }
+
+      std::string document_key = next->entry.document_key();
+      next->iter->Next();
+      if (!Load(*next)) {
+        ranges_.erase(next);
+      }
+
+      if (emitted_keys_.insert(document_key).second) {
+        current_ = DocumentKey::FromPathString(document_key);
+        return;
+      }
+    }
+  }
+
+  std::vector<RangeState> ranges_;
+  std::unordered_set<std::string> emitted_keys_;
+  absl::optional<DocumentKey> current_;
+};
+
 LevelDbIndexManager::LevelDbIndexManager(const User& user,
                                          LevelDbPersistence* db,
                                          LocalSerializer* serializer)
@@ -253,8 +427,13 @@ void LevelDbIndexManager::Start() {
         break;
       }
 
+      absl::optional<IndexStatistics> statistics;
       index_states.insert(
-          {state_key.index_id(), DecodeIndexState(state_iter->value())});
+          {state_key.index_id(),
+           DecodeIndexState(state_iter->value(), &statistics)});
+      if (statistics.has_value()) {
+        index_statistics_[state_key.index_id()] = statistics.value();
+      }
     }
   }
 
@@ -292,6 +471,13 @@ void LevelDbIndexManager::Start() {
                              ? iter->second
                              : FieldIndex::InitialState();
 
+      // Without an index state the user has no entries for this index yet, so
+      // its statistics start out exact. States written by older SDK versions
+      // have no statistics, and we leave them unknown.
+      if (iter == index_states.end()) {
+        index_statistics_[config_key.index_id()] = IndexStatistics();
+      }
+
       // Store the index and update `memoized_max_index_id_` and
       // `memoized_max_sequence_number_`.
       MemoizeIndex(FieldIndex(config_key.index_id(),
@@ -358,6 +544,7 @@ void LevelDbIndexManager::AddFieldIndex(const FieldIndex& index) {
       new_index.index_id(), new_index.collection_group());
   db_->current_transaction()->Put(
       config_key, serializer_->EncodeFieldIndexSegments(new_index.segments()));
+  index_statistics_[new_index.index_id()] = IndexStatistics();
 
   MemoizeIndex(std::move(new_index));
 }
@@ -406,6 +593,7 @@ void LevelDbIndexManager::DeleteFieldIndex(const FieldIndex& index) {
       index_map.erase(index_iter);
     }
   }
+  index_statistics_.erase(index.index_id());
 }
 
 std::vector<FieldIndex> LevelDbIndexManager::GetFieldIndexes(
@@ -469,6 +657,7 @@ void LevelDbIndexManager::DeleteAllFieldIndexes() {
 
   db_->DeleteAllFieldIndexes();
   memoized_indexes_.clear();
+  index_statistics_.clear();
   next_index_to_update_ = QueueForNextIndexToUpdate();
 }
 
@@ -578,18 +767,7 @@ LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
     LOG_DEBUG("Using index %s to execute target %s", index.collection_group(),
               sub_target.CanonicalId());
 
-    auto array_values = sub_target.GetArrayValues(index);
-    auto not_in_values = sub_target.GetNotInValues(index);
-    auto lower_bound = sub_target.GetLowerBound(index);
-    auto upper_bound = sub_target.GetUpperBound(index);
-
-    auto encoded_lower = EncodeBound(index, sub_target, lower_bound);
-    auto encoded_upper = EncodeBound(index, sub_target, upper_bound);
-    auto encoded_not_in = EncodeValues(index, sub_target, not_in_values);
-
-    auto index_ranges = GenerateIndexRanges(
-        index.index_id(), array_values, encoded_lower, lower_bound.inclusive,
-        encoded_upper, upper_bound.inclusive, encoded_not_in);
+    auto index_ranges = GetIndexRanges(sub_target, index);
 
     auto iter = db_->current_transaction()->NewIterator();
     for (const auto& range : index_ranges) {
@@ -616,6 +794,91 @@ LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
   return result;
 }
 
+absl::optional<IndexStatistics> LevelDbIndexManager::GetIndexStatistics(
+    const model::FieldIndex& index) const {
+  auto it = index_statistics_.find(index.index_id());
+  if (it == index_statistics_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+absl::optional<size_t> LevelDbIndexManager::GetCollectionGroupSizeEstimate(
+    const std::string& collection_group) const {
+  // Every index only contains the documents that have all of its fields, so
+  // the largest index is the best lower bound for the collection group size.
+  absl::optional<size_t> result;
+  for (const auto& index : GetFieldIndexes(collection_group)) {
+    auto statistics = GetIndexStatistics(index);
+    if (statistics.has_value()) {
+      result = std::max(result.value_or(0),
+                        static_cast<size_t>(statistics->document_count));
+    }
+  }
+  return result;
+}
+
+absl::optional<size_t> LevelDbIndexManager::EstimateDocumentsMatchingTarget(
+    const core::Target& target) {
+  double estimate = 0;
+  for (const auto& sub_target : GetSubTargets(target)) {
+    auto index = GetFieldIndex(sub_target);
+    if (!index.has_value()) {
+      return absl::nullopt;
+    }
+    auto statistics = GetIndexStatistics(index.value());
+    if (!statistics.has_value()) {
+      return absl::nullopt;
+    }
+
+    double matches = statistics->document_count *
+                     EstimateSelectivity(sub_target, index.value());
+    if (sub_target.HasLimit()) {
+      // Index scans stop reading once the limit is reached.
+      matches = std::min(matches, static_cast<double>(sub_target.limit()));
+    }
+    estimate += matches;
+  }
+  return static_cast<size_t>(std::round(estimate));
+}
+
+std::unique_ptr<IndexCursor> LevelDbIndexManager::CreateIndexCursor(
+    const core::Target& target) {
+  if (GetIndexType(target) != IndexType::FULL) {
+    return nullptr;
+  }
+
+  // Entries from different indexes cannot be merged in order.
+  std::vector<Target> sub_targets = GetSubTargets(target);
+  if (sub_targets.size() != 1) {
+    return nullptr;
+  }
+
+  const Target& sub_target = sub_targets.front();
+  FieldIndex index = GetFieldIndex(sub_target).value();
+  LOG_DEBUG("Using index %s to stream target %s", index.collection_group(),
+            sub_target.CanonicalId());
+  return absl::make_unique<RangeCursor>(db_->current_transaction(),
+                                        GetIndexRanges(sub_target, index));
+}
+
+std::vector<LevelDbIndexManager::IndexRange>
+LevelDbIndexManager::GetIndexRanges(const Target& sub_target,
+                                    const FieldIndex& index) {
+  auto array_values = sub_target.GetArrayValues(index);
+  auto not_in_values = sub_target.GetNotInValues(index);
+  auto lower_bound = sub_target.GetLowerBound(index);
+  auto upper_bound = sub_target.GetUpperBound(index);
+
+  auto encoded_lower = EncodeBound(index, sub_target, lower_bound);
+  auto encoded_upper = EncodeBound(index, sub_target, upper_bound);
+  auto encoded_not_in = EncodeValues(index, sub_target, not_in_values);
+
+  return GenerateIndexRanges(index.index_id(), array_values, encoded_lower,
+                             lower_bound.inclusive, encoded_upper,
+                             upper_bound.inclusive, encoded_not_in);
+}
+
 std::vector<std::string> LevelDbIndexManager::EncodeBound(
     const FieldIndex& index,
     const Target& target,
@@ -767,8 +1030,9 @@ void LevelDbIndexManager::UpdateCollectionGroup(
     IndexState updated_state{memoized_max_sequence_number_, offset};
 
     auto state_key = LevelDbIndexStateKey::Key(uid_, field_index.index_id());
-    db_->current_transaction()->Put(std::move(state_key),
-                                    EncodeIndexState(updated_state));
+    db_->current_transaction()->Put(
+        std::move(state_key),
+        EncodeIndexState(updated_state, GetIndexStatistics(field_index)));
 
     MemoizeIndex(FieldIndex{field_index.index_id(),
                             field_index.collection_group(),
@@ -780,31 +1044,80 @@ void LevelDbIndexManager::UpdateIndexEntries(
     const model::DocumentMap& documents) {
   HARD_ASSERT(started_, "IndexManager not started");
 
+  struct PendingUpdate {
+    const model::Document* document;
+    FieldIndex index;
+    std::vector<IndexEntry> new_entries;
+  };
+
+  std::vector<PendingUpdate> updates;
   for (const auto& kv : documents) {
     const auto group = kv.first.GetCollectionGroup();
     HARD_ASSERT(group.has_value(),
                 "Document key is expected to have a collection group");
-    std::vector<FieldIndex> indexes;
-    indexes = GetFieldIndexes(group.value());
-
-    for (const auto& index : indexes) {
-      auto existing_entries = GetExistingIndexEntries(kv.first, index);
-      auto new_entries = ComputeIndexEntries(kv.second, index);
-      if (existing_entries != new_entries) {
-        UpdateEntries(kv.second, index, existing_entries, new_entries);
-      }
+    for (auto& index : GetFieldIndexes(group.value())) {
+      updates.push_back({&kv.second, std::move(index), {}});
+    }
+  }
+
+  // Encoding the new entries only reads the documents, so large updates (such
+  // as those from the index backfiller) are encoded on the shared pool. The
+  // reads and writes below stay on this thread, inside the transaction.
+  auto compute_chunk = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      updates[i].new_entries =
+          ComputeIndexEntries(*updates[i].document, updates[i].index);
+    }
+  };
+
+  if (updates.size() <= kComputeChunkSize) {
+    compute_chunk(0, updates.size());
+  } else {
+    util::BackgroundQueue tasks;
+    for (size_t begin = 0; begin < updates.size();
+         begin += kComputeChunkSize) {
+      size_t end = std::min(begin + kComputeChunkSize, updates.size());
+      tasks.Execute(
+          [&compute_chunk, begin, end] { compute_chunk(begin, end); });
+    }
+    tasks.AwaitAll();
+  }
+
+  for (const PendingUpdate& update : updates) {
+    auto existing_entries =
+        GetExistingIndexEntries((*update.document)->key(), update.index);
+    if (existing_entries != update.new_entries) {
+      UpdateStatistics(update.index, existing_entries, update.new_entries);
+      UpdateEntries(*update.document, update.index, existing_entries,
+                    update.new_entries);
     }
   }
 }
 
-std::set<IndexEntry> LevelDbIndexManager::GetExistingIndexEntries(
+void LevelDbIndexManager::UpdateStatistics(
+    const FieldIndex& index,
+    const std::vector<IndexEntry>& existing_entries,
+    const std::vector<IndexEntry>& new_entries) {
+  auto it = index_statistics_.find(index.index_id());
+  if (it == index_statistics_.end()) {
+    // The index predates statistics tracking, so deltas have no baseline.
+    return;
+  }
+  IndexStatistics& statistics = it->second;
+  statistics.entry_count += static_cast<int64_t>(new_entries.size()) -
+                            static_cast<int64_t>(existing_entries.size());
+  statistics.document_count +=
+      (new_entries.empty() ? 0 : 1) - (existing_entries.empty() ? 0 : 1);
+}
+
+std::vector<IndexEntry> LevelDbIndexManager::GetExistingIndexEntries(
     const DocumentKey& key, const FieldIndex& index) {
   auto document_key_index_prefix =
       LevelDbIndexEntryDocumentKeyIndexKey::KeyPrefix(
           index.index_id(), uid_, key.path().CanonicalString());
   LevelDbIndexEntryDocumentKeyIndexKey document_key_index_key;
   auto iter = db_->current_transaction()->NewIterator();
-  std::set<IndexEntry> index_entries;
+  std::vector<IndexEntry> index_entries;
   for (iter->Seek(document_key_index_prefix); iter->Valid(); iter->Next()) {
     if (!absl::StartsWith(iter->key(), document_key_index_prefix) ||
         !document_key_index_key.Decode(iter->key())) {
@@ -815,16 +1128,19 @@ std::set<IndexEntry> LevelDbIndexManager::GetExistingIndexEntries(
     HARD_ASSERT(decoded,
                 "LevelDbIndexEntryKey cannot be decoded from document key "
                 "index table.");
-    index_entries.insert({entry_key.index_id(), key, entry_key.array_value(),
-                          entry_key.directional_value()});
+    index_entries.emplace_back(entry_key.index_id(), key,
+                               entry_key.array_value(),
+                               entry_key.directional_value());
   }
 
+  // The document key index is ordered by sequence number, not by entry.
+  SortAndDeduplicate(&index_entries);
   return index_entries;
 }
 
-std::set<IndexEntry> LevelDbIndexManager::ComputeIndexEntries(
-    const model::Document& document, const FieldIndex& index) {
-  std::set<IndexEntry> results;
+std::vector<IndexEntry> LevelDbIndexManager::ComputeIndexEntries(
+    const model::Document& document, const FieldIndex& index) const {
+  std::vector<IndexEntry> results;
 
   auto directional_value = EncodeDirectionalElements(index, document);
   if (directional_value == absl::nullopt) {
@@ -837,24 +1153,25 @@ std::set<IndexEntry> LevelDbIndexManager::ComputeIndexEntries(
     if (field_value.has_value() &&
         field_value.value().which_value_type ==
             google_firestore_v1_Value_array_value_tag) {
-      for (pb_size_t i = 0; i < field_value.value().array_value.values_count;
-           ++i) {
-        results.insert(IndexEntry(
-            index.index_id(), document->key(),
-            EncodeSingleElement(field_value.value().array_value.values[i]),
-            directional_value.value()));
+      const auto& array_value = field_value.value().array_value;
+      results.reserve(array_value.values_count);
+      for (pb_size_t i = 0; i < array_value.values_count; ++i) {
+        results.emplace_back(index.index_id(), document->key(),
+                             EncodeSingleElement(array_value.values[i]),
+                             directional_value.value());
       }
+      SortAndDeduplicate(&results);
     }
   } else {
-    results.insert(IndexEntry(index.index_id(), document->key(), "",
-                              directional_value.value()));
+    results.emplace_back(index.index_id(), document->key(), "",
+                         directional_value.value());
   }
 
   return results;
 }
 
 absl::optional<std::string> LevelDbIndexManager::EncodeDirectionalElements(
-    const FieldIndex& index, const model::Document& document) {
+    const FieldIndex& index, const model::Document& document) const {
   IndexEncodingBuffer index_buffer;
   for (const auto& segment : index.GetDirectionalSegments()) {
     auto field = document->field(segment.field_path());
@@ -867,7 +1184,7 @@ absl::optional<std::string> LevelDbIndexManager::EncodeDirectionalElements(
 }
 
 std::string LevelDbIndexManager::EncodeSingleElement(
-    const _google_firestore_v1_Value& value) {
+    const _google_firestore_v1_Value& value) const {
   IndexEncodingBuffer index_buffer;
   index::WriteIndexValue(value,
                          index_buffer.ForKind(model::Segment::kAscending));
@@ -877,54 +1194,68 @@ std::string LevelDbIndexManager::EncodeSingleElement(
 void LevelDbIndexManager::UpdateEntries(
     const model::Document& document,
     const FieldIndex& index,
-    const std::set<IndexEntry>& existing_entries,
-    const std::set<IndexEntry>& new_entries) {
-  util::DiffSets<IndexEntry>(
-      existing_entries, new_entries,
-      [](const IndexEntry& left, const IndexEntry& right) {
-        return left.CompareTo(right);
-      },
-      [this, document, index](const IndexEntry& entry) {
-        this->AddIndexEntry(document, index, entry);
-      },
-      [this, document, index](const IndexEntry& entry) {
-        this->DeleteIndexEntry(document, index, entry);
-      });
-}
-
-void LevelDbIndexManager::AddIndexEntry(const model::Document& document,
-                                        const FieldIndex& index,
-                                        const IndexEntry& entry) {
+    const std::vector<IndexEntry>& existing_entries,
+    const std::vector<IndexEntry>& new_entries) {
+  LevelDbTransaction* transaction = db_->current_transaction();
   std::string document_key = document->key().path().CanonicalString();
-  auto entry_key = LevelDbIndexEntryKey::Key(
-      entry.index_id(), uid_, entry.array_value(), entry.directional_value(),
-      EncodedDirectionalKey(index, document->key()), document_key);
-  db_->current_transaction()->Put(entry_key, "");
+  std::string directional_key = EncodedDirectionalKey(index, document->key());
+  auto entry_key = [&](const IndexEntry& entry) {
+    return LevelDbIndexEntryKey::Key(entry.index_id(), uid_,
+                                     entry.array_value(),
+                                     entry.directional_value(),
+                                     directional_key, document_key);
+  };
 
+  // Both lists are sorted, so a single merge finds the entries to add and
+  // remove. The keys of all new entries are kept for the document key index.
+  std::vector<std::string> new_entry_keys;
+  new_entry_keys.reserve(new_entries.size());
+  auto existing_iter = existing_entries.begin();
+  auto new_iter = new_entries.begin();
+  while (existing_iter != existing_entries.end() ||
+         new_iter != new_entries.end()) {
+    if (new_iter == new_entries.end() ||
+        (existing_iter != existing_entries.end() &&
+         *existing_iter < *new_iter)) {
+      transaction->Delete(entry_key(*existing_iter));
+      ++existing_iter;
+      continue;
+    }
+
+    new_entry_keys.push_back(entry_key(*new_iter));
+    if (existing_iter != existing_entries.end() &&
+        *existing_iter == *new_iter) {
+      ++existing_iter;
+    } else {
+      transaction->Put(new_entry_keys.back(), "");
+    }
+    ++new_iter;
+  }
+
+  // Rewrite the document key index so that it lists exactly the new entries,
+  // numbered from zero. Rows past the new entry count are removed and the
+  // rest are overwritten in place.
+  auto new_entry_count = static_cast<int64_t>(new_entry_keys.size());
   auto document_key_index_prefix =
-      LevelDbIndexEntryDocumentKeyIndexKey::KeyPrefix(entry.index_id(), uid_,
+      LevelDbIndexEntryDocumentKeyIndexKey::KeyPrefix(index.index_id(), uid_,
                                                       document_key);
-  std::unique_ptr<leveldb::Iterator> iter(
-      db_->ptr()->NewIterator(LevelDbTransaction::DefaultReadOptions()));
-  iter->Seek(util::PrefixSuccessor(document_key_index_prefix));
-  iter->Prev();
-  absl::string_view raw_key;
-  if (iter->Valid() && absl::StartsWith(local::MakeStringView(iter->key()),
-                                        document_key_index_prefix)) {
-    raw_key = local::MakeStringView(iter->key());
-  }
-
-  LevelDbIndexEntryDocumentKeyIndexKey document_key_index_key(
-      entry.index_id(), uid_, document_key, 0);
-  if (!raw_key.empty()) {
-    bool decoded = document_key_index_key.Decode(raw_key);
-    HARD_ASSERT(decoded,
-                "LevelDbIndexEntryDocumentKeyIndexKey cannot be decoded from "
-                "document key index table.");
-    document_key_index_key.IncreaseSeqNumber();
+  LevelDbIndexEntryDocumentKeyIndexKey document_key_index_key;
+  auto iter = transaction->NewIterator();
+  for (iter->Seek(document_key_index_prefix); iter->Valid(); iter->Next()) {
+    if (!absl::StartsWith(iter->key(), document_key_index_prefix) ||
+        !document_key_index_key.Decode(iter->key())) {
+      break;
+    }
+    if (document_key_index_key.seq_number() >= new_entry_count) {
+      transaction->Delete(iter->key());
+    }
   }
 
-  db_->current_transaction()->Put(document_key_index_key.Key(), entry_key);
+  for (size_t i = 0; i < new_entry_keys.size(); ++i) {
+    LevelDbIndexEntryDocumentKeyIndexKey row(
+        index.index_id(), uid_, document_key, static_cast<int64_t>(i));
+    transaction->Put(row.Key(), std::move(new_entry_keys[i]));
+  }
 }
 
 std::string LevelDbIndexManager::EncodedDirectionalKey(
@@ -938,29 +1269,6 @@ std::string LevelDbIndexManager::EncodedDirectionalKey(
   return buffer.GetEncodedBytes();
 }
 
-void LevelDbIndexManager::DeleteIndexEntry(const model::Document& document,
-                                           const FieldIndex& index,
-                                           const IndexEntry& entry) {
-  std::string document_key = document->key().path().CanonicalString();
-  auto entry_key = LevelDbIndexEntryKey::Key(
-      entry.index_id(), uid_, entry.array_value(), entry.directional_value(),
-      EncodedDirectionalKey(index, document->key()), document_key);
-  db_->current_transaction()->Delete(entry_key);
-
-  auto document_key_index_prefix =
-      LevelDbIndexEntryDocumentKeyIndexKey::KeyPrefix(entry.index_id(), uid_,
-                                                      document_key);
-  LevelDbIndexEntryDocumentKeyIndexKey document_key_index_key;
-  auto iter = db_->current_transaction()->NewIterator();
-  for (iter->Seek(document_key_index_prefix); iter->Valid(); iter->Next()) {
-    if (!absl::StartsWith(iter->key(), document_key_index_prefix) ||
-        !document_key_index_key.Decode(iter->key())) {
-      break;
-    }
-    db_->current_transaction()->Delete(iter->key());
-  }
-}
-
 std::vector<Target> LevelDbIndexManager::GetSubTargets(const Target& target) {
   auto it = target_to_dnf_subtargets_.find(target);
   if (it != target_to_dnf_subtargets_.end()) {
@@ -17,8 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_INDEX_MANAGER_H_
 
+#include <memory>
 #include <queue>
-#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -83,6 +83,18 @@ class LevelDbIndexManager : public IndexManager {
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
       const core::Target& target) override;
 
+  std::unique_ptr<IndexCursor> CreateIndexCursor(
+      const core::Target& target) override;
+
+  absl::optional<IndexStatistics> GetIndexStatistics(
+      const model::FieldIndex& index) const override;
+
+  absl::optional<size_t> GetCollectionGroupSizeEstimate(
+      const std::string& collection_group) const override;
+
+  absl::optional<size_t> EstimateDocumentsMatchingTarget(
+      const core::Target& target) override;
+
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
   void UpdateCollectionGroup(const std::string& collection_group,
@@ -102,6 +114,9 @@ class LevelDbIndexManager : public IndexManager {
     std::string upper;
   };
 
+  /** Merges the entries of several index ranges in index order. */
+  class RangeCursor;
+
   /**
    * Stores the index in the memoized indexes table and updates
    * `next_index_to_update_` `memoized_max_index_id_` and
@@ -111,30 +126,31 @@ class LevelDbIndexManager : public IndexManager {
 
   void DeleteFromUpdateQueue(model::FieldIndex* index);
 
-  std::set<index::IndexEntry> GetExistingIndexEntries(
+  /**
+   * Adjusts the cardinality statistics of `index` for a document whose entries
+   * change from `existing_entries` to `new_entries`.
+   */
+  void UpdateStatistics(const model::FieldIndex& index,
+                        const std::vector<index::IndexEntry>& existing_entries,
+                        const std::vector<index::IndexEntry>& new_entries);
+
+  /** Returns the stored index entries of the given document, sorted. */
+  std::vector<index::IndexEntry> GetExistingIndexEntries(
       const model::DocumentKey& key, const model::FieldIndex& index);
 
-  /** Creates the index entries for the given document. */
-  std::set<index::IndexEntry> ComputeIndexEntries(
-      const model::Document& document, const model::FieldIndex& index);
+  /** Creates the index entries for the given document, sorted. */
+  std::vector<index::IndexEntry> ComputeIndexEntries(
+      const model::Document& document, const model::FieldIndex& index) const;
 
   /**
    * Updates the index entries for the provided document by deleting entries
    * that are no longer referenced in `new_entries` and adding all newly added
-   * entries.
+   * entries. Both lists must be sorted and free of duplicates.
    */
   void UpdateEntries(const model::Document& document,
                      const model::FieldIndex& index,
-                     const std::set<index::IndexEntry>& existing_entries,
-                     const std::set<index::IndexEntry>& new_entries);
-
-  void AddIndexEntry(const model::Document& document,
-                     const model::FieldIndex& index,
-                     const index::IndexEntry& entry);
-
-  void DeleteIndexEntry(const model::Document& document,
-                        const model::FieldIndex& index,
-                        const index::IndexEntry& entry);
+                     const std::vector<index::IndexEntry>& existing_entries,
+                     const std::vector<index::IndexEntry>& new_entries);
 
   /**
    * Returns the byte encoded form of the directional values in the field index.
@@ -142,10 +158,11 @@ class LevelDbIndexManager : public IndexManager {
    * index.
    */
   absl::optional<std::string> EncodeDirectionalElements(
-      const model::FieldIndex& index, const model::Document& document);
+      const model::FieldIndex& index, const model::Document& document) const;
 
   /** Encodes a single value to the ascending index format. */
-  std::string EncodeSingleElement(const _google_firestore_v1_Value& value);
+  std::string EncodeSingleElement(
+      const _google_firestore_v1_Value& value) const;
 
   /**
    * Returns an encoded form of the document key that sorts based on the key
@@ -176,6 +193,13 @@ class LevelDbIndexManager : public IndexManager {
                                         const core::Target& target,
                                         core::IndexedValues values);
 
+  /**
+   * Returns the LevelDb key ranges in `index` that contain the entries
+   * matching `sub_target`.
+   */
+  std::vector<IndexRange> GetIndexRanges(const core::Target& sub_target,
+                                         const model::FieldIndex& index);
+
   /**
    * Constructs a vector of LevelDb key ranges that unions all bounds.
    *
@@ -240,6 +264,12 @@ class LevelDbIndexManager : public IndexManager {
                      std::unordered_map<int32_t, model::FieldIndex>>
       memoized_indexes_;
 
+  /**
+   * Cardinality statistics keyed by index_id. Persisted alongside the index
+   * state in `UpdateCollectionGroup()` and restored in `Start()`.
+   */
+  std::unordered_map<int32_t, IndexStatistics> index_statistics_;
+
   QueueForNextIndexToUpdate next_index_to_update_;
   int32_t memoized_max_index_id_ = -1;
   int64_t memoized_max_sequence_number_ = -1;
@@ -41,8 +41,12 @@ namespace {
 const char* kVersionGlobalTable = "version";
 const char* kMutationsTable = "mutation";
 const char* kDocumentMutationsTable = "document_mutation";
+const char* kCollectionMutationsTable = "collection_mutation";
 const char* kMutationQueuesTable = "mutation_queue";
 const char* kTargetGlobalTable = "target_global";
+const char* kTargetDocumentFilterTable = "target_document_filter";
+const char* kSequenceNumberHistogramTable = "sequence_number_histogram";
+const char* kTableSizesTable = "table_sizes";
 const char* kTargetsTable = "target";
 const char* kQueryTargetsTable = "query_target";
 const char* kTargetDocumentsTable = "target_document";
@@ -206,6 +210,10 @@ class Reader {
    */
   std::string Describe();
 
+  std::string ReadTableName() {
+    return ReadLabeledString(ComponentLabel::TableName);
+  }
+
   void ReadTableNameMatching(const char* expected_table_name) {
     if (!ReadLabeledStringMatching(ComponentLabel::TableName,
                                    expected_table_name)) {
@@ -851,6 +859,39 @@ std::string DescribeKey(const char* key) {
   return DescribeKey(leveldb::Slice{key});
 }
 
+LevelDbTableGroup TableGroupForKey(absl::string_view key) {
+  Reader reader{key};
+  std::string table = reader.ReadTableName();
+  if (!reader.ok()) {
+    return LevelDbTableGroup::kOther;
+  }
+
+  if (table == kRemoteDocumentsTable || table == kRemoteDocumentReadTimeTable ||
+      table == kCollectionParentsTable) {
+    return LevelDbTableGroup::kDocuments;
+  }
+  if (table == kTargetsTable || table == kQueryTargetsTable ||
+      table == kTargetDocumentsTable || table == kDocumentTargetsTable ||
+      table == kTargetGlobalTable || table == kTargetDocumentFilterTable) {
+    return LevelDbTableGroup::kTargets;
+  }
+  if (table == kMutationsTable || table == kDocumentMutationsTable ||
+      table == kCollectionMutationsTable || table == kMutationQueuesTable) {
+    return LevelDbTableGroup::kMutations;
+  }
+  if (table == kDocumentOverlaysTable ||
+      table == kDocumentOverlaysLargestBatchIdIndexTable ||
+      table == kDocumentOverlaysCollectionIndexTable ||
+      table == kDocumentOverlaysCollectionGroupIndexTable) {
+    return LevelDbTableGroup::kOverlays;
+  }
+  if (table == kIndexEntriesTable ||
+      table == kIndexEntriesDocumentKeyIndexTable) {
+    return LevelDbTableGroup::kIndexEntries;
+  }
+  return LevelDbTableGroup::kOther;
+}
+
 std::string LevelDbVersionKey::Key() {
   Writer writer;
   writer.WriteTableName(kVersionGlobalTable);
@@ -934,6 +975,56 @@ bool LevelDbDocumentMutationKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbCollectionMutationKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id, const ResourcePath& collection) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(collection);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::Key(absl::string_view user_id,
+                                              const DocumentKey& document_key,
+                                              model::BatchId batch_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(document_key.path().PopLast());
+  writer.WriteBatchId(batch_id);
+  writer.WriteDocumentId(document_key.path().last_segment());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbCollectionMutationKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionMutationsTable);
+  user_id_ = reader.ReadUserId();
+  ResourcePath collection = reader.ReadResourcePath();
+  batch_id_ = reader.ReadBatchId();
+  std::string document_id = reader.ReadDocumentId();
+  reader.ReadTerminator();
+  if (reader.ok()) {
+    document_key_ = DocumentKey(collection.Append(document_id));
+  }
+  return reader.ok();
+}
+
 std::string LevelDbMutationQueueKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationQueuesTable);
@@ -970,6 +1061,48 @@ bool LevelDbTargetGlobalKey::Decode(leveldb::Slice key) {
   return reader.ok();
 }
 
+std::string LevelDbTargetDocumentFilterKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kTargetDocumentFilterTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbTargetDocumentFilterKey::Decode(leveldb::Slice key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kTargetDocumentFilterTable);
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbSequenceNumberHistogramKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kSequenceNumberHistogramTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbSequenceNumberHistogramKey::Decode(leveldb::Slice key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kSequenceNumberHistogramTable);
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbTableSizesKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kTableSizesTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbTableSizesKey::Decode(leveldb::Slice key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kTableSizesTable);
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbTargetKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kTargetsTable);
@@ -162,6 +162,19 @@ std::string DescribeKey(absl::string_view key);
 std::string DescribeKey(const std::string& key);
 std::string DescribeKey(const char* key);
 
+/** Groups of logical tables whose sizes are accounted for separately. */
+enum class LevelDbTableGroup {
+  kDocuments,
+  kTargets,
+  kMutations,
+  kOverlays,
+  kIndexEntries,
+  kOther,
+};
+
+/** Returns the group of the table that the given key belongs to. */
+LevelDbTableGroup TableGroupForKey(absl::string_view key);
+
 /** A key to a singleton row storing the version of the schema. */
 class LevelDbVersionKey {
  public:
@@ -283,6 +296,80 @@ class LevelDbDocumentMutationKey {
   model::BatchId batch_id_ = model::kBatchIdUnknown;
 };
 
+/**
+ * A key in the collection mutations index, which stores the batches in which
+ * the immediate children of a collection are mutated.
+ *
+ * Unlike the document mutations index, rows for a collection are contiguous
+ * and exclude documents in subcollections. Within a collection, rows are
+ * ordered by batch_id, so a scan yields the batch_ids affecting the collection
+ * in ascending order, with repeats adjacent to each other.
+ */
+class LevelDbCollectionMutationKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id.
+   */
+  static std::string KeyPrefix(absl::string_view user_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id and collection.
+   */
+  static std::string KeyPrefix(absl::string_view user_id,
+                               const model::ResourcePath& collection);
+
+  /**
+   * Creates a complete key that points to a specific user_id, document key,
+   * and batch_id.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const model::DocumentKey& document_key,
+                         model::BatchId batch_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  const std::string& user_id() const {
+    return user_id_;
+  }
+
+  /** The collection containing the mutated document. */
+  model::ResourcePath collection() const {
+    return document_key_.path().PopLast();
+  }
+
+  /** The batch_id in which the document participates. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+  /** The mutated document. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  std::string user_id_;
+  model::BatchId batch_id_ = model::kBatchIdUnknown;
+  model::DocumentKey document_key_;
+};
+
 /**
  * A key in the mutation_queues table.
  *
@@ -339,6 +426,57 @@ class LevelDbTargetGlobalKey {
   bool Decode(leveldb::Slice key);
 };
 
+/**
+ * A key for the single row holding the persisted `DocumentKeyFilter` over the
+ * documents referenced by some target.
+ */
+class LevelDbTargetDocumentFilterKey {
+ public:
+  /** Creates a key that points to the single target document filter row. */
+  static std::string Key();
+
+  /**
+   * Decodes the contents of a target document filter key, essentially just
+   * verifying that the key has the correct table name.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(leveldb::Slice key);
+};
+
+/**
+ * A key for the single row holding the persisted `SequenceNumberHistogram` of
+ * orphaned documents, used by LRU garbage collection.
+ */
+class LevelDbSequenceNumberHistogramKey {
+ public:
+  /** Creates a key that points to the single histogram row. */
+  static std::string Key();
+
+  /**
+   * Decodes the contents of a histogram key, essentially just verifying that
+   * the key has the correct table name.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(leveldb::Slice key);
+};
+
+/**
+ * A key for the single row holding the persisted `LevelDbTableSizes`, the
+ * number of bytes stored in each group of tables.
+ */
+class LevelDbTableSizesKey {
+ public:
+  /** Creates a key that points to the single table sizes row. */
+  static std::string Key();
+
+  /**
+   * Decodes the contents of a table sizes key, essentially just verifying that
+   * the key has the correct table name.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(leveldb::Slice key);
+};
+
 /** A key in the targets table. */
 class LevelDbTargetKey {
  public:
@@ -993,6 +1131,14 @@ class LevelDbIndexEntryKey {
     return directional_value_;
   }
 
+  /**
+   * The document key encoded in the direction of the index's last segment,
+   * which orders entries with the same directional value.
+   */
+  const std::string& ordered_document_key() const {
+    return ordered_document_key_;
+  }
+
   /** The document key this entry points to. */
   const std::string& document_key() const {
     return document_key_;
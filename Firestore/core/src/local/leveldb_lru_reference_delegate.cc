@@ -22,6 +22,7 @@
 
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_util.h"
 #include "Firestore/core/src/local/listen_sequence.h"
 #include "Firestore/core/src/local/reference_set.h"
 #include "Firestore/core/src/local/target_data.h"
@@ -54,6 +55,18 @@ void LevelDbLruReferenceDelegate::Start() {
   ListenSequenceNumber highest_sequence_number =
       db_->target_cache()->highest_listen_sequence_number();
   listen_sequence_ = absl::make_unique<ListenSequence>(highest_sequence_number);
+
+  std::string encoded_histogram;
+  leveldb::Status status = db_->ptr()->Get(
+      StandardReadOptions(), LevelDbSequenceNumberHistogramKey::Key(),
+      &encoded_histogram);
+  if (status.ok()) {
+    absl::optional<SequenceNumberHistogram> histogram =
+        SequenceNumberHistogram::Decode(encoded_histogram);
+    if (histogram) {
+      gc_->RestoreHistogram(std::move(histogram).value());
+    }
+  }
 }
 
 void LevelDbLruReferenceDelegate::AddInMemoryPins(ReferenceSet* set) {
@@ -68,11 +81,13 @@ void LevelDbLruReferenceDelegate::AddReference(const DocumentKey& key) {
 
 void LevelDbLruReferenceDelegate::RemoveReference(const DocumentKey& key) {
   WriteSentinel(key);
+  gc_->RecordDocumentSequenceNumber(current_sequence_number());
 }
 
 void LevelDbLruReferenceDelegate::RemoveMutationReference(
     const DocumentKey& key) {
   WriteSentinel(key);
+  gc_->RecordDocumentSequenceNumber(current_sequence_number());
 }
 
 void LevelDbLruReferenceDelegate::RemoveTarget(const TargetData& target_data) {
@@ -83,6 +98,7 @@ void LevelDbLruReferenceDelegate::RemoveTarget(const TargetData& target_data) {
 
 void LevelDbLruReferenceDelegate::UpdateLimboDocument(const DocumentKey& key) {
   WriteSentinel(key);
+  gc_->RecordDocumentSequenceNumber(current_sequence_number());
 }
 
 ListenSequenceNumber LevelDbLruReferenceDelegate::current_sequence_number()
@@ -132,19 +148,45 @@ void LevelDbLruReferenceDelegate::EnumerateOrphanedDocuments(
 int LevelDbLruReferenceDelegate::RemoveOrphanedDocuments(
     ListenSequenceNumber upper_bound) {
   int count = 0;
-  db_->target_cache()->EnumerateOrphanedDocuments(
-      [&](const DocumentKey& key, ListenSequenceNumber sequence_number) {
-        if (sequence_number <= upper_bound) {
-          if (!IsPinned(key)) {
-            count++;
-            db_->remote_document_cache()->Remove(key);
-            RemoveSentinel(key);
-          }
-        }
-      });
+  RemoveOrphanedDocumentsUntil(
+      upper_bound, absl::nullopt, LruDeadline::max(),
+      [](ListenSequenceNumber) {}, &count);
   return count;
 }
 
+absl::optional<DocumentKey>
+LevelDbLruReferenceDelegate::RemoveOrphanedDocumentsUntil(
+    ListenSequenceNumber upper_bound,
+    const absl::optional<DocumentKey>& start_after,
+    LruDeadline deadline,
+    const SequenceNumberCallback& kept_callback,
+    int* removed_count) {
+  int count = 0;
+  auto should_stop = [deadline] {
+    return std::chrono::steady_clock::now() >= deadline;
+  };
+  absl::optional<DocumentKey> last_visited =
+      db_->target_cache()->EnumerateOrphanedDocuments(
+          start_after, should_stop,
+          [&](const DocumentKey& key, ListenSequenceNumber sequence_number) {
+            if (sequence_number <= upper_bound && !IsPinned(key)) {
+              count++;
+              db_->remote_document_cache()->Remove(key);
+              RemoveSentinel(key);
+            } else {
+              kept_callback(sequence_number);
+            }
+          });
+  *removed_count = count;
+  return last_visited;
+}
+
+void LevelDbLruReferenceDelegate::SaveSequenceNumberHistogram(
+    const SequenceNumberHistogram& histogram) {
+  db_->current_transaction()->Put(LevelDbSequenceNumberHistogramKey::Key(),
+                                  histogram.Encode());
+}
+
 int LevelDbLruReferenceDelegate::RemoveTargets(
     ListenSequenceNumber sequence_number, const LiveQueryMap& live_queries) {
   return static_cast<int>(
@@ -66,6 +66,15 @@ class LevelDbLruReferenceDelegate : public LruDelegate {
       const OrphanedDocumentCallback& callback) override;
 
   int RemoveOrphanedDocuments(model::ListenSequenceNumber upper_bound) override;
+  absl::optional<model::DocumentKey> RemoveOrphanedDocumentsUntil(
+      model::ListenSequenceNumber upper_bound,
+      const absl::optional<model::DocumentKey>& start_after,
+      LruDeadline deadline,
+      const SequenceNumberCallback& kept_callback,
+      int* removed_count) override;
+  void SaveSequenceNumberHistogram(
+      const SequenceNumberHistogram& histogram) override;
+
   int RemoveTargets(model::ListenSequenceNumber sequence_number,
                     const LiveQueryMap& live_queries) override;
 
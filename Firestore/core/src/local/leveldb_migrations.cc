@@ -57,6 +57,16 @@ void SaveVersion(LevelDbMigrations::SchemaVersion version,
   transaction->Put(key, version_string);
 }
 
+/**
+ * Drops the persisted table sizes, which LevelDbPersistence recomputes when
+ * they are missing. Neither migrations nor versions of the client that predate
+ * the sizes keep them up to date, so `RunMigrations` drops them whenever the
+ * schema version changes.
+ */
+void DropTableSizes(LevelDbTransaction* transaction) {
+  transaction->Delete(LevelDbTableSizesKey::Key());
+}
+
 void DeleteEverythingWithPrefix(const std::string& prefix, leveldb::DB* db) {
   bool more_deletes = true;
   while (more_deletes) {
@@ -370,6 +380,67 @@ void EnsureOverlayDataMigrationIsRequired(leveldb::DB* db) {
   transaction.Commit();
 }
 
+/**
+ * Migration 9.
+ *
+ * Creates LevelDbCollectionMutationKey rows for all existing rows in the
+ * document-mutation index. Versions of the client that predate the index
+ * don't remove its rows along with their mutations, so any rows left from
+ * before a downgrade are dropped first.
+ */
+void EnsureCollectionMutationsIndex(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbCollectionMutationKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Ensure Collection Mutations Index");
+
+  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(mutations_prefix);
+  LevelDbDocumentMutationKey key;
+  std::string empty_buffer;
+  for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
+       it->Next()) {
+    bool decoded = key.Decode(it->key());
+    HARD_ASSERT(decoded, "Failed to decode document-mutation key");
+
+    transaction.Put(LevelDbCollectionMutationKey::Key(
+                        key.user_id(), key.document_key(), key.batch_id()),
+                    empty_buffer);
+  }
+
+  SaveVersion(9, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 10.
+ *
+ * Drops the persisted target document filter. Versions of the client that
+ * predate the filter add target documents without updating it, so a filter
+ * saved before a downgrade can't be trusted after upgrading again.
+ */
+void DropTargetDocumentFilter(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Drop target document filter");
+  transaction.Delete(LevelDbTargetDocumentFilterKey::Key());
+  SaveVersion(10, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 12.
+ *
+ * Drops the persisted sequence number histogram, which LRU garbage collection
+ * rebuilds when it is missing. Versions of the client that predate it add and
+ * remove documents without updating it, so a histogram saved before a
+ * downgrade can't be trusted after upgrading again.
+ */
+void DropSequenceNumberHistogram(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Drop sequence number histogram");
+  transaction.Delete(LevelDbSequenceNumberHistogramKey::Key());
+  SaveVersion(12, &transaction);
+  transaction.Commit();
+}
+
 }  // namespace
 
 LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
@@ -399,9 +470,10 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   SchemaVersion from_version = ReadSchemaVersion(db);
   // If this is a downgrade, just save the downgrade version so we can
   // detect it when we go to upgrade again, allowing us to rerun the
-  // data migrations.
+  // data migrations. The table sizes are dropped on any version change.
   if (from_version > to_version) {
     LevelDbTransaction transaction(db, "Save downgrade version");
+    DropTableSizes(&transaction);
     SaveVersion(to_version, &transaction);
     transaction.Commit();
     return;
@@ -433,6 +505,26 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   if (from_version < 8 && to_version >= 8) {
     EnsureOverlayDataMigrationIsRequired(db);
   }
+
+  if (from_version < 9 && to_version >= 9) {
+    EnsureCollectionMutationsIndex(db);
+  }
+
+  if (from_version < 10 && to_version >= 10) {
+    DropTargetDocumentFilter(db);
+  }
+
+  if (from_version < 12 && to_version >= 12) {
+    DropSequenceNumberHistogram(db);
+  }
+
+  // Migration 11 only drops the table sizes, which happens on every upgrade.
+  if (from_version < to_version) {
+    LevelDbTransaction transaction(db, "Drop table sizes");
+    DropTableSizes(&transaction);
+    SaveVersion(to_version, &transaction);
+    transaction.Commit();
+  }
 }
 
 }  // namespace local
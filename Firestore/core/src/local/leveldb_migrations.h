@@ -73,8 +73,16 @@ class LevelDbMigrations {
  *   * Migration 6 populates the collection_parents index.
  *   * Migration 7 rewrites query_targets canonical ids in new format.
  *   * Migration 8 kicks off overlay data migration.
+ *   * Migration 9 populates the collection_mutation index.
+ *   * Migration 10 drops the target_document_filter row, which may be stale
+ *     if an older client has written to the target cache.
+ *   * Migration 11 drops the table_sizes row, which may be stale if an older
+ *     client or another migration has written to the database. Since then,
+ *     `RunMigrations` drops the row whenever the schema version changes.
+ *   * Migration 12 drops the sequence_number_histogram row, which may be stale
+ *     if an older client has added or removed documents.
  */
-const LevelDbMigrations::SchemaVersion kSchemaVersion = 8;
+const LevelDbMigrations::SchemaVersion kSchemaVersion = 12;
 
 }  // namespace local
 }  // namespace firestore
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/local/leveldb_mutation_queue.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -179,6 +180,9 @@ MutationBatch LevelDbMutationQueue::AddMutationBatch(
     key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key(), batch_id);
     db_->current_transaction()->Put(key, empty_buffer);
 
+    key = LevelDbCollectionMutationKey::Key(user_id_, mutation.key(), batch_id);
+    db_->current_transaction()->Put(key, empty_buffer);
+
     index_manager_->AddToCollectionParentIndex(mutation.key().path().PopLast());
   }
 
@@ -206,6 +210,9 @@ void LevelDbMutationQueue::RemoveMutationBatch(const MutationBatch& batch) {
   for (const Mutation& mutation : batch.mutations()) {
     key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key(), batch_id);
     db_->current_transaction()->Delete(key);
+
+    key = LevelDbCollectionMutationKey::Key(user_id_, mutation.key(), batch_id);
+    db_->current_transaction()->Delete(key);
     db_->reference_delegate()->RemoveMutationReference(mutation.key());
   }
 }
@@ -225,10 +232,10 @@ std::vector<MutationBatch> LevelDbMutationQueue::AllMutationBatches() {
 std::vector<MutationBatch>
 LevelDbMutationQueue::AllMutationBatchesAffectingDocumentKeys(
     const DocumentKeySet& document_keys) {
-  // Take a pass through the document keys and collect the set of unique
-  // mutation batch_ids that affect them all. Some batches can affect more than
-  // one key.
-  std::set<BatchId> batch_ids;
+  // Take a pass through the document keys and collect the mutation batch_ids
+  // that affect them all. Some batches can affect more than one key, so the
+  // IDs are sorted and deduplicated below.
+  std::vector<BatchId> batch_ids;
 
   auto index_iterator = db_->current_transaction()->NewIterator();
   LevelDbDocumentMutationKey row_key;
@@ -254,10 +261,13 @@ LevelDbMutationQueue::AllMutationBatchesAffectingDocumentKeys(
         break;
       }
 
-      batch_ids.insert(row_key.batch_id());
+      batch_ids.push_back(row_key.batch_id());
     }
   }
 
+  std::sort(batch_ids.begin(), batch_ids.end());
+  batch_ids.erase(std::unique(batch_ids.begin(), batch_ids.end()),
+                  batch_ids.end());
   return AllMutationBatchesWithIds(batch_ids);
 }
 
@@ -275,58 +285,36 @@ LevelDbMutationQueue::AllMutationBatchesAffectingQuery(const Query& query) {
       !query.IsCollectionGroupQuery(),
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
-  const ResourcePath& query_path = query.path();
-  size_t immediate_children_path_length = query_path.size() + 1;
-
-  // TODO(mcg): Actually implement a single-collection query
-  //
-  // This is actually executing an ancestor query, traversing the whole subtree
-  // below the collection which can be horrifically inefficient for some
-  // structures. The right way to solve this is to implement the full value
-  // index, but that's not in the cards in the near future so this is the best
-  // we can do for the moment.
-  //
   // Since we don't yet index the actual properties in the mutations, our
   // current approach is to just return all mutation batches that affect
   // documents in the collection being queried.
   //
-  // Unlike AllMutationBatchesAffectingDocumentKey, this iteration will scan the
-  // document-mutation index for more than a single document so the associated
-  // batch_ids will be neither necessarily unique nor in order. This means an
-  // efficient simultaneous scan isn't possible.
+  // The collection-mutation index keys rows by collection and then batch_id,
+  // so the rows for the immediate children of the query path are contiguous
+  // and yield the batch_ids in ascending order. A batch that touches several
+  // documents in the collection shows up once per document, but always in
+  // adjacent rows. Rows of subcollections share the key prefix but sort after
+  // all of these (Path markers sort after BatchId markers), so the scan can
+  // stop at the first one.
+  const ResourcePath& query_path = query.path();
   std::string index_prefix =
-      LevelDbDocumentMutationKey::KeyPrefix(user_id_, query_path);
+      LevelDbCollectionMutationKey::KeyPrefix(user_id_, query_path);
   auto index_iterator = db_->current_transaction()->NewIterator();
   index_iterator->Seek(index_prefix);
 
-  LevelDbDocumentMutationKey row_key;
-
-  // Collect up unique batch_ids encountered during a scan of the index. Use a
-  // set<BatchId> to accumulate the IDs so they can be traversed in order in a
-  // scan of the main table.
-  //
-  // This method is faster than performing lookups of the keys with _db->Get and
-  // keeping a hash of batch_ids that have already been looked up. The
-  // performance difference is minor for small numbers of keys but > 30% faster
-  // for larger numbers of keys.
-  std::set<BatchId> unique_batch_ids;
+  LevelDbCollectionMutationKey row_key;
+  std::vector<BatchId> unique_batch_ids;
   for (; index_iterator->Valid(); index_iterator->Next()) {
     if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
-        !row_key.Decode(index_iterator->key())) {
+        !row_key.Decode(index_iterator->key()) ||
+        row_key.document_key().path().size() != query_path.size() + 1) {
       break;
     }
 
-    // Rows with document keys more than one segment longer than the query path
-    // can't be matches. For example, a query on 'rooms' can't match the
-    // document /rooms/abc/messages/xyx.
-    // TODO(mcg): we'll need a different scanner when we implement ancestor
-    // queries.
-    if (row_key.document_key().path().size() !=
-        immediate_children_path_length) {
-      continue;
+    if (unique_batch_ids.empty() ||
+        unique_batch_ids.back() != row_key.batch_id()) {
+      unique_batch_ids.push_back(row_key.batch_id());
     }
-
-    unique_batch_ids.insert(row_key.batch_id());
   }
 
   return AllMutationBatchesWithIds(unique_batch_ids);
@@ -414,6 +402,17 @@ void LevelDbMutationQueue::PerformConsistencyCheck() {
     dangling_mutation_references.push_back(DescribeKey(index_iterator));
   }
 
+  // The same holds for the collection-mutation index.
+  index_prefix = LevelDbCollectionMutationKey::KeyPrefix(user_id_);
+  index_iterator->Seek(index_prefix);
+  for (; index_iterator->Valid(); index_iterator->Next()) {
+    if (!absl::StartsWith(index_iterator->key(), index_prefix)) {
+      break;
+    }
+
+    dangling_mutation_references.push_back(DescribeKey(index_iterator));
+  }
+
   HARD_ASSERT(dangling_mutation_references.empty(),
               "Document leak -- detected dangling mutation references when "
               "queue is empty. Dangling keys: %s",
@@ -432,15 +431,23 @@ void LevelDbMutationQueue::SetLastStreamToken(ByteString stream_token) {
 }
 
 std::vector<MutationBatch> LevelDbMutationQueue::AllMutationBatchesWithIds(
-    const std::set<BatchId>& batch_ids) {
+    const std::vector<BatchId>& batch_ids) {
   std::vector<MutationBatch> result;
+  result.reserve(batch_ids.size());
 
-  // Given an ordered set of unique batch_ids perform a skipping scan over the
-  // main table to find the mutation batches.
+  // Given an ordered list of unique batch_ids perform a skipping scan over the
+  // main table to find the mutation batches. Batches are usually clustered, so
+  // check whether the row after the previous batch is the next one wanted
+  // before falling back to a seek.
   auto mutation_iterator = db_->current_transaction()->NewIterator();
+  bool positioned = false;
   for (BatchId batch_id : batch_ids) {
     std::string mutation_key = mutation_batch_key(batch_id);
-    mutation_iterator->Seek(mutation_key);
+    if (!positioned || !mutation_iterator->Valid() ||
+        mutation_iterator->key() != mutation_key) {
+      mutation_iterator->Seek(mutation_key);
+      positioned = true;
+    }
     if (!mutation_iterator->Valid() ||
         mutation_iterator->key() != mutation_key) {
       HARD_FAIL(
@@ -450,6 +457,7 @@ std::vector<MutationBatch> LevelDbMutationQueue::AllMutationBatchesWithIds(
     }
 
     result.push_back(ParseMutationBatch(mutation_iterator->value()));
+    mutation_iterator->Next();
   }
 
   return result;
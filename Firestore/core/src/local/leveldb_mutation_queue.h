@@ -17,7 +17,6 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_MUTATION_QUEUE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_MUTATION_QUEUE_H_
 
-#include <set>
 #include <string>
 #include <vector>
 
@@ -100,9 +99,13 @@ class LevelDbMutationQueue : public MutationQueue {
   /**
    * Constructs a vector of matching batches, sorted by batch_id to ensure that
    * multiple mutations affecting the same document key are applied in order.
+   *
+   * `batch_ids` must be sorted in ascending order and free of duplicates. The
+   * batches are read in a single forward pass over the mutations table, so
+   * runs of adjacent batch_ids cost a step of the iterator instead of a seek.
    */
   std::vector<model::MutationBatch> AllMutationBatchesWithIds(
-      const std::set<model::BatchId>& batch_ids);
+      const std::vector<model::BatchId>& batch_ids);
 
   std::string mutation_queue_key() const;
 
@@ -16,7 +16,6 @@
 
 #include "Firestore/core/src/local/leveldb_persistence.h"
 
-#include <limits>
 #include <utility>
 
 #include "Firestore/core/src/core/database_info.h"
@@ -25,6 +24,7 @@
 #include "Firestore/core/src/local/leveldb_lru_reference_delegate.h"
 #include "Firestore/core/src/local/leveldb_migrations.h"
 #include "Firestore/core/src/local/leveldb_opener.h"
+#include "Firestore/core/src/local/leveldb_table_sizes.h"
 #include "Firestore/core/src/local/leveldb_util.h"
 #include "Firestore/core/src/local/listen_sequence.h"
 #include "Firestore/core/src/local/lru_garbage_collector.h"
@@ -74,6 +74,28 @@ std::set<std::string> CollectUserSet(LevelDbTransaction* transaction) {
   return result;
 }
 
+/**
+ * Reads the persisted table sizes, computing and saving them first if they
+ * are missing. They are missing after upgrading from a version of the client
+ * that didn't track them, or after migrations that drop them because they
+ * might be stale.
+ */
+LevelDbTableSizes LoadTableSizes(DB* db, LevelDbTransaction* transaction) {
+  std::string key = LevelDbTableSizesKey::Key();
+  std::string encoded;
+  if (transaction->Get(key, &encoded).ok()) {
+    absl::optional<LevelDbTableSizes> decoded =
+        LevelDbTableSizes::Decode(encoded);
+    if (decoded) {
+      return *decoded;
+    }
+  }
+
+  LevelDbTableSizes computed = LevelDbTableSizes::Compute(db);
+  transaction->Put(key, computed.Encode());
+  return computed;
+}
+
 }  // namespace
 
 StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
@@ -96,12 +118,13 @@ StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
 
   LevelDbTransaction transaction(db.get(), "Start LevelDB");
   std::set<std::string> users = CollectUserSet(&transaction);
+  LevelDbTableSizes table_sizes = LoadTableSizes(db.get(), &transaction);
   transaction.Commit();
 
   // Explicit conversion is required to allow the StatusOr to be created.
-  std::unique_ptr<LevelDbPersistence> result(
-      new LevelDbPersistence(std::move(db), std::move(dir), std::move(users),
-                             std::move(serializer), lru_params));
+  std::unique_ptr<LevelDbPersistence> result(new LevelDbPersistence(
+      std::move(db), std::move(users), std::move(serializer), lru_params,
+      table_sizes));
   return {std::move(result)};
 }
 
@@ -112,14 +135,14 @@ StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
 }
 
 LevelDbPersistence::LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
-                                       util::Path directory,
                                        std::set<std::string> users,
                                        LocalSerializer serializer,
-                                       const LruParams& lru_params)
+                                       const LruParams& lru_params,
+                                       const LevelDbTableSizes& table_sizes)
     : db_(std::move(db)),
-      directory_(std::move(directory)),
       users_(std::move(users)),
-      serializer_(std::move(serializer)) {
+      serializer_(std::move(serializer)),
+      table_sizes_(table_sizes) {
   target_cache_ = absl::make_unique<LevelDbTargetCache>(this, &serializer_);
   document_cache_ =
       absl::make_unique<LevelDbRemoteDocumentCache>(this, &serializer_);
@@ -188,36 +211,8 @@ util::Status LevelDbPersistence::ClearPersistence(
 }
 
 StatusOr<int64_t> LevelDbPersistence::CalculateByteSize() {
-  auto* fs = Filesystem::Default();
-
-  // Accumulate the total size in an unsigned integer to avoid undefined
-  // behavior on overflow.
-  uint64_t count = 0;
-  auto iter = util::DirectoryIterator::Create(directory_);
-  for (; iter->Valid(); iter->Next()) {
-    StatusOr<int64_t> maybe_size = fs->FileSize(iter->file());
-    if (!maybe_size.ok()) {
-      return Status::FromCause("Failed to size LevelDB directory",
-                               maybe_size.status());
-    }
-
-    uint64_t old_count = count;
-    int64_t file_size = maybe_size.ValueOrDie();
-    count += file_size;
-
-    auto max_signed_value =
-        static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
-    if (count < old_count || count > max_signed_value) {
-      return Status(Error::kErrorOutOfRange,
-                    "Failed to size LevelDB: count overflowed");
-    }
-  }
-
-  if (!iter->status().ok()) {
-    return Status::FromCause("Failed to iterate over LevelDB files",
-                             iter->status());
-  }
-  return static_cast<int64_t>(count);
+  LOG_DEBUG("Calculated cache size: %s", table_sizes_.ToString());
+  return table_sizes_.total_size();
 }
 
 // MARK: - Persistence
@@ -230,6 +225,12 @@ model::ListenSequenceNumber LevelDbPersistence::current_sequence_number()
 void LevelDbPersistence::Shutdown() {
   HARD_ASSERT(started_, "LevelDbPersistence shutdown without start!");
   started_ = false;
+
+  LevelDbTransaction transaction(db_.get(), "Save target document filter");
+  transaction.TrackTableSizes(&table_sizes_);
+  target_cache_->SaveDocumentFilter(&transaction);
+  transaction.Commit();
+
   db_.reset();
 }
 
@@ -324,6 +325,7 @@ void LevelDbPersistence::RunInternal(absl::string_view label,
               "Starting a transaction while one is already in progress");
 
   transaction_ = absl::make_unique<LevelDbTransaction>(db_.get(), label);
+  transaction_->TrackTableSizes(&table_sizes_);
   reference_delegate_->OnTransactionStarted(label);
 
   block();
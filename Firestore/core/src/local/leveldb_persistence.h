@@ -31,6 +31,7 @@
 #include "Firestore/core/src/local/leveldb_mutation_queue.h"
 #include "Firestore/core/src/local/leveldb_overlay_migration_manager.h"
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/local/leveldb_table_sizes.h"
 #include "Firestore/core/src/local/leveldb_target_cache.h"
 #include "Firestore/core/src/local/leveldb_transaction.h"
 #include "Firestore/core/src/local/local_serializer.h"
@@ -74,8 +75,17 @@ class LevelDbPersistence : public Persistence {
 
   static util::Status ClearPersistence(const core::DatabaseInfo& database_info);
 
+  /**
+   * Returns the logical size of all rows in the database, as tracked in
+   * `table_sizes()`. Doesn't touch the filesystem.
+   */
   util::StatusOr<int64_t> CalculateByteSize();
 
+  /** The logical number of bytes stored in each group of tables. */
+  const LevelDbTableSizes& table_sizes() const {
+    return table_sizes_;
+  }
+
   // MARK: Persistence overrides
 
   model::ListenSequenceNumber current_sequence_number() const override;
@@ -112,10 +122,10 @@ class LevelDbPersistence : public Persistence {
   friend class LevelDbIndexManager;
 
   LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
-                     util::Path directory,
                      std::set<std::string> users,
                      LocalSerializer serializer,
-                     const LruParams& lru_params);
+                     const LruParams& lru_params,
+                     const LevelDbTableSizes& table_sizes);
 
   /**
    * The maximum number of operation per transaction.
@@ -148,10 +158,10 @@ class LevelDbPersistence : public Persistence {
 
   std::unique_ptr<leveldb::DB> db_;
 
-  util::Path directory_;
   std::set<std::string> users_;
   LocalSerializer serializer_;
   bool started_ = false;
+  LevelDbTableSizes table_sizes_;
 
   std::unique_ptr<LevelDbBundleCache> bundle_cache_;
   std::unordered_map<std::string, std::unique_ptr<LevelDbDocumentOverlayCache>>
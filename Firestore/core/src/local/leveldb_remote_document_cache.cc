@@ -16,9 +16,10 @@
 
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 
+#include <algorithm>
 #include <string>
-#include <thread>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/core/src/core/query.h"
@@ -33,7 +34,6 @@
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/util/background_queue.h"
-#include "Firestore/core/src/util/executor.h"
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/core/src/util/string_util.h"
 #include "leveldb/db.h"
@@ -55,38 +55,24 @@ using model::SnapshotVersion;
 using nanopb::Message;
 using nanopb::StringReader;
 using util::BackgroundQueue;
-using util::Executor;
 
 /**
- * An accumulator for results produced asynchronously. This accumulates
- * values in a vector to avoid contention caused by accumulating into more
- * complex structures like immutable::SortedMap.
+ * The number of documents decoded by a single task in
+ * `LevelDbRemoteDocumentCache::BatchGet()`. Large enough to amortize the cost
+ * of scheduling a task, small enough to spread a typical batch across cores.
  */
-template <typename T>
-class AsyncResults {
- public:
-  void Insert(T&& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    values_.push_back(std::move(value));
-  }
-
-  void Insert(const T& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    values_.push_back(value);
-  }
-
-  /**
-   * Returns the accumulated result, moving it out of AsyncResults. The
-   * AsyncResults object should not be reused.
-   */
-  std::vector<T> Result() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return std::move(values_);
-  }
+const size_t kDecodeChunkSize = 64;
 
- private:
-  std::vector<T> values_;
-  std::mutex mutex_;
+/**
+ * A row read from the remote_documents table that is yet to be decoded. The
+ * encoded value is stored in a buffer shared by the whole batch.
+ */
+struct PendingDocument {
+  std::string ldb_key;
+  DocumentKey key;
+  bool found = false;
+  size_t offset = 0;
+  size_t size = 0;
 };
 
 }  // namespace
@@ -94,16 +80,8 @@ class AsyncResults {
 LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
     LevelDbPersistence* db, LocalSerializer* serializer)
     : db_(db), serializer_(NOT_NULL(serializer)) {
-  auto hw_concurrency = std::thread::hardware_concurrency();
-  if (hw_concurrency == 0) {
-    // If the standard library doesn't know, guess something reasonable.
-    hw_concurrency = 4;
-  }
-  executor_ = Executor::CreateConcurrent("com.google.firebase.firestore.query",
-                                         static_cast<int>(hw_concurrency));
 }
 
-// Out of line because of unique_ptrs to incomplete types.
 LevelDbRemoteDocumentCache::~LevelDbRemoteDocumentCache() = default;
 
 void LevelDbRemoteDocumentCache::Add(const MutableDocument& document,
@@ -144,57 +122,109 @@ MutableDocument LevelDbRemoteDocumentCache::Get(const DocumentKey& key) const {
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) const {
-  BackgroundQueue tasks(executor_.get());
-  AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
-
-  LevelDbRemoteDocumentKey current_key;
-  auto it = db_->current_transaction()->NewIterator();
-
-  for (const DocumentKey& key : keys) {
-    it->Seek(LevelDbRemoteDocumentKey::Key(key));
-    if (!it->Valid() || !current_key.Decode(it->key()) ||
-        current_key.document_key() != key) {
-      results.Insert(
-          std::make_pair(key, MutableDocument::InvalidDocument(key)));
-    } else {
-      const std::string& contents = it->value();
-      tasks.Execute([this, &results, &key, contents] {
-        results.Insert(std::make_pair(key, DecodeMaybeDocument(contents, key)));
-      });
-    }
-  }
-
-  tasks.AwaitAll();
-
-  MutableDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
-  }
-  return map;
+  return BatchGet(std::vector<DocumentKey>(keys.begin(), keys.end()));
 }
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
     DocumentVersionMap&& remote_map,
     const core::Query& query,
     const model::OverlayByDocumentKeyMap& mutated_docs) const {
-  BackgroundQueue tasks(executor_.get());
-  AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
+  std::vector<DocumentKey> keys;
+  keys.reserve(remote_map.size());
   for (const auto& key_version : remote_map) {
-    tasks.Execute([this, &results, &key_version, query, &mutated_docs] {
-      auto document = Get(key_version.first).WithReadTime(key_version.second);
-      if (document.is_found_document() &&
-          // Either the document matches the given query, or it is mutated.
-          (query.Matches(document) ||
-           mutated_docs.find(key_version.first) != mutated_docs.end())) {
-        results.Insert(std::make_pair(key_version.first, std::move(document)));
+    keys.push_back(key_version.first);
+  }
+
+  return BatchGet(keys, [&](MutableDocument& document) {
+    if (!document.is_found_document()) {
+      return false;
+    }
+    document.WithReadTime(remote_map.at(document.key()));
+    // Either the document matches the given query, or it is mutated.
+    return query.Matches(document) ||
+           mutated_docs.find(document.key()) != mutated_docs.end();
+  });
+}
+
+MutableDocumentMap LevelDbRemoteDocumentCache::BatchGet(
+    const std::vector<DocumentKey>& keys,
+    const std::function<bool(MutableDocument&)>& filter) const {
+  std::vector<PendingDocument> pending;
+  pending.reserve(keys.size());
+  for (const DocumentKey& key : keys) {
+    pending.push_back({LevelDbRemoteDocumentKey::Key(key), key});
+  }
+  std::sort(pending.begin(), pending.end(),
+            [](const PendingDocument& lhs, const PendingDocument& rhs) {
+              return lhs.ldb_key < rhs.ldb_key;
+            });
+
+  // Walk the table in key order. The iterator always rests on the first row
+  // at or after the last key we looked up, so a key that sorts before that
+  // row is missing without any further work, and a key right after it is
+  // usually one `Next()` away.
+  //
+  // Values are appended straight from the iterator's pinned slice to a single
+  // buffer, which costs a handful of reallocations for the whole batch instead
+  // of two string copies per document. Only the encoded bytes share this
+  // buffer; decoding still allocates each document's fields separately.
+  std::string contents;
+  auto it = db_->current_transaction()->NewIterator();
+  bool positioned = false;
+  for (PendingDocument& document : pending) {
+    if (!positioned) {
+      it->Seek(document.ldb_key);
+      positioned = true;
+    } else if (it->Valid() && it->key() < document.ldb_key) {
+      it->Next();
+      if (it->Valid() && it->key() < document.ldb_key) {
+        it->Seek(document.ldb_key);
       }
-    });
+    }
+
+    if (it->Valid() && it->key() == document.ldb_key) {
+      absl::string_view value = it->value_view();
+      document.found = true;
+      document.offset = contents.size();
+      document.size = value.size();
+      contents.append(value.data(), value.size());
+    }
+  }
+
+  // Decode in fixed-size chunks. Every task writes to its own slots, so the
+  // results need no synchronization.
+  std::vector<absl::optional<MutableDocument>> results(pending.size());
+  auto decode_chunk = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const PendingDocument& document = pending[i];
+      MutableDocument result =
+          document.found
+              ? DecodeMaybeDocument(absl::string_view(contents).substr(
+                                        document.offset, document.size),
+                                    document.key)
+              : MutableDocument::InvalidDocument(document.key);
+      if (!filter || filter(result)) {
+        results[i] = std::move(result);
+      }
+    }
+  };
+
+  if (pending.size() <= kDecodeChunkSize) {
+    decode_chunk(0, pending.size());
+  } else {
+    BackgroundQueue tasks;
+    for (size_t begin = 0; begin < pending.size(); begin += kDecodeChunkSize) {
+      size_t end = std::min(begin + kDecodeChunkSize, pending.size());
+      tasks.Execute([&decode_chunk, begin, end] { decode_chunk(begin, end); });
+    }
+    tasks.AwaitAll();
   }
-  tasks.AwaitAll();
 
   MutableDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
+  for (auto& result : results) {
+    if (result.has_value()) {
+      map = map.insert(result->key(), std::move(result).value());
+    }
   }
   return map;
 }
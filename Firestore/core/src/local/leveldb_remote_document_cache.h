@@ -17,9 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 
-#include <memory>
+#include <functional>
 #include <string>
-#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "Firestore/core/src/core/query.h"
@@ -34,10 +33,6 @@
 namespace firebase {
 namespace firestore {
 
-namespace util {
-class Executor;
-}  // namespace util
-
 namespace model {
 class MutableDocument;
 class SnapshotVersion;
@@ -80,6 +75,24 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
   void SetIndexManager(IndexManager* manager) override;
 
  private:
+  /**
+   * Reads the documents for the given keys in a single pass over the
+   * remote_documents table.
+   *
+   * The keys are sorted in the order of their LevelDB encoding, so one
+   * iterator can step forward with `Next()` across adjacent rows and only
+   * seeks across gaps. The values are then decoded in fixed-size chunks on
+   * the shared WorkStealingPool. Keys without a row are returned as invalid
+   * documents.
+   *
+   * If `filter` is set, it is applied to each document on the decoding thread
+   * and only documents for which it returns true are returned.
+   */
+  model::MutableDocumentMap BatchGet(
+      const std::vector<model::DocumentKey>& keys,
+      const std::function<bool(model::MutableDocument&)>& filter =
+          nullptr) const;
+
   /**
    * Looks up a set of entries in the cache, returning only existing entries of
    * Type::Document together with its SnapshotVersion.
@@ -98,8 +111,6 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
   IndexManager* index_manager_ = nullptr;
   // Owned by LevelDbPersistence.
   LocalSerializer* serializer_ = nullptr;
-
-  std::unique_ptr<util::Executor> executor_;
 };
 
 }  // namespace local
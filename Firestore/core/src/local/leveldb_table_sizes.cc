@@ -0,0 +1,136 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_table_sizes.h"
+
+#include <memory>
+
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/local/leveldb_util.h"
+#include "absl/strings/str_cat.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+// The encoding is the size of each group in `LevelDbTableGroup` order, as
+// 8-byte little-endian integers.
+const size_t kFieldSize = 8;
+
+const char* GroupName(LevelDbTableGroup group) {
+  switch (group) {
+    case LevelDbTableGroup::kDocuments:
+      return "documents";
+    case LevelDbTableGroup::kTargets:
+      return "targets";
+    case LevelDbTableGroup::kMutations:
+      return "mutations";
+    case LevelDbTableGroup::kOverlays:
+      return "overlays";
+    case LevelDbTableGroup::kIndexEntries:
+      return "index_entries";
+    case LevelDbTableGroup::kOther:
+      return "other";
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+absl::optional<LevelDbTableSizes> LevelDbTableSizes::Decode(
+    absl::string_view encoded) {
+  if (encoded.size() != kGroupCount * kFieldSize) {
+    return absl::nullopt;
+  }
+
+  LevelDbTableSizes result;
+  for (size_t i = 0; i < kGroupCount; ++i) {
+    uint64_t bits = 0;
+    for (size_t j = 0; j < kFieldSize; ++j) {
+      auto byte = static_cast<uint8_t>(encoded[i * kFieldSize + j]);
+      bits |= static_cast<uint64_t>(byte) << (8 * j);
+    }
+    result.sizes_[i] = static_cast<int64_t>(bits);
+    if (result.sizes_[i] < 0) {
+      return absl::nullopt;
+    }
+  }
+  return result;
+}
+
+LevelDbTableSizes LevelDbTableSizes::Compute(leveldb::DB* db) {
+  std::string sizes_key = LevelDbTableSizesKey::Key();
+
+  LevelDbTableSizes result;
+  std::unique_ptr<leveldb::Iterator> it(
+      db->NewIterator(LevelDbTransaction::DefaultReadOptions()));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    // The sizes row doesn't account for itself.
+    if (it->key() == sizes_key) {
+      continue;
+    }
+
+    result.AddRow(MakeStringView(it->key()), it->value().size());
+  }
+  return result;
+}
+
+void LevelDbTableSizes::AddRow(absl::string_view key, size_t value_size) {
+  sizes_[static_cast<size_t>(TableGroupForKey(key))] +=
+      static_cast<int64_t>(key.size() + value_size);
+}
+
+void LevelDbTableSizes::RemoveRow(absl::string_view key, size_t value_size) {
+  sizes_[static_cast<size_t>(TableGroupForKey(key))] -=
+      static_cast<int64_t>(key.size() + value_size);
+}
+
+int64_t LevelDbTableSizes::total_size() const {
+  int64_t total = 0;
+  for (int64_t size : sizes_) {
+    total += size;
+  }
+  return total;
+}
+
+std::string LevelDbTableSizes::Encode() const {
+  std::string result;
+  result.reserve(kGroupCount * kFieldSize);
+  for (int64_t size : sizes_) {
+    auto bits = static_cast<uint64_t>(size);
+    for (size_t j = 0; j < kFieldSize; ++j) {
+      result.push_back(static_cast<char>((bits >> (8 * j)) & 0xFF));
+    }
+  }
+  return result;
+}
+
+std::string LevelDbTableSizes::ToString() const {
+  std::string result = "LevelDbTableSizes(";
+  for (size_t i = 0; i < kGroupCount; ++i) {
+    absl::StrAppend(&result, i == 0 ? "" : ", ",
+                    GroupName(static_cast<LevelDbTableGroup>(i)), "=",
+                    sizes_[i]);
+  }
+  absl::StrAppend(&result, ")");
+  return result;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TABLE_SIZES_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TABLE_SIZES_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace leveldb {
+class DB;
+}  // namespace leveldb
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * The logical number of bytes stored in each group of LevelDB tables: the sum
+ * of the sizes of the keys and values of their rows.
+ *
+ * Sizes are kept up to date by `LevelDbTransaction::Commit` as rows are written
+ * and deleted, so that the size of the cache can be checked without touching
+ * the filesystem. Logical sizes ignore LevelDB's own overhead (compression,
+ * write-ahead logs, and data that has not been compacted away yet), so they
+ * differ from the size of the files on disk.
+ */
+class LevelDbTableSizes {
+ public:
+  LevelDbTableSizes() = default;
+
+  /**
+   * Decodes sizes previously produced by `Encode`, or returns `nullopt` if
+   * `encoded` is not a valid encoding.
+   */
+  static absl::optional<LevelDbTableSizes> Decode(absl::string_view encoded);
+
+  /** Computes the sizes of all tables by reading every row in `db`. */
+  static LevelDbTableSizes Compute(leveldb::DB* db);
+
+  /** Accounts for a row being written with the given key and value size. */
+  void AddRow(absl::string_view key, size_t value_size);
+
+  /** Accounts for an existing row being deleted or overwritten. */
+  void RemoveRow(absl::string_view key, size_t value_size);
+
+  int64_t size(LevelDbTableGroup group) const {
+    return sizes_[static_cast<size_t>(group)];
+  }
+
+  /** The sum of the sizes of all table groups. */
+  int64_t total_size() const;
+
+  std::string Encode() const;
+
+  /** Returns a description of each group's size, suitable for logging. */
+  std::string ToString() const;
+
+  friend bool operator==(const LevelDbTableSizes& lhs,
+                         const LevelDbTableSizes& rhs) {
+    return lhs.sizes_ == rhs.sizes_;
+  }
+
+ private:
+  static constexpr size_t kGroupCount =
+      static_cast<size_t>(LevelDbTableGroup::kOther) + 1;
+
+  std::array<int64_t, kGroupCount> sizes_{};
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TABLE_SIZES_H_
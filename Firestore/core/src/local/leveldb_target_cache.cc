@@ -22,6 +22,7 @@
 
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
 #include "Firestore/core/src/local/leveldb_util.h"
 #include "Firestore/core/src/local/local_serializer.h"
 #include "Firestore/core/src/local/reference_delegate.h"
@@ -97,6 +98,21 @@ void LevelDbTargetCache::Start() {
     HARD_FAIL("Failed to decode last remote snapshot version, reason: '%s'",
               reader.status().ToString());
   }
+
+  std::string encoded_filter;
+  Status status = db_->ptr()->Get(StandardReadOptions(),
+                                  LevelDbTargetDocumentFilterKey::Key(),
+                                  &encoded_filter);
+  if (status.ok()) {
+    document_filter_ = DocumentKeyFilter::Decode(encoded_filter);
+    if (document_filter_) {
+      document_filter_saved_ = true;
+    } else {
+      LOG_WARN("Ignoring target document filter that failed to decode");
+    }
+  } else if (!status.IsNotFound()) {
+    LOG_WARN("Failed to read target document filter: %s", status.ToString());
+  }
 }
 
 void LevelDbTargetCache::AddTarget(const TargetData& target_data) {
@@ -255,6 +271,18 @@ void LevelDbTargetCache::AddMatchingKeys(const DocumentKeySet& keys,
     db_->current_transaction()->Put(
         LevelDbDocumentTargetKey::Key(key, target_id), empty_buffer);
     db_->reference_delegate()->AddReference(key);
+
+    if (document_filter_) {
+      document_filter_->Add(key);
+    }
+    if (rebuilt_document_filter_) {
+      rebuilt_document_filter_->Add(key);
+    }
+  }
+
+  if (document_filter_saved_ && !keys.empty()) {
+    db_->current_transaction()->Delete(LevelDbTargetDocumentFilterKey::Key());
+    document_filter_saved_ = false;
   }
 }
 
@@ -331,6 +359,10 @@ DocumentKeySet LevelDbTargetCache::GetMatchingKeys(TargetId target_id) {
 }
 
 bool LevelDbTargetCache::Contains(const DocumentKey& key) {
+  if (document_filter_ && !document_filter_->MightContain(key)) {
+    return false;
+  }
+
   // ignore sentinel rows when determining if a key belongs to a target.
   // Sentinel row just says the document exists, not that it's a member of any
   // particular target.
@@ -365,22 +397,56 @@ void LevelDbTargetCache::SetLastRemoteSnapshotVersion(SnapshotVersion version) {
 
 void LevelDbTargetCache::EnumerateOrphanedDocuments(
     const OrphanedDocumentCallback& callback) {
+  EnumerateOrphanedDocuments(
+      absl::nullopt, [] { return false; }, callback);
+}
+
+absl::optional<DocumentKey> LevelDbTargetCache::EnumerateOrphanedDocuments(
+    const absl::optional<DocumentKey>& start_after,
+    const std::function<bool()>& should_stop,
+    const OrphanedDocumentCallback& callback) {
   std::string document_target_prefix = LevelDbDocumentTargetKey::KeyPrefix();
   auto it = db_->current_transaction()->NewIterator();
-  it->Seek(document_target_prefix);
+  if (start_after) {
+    // The rows of a document sort before those of its subcollections, so
+    // skipping past the rows of `start_after` itself is enough.
+    it->Seek(LevelDbDocumentTargetKey::SentinelKey(*start_after));
+  } else {
+    it->Seek(document_target_prefix);
+  }
   ListenSequenceNumber next_to_report = 0;
   DocumentKey key_to_report;
   LevelDbDocumentTargetKey key;
+  absl::optional<DocumentKey> last_visited;
+
+  // A walk from the start begins a new filter, sized for the number of keys
+  // in the previous one, which is an upper bound unless many keys were added
+  // since it was built. Later slices of the walk keep adding to it.
+  if (!start_after) {
+    rebuilt_document_filter_ = DocumentKeyFilter(
+        document_filter_ ? static_cast<size_t>(document_filter_->added_count())
+                         : 0);
+  }
+  absl::optional<DocumentKey> last_referenced;
 
   for (; it->Valid() && absl::StartsWith(it->key(), document_target_prefix);
        it->Next()) {
     HARD_ASSERT(key.Decode(it->key()), "Failed to decode DocumentTarget key");
+    if (start_after && key.document_key() == *start_after) {
+      continue;
+    }
+
     if (key.IsSentinel()) {
       // if next_to_report is non-zero, report it, this is a new key so the last
       // one must be not be a member of any targets.
       if (next_to_report != 0) {
         callback(key_to_report, next_to_report);
       }
+      // All rows of the previous document have been visited, so this is the
+      // place to stop.
+      if (last_visited && should_stop()) {
+        return last_visited;
+      }
       // set next_to_report to be this sequence number. It's the next one we
       // might report, if we don't find any targets for this document.
       next_to_report =
@@ -390,13 +456,42 @@ void LevelDbTargetCache::EnumerateOrphanedDocuments(
       // set next_to_report to be 0, we know we don't need to report this one
       // since we found a target for it.
       next_to_report = 0;
+
+      // Rows for the same document are adjacent, so only add each key once.
+      if (rebuilt_document_filter_ &&
+          (!last_referenced || *last_referenced != key.document_key())) {
+        rebuilt_document_filter_->Add(key.document_key());
+        last_referenced = key.document_key();
+      }
     }
+    last_visited = key.document_key();
   }
   // if next_to_report is non-zero, report it. We didn't find any targets for
   // that document, and we weren't asked to stop.
   if (next_to_report != 0) {
     callback(key_to_report, next_to_report);
   }
+
+  // The walk has now seen every document referenced before it began, and
+  // `AddMatchingKeys` added the ones referenced since. A persisted copy of the
+  // previous filter remains a valid superset, so only write the new one if
+  // there is no persisted copy.
+  if (rebuilt_document_filter_) {
+    document_filter_ = std::move(rebuilt_document_filter_);
+    rebuilt_document_filter_ = absl::nullopt;
+    SaveDocumentFilter(db_->current_transaction());
+  }
+  return absl::nullopt;
+}
+
+void LevelDbTargetCache::SaveDocumentFilter(LevelDbTransaction* transaction) {
+  if (!document_filter_ || document_filter_saved_) {
+    return;
+  }
+
+  transaction->Put(LevelDbTargetDocumentFilterKey::Key(),
+                   document_filter_->Encode());
+  document_filter_saved_ = true;
 }
 
 void LevelDbTargetCache::Save(const TargetData& target_data) {
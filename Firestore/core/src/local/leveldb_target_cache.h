@@ -17,10 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TARGET_CACHE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_TARGET_CACHE_H_
 
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
+#include "Firestore/core/src/local/document_key_filter.h"
 #include "Firestore/core/src/local/target_cache.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/snapshot_version.h"
@@ -34,6 +36,7 @@ namespace firestore {
 namespace local {
 
 class LevelDbPersistence;
+class LevelDbTransaction;
 class LocalSerializer;
 class TargetData;
 
@@ -100,6 +103,9 @@ class LevelDbTargetCache : public TargetCache {
 
   /**
    * Checks to see if there are any references to a document with the given key.
+   *
+   * Keys that the document filter rules out are answered without reading from
+   * LevelDB.
    */
   bool Contains(const model::DocumentKey& key) override;
 
@@ -123,8 +129,36 @@ class LevelDbTargetCache : public TargetCache {
   // Non-interface methods
   void Start();
 
+  /**
+   * Enumerates the documents that aren't referenced by any target.
+   *
+   * Since this walks the whole document-target index, it also rebuilds the
+   * document filter from scratch, dropping keys that are no longer referenced.
+   */
   void EnumerateOrphanedDocuments(const OrphanedDocumentCallback& callback);
 
+  /**
+   * Enumerates the orphaned documents that come after `start_after` (or all of
+   * them if it's empty), calling `should_stop` after each document to check
+   * whether to stop early.
+   *
+   * A walk split this way still rebuilds the document filter: it starts over
+   * whenever `start_after` is empty and is installed once a walk completes.
+   *
+   * @return The last document visited if enumeration stopped early, or an
+   *     empty optional if all orphaned documents have been visited.
+   */
+  absl::optional<model::DocumentKey> EnumerateOrphanedDocuments(
+      const absl::optional<model::DocumentKey>& start_after,
+      const std::function<bool()>& should_stop,
+      const OrphanedDocumentCallback& callback);
+
+  /**
+   * Writes the document filter in the given transaction, unless the persisted
+   * copy is already up to date.
+   */
+  void SaveDocumentFilter(LevelDbTransaction* transaction);
+
  private:
   void Save(const TargetData& target_data);
   bool UpdateMetadata(const TargetData& target_data);
@@ -153,6 +187,27 @@ class LevelDbTargetCache : public TargetCache {
   nanopb::Message<firestore_client_TargetGlobal> metadata_;
 
   model::SnapshotVersion last_remote_snapshot_version_;
+
+  /**
+   * A filter over the documents referenced by some target, or `nullopt` if it
+   * hasn't been loaded or built yet. Keys are added as they are referenced but
+   * only dropped when the filter is rebuilt, so the filter is always a
+   * superset of the referenced documents.
+   *
+   * The persisted copy is only valid while no keys have been added since it
+   * was written: the first addition afterwards deletes it in the same
+   * transaction, so that a stale copy is never loaded after a restart.
+   */
+  absl::optional<DocumentKeyFilter> document_filter_;
+  bool document_filter_saved_ = false;
+
+  /**
+   * The filter being built by a walk over the document-target index that
+   * hasn't completed yet, or `nullopt` if there is none. Keys referenced
+   * during the walk are added to it too, since the walk may already be past
+   * them.
+   */
+  absl::optional<DocumentKeyFilter> rebuilt_document_filter_;
 };
 
 }  // namespace local
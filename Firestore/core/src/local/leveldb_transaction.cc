@@ -14,16 +14,20 @@
  * limitations under the License.
  */
 
-#include <type_traits>
-
 #include "Firestore/core/src/local/leveldb_transaction.h"
 
+#include <type_traits>
+#include <utility>
+
 #include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_table_sizes.h"
+#include "Firestore/core/src/local/leveldb_util.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "leveldb/write_batch.h"
 
 using leveldb::DB;
@@ -67,8 +71,11 @@ void LevelDbTransaction::Iterator::UpdateCurrent() {
     }
     if (is_mutation_) {
       current_ = *mutations_iter_;
+      value_loaded_ = true;
     } else {
-      current_ = {db_iter_->key().ToString(), db_iter_->value().ToString()};
+      Slice key = db_iter_->key();
+      current_.first.assign(key.data(), key.size());
+      value_loaded_ = false;
     }
   }
 }
@@ -93,9 +100,22 @@ const std::string& LevelDbTransaction::Iterator::key() const {
 
 const std::string& LevelDbTransaction::Iterator::value() const {
   HARD_ASSERT(Valid(), "value() called on invalid iterator");
+  if (!value_loaded_) {
+    Slice value = db_iter_->value();
+    current_.second.assign(value.data(), value.size());
+    value_loaded_ = true;
+  }
   return current_.second;
 }
 
+absl::string_view LevelDbTransaction::Iterator::value_view() const {
+  HARD_ASSERT(Valid(), "value_view() called on invalid iterator");
+  if (value_loaded_) {
+    return current_.second;
+  }
+  return MakeStringView(db_iter_->value());
+}
+
 bool LevelDbTransaction::Iterator::IsDeleted(leveldb::Slice slice) {
   return txn_->deletions_.find(slice.ToString()) != txn_->deletions_.end();
 }
@@ -189,9 +209,51 @@ Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
       *value = iter->second;
       return Status::OK();
     } else {
-      return db_->Get(read_options_, key_string, value);
+      Status status = db_->Get(read_options_, key_string, value);
+      if (status.ok()) {
+        RecordCommittedSize(key_string, value->size());
+      } else if (status.IsNotFound()) {
+        RecordCommittedSize(key_string, absl::nullopt);
+      }
+      return status;
+    }
+  }
+}
+
+void LevelDbTransaction::RecordCommittedSize(const std::string& key,
+                                             absl::optional<size_t> size) {
+  if (table_sizes_ != nullptr) {
+    committed_sizes_.emplace(key, size);
+  }
+}
+
+absl::optional<size_t> LevelDbTransaction::CommittedSize(
+    const std::string& key, std::unique_ptr<leveldb::Iterator>* it) {
+  auto found = committed_sizes_.find(key);
+  if (found != committed_sizes_.end()) {
+    return found->second;
+  }
+
+  // The iterator usually rests just before `key`, so adjacent keys only take
+  // a `Next()`.
+  if (!*it) {
+    it->reset(db_->NewIterator(read_options_));
+    (*it)->Seek(key);
+  } else if (!(*it)->Valid() || (*it)->key().compare(key) > 0) {
+    (*it)->Seek(key);
+  } else if ((*it)->key().compare(key) < 0) {
+    (*it)->Next();
+    if ((*it)->Valid() && (*it)->key().compare(key) < 0) {
+      (*it)->Seek(key);
     }
   }
+  HARD_ASSERT((*it)->status().ok(), "leveldb iterator reported an error: %s",
+              (*it)->status().ToString());
+
+  if ((*it)->Valid() && (*it)->key() == key) {
+    return (*it)->value().size();
+  }
+  return absl::nullopt;
 }
 
 void LevelDbTransaction::Delete(absl::string_view key) {
@@ -211,11 +273,43 @@ void LevelDbTransaction::Commit() {
     batch.Put(entry.first, entry.second);
   }
 
+  absl::optional<LevelDbTableSizes> updated_sizes;
+  if (table_sizes_ != nullptr && changed_keys() > 0) {
+    updated_sizes = *table_sizes_;
+
+    // Deleted and overwritten rows no longer count. Rows this transaction
+    // hasn't read are looked up in key order with a single iterator.
+    std::unique_ptr<leveldb::Iterator> it;
+    for (const auto& deletion : deletions_) {
+      absl::optional<size_t> old_size = CommittedSize(deletion, &it);
+      if (old_size) {
+        updated_sizes->RemoveRow(deletion, *old_size);
+      }
+    }
+    for (const auto& entry : mutations_) {
+      absl::optional<size_t> old_size = CommittedSize(entry.first, &it);
+      if (old_size) {
+        updated_sizes->RemoveRow(entry.first, *old_size);
+      }
+      updated_sizes->AddRow(entry.first, entry.second.size());
+    }
+
+    if (*updated_sizes == *table_sizes_) {
+      updated_sizes.reset();
+    } else {
+      batch.Put(LevelDbTableSizesKey::Key(), updated_sizes->Encode());
+    }
+  }
+
   LOG_DEBUG("Committing transaction: %s", ToString());
 
   Status status = db_->Write(write_options_, &batch);
   HARD_ASSERT(status.ok(), "Failed to commit transaction:\n%s\n Failed: %s",
               ToString(), status.ToString());
+
+  if (updated_sizes) {
+    *table_sizes_ = std::move(*updated_sizes);
+  }
 }
 
 std::string LevelDbTransaction::ToString() {
@@ -28,12 +28,15 @@
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/writer.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "leveldb/db.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+class LevelDbTableSizes;
+
 /**
  * LevelDBTransaction tracks pending changes to entries in leveldb, including
  * deletions. It also provides an Iterator to traverse a merged view of pending
@@ -80,6 +83,12 @@ class LevelDbTransaction {
      */
     const std::string& value() const;
 
+    /**
+     * Returns the value of the current entry without copying it out of
+     * leveldb. The view is only valid until the next call to Seek() or Next().
+     */
+    absl::string_view value_view() const;
+
    private:
     /**
      * Advances to the next non-deleted key in leveldb.
@@ -115,8 +124,10 @@ class LevelDbTransaction {
     Mutations::iterator mutations_iter_;
     // We save the current key and value so that once an iterator is Valid(), it
     // remains so at least until the next call to Seek() or Next(), even if the
-    // underlying data is deleted.
-    std::pair<std::string, std::string> current_;
+    // underlying data is deleted. Committed values are pinned by `db_iter_`
+    // until it moves, so they are only copied on the first call to value().
+    mutable std::pair<std::string, std::string> current_;
+    mutable bool value_loaded_ = false;
     // True if current_ represents an entry in the mutations_ map, rather than
     // committed data.
     bool is_mutation_;
@@ -184,6 +195,15 @@ class LevelDbTransaction {
    */
   std::unique_ptr<Iterator> NewIterator();
 
+  /**
+   * Makes `Commit` account for the rows it writes and deletes in
+   * `table_sizes`, and save the updated sizes along with the other changes.
+   * `table_sizes` must outlive this transaction.
+   */
+  void TrackTableSizes(LevelDbTableSizes* table_sizes) {
+    table_sizes_ = table_sizes;
+  }
+
   /**
    * Commits the transaction. All pending changes are written. The transaction
    * should not be used after calling this method.
@@ -193,6 +213,21 @@ class LevelDbTransaction {
   std::string ToString();
 
  private:
+  /**
+   * Remembers the size of a committed row read through `Get`, or `nullopt` if
+   * the row doesn't exist.
+   */
+  void RecordCommittedSize(const std::string& key,
+                           absl::optional<size_t> size);
+
+  /**
+   * Returns the size of the committed row for `key`, reading it with `it`
+   * unless it was already read through this transaction. Expects to be called
+   * with keys in ascending order to step `it` forward.
+   */
+  absl::optional<size_t> CommittedSize(const std::string& key,
+                                       std::unique_ptr<leveldb::Iterator>* it);
+
   leveldb::DB* db_ = nullptr;
   Mutations mutations_;
   Deletions deletions_;
@@ -200,6 +235,15 @@ class LevelDbTransaction {
   leveldb::WriteOptions write_options_;
   int32_t version_ = 0;
   std::string label_;
+  LevelDbTableSizes* table_sizes_ = nullptr;
+
+  /**
+   * The sizes of the committed rows read through `Get`, so that `Commit` can
+   * account for the rows it overwrites or deletes without reading them again.
+   * Rows visited by iterators aren't recorded, since scans usually read many
+   * more rows than they change. Only kept while table sizes are tracked.
+   */
+  std::map<std::string, absl::optional<size_t>> committed_sizes_;
 };
 
 /**
@@ -38,6 +38,7 @@
 #include "Firestore/core/src/model/overlayed_document.h"
 #include "Firestore/core/src/model/resource_path.h"
 #include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "absl/types/optional.h"
 
@@ -298,16 +299,21 @@ model::OverlayedDocumentMap LocalDocumentsView::ComputeViews(
 
 void LocalDocumentsView::RecalculateAndSaveOverlays(
     const DocumentKeySet& keys) const {
+  // The documents only live long enough to compute the overlays, so the
+  // values created while applying mutations to them can be released at once.
+  // Declared first so that it outlives `remote_docs`.
+  nanopb::Arena arena;
+
   model::MutableDocumentPtrMap docs;
   auto remote_docs = remote_document_cache_->GetAll(keys);
   for (const auto& entry : remote_docs) {
     docs[entry.first] = const_cast<MutableDocument*>(&(entry.second));
   }
-  RecalculateAndSaveOverlays(std::move(docs));
+  RecalculateAndSaveOverlays(std::move(docs), &arena);
 }
 
 model::FieldMaskMap LocalDocumentsView::RecalculateAndSaveOverlays(
-    model::MutableDocumentPtrMap&& docs) const {
+    model::MutableDocumentPtrMap&& docs, nanopb::Arena* arena) const {
   DocumentKeySet keys;
   for (const auto& doc : docs) {
     keys = keys.insert(doc.first);
@@ -321,27 +327,31 @@ model::FieldMaskMap LocalDocumentsView::RecalculateAndSaveOverlays(
   std::map<BatchId, DocumentKeySet> documents_by_batch_id;
 
   // Apply mutations from mutation queue to the documents, collecting batch id
-  // and field masks along the way.
-  for (const MutationBatch& batch : batches) {
-    for (const DocumentKey& key : batch.keys()) {
-      auto base_doc_it = docs.find(key);
-      if (base_doc_it == docs.end()) {
-        // If this batch has documents not included in passed in `docs`, skip
-        // them.
-        continue;
-      }
-      MutableDocument* base_doc = base_doc_it->second;
+  // and field masks along the way. The overlays computed below are saved, so
+  // they must not be allocated from the arena.
+  {
+    nanopb::ArenaScope arena_scope(arena);
+    for (const MutationBatch& batch : batches) {
+      for (const DocumentKey& key : batch.keys()) {
+        auto base_doc_it = docs.find(key);
+        if (base_doc_it == docs.end()) {
+          // If this batch has documents not included in passed in `docs`, skip
+          // them.
+          continue;
+        }
+        MutableDocument* base_doc = base_doc_it->second;
 
-      absl::optional<FieldMask> mask = FieldMask();
-      auto mask_it = masks.find(key);
-      if (mask_it != masks.end()) {
-        mask = mask_it->second;
+        absl::optional<FieldMask> mask = FieldMask();
+        auto mask_it = masks.find(key);
+        if (mask_it != masks.end()) {
+          mask = mask_it->second;
+        }
+        mask = batch.ApplyToLocalView(*base_doc, std::move(mask));
+        masks[key] = mask;
+        BatchId batch_id = batch.batch_id();
+        DocumentKeySet& documents = documents_by_batch_id[batch_id];
+        documents = documents.insert(key);
       }
-      mask = batch.ApplyToLocalView(*base_doc, std::move(mask));
-      masks[key] = mask;
-      BatchId batch_id = batch.batch_id();
-      DocumentKeySet& documents = documents_by_batch_id[batch_id];
-      documents = documents.insert(key);
     }
   }
 
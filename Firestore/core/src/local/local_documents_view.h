@@ -40,6 +40,10 @@ namespace core {
 class Query;
 }  // namespace core
 
+namespace nanopb {
+class Arena;
+}  // namespace nanopb
+
 namespace local {
 
 class LocalWriteResult;
@@ -215,8 +219,14 @@ class LocalDocumentsView {
       model::OverlayByDocumentKeyMap&& overlays,
       const model::DocumentKeySet& existence_state_changed) const;
 
+  /**
+   * Applies the pending mutations to `docs` in place and saves the resulting
+   * overlays. If `arena` is set, the values written while applying the
+   * mutations are allocated from it, so `docs` must not outlive it.
+   */
   model::FieldMaskMap RecalculateAndSaveOverlays(
-      model::MutableDocumentPtrMap&& docs) const;
+      model::MutableDocumentPtrMap&& docs,
+      nanopb::Arena* arena = nullptr) const;
 
   RemoteDocumentCache* remote_document_cache_;
   MutationQueue* mutation_queue_;
@@ -173,6 +173,9 @@ DocumentMap LocalStore::HandleUserChange(const User& user) {
         index_manager_);
     query_engine_->Initialize(local_documents_.get());
 
+    // The new user's mutations can change the local view of any document.
+    query_result_cache_.Clear();
+
     // Union the old/new changed keys.
     DocumentKeySet changed_keys;
     for (const std::vector<MutationBatch>* batches :
@@ -244,8 +247,10 @@ LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
     std::unordered_map<DocumentKey, Mutation, DocumentKeyHash> overlays =
         batch.ApplyToLocalDocumentSet(overlayed_documents);
     document_overlay_cache_->SaveOverlays(batch.batch_id(), overlays);
-    return LocalWriteResult::FromOverlayedDocuments(
+    LocalWriteResult result = LocalWriteResult::FromOverlayedDocuments(
         batch.batch_id(), std::move(overlayed_documents));
+    query_result_cache_.ApplyChanges(result.changes());
+    return result;
   });
 }
 
@@ -262,7 +267,9 @@ DocumentMap LocalStore::AcknowledgeBatch(
     local_documents_->RecalculateAndSaveOverlays(
         GetKeysWithTransformResults(batch_result));
 
-    return local_documents_->GetDocuments(batch.keys());
+    DocumentMap changes = local_documents_->GetDocuments(batch.keys());
+    query_result_cache_.ApplyChanges(changes);
+    return changes;
   });
 }
 
@@ -302,7 +309,9 @@ DocumentMap LocalStore::RejectBatch(BatchId batch_id) {
     document_overlay_cache_->RemoveOverlaysForBatchId(batch_id);
     local_documents_->RecalculateAndSaveOverlays(to_reject.value().keys());
 
-    return local_documents_->GetDocuments(to_reject->keys());
+    DocumentMap changes = local_documents_->GetDocuments(to_reject->keys());
+    query_result_cache_.ApplyChanges(changes);
+    return changes;
   });
 }
 
@@ -351,6 +360,9 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
           old_target_data.WithSequenceNumber(sequence_number);
       if (remote_event.target_mismatches().find(target_id) !=
           remote_event.target_mismatches().end()) {
+        // The server considers the cached results of this target to be wrong,
+        // so the next execution must not rely on them.
+        query_result_cache_.Invalidate(old_target_data.target());
         new_target_data =
             new_target_data
                 .WithResumeToken(ByteString{}, SnapshotVersion::None())
@@ -378,15 +390,22 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
       }
     }
 
-    auto result = PopulateDocumentChanges(remote_event.document_updates(),
-                                          DocumentVersionMap(),
-                                          remote_event.snapshot_version());
-
     // HACK: The only reason we allow omitting snapshot version is so we can
-    // synthesize remote events when we get permission denied errors while
-    // trying to resolve the state of a locally cached document that is in
-    // limbo.
+    // synthesize remote events for documents in limbo: when we get permission
+    // denied errors while trying to resolve their state, or when they were
+    // looked up outside of the watch stream. In the latter case, documents are
+    // stored at the time the lookup read them.
     const SnapshotVersion& remote_version = remote_event.snapshot_version();
+    DocumentVersionMap document_versions;
+    if (remote_version == SnapshotVersion::None()) {
+      for (const auto& kv : remote_event.document_updates()) {
+        document_versions.emplace(kv.first, kv.second.read_time());
+      }
+    }
+
+    auto result = PopulateDocumentChanges(remote_event.document_updates(),
+                                          document_versions, remote_version);
+
     if (remote_version != SnapshotVersion::None()) {
       HARD_ASSERT(remote_version >= last_remote_version,
                   "Watch stream reverted to previous snapshot?? (%s < %s)",
@@ -394,9 +413,11 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
       target_cache_->SetLastRemoteSnapshotVersion(remote_version);
     }
 
-    return local_documents_->GetLocalViewOfDocuments(
+    DocumentMap changes = local_documents_->GetLocalViewOfDocuments(
         std::move(result.changed_docs),
         std::move(result.existence_changed_keys));
+    query_result_cache_.ApplyChanges(changes);
+    return changes;
   });
 }
 
@@ -564,11 +585,32 @@ QueryResult LocalStore::ExecuteQuery(const Query& query,
       remote_keys = target_cache_->GetMatchingKeys(target_data->target_id());
     }
 
+    bool cacheable =
+        query_result_cache_enabled_ && QueryResultCache::IsCacheable(query);
+    if (cacheable) {
+      absl::optional<DocumentKeySet> cached_keys =
+          query_result_cache_.Get(query);
+      if (cached_keys) {
+        // Garbage collection can remove documents without reporting them as
+        // changes, so each document is checked again.
+        DocumentMap documents;
+        for (const auto& kv : local_documents_->GetDocuments(*cached_keys)) {
+          if (query.Matches(kv.second)) {
+            documents = documents.insert(kv.first, kv.second);
+          }
+        }
+        return QueryResult(std::move(documents), std::move(remote_keys));
+      }
+    }
+
     model::DocumentMap documents = query_engine_->GetDocumentsMatchingQuery(
         query,
         use_previous_results ? last_limbo_free_snapshot_version
                              : SnapshotVersion::None(),
         use_previous_results ? remote_keys : DocumentKeySet{});
+    if (cacheable) {
+      query_result_cache_.Put(query, documents);
+    }
     return QueryResult(std::move(documents), std::move(remote_keys));
   });
 }
@@ -585,6 +627,15 @@ LruResults LocalStore::CollectGarbage(LruGarbageCollector* garbage_collector) {
   });
 }
 
+absl::optional<LruResults> LocalStore::CollectGarbageStep(
+    LruGarbageCollector* garbage_collector,
+    std::chrono::milliseconds duration) {
+  LruDeadline deadline = std::chrono::steady_clock::now() + duration;
+  return persistence_->Run("Collect garbage step", [&] {
+    return garbage_collector->CollectStep(target_data_by_target_, deadline);
+  });
+}
+
 int LocalStore::Backfill() const {
   return persistence_->Run("Backfill Indexes", [&] {
     return index_backfiller_->WriteIndexEntries(this);
@@ -607,6 +658,14 @@ void LocalStore::SaveBundle(const bundle::BundleMetadata& metadata) {
 
 DocumentMap LocalStore::ApplyBundledDocuments(
     const MutableDocumentMap& bundled_documents, const std::string& bundle_id) {
+  return ApplyBundledDocumentsChunk(bundled_documents, bundle_id,
+                                    /*first_chunk=*/true);
+}
+
+DocumentMap LocalStore::ApplyBundledDocumentsChunk(
+    const MutableDocumentMap& bundled_documents,
+    const std::string& bundle_id,
+    bool first_chunk) {
   // Allocates a target to hold all document keys from the bundle, such that
   // they will not get garbage collected right away.
   TargetData umbrella_target = AllocateTarget(NewUmbrellaTarget(bundle_id));
@@ -625,14 +684,18 @@ DocumentMap LocalStore::ApplyBundledDocuments(
       versions.emplace(key, doc.version());
     }
 
-    target_cache_->RemoveMatchingKeysForTarget(umbrella_target.target_id());
+    if (first_chunk) {
+      target_cache_->RemoveMatchingKeysForTarget(umbrella_target.target_id());
+    }
     target_cache_->AddMatchingKeys(keys, umbrella_target.target_id());
 
     auto result = PopulateDocumentChanges(document_updates, versions,
                                           SnapshotVersion::None());
-    return local_documents_->GetLocalViewOfDocuments(
+    DocumentMap changes = local_documents_->GetLocalViewOfDocuments(
         std::move(result.changed_docs),
         std::move(result.existence_changed_keys));
+    query_result_cache_.ApplyChanges(changes);
+    return changes;
   });
 }
 
@@ -703,6 +766,13 @@ void LocalStore::SetIndexAutoCreationEnabled(bool is_enabled) const {
   query_engine_->SetIndexAutoCreationEnabled(is_enabled);
 }
 
+void LocalStore::SetQueryResultCacheEnabled(bool is_enabled) {
+  query_result_cache_enabled_ = is_enabled;
+  if (!is_enabled) {
+    query_result_cache_.Clear();
+  }
+}
+
 void LocalStore::DeleteAllFieldIndexes() const {
   // This step is not wrapped in `persistence_->Run()`.
   // The reason is `persistence_->Run()` always assume each operation is
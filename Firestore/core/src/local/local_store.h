@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LOCAL_STORE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LOCAL_STORE_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -28,6 +29,7 @@
 #include "Firestore/core/src/core/target_id_generator.h"
 #include "Firestore/core/src/local/document_overlay_cache.h"
 #include "Firestore/core/src/local/overlay_migration_manager.h"
+#include "Firestore/core/src/local/query_result_cache.h"
 #include "Firestore/core/src/local/reference_set.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/document.h"
@@ -250,6 +252,15 @@ class LocalStore : public bundle::BundleCallback {
 
   LruResults CollectGarbage(LruGarbageCollector* garbage_collector);
 
+  /**
+   * Runs a slice of garbage collection for at most `duration`. Returns the
+   * results once the collection is done, or an empty optional if more steps
+   * are needed. See `LruGarbageCollector::CollectStep`.
+   */
+  absl::optional<LruResults> CollectGarbageStep(
+      LruGarbageCollector* garbage_collector,
+      std::chrono::milliseconds duration);
+
   /**
    * Runs a single backfill operation and returns the number of documents
    * processed.
@@ -276,6 +287,16 @@ class LocalStore : public bundle::BundleCallback {
       const model::MutableDocumentMap& documents,
       const std::string& bundle_id) override;
 
+  /**
+   * Applies one chunk of the documents from a bundle, in its own transaction.
+   * The documents of previous chunks stay in the bundle's umbrella target,
+   * unless this is the `first_chunk`.
+   */
+  model::DocumentMap ApplyBundledDocumentsChunk(
+      const model::MutableDocumentMap& documents,
+      const std::string& bundle_id,
+      bool first_chunk) override;
+
   /** Saves the given `NamedQuery` to local persistence. */
   void SaveNamedQuery(const bundle::NamedQuery& query,
                       const model::DocumentKeySet& keys) override;
@@ -290,6 +311,13 @@ class LocalStore : public bundle::BundleCallback {
 
   void SetIndexAutoCreationEnabled(bool is_enabled) const;
 
+  /**
+   * Enables or disables caching the matching keys of queries without a limit,
+   * so that executing such a query again only reads the documents in its
+   * result. Disabled by default.
+   */
+  void SetQueryResultCacheEnabled(bool is_enabled);
+
   void DeleteAllFieldIndexes() const;
 
  private:
@@ -422,6 +450,13 @@ class LocalStore : public bundle::BundleCallback {
    */
   std::unique_ptr<LocalDocumentsView> local_documents_;
 
+  /**
+   * The keys of the documents matching recently executed queries. Kept in sync
+   * with every change to the local view of documents.
+   */
+  QueryResultCache query_result_cache_;
+  bool query_result_cache_enabled_ = false;
+
   /**
    * Implements the steps for backfilling indexes.
    */
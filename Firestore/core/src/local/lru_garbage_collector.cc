@@ -114,10 +114,10 @@ StatusOr<int64_t> LruGarbageCollector::CalculateByteSize() const {
   return delegate_->CalculateByteSize();
 }
 
-LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
+bool LruGarbageCollector::ShouldCollect() const {
   if (params_.min_bytes_threshold == Settings::CacheSizeUnlimited) {
     LOG_DEBUG("Garbage collection skipped; disabled");
-    return LruResults::DidNotRun();
+    return false;
   }
 
   StatusOr<int64_t> maybe_current_size = CalculateByteSize();
@@ -126,7 +126,7 @@ LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
         "Garbage collection skipped; failed to estimate the size of the "
         "cache: %s",
         maybe_current_size.status().ToString());
-    return LruResults::DidNotRun();
+    return false;
   }
 
   int64_t current_size = maybe_current_size.ValueOrDie();
@@ -135,13 +135,80 @@ LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
     LOG_DEBUG(
         "Garbage collection skipped; Cache size %s is lower than threshold %s",
         current_size, params_.min_bytes_threshold);
-    return LruResults::DidNotRun();
+    return false;
   }
 
   LOG_DEBUG("Running garbage collection on cache of size: %s", current_size);
+  return true;
+}
+
+LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
+  if (!ShouldCollect()) {
+    return LruResults::DidNotRun();
+  }
+
   return RunGarbageCollection(live_targets);
 }
 
+absl::optional<LruResults> LruGarbageCollector::CollectStep(
+    const LiveQueryMap& live_targets, LruDeadline deadline) {
+  if (!pass_) {
+    if (!ShouldCollect()) {
+      return LruResults::DidNotRun();
+    }
+
+    int sequence_numbers =
+        QueryCountForPercentile(params_.percentile_to_collect);
+    if (sequence_numbers > params_.maximum_sequence_numbers_to_collect) {
+      sequence_numbers = params_.maximum_sequence_numbers_to_collect;
+    }
+    ListenSequenceNumber upper_bound =
+        SequenceNumberForQueryCount(sequence_numbers);
+    int targets_removed = RemoveTargets(upper_bound, live_targets);
+    pass_.emplace(sequence_numbers, upper_bound, targets_removed);
+  }
+
+  int documents_removed = 0;
+  pass_->resume_after = delegate_->RemoveOrphanedDocumentsUntil(
+      pass_->upper_bound, pass_->resume_after, deadline,
+      [this](ListenSequenceNumber sequence_number) {
+        pass_->kept.Add(sequence_number);
+      },
+      &documents_removed);
+  pass_->documents_removed += documents_removed;
+  if (pass_->resume_after) {
+    return absl::nullopt;
+  }
+
+  LruResults results{/* did_run= */ true, pass_->sequence_numbers,
+                     pass_->targets_removed, pass_->documents_removed};
+  if (params_.use_sequence_number_histogram) {
+    histogram_ = std::move(pass_->kept);
+    delegate_->SaveSequenceNumberHistogram(*histogram_);
+  }
+  pass_.reset();
+
+  LOG_DEBUG("LRU Garbage Collection: removed %s targets and %s documents",
+            results.targets_removed, results.documents_removed);
+  return results;
+}
+
+void LruGarbageCollector::RecordDocumentSequenceNumber(
+    ListenSequenceNumber sequence_number) {
+  if (histogram_) {
+    histogram_->Add(sequence_number);
+  }
+  // Documents that were already visited by the ongoing collection won't be
+  // visited again, so count them as survivors.
+  if (pass_) {
+    pass_->kept.Add(sequence_number);
+  }
+}
+
+void LruGarbageCollector::RestoreHistogram(SequenceNumberHistogram histogram) {
+  histogram_ = std::move(histogram);
+}
+
 LruResults LruGarbageCollector::RunGarbageCollection(
     const LiveQueryMap& live_targets) {
   Timestamp start = Timestamp::Now();
@@ -160,7 +227,21 @@ LruResults LruGarbageCollector::RunGarbageCollection(
   int num_targets_removed = RemoveTargets(upper_bound, live_targets);
   Timestamp removed_targets = Timestamp::Now();
 
-  int num_documents_removed = RemoveOrphanedDocuments(upper_bound);
+  int num_documents_removed = 0;
+  if (params_.use_sequence_number_histogram) {
+    // Rebuild the histogram from the orphaned documents that survive.
+    SequenceNumberHistogram kept;
+    delegate_->RemoveOrphanedDocumentsUntil(
+        upper_bound, absl::nullopt, LruDeadline::max(),
+        [&kept](ListenSequenceNumber sequence_number) {
+          kept.Add(sequence_number);
+        },
+        &num_documents_removed);
+    histogram_ = std::move(kept);
+    delegate_->SaveSequenceNumberHistogram(*histogram_);
+  } else {
+    num_documents_removed = RemoveOrphanedDocuments(upper_bound);
+  }
   Timestamp removed_documents = Timestamp::Now();
 
   std::string desc = "LRU Garbage Collection:\n";
@@ -185,7 +266,11 @@ LruResults LruGarbageCollector::RunGarbageCollection(
 }
 
 int LruGarbageCollector::QueryCountForPercentile(int percentile) {
-  size_t total_count = delegate_->GetSequenceNumberCount();
+  absl::optional<SequenceNumberHistogram> histogram =
+      SequenceNumberHistogramForQueries();
+  size_t total_count = histogram
+                           ? static_cast<size_t>(histogram->total_count())
+                           : delegate_->GetSequenceNumberCount();
   return static_cast<int>((percentile / 100.0f) * total_count);
 }
 
@@ -195,6 +280,12 @@ ListenSequenceNumber LruGarbageCollector::SequenceNumberForQueryCount(
     return kListenSequenceNumberInvalid;
   }
 
+  absl::optional<SequenceNumberHistogram> histogram =
+      SequenceNumberHistogramForQueries();
+  if (histogram) {
+    return histogram->NthSequenceNumber(query_count);
+  }
+
   RollingSequenceNumberBuffer buffer(query_count);
 
   delegate_->EnumerateTargetSequenceNumbers(
@@ -202,14 +293,36 @@ ListenSequenceNumber LruGarbageCollector::SequenceNumberForQueryCount(
         buffer.AddElement(sequence_number);
       });
 
+  // Populate the histogram while all orphaned documents are enumerated anyway.
+  SequenceNumberHistogram orphaned;
   delegate_->EnumerateOrphanedDocuments(
-      [&buffer](const DocumentKey&, ListenSequenceNumber sequence_number) {
+      [&](const DocumentKey&, ListenSequenceNumber sequence_number) {
         buffer.AddElement(sequence_number);
+        orphaned.Add(sequence_number);
       });
+  if (params_.use_sequence_number_histogram) {
+    histogram_ = std::move(orphaned);
+  }
 
   return buffer.max_value();
 }
 
+absl::optional<SequenceNumberHistogram>
+LruGarbageCollector::SequenceNumberHistogramForQueries() {
+  if (!params_.use_sequence_number_histogram || !histogram_) {
+    return absl::nullopt;
+  }
+
+  // Targets are few and their sequence numbers change all the time, so they
+  // are enumerated rather than tracked.
+  SequenceNumberHistogram result = *histogram_;
+  delegate_->EnumerateTargetSequenceNumbers(
+      [&result](ListenSequenceNumber sequence_number) {
+        result.Add(sequence_number);
+      });
+  return result;
+}
+
 int LruGarbageCollector::RemoveTargets(ListenSequenceNumber sequence_number,
                                        const LiveQueryMap& live_queries) {
   return delegate_->RemoveTargets(sequence_number, live_queries);
@@ -17,13 +17,17 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LRU_GARBAGE_COLLECTOR_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LRU_GARBAGE_COLLECTOR_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <unordered_map>
 
 #include "Firestore/core/src/local/reference_delegate.h"
+#include "Firestore/core/src/local/sequence_number_histogram.h"
 #include "Firestore/core/src/local/target_cache.h"
 #include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/types.h"
 #include "Firestore/core/src/util/status_fwd.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -45,6 +49,14 @@ struct LruParams {
   int64_t min_bytes_threshold;
   int percentile_to_collect;
   int maximum_sequence_numbers_to_collect;
+
+  /**
+   * Whether to find the sequence number cutoff for a collection from a
+   * histogram of the sequence numbers of orphaned documents, instead of
+   * enumerating all orphaned documents. The histogram is approximate, but
+   * finding the cutoff only takes time proportional to the number of targets.
+   */
+  bool use_sequence_number_histogram = false;
 };
 
 struct LruResults {
@@ -60,6 +72,8 @@ struct LruResults {
 
 using LiveQueryMap = std::unordered_map<model::TargetId, TargetData>;
 
+using LruDeadline = std::chrono::steady_clock::time_point;
+
 /**
  * Persistence layers intending to use LRU Garbage collection should implement
  * this interface. This interface defines the operations that the LRU garbage
@@ -98,6 +112,29 @@ class LruDelegate : public ReferenceDelegate {
   virtual int RemoveOrphanedDocuments(
       model::ListenSequenceNumber sequence_number) = 0;
 
+  /**
+   * Like `RemoveOrphanedDocuments`, but only visits the orphaned documents
+   * that come after `start_after` (or all of them if it's empty), and stops
+   * early once `deadline` has passed. The sequence numbers of visited orphaned
+   * documents that are kept are passed to `kept_callback`.
+   *
+   * @return The key to pass as `start_after` to continue, or an empty optional
+   *     if all orphaned documents have been visited.
+   */
+  virtual absl::optional<model::DocumentKey> RemoveOrphanedDocumentsUntil(
+      model::ListenSequenceNumber upper_bound,
+      const absl::optional<model::DocumentKey>& start_after,
+      LruDeadline deadline,
+      const SequenceNumberCallback& kept_callback,
+      int* removed_count) = 0;
+
+  /**
+   * Persists the histogram of orphaned document sequence numbers, so that it
+   * can be passed to `LruGarbageCollector::RestoreHistogram` after a restart.
+   */
+  virtual void SaveSequenceNumberHistogram(
+      const SequenceNumberHistogram& histogram) = 0;
+
   /**
    * Removes all targets that are not currently being listened to and have a
    * sequence number less than or equal to the given sequence number. Returns
@@ -147,6 +184,33 @@ class LruGarbageCollector {
 
   local::LruResults Collect(const LiveQueryMap& live_targets);
 
+  /**
+   * Performs a slice of a collection, stopping once `deadline` has passed.
+   *
+   * The first step of a collection checks whether it should run and removes
+   * targets. Each step, including the first, then removes orphaned documents
+   * until the deadline. Calling this again continues where the previous step
+   * left off, and starts a new collection once the previous one is done.
+   *
+   * @return The results of the collection once it is done, or an empty
+   *     optional if more steps are needed.
+   */
+  absl::optional<LruResults> CollectStep(const LiveQueryMap& live_targets,
+                                         LruDeadline deadline);
+
+  /**
+   * Records that a document was last used at `sequence_number`, and may be
+   * orphaned. Delegates call this whenever they update the sequence number of
+   * a document that isn't known to be referenced.
+   */
+  void RecordDocumentSequenceNumber(
+      model::ListenSequenceNumber sequence_number);
+
+  /**
+   * Restores a histogram saved by `LruDelegate::SaveSequenceNumberHistogram`.
+   */
+  void RestoreHistogram(SequenceNumberHistogram histogram);
+
   /**
    * Visible for testing only!
    */
@@ -155,12 +219,48 @@ class LruGarbageCollector {
   }
 
  private:
+  /** The state of a collection that is performed in steps. */
+  struct Pass {
+    Pass(int sequence_numbers,
+         model::ListenSequenceNumber upper_bound,
+         int targets_removed)
+        : sequence_numbers(sequence_numbers),
+          upper_bound(upper_bound),
+          targets_removed(targets_removed) {
+    }
+
+    int sequence_numbers = 0;
+    model::ListenSequenceNumber upper_bound = 0;
+    int targets_removed = 0;
+    int documents_removed = 0;
+    absl::optional<model::DocumentKey> resume_after;
+
+    // The orphaned documents that survive this collection, which become the
+    // new histogram once it's done.
+    SequenceNumberHistogram kept;
+  };
+
+  /** Returns whether the cache is large enough to warrant a collection. */
+  bool ShouldCollect() const;
+
   LruResults RunGarbageCollection(const LiveQueryMap& live_targets);
 
+  /**
+   * Returns the histogram of the sequence numbers of all targets and orphaned
+   * documents, if it's in use and populated.
+   */
+  absl::optional<SequenceNumberHistogram> SequenceNumberHistogramForQueries();
+
   // Delegate owns the LruGarbageCollector; this is a back pointer.
   LruDelegate* delegate_;
 
   LruParams params_ = LruParams::Default();
+
+  // An estimate of the sequence numbers of orphaned documents, or empty if it
+  // hasn't been populated yet.
+  absl::optional<SequenceNumberHistogram> histogram_;
+
+  absl::optional<Pass> pass_;
 };
 
 }  // namespace local
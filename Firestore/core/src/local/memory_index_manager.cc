@@ -17,6 +17,7 @@
 #include "Firestore/core/src/local/memory_index_manager.h"
 
 #include <algorithm>
+#include <memory>
 #include <set>
 #include <unordered_map>
 #include <vector>
@@ -113,6 +114,28 @@ MemoryIndexManager::GetDocumentsMatchingTarget(const core::Target&) {
   return absl::nullopt;
 }
 
+std::unique_ptr<IndexCursor> MemoryIndexManager::CreateIndexCursor(
+    const core::Target&) {
+  // Field indices are not supported with memory persistence.
+  return nullptr;
+}
+
+absl::optional<IndexStatistics> MemoryIndexManager::GetIndexStatistics(
+    const model::FieldIndex&) const {
+  return absl::nullopt;
+}
+
+absl::optional<size_t> MemoryIndexManager::GetCollectionGroupSizeEstimate(
+    const std::string&) const {
+  return absl::nullopt;
+}
+
+absl::optional<size_t> MemoryIndexManager::EstimateDocumentsMatchingTarget(
+    const core::Target&) {
+  // Field indices are not supported with memory persistence.
+  return absl::nullopt;
+}
+
 absl::optional<std::string> MemoryIndexManager::GetNextCollectionGroupToUpdate()
     const {
   return absl::nullopt;
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_MEMORY_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_INDEX_MANAGER_H_
 
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -80,6 +81,18 @@ class MemoryIndexManager : public IndexManager {
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
       const core::Target&) override;
 
+  std::unique_ptr<IndexCursor> CreateIndexCursor(
+      const core::Target&) override;
+
+  absl::optional<IndexStatistics> GetIndexStatistics(
+      const model::FieldIndex&) const override;
+
+  absl::optional<size_t> GetCollectionGroupSizeEstimate(
+      const std::string&) const override;
+
+  absl::optional<size_t> EstimateDocumentsMatchingTarget(
+      const core::Target&) override;
+
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
   void UpdateCollectionGroup(const std::string&, model::IndexOffset) override;
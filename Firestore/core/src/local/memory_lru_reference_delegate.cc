@@ -76,6 +76,7 @@ void MemoryLruReferenceDelegate::RemoveTarget(const TargetData& target_data) {
 void MemoryLruReferenceDelegate::UpdateLimboDocument(
     const model::DocumentKey& key) {
   sequence_numbers_[key] = current_sequence_number_;
+  gc_.RecordDocumentSequenceNumber(current_sequence_number_);
 }
 
 void MemoryLruReferenceDelegate::OnTransactionStarted(absl::string_view) {
@@ -131,12 +132,35 @@ int MemoryLruReferenceDelegate::RemoveOrphanedDocuments(
   return static_cast<int>(removed.size());
 }
 
+absl::optional<DocumentKey>
+MemoryLruReferenceDelegate::RemoveOrphanedDocumentsUntil(
+    ListenSequenceNumber upper_bound,
+    const absl::optional<DocumentKey>&,
+    LruDeadline,
+    const SequenceNumberCallback& kept_callback,
+    int* removed_count) {
+  // Memory caches are small and their documents are not ordered, so remove
+  // everything in a single step.
+  *removed_count = RemoveOrphanedDocuments(upper_bound);
+  EnumerateOrphanedDocuments(
+      [&](const DocumentKey&, ListenSequenceNumber sequence_number) {
+        kept_callback(sequence_number);
+      });
+  return absl::nullopt;
+}
+
+void MemoryLruReferenceDelegate::SaveSequenceNumberHistogram(
+    const SequenceNumberHistogram&) {
+  // Nothing to do, the histogram lives as long as the cache.
+}
+
 void MemoryLruReferenceDelegate::AddReference(const DocumentKey& key) {
   sequence_numbers_[key] = current_sequence_number_;
 }
 
 void MemoryLruReferenceDelegate::RemoveReference(const DocumentKey& key) {
   sequence_numbers_[key] = current_sequence_number_;
+  gc_.RecordDocumentSequenceNumber(current_sequence_number_);
 }
 
 bool MemoryLruReferenceDelegate::MutationQueuesContainKey(
@@ -153,6 +177,7 @@ bool MemoryLruReferenceDelegate::MutationQueuesContainKey(
 void MemoryLruReferenceDelegate::RemoveMutationReference(
     const DocumentKey& key) {
   sequence_numbers_[key] = current_sequence_number_;
+  gc_.RecordDocumentSequenceNumber(current_sequence_number_);
 }
 
 bool MemoryLruReferenceDelegate::IsPinnedAtSequenceNumber(
@@ -16,10 +16,15 @@
 
 #include "Firestore/core/src/local/query_engine.h"
 
+#include <algorithm>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/local/index_manager.h"
 #include "Firestore/core/src/local/local_documents_view.h"
 #include "Firestore/core/src/local/query_context.h"
 #include "Firestore/core/src/model/document.h"
@@ -44,6 +49,15 @@ static const int kDefaultIndexAutoCreationMinCollectionSize = 100;
  */
 
 static const double KDefaultRelativeIndexReadCostPerDocument = 3.4;
+
+/**
+ * The cost of reading a document by key, relative to reading it during a full
+ * collection scan. This is the [docKey, docContent] part of the indexed read
+ * cost above, without the index entry read.
+ */
+static const double kRelativeKeyLookupCostPerDocument = 2.4;
+
+static const size_t kDefaultCostBasedPlanningMinCollectionSize = 100;
 }  // namespace
 
 using core::LimitType;
@@ -62,6 +76,8 @@ void QueryEngine::Initialize(LocalDocumentsView* local_documents) {
       kDefaultIndexAutoCreationMinCollectionSize;
   relative_index_read_cost_per_document_ =
       KDefaultRelativeIndexReadCostPerDocument;
+  cost_based_planning_min_collection_size_ =
+      kDefaultCostBasedPlanningMinCollectionSize;
 }
 
 const DocumentMap QueryEngine::GetDocumentsMatchingQuery(
@@ -71,16 +87,24 @@ const DocumentMap QueryEngine::GetDocumentsMatchingQuery(
   HARD_ASSERT(local_documents_view_ && index_manager_,
               "Initialize() not called");
 
-  const absl::optional<DocumentMap> index_result =
-      PerformQueryUsingIndex(query);
-  if (index_result.has_value()) {
-    return index_result.value();
-  }
+  const QueryPlan plan =
+      Explain(query, last_limbo_free_snapshot_version, remote_keys);
+  LOG_DEBUG("Executing query %s with %s", query.ToString(), plan.ToString());
+
+  for (const QueryPlan::Candidate& candidate : plan.candidates()) {
+    absl::optional<DocumentMap> result;
+    if (candidate.strategy == QueryPlan::Strategy::IndexScan) {
+      result = PerformQueryUsingIndex(query);
+    } else if (candidate.strategy == QueryPlan::Strategy::TargetMapping) {
+      result = PerformQueryUsingRemoteKeys(query, remote_keys,
+                                           last_limbo_free_snapshot_version);
+    } else {
+      break;
+    }
 
-  const absl::optional<DocumentMap> key_result = PerformQueryUsingRemoteKeys(
-      query, remote_keys, last_limbo_free_snapshot_version);
-  if (key_result.has_value()) {
-    return key_result.value();
+    if (result.has_value()) {
+      return result.value();
+    }
   }
 
   absl::optional<QueryContext> context = QueryContext();
@@ -91,6 +115,84 @@ const DocumentMap QueryEngine::GetDocumentsMatchingQuery(
   return full_scan_result;
 }
 
+QueryPlan QueryEngine::Explain(
+    const Query& query,
+    const SnapshotVersion& last_limbo_free_snapshot_version,
+    const DocumentKeySet& remote_keys) const {
+  HARD_ASSERT(local_documents_view_ && index_manager_,
+              "Initialize() not called");
+
+  const core::Target& target = query.ToTarget();
+  const std::string collection_group = target.collection_group() != nullptr
+                                           ? *target.collection_group()
+                                           : target.path().last_segment();
+  absl::optional<size_t> collection_size =
+      index_manager_->GetCollectionGroupSizeEstimate(collection_group);
+
+  // Queries that match all documents are always cheapest as a scan. The
+  // eligibility checks mirror the ones in `PerformQueryUsingIndex()` and
+  // `PerformQueryUsingRemoteKeys()`.
+  bool use_index = false;
+  absl::optional<size_t> index_results;
+  if (!query.MatchesAllDocuments()) {
+    IndexManager::IndexType index_type = index_manager_->GetIndexType(target);
+    use_index = index_type != IndexManager::IndexType::NONE;
+    if (use_index) {
+      // Limits are not applied to partial index scans.
+      index_results = index_manager_->EstimateDocumentsMatchingTarget(
+          query.has_limit() && index_type == IndexManager::IndexType::PARTIAL
+              ? query.WithLimitToFirst(core::Target::kNoLimit).ToTarget()
+              : target);
+    }
+  }
+  bool use_target_mapping =
+      !query.MatchesAllDocuments() &&
+      last_limbo_free_snapshot_version != SnapshotVersion::None();
+
+  std::vector<QueryPlan::Candidate> candidates;
+  if (use_index) {
+    absl::optional<double> cost;
+    if (index_results.has_value()) {
+      cost = relative_index_read_cost_per_document_ * index_results.value();
+    }
+    candidates.push_back({QueryPlan::Strategy::IndexScan, cost});
+  }
+  if (use_target_mapping) {
+    candidates.push_back(
+        {QueryPlan::Strategy::TargetMapping,
+         kRelativeKeyLookupCostPerDocument * remote_keys.size()});
+  }
+  absl::optional<double> full_scan_cost;
+  if (collection_size.has_value()) {
+    full_scan_cost = static_cast<double>(collection_size.value());
+  }
+  candidates.push_back({QueryPlan::Strategy::FullScan, full_scan_cost});
+
+  // Without statistics, or for collections where the choice hardly matters, we
+  // keep the fixed order of index scan, target mapping and full scan.
+  bool cost_based =
+      collection_size.has_value() &&
+      collection_size.value() >= cost_based_planning_min_collection_size_ &&
+      (!use_index || index_results.has_value());
+  if (cost_based) {
+    std::stable_sort(
+        candidates.begin(), candidates.end(),
+        [](const QueryPlan::Candidate& lhs, const QueryPlan::Candidate& rhs) {
+          return lhs.cost.value() < rhs.cost.value();
+        });
+    // A full scan always produces a result, so nothing after it is attempted.
+    auto full_scan = std::find_if(
+        candidates.begin(), candidates.end(),
+        [](const QueryPlan::Candidate& candidate) {
+          return candidate.strategy == QueryPlan::Strategy::FullScan;
+        });
+    candidates.erase(full_scan + 1, candidates.end());
+  }
+
+  return QueryPlan(std::move(candidates), cost_based, collection_size,
+                   index_results);
+}
+
 void QueryEngine::CreateCacheIndexes(const core::Query& query,
                                      const QueryContext& context,
                                      size_t result_size) const {
@@ -153,6 +255,17 @@ absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndex(
     return PerformQueryUsingIndex(query_with_limit);
   }
 
+  if (query.has_limit()) {
+    // A full index returns documents in query order, so we only need to read
+    // as many entries as it takes to fill the limit.
+    std::unique_ptr<IndexCursor> cursor =
+        index_manager_->CreateIndexCursor(target);
+    if (cursor) {
+      return PerformLimitQueryUsingIndexCursor(
+          query, *cursor, index_manager_->GetMinOffset(target));
+    }
+  }
+
   auto keys = index_manager_->GetDocumentsMatchingTarget(target);
   HARD_ASSERT(
       keys.has_value(),
@@ -183,6 +296,46 @@ absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndex(
   return AppendRemainingResults(previous_results, query, offset);
 }
 
+DocumentMap QueryEngine::PerformLimitQueryUsingIndexCursor(
+    const Query& query,
+    IndexCursor& cursor,
+    const model::IndexOffset& offset) const {
+  // Documents updated since the offset are evaluated from their current
+  // contents. Their index entries, if any, may be stale.
+  const DocumentMap remaining_results =
+      local_documents_view_->GetDocumentsMatchingQuery(query, offset);
+
+  // Index entries of documents that did not change since the offset are
+  // accurate and in query order. The first `limit` matches among them,
+  // combined with the remaining results, therefore contain the query's result.
+  const size_t limit = static_cast<size_t>(query.limit());
+  DocumentMap results = remaining_results;
+  size_t index_matches = 0;
+  while (cursor.Valid() && index_matches < limit) {
+    DocumentKeySet batch;
+    for (; cursor.Valid() && batch.size() < limit - index_matches;
+         cursor.Next()) {
+      if (!remaining_results.contains(cursor.key())) {
+        batch = batch.insert(cursor.key());
+      }
+    }
+
+    // Documents that were deleted or no longer match since they were indexed
+    // are dropped here, and the scan continues past them.
+    for (const auto& entry : local_documents_view_->GetDocuments(batch)) {
+      const Document& doc = entry.second;
+      if (doc->is_found_document() && query.Matches(doc)) {
+        results = results.insert(doc->key(), doc);
+        ++index_matches;
+      }
+    }
+  }
+
+  LOG_DEBUG("Index scan produced %s documents for limit query: %s",
+            index_matches, query.ToString());
+  return results;
+}
+
 absl::optional<DocumentMap> QueryEngine::PerformQueryUsingRemoteKeys(
     const Query& query,
     const DocumentKeySet& remote_keys,
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_QUERY_ENGINE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_QUERY_ENGINE_H_
 
+#include "Firestore/core/src/local/query_plan.h"
 #include "Firestore/core/src/model/model_fwd.h"
 
 namespace firebase {
@@ -30,6 +31,7 @@ enum class LimitType;
 namespace local {
 
 class LocalDocumentsView;
+class IndexCursor;
 class IndexManager;
 class QueryContext;
 
@@ -61,6 +63,11 @@ class QueryContext;
  * specific optimization is not guaranteed to produce the same results as full
  * collection scans. So in these cases, query processing falls back to full
  * scans.
+ *
+ * Once the IndexManager has collected cardinality statistics for a collection
+ * group of meaningful size, the eligible modes are ordered by their estimated
+ * cost instead, so that e.g. an unselective index is skipped in favor of a
+ * full scan. `Explain()` returns the resulting QueryPlan.
  */
 class QueryEngine {
  public:
@@ -79,6 +86,15 @@ class QueryEngine {
       const model::SnapshotVersion& last_limbo_free_snapshot_version,
       const model::DocumentKeySet& remote_keys) const;
 
+  /**
+   * Returns the plan that `GetDocumentsMatchingQuery()` follows for the given
+   * arguments, without executing the query.
+   */
+  QueryPlan Explain(
+      const core::Query& query,
+      const model::SnapshotVersion& last_limbo_free_snapshot_version,
+      const model::DocumentKeySet& remote_keys) const;
+
   void SetIndexAutoCreationEnabled(bool is_enabled);
 
  private:
@@ -92,6 +108,19 @@ class QueryEngine {
   absl::optional<model::DocumentMap> PerformQueryUsingIndex(
       const core::Query& query) const;
 
+  /**
+   * Performs a limit query by pulling document keys from `cursor` in query
+   * order until the limit is satisfied.
+   *
+   * Documents that changed since `offset` may be out of place in the index.
+   * They are skipped while scanning and merged from their current contents
+   * instead, so the scan never needs to be re-run without the limit.
+   */
+  model::DocumentMap PerformLimitQueryUsingIndexCursor(
+      const core::Query& query,
+      IndexCursor& cursor,
+      const model::IndexOffset& offset) const;
+
   /**
    * Performs a query based on the target's persisted query mapping. Returns
    * nullopt if the mapping is not available or cannot be used.
@@ -151,6 +180,12 @@ class QueryEngine {
 
   double relative_index_read_cost_per_document_;
 
+  /**
+   * The planner only orders execution modes by cost for collection groups that
+   * are estimated to contain at least this many documents.
+   */
+  size_t cost_based_planning_min_collection_size_;
+
   // For testing
   void SetIndexAutoCreationMinCollectionSize(size_t new_min) {
     index_auto_creation_min_collection_size_ = new_min;
@@ -160,6 +195,11 @@ class QueryEngine {
   void SetRelativeIndexReadCostPerDocument(double new_cost) {
     relative_index_read_cost_per_document_ = new_cost;
   }
+
+  // For testing
+  void SetCostBasedPlanningMinCollectionSize(size_t new_min) {
+    cost_based_planning_min_collection_size_ = new_min;
+  }
 };
 
 }  // namespace local
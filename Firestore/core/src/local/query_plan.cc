@@ -0,0 +1,75 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/query_plan.h"
+
+#include <ostream>
+#include <sstream>
+
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+const char* ToString(QueryPlan::Strategy strategy) {
+  switch (strategy) {
+    case QueryPlan::Strategy::IndexScan:
+      return "IndexScan";
+    case QueryPlan::Strategy::TargetMapping:
+      return "TargetMapping";
+    case QueryPlan::Strategy::FullScan:
+      return "FullScan";
+  }
+
+  UNREACHABLE();
+}
+
+std::ostream& operator<<(std::ostream& os, QueryPlan::Strategy strategy) {
+  return os << ToString(strategy);
+}
+
+std::string QueryPlan::ToString() const {
+  std::ostringstream ss;
+  ss << *this;
+  return ss.str();
+}
+
+std::ostream& operator<<(std::ostream& os, const QueryPlan& plan) {
+  os << "QueryPlan(cost_based=" << (plan.cost_based_ ? "true" : "false");
+  if (plan.collection_size_estimate_.has_value()) {
+    os << ", collection_size=" << plan.collection_size_estimate_.value();
+  }
+  if (plan.index_result_estimate_.has_value()) {
+    os << ", index_results=" << plan.index_result_estimate_.value();
+  }
+  os << ", candidates=[";
+  for (size_t i = 0; i < plan.candidates_.size(); ++i) {
+    const QueryPlan::Candidate& candidate = plan.candidates_[i];
+    if (i > 0) {
+      os << ", ";
+    }
+    os << candidate.strategy;
+    if (candidate.cost.has_value()) {
+      os << "(cost=" << candidate.cost.value() << ")";
+    }
+  }
+  return os << "])";
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_QUERY_PLAN_H_
+#define FIRESTORE_CORE_SRC_LOCAL_QUERY_PLAN_H_
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Describes how the QueryEngine executes a query, similar to the output of an
+ * `EXPLAIN` statement.
+ *
+ * A plan lists every execution strategy that is eligible for the query in the
+ * order in which the QueryEngine attempts them. Strategies other than the full
+ * collection scan can decline to produce a result at execution time (e.g. when
+ * a limit query needs to be refilled), in which case the next strategy is
+ * used. The full collection scan is always the last strategy.
+ */
+class QueryPlan {
+ public:
+  enum class Strategy {
+    /** Reads the matching document keys from a client-side field index. */
+    IndexScan,
+    /** Re-uses the target-to-document mapping from the last remote snapshot. */
+    TargetMapping,
+    /** Scans and filters every document in the collection. */
+    FullScan,
+  };
+
+  /** An eligible strategy and its estimated cost. */
+  struct Candidate {
+    Strategy strategy;
+
+    /**
+     * The estimated cost in units of documents read by a full collection
+     * scan, or `nullopt` if the planner had no statistics to estimate it.
+     */
+    absl::optional<double> cost;
+  };
+
+  QueryPlan(std::vector<Candidate> candidates,
+            bool cost_based,
+            absl::optional<size_t> collection_size_estimate,
+            absl::optional<size_t> index_result_estimate)
+      : candidates_(std::move(candidates)),
+        cost_based_(cost_based),
+        collection_size_estimate_(collection_size_estimate),
+        index_result_estimate_(index_result_estimate) {
+  }
+
+  /** The strategies to attempt, in order. Always ends with `FullScan`. */
+  const std::vector<Candidate>& candidates() const {
+    return candidates_;
+  }
+
+  /** The strategy that is attempted first. */
+  Strategy strategy() const {
+    return candidates_.front().strategy;
+  }
+
+  /**
+   * Whether the candidates were ordered by estimated cost. If false, the
+   * planner lacked statistics (or the collection was too small to matter) and
+   * used the fixed order of index scan, target mapping, full scan.
+   */
+  bool cost_based() const {
+    return cost_based_;
+  }
+
+  /** The estimated number of documents in the queried collection group. */
+  const absl::optional<size_t>& collection_size_estimate() const {
+    return collection_size_estimate_;
+  }
+
+  /** The estimated number of documents read by an index scan. */
+  const absl::optional<size_t>& index_result_estimate() const {
+    return index_result_estimate_;
+  }
+
+  std::string ToString() const;
+
+  friend std::ostream& operator<<(std::ostream& os, const QueryPlan& plan);
+
+ private:
+  std::vector<Candidate> candidates_;
+  bool cost_based_ = false;
+  absl::optional<size_t> collection_size_estimate_;
+  absl::optional<size_t> index_result_estimate_;
+};
+
+const char* ToString(QueryPlan::Strategy strategy);
+
+std::ostream& operator<<(std::ostream& os, QueryPlan::Strategy strategy);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_QUERY_PLAN_H_
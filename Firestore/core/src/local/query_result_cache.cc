@@ -0,0 +1,116 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/query_result_cache.h"
+
+#include <utility>
+
+#include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using core::Query;
+using core::Target;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::DocumentMap;
+
+QueryResultCache::QueryResultCache(size_t max_entries)
+    : max_entries_(max_entries) {
+  HARD_ASSERT(max_entries_ > 0, "QueryResultCache must hold an entry");
+}
+
+bool QueryResultCache::IsCacheable(const Query& query) {
+  return !query.has_limit();
+}
+
+absl::optional<DocumentKeySet> QueryResultCache::Get(const Query& query) {
+  auto found = entries_by_id_.find(query.ToTarget().CanonicalId());
+  if (found == entries_by_id_.end()) {
+    return absl::nullopt;
+  }
+
+  entries_.splice(entries_.begin(), entries_, found->second);
+  return found->second->keys;
+}
+
+void QueryResultCache::Put(const Query& query, const DocumentMap& documents) {
+  HARD_ASSERT(IsCacheable(query), "Cannot cache the results of %s",
+              query.ToString());
+
+  DocumentKeySet keys;
+  for (const auto& kv : documents) {
+    keys = keys.insert(kv.first);
+  }
+
+  const std::string& canonical_id = query.ToTarget().CanonicalId();
+  auto found = entries_by_id_.find(canonical_id);
+  if (found != entries_by_id_.end()) {
+    found->second->keys = std::move(keys);
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return;
+  }
+
+  entries_.push_front(Entry{canonical_id, query, std::move(keys)});
+  entries_by_id_.emplace(canonical_id, entries_.begin());
+
+  if (entries_.size() > max_entries_) {
+    entries_by_id_.erase(entries_.back().canonical_id);
+    entries_.pop_back();
+  }
+}
+
+void QueryResultCache::ApplyChanges(const DocumentMap& changes) {
+  if (changes.empty()) {
+    return;
+  }
+
+  for (Entry& entry : entries_) {
+    for (const auto& kv : changes) {
+      const DocumentKey& key = kv.first;
+      const Document& document = kv.second;
+      if (entry.query.Matches(document)) {
+        entry.keys = entry.keys.insert(key);
+      } else {
+        entry.keys = entry.keys.erase(key);
+      }
+    }
+  }
+}
+
+void QueryResultCache::Invalidate(const Target& target) {
+  auto found = entries_by_id_.find(target.CanonicalId());
+  if (found == entries_by_id_.end()) {
+    return;
+  }
+
+  entries_.erase(found->second);
+  entries_by_id_.erase(found);
+}
+
+void QueryResultCache::Clear() {
+  entries_.clear();
+  entries_by_id_.clear();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_QUERY_RESULT_CACHE_H_
+#define FIRESTORE_CORE_SRC_LOCAL_QUERY_RESULT_CACHE_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/model_fwd.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Remembers the keys of the documents that match recently executed queries,
+ * so that executing the same query again only needs to look up those keys
+ * instead of scanning the collection.
+ *
+ * The results reflect the local view of the documents (i.e. with overlays
+ * applied). They are kept up to date incrementally: the LocalStore passes every
+ * set of documents whose local view changed to `ApplyChanges`, which re-matches
+ * only those documents against each cached query.
+ *
+ * Only queries without a limit are cached. The result of a limit query depends
+ * on documents outside of it, so it cannot be maintained from the changed
+ * documents alone.
+ *
+ * Entries are evicted in least recently used order once `max_entries` is
+ * exceeded. This class is not thread-safe.
+ */
+class QueryResultCache {
+ public:
+  static constexpr size_t kDefaultMaxEntries = 100;
+
+  explicit QueryResultCache(size_t max_entries = kDefaultMaxEntries);
+
+  /** Whether the results of `query` can be cached. */
+  static bool IsCacheable(const core::Query& query);
+
+  /**
+   * Returns the keys of the documents that match `query`, or `nullopt` if the
+   * query is not cached.
+   */
+  absl::optional<model::DocumentKeySet> Get(const core::Query& query);
+
+  /** Caches `documents` as the complete result of `query`. */
+  void Put(const core::Query& query, const model::DocumentMap& documents);
+
+  /**
+   * Updates the cached results for documents whose local view has changed.
+   * Each document in `changes` must be its new local view; documents that no
+   * longer exist are removed from every result.
+   */
+  void ApplyChanges(const model::DocumentMap& changes);
+
+  /** Drops the cached result of every query that maps to `target`. */
+  void Invalidate(const core::Target& target);
+
+  /** Drops all cached results. */
+  void Clear();
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    std::string canonical_id;
+    core::Query query;
+    model::DocumentKeySet keys;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  // Ordered from most to least recently used.
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> entries_by_id_;
+  size_t max_entries_ = 0;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_QUERY_RESULT_CACHE_H_
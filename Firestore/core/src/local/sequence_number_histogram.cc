@@ -0,0 +1,162 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/sequence_number_histogram.h"
+
+#include <utility>
+
+#include "Firestore/core/src/local/lru_garbage_collector.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::ListenSequenceNumber;
+
+// The encoding is the bucket width followed by a (start, count) pair for each
+// bucket, all as 8-byte little-endian integers.
+const size_t kFieldSize = 8;
+
+void AppendInt64(std::string* out, int64_t value) {
+  auto bits = static_cast<uint64_t>(value);
+  for (size_t i = 0; i < kFieldSize; ++i) {
+    out->push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+  }
+}
+
+int64_t ReadInt64(absl::string_view in) {
+  uint64_t bits = 0;
+  for (size_t i = 0; i < kFieldSize; ++i) {
+    bits |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+  }
+  return static_cast<int64_t>(bits);
+}
+
+}  // namespace
+
+SequenceNumberHistogram::SequenceNumberHistogram(size_t max_buckets)
+    : max_buckets_(max_buckets) {
+  HARD_ASSERT(max_buckets_ > 0, "SequenceNumberHistogram needs a bucket");
+}
+
+absl::optional<SequenceNumberHistogram> SequenceNumberHistogram::Decode(
+    absl::string_view encoded) {
+  if (encoded.size() < kFieldSize ||
+      (encoded.size() - kFieldSize) % (2 * kFieldSize) != 0) {
+    return absl::nullopt;
+  }
+
+  SequenceNumberHistogram result;
+  result.bucket_width_ = ReadInt64(encoded);
+  if (result.bucket_width_ <= 0) {
+    return absl::nullopt;
+  }
+
+  for (size_t pos = kFieldSize; pos < encoded.size(); pos += 2 * kFieldSize) {
+    ListenSequenceNumber start = ReadInt64(encoded.substr(pos));
+    int64_t count = ReadInt64(encoded.substr(pos + kFieldSize));
+    if (count <= 0 || result.BucketStart(start) != start) {
+      return absl::nullopt;
+    }
+    result.buckets_[start] += count;
+    result.total_count_ += count;
+  }
+
+  while (result.buckets_.size() > result.max_buckets_) {
+    result.Widen();
+  }
+  return result;
+}
+
+void SequenceNumberHistogram::Add(ListenSequenceNumber sequence_number,
+                                  int64_t count) {
+  if (count <= 0) {
+    return;
+  }
+
+  buckets_[BucketStart(sequence_number)] += count;
+  total_count_ += count;
+  if (buckets_.size() > max_buckets_) {
+    Widen();
+  }
+}
+
+void SequenceNumberHistogram::AddAll(const SequenceNumberHistogram& other) {
+  while (bucket_width_ < other.bucket_width_) {
+    Widen();
+  }
+  for (const auto& bucket : other.buckets_) {
+    Add(bucket.first, bucket.second);
+  }
+}
+
+ListenSequenceNumber SequenceNumberHistogram::NthSequenceNumber(
+    int64_t n) const {
+  if (n <= 0 || buckets_.empty()) {
+    return kListenSequenceNumberInvalid;
+  }
+
+  int64_t seen = 0;
+  for (const auto& bucket : buckets_) {
+    seen += bucket.second;
+    if (seen >= n) {
+      return bucket.first + bucket_width_ - 1;
+    }
+  }
+  return buckets_.rbegin()->first + bucket_width_ - 1;
+}
+
+std::string SequenceNumberHistogram::Encode() const {
+  std::string result;
+  result.reserve(kFieldSize * (1 + 2 * buckets_.size()));
+  AppendInt64(&result, bucket_width_);
+  for (const auto& bucket : buckets_) {
+    AppendInt64(&result, bucket.first);
+    AppendInt64(&result, bucket.second);
+  }
+  return result;
+}
+
+ListenSequenceNumber SequenceNumberHistogram::BucketStart(
+    ListenSequenceNumber sequence_number) const {
+  // Round towards negative infinity, so that every bucket is equally wide.
+  ListenSequenceNumber remainder = sequence_number % bucket_width_;
+  if (remainder < 0) {
+    remainder += bucket_width_;
+  }
+  return sequence_number - remainder;
+}
+
+void SequenceNumberHistogram::Widen() {
+  bucket_width_ *= 2;
+
+  std::map<ListenSequenceNumber, int64_t> merged;
+  for (const auto& bucket : buckets_) {
+    merged[BucketStart(bucket.first)] += bucket.second;
+  }
+  buckets_ = std::move(merged);
+
+  // A single widening may not merge enough buckets when they are sparse.
+  if (buckets_.size() > max_buckets_) {
+    Widen();
+  }
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_SEQUENCE_NUMBER_HISTOGRAM_H_
+#define FIRESTORE_CORE_SRC_LOCAL_SEQUENCE_NUMBER_HISTOGRAM_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "Firestore/core/src/model/types.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Counts sequence numbers in buckets of equal width, so that the nth smallest
+ * sequence number can be estimated in time proportional to the number of
+ * buckets rather than the number of sequence numbers.
+ *
+ * Buckets start out one sequence number wide, which makes the histogram exact.
+ * Once there are more than `max_buckets` buckets, the width is doubled and
+ * adjacent buckets are merged, so estimates are off by less than one bucket.
+ */
+class SequenceNumberHistogram {
+ public:
+  static constexpr size_t kDefaultMaxBuckets = 256;
+
+  explicit SequenceNumberHistogram(size_t max_buckets = kDefaultMaxBuckets);
+
+  /**
+   * Decodes a histogram previously produced by `Encode`, or returns `nullopt`
+   * if `encoded` is not a valid encoding.
+   */
+  static absl::optional<SequenceNumberHistogram> Decode(
+      absl::string_view encoded);
+
+  void Add(model::ListenSequenceNumber sequence_number, int64_t count = 1);
+
+  /** Adds all the counts in `other` to this histogram. */
+  void AddAll(const SequenceNumberHistogram& other);
+
+  /**
+   * Returns an upper bound for the nth smallest sequence number (counting from
+   * 1): the largest sequence number of the bucket that contains it. Returns
+   * the largest sequence number counted if `n` exceeds `total_count()`, or
+   * `kListenSequenceNumberInvalid` if the histogram is empty or `n` is 0.
+   */
+  model::ListenSequenceNumber NthSequenceNumber(int64_t n) const;
+
+  int64_t total_count() const {
+    return total_count_;
+  }
+
+  int64_t bucket_width() const {
+    return bucket_width_;
+  }
+
+  std::string Encode() const;
+
+ private:
+  model::ListenSequenceNumber BucketStart(
+      model::ListenSequenceNumber sequence_number) const;
+
+  void Widen();
+
+  size_t max_buckets_ = 0;
+  int64_t bucket_width_ = 1;
+  int64_t total_count_ = 0;
+
+  // Counts keyed by the first sequence number of each bucket.
+  std::map<model::ListenSequenceNumber, int64_t> buckets_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_SEQUENCE_NUMBER_HISTOGRAM_H_
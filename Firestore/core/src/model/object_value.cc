@@ -22,6 +22,7 @@
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
 #include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/fields_array.h"
 #include "Firestore/core/src/nanopb/message.h"
@@ -117,8 +118,9 @@ void ApplyChanges(
   auto* source_fields = parent->fields;
 
   size_t target_count = CalculateSizeOfUnion(*parent, upserts, deletes);
+  nanopb::Arena* arena = nanopb::Arena::Current();
   auto* target_fields = MakeArray<google_firestore_v1_MapValue_FieldsEntry>(
-      CheckedSize(target_count));
+      CheckedSize(target_count), arena);
 
   auto delete_it = deletes.begin();
   auto upsert_it = upserts.begin();
@@ -166,7 +168,8 @@ void ApplyChanges(
     }
 
     // Otherwise, insert the next upsert.
-    target_entry.key = MakeBytesArray(upsert_it->first);
+    target_entry.key = MakeBytesArray(upsert_it->first.data(),
+                                      upsert_it->first.size(), arena);
     target_entry.value = *(upsert_it->second.release());
     SortFields(target_entry.value);
 
@@ -180,7 +183,7 @@ void ApplyChanges(
     FreeFieldsArray(&source_fields[source_index]);
   }
 
-  free(parent->fields);
+  nanopb::Free(parent->fields);
   parent->fields = target_fields;
   parent->fields_count = CheckedSize(target_count);
 }
@@ -264,7 +264,7 @@ Message<google_firestore_v1_Value> ArrayTransform::Rep::Apply(
     // Append the elements to the end of the list
     size_t new_size = array_value->values_count + new_elements.size();
     array_value->values = nanopb::ResizeArray<google_firestore_v1_Value>(
-        array_value->values, new_size);
+        array_value->values, array_value->values_count, new_size);
     for (auto& element : new_elements) {
       array_value->values[array_value->values_count] = *element.release();
       ++array_value->values_count;
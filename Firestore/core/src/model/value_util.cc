@@ -27,6 +27,7 @@
 #include "Firestore/core/src/model/database_id.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/server_timestamp_util.h"
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
 #include "Firestore/core/src/util/comparison.h"
 #include "Firestore/core/src/util/hard_assert.h"
@@ -943,26 +944,29 @@ Message<google_firestore_v1_Value> RefValue(
 
 Message<google_firestore_v1_Value> DeepClone(
     const google_firestore_v1_Value& source) {
+  nanopb::Arena* arena = nanopb::Arena::Current();
   Message<google_firestore_v1_Value> target{source};
   switch (source.which_value_type) {
     case google_firestore_v1_Value_string_value_tag:
       target->string_value =
           source.string_value
               ? nanopb::MakeBytesArray(source.string_value->bytes,
-                                       source.string_value->size)
+                                       source.string_value->size, arena)
               : nullptr;
       break;
 
     case google_firestore_v1_Value_reference_value_tag:
-      target->reference_value = nanopb::MakeBytesArray(
-          source.reference_value->bytes, source.reference_value->size);
+      target->reference_value =
+          nanopb::MakeBytesArray(source.reference_value->bytes,
+                                 source.reference_value->size, arena);
       break;
 
     case google_firestore_v1_Value_bytes_value_tag:
       target->bytes_value =
-          source.bytes_value ? nanopb::MakeBytesArray(source.bytes_value->bytes,
-                                                      source.bytes_value->size)
-                             : nullptr;
+          source.bytes_value
+              ? nanopb::MakeBytesArray(source.bytes_value->bytes,
+                                       source.bytes_value->size, arena)
+              : nullptr;
       break;
 
     case google_firestore_v1_Value_array_value_tag:
@@ -980,8 +984,8 @@ Message<google_firestore_v1_ArrayValue> DeepClone(
     const google_firestore_v1_ArrayValue& source) {
   Message<google_firestore_v1_ArrayValue> target{source};
   target->values_count = source.values_count;
-  target->values =
-      nanopb::MakeArray<google_firestore_v1_Value>(source.values_count);
+  target->values = nanopb::MakeArray<google_firestore_v1_Value>(
+      source.values_count, nanopb::Arena::Current());
   for (pb_size_t i = 0; i < source.values_count; ++i) {
     target->values[i] = *DeepClone(source.values[i]).release();
   }
@@ -992,11 +996,12 @@ Message<google_firestore_v1_MapValue> DeepClone(
     const google_firestore_v1_MapValue& source) {
   Message<google_firestore_v1_MapValue> target{source};
   target->fields_count = source.fields_count;
+  nanopb::Arena* arena = nanopb::Arena::Current();
   target->fields = nanopb::MakeArray<google_firestore_v1_MapValue_FieldsEntry>(
-      source.fields_count);
+      source.fields_count, arena);
   for (pb_size_t i = 0; i < source.fields_count; ++i) {
-    target->fields[i].key = nanopb::MakeBytesArray(source.fields[i].key->bytes,
-                                                   source.fields[i].key->size);
+    target->fields[i].key = nanopb::MakeBytesArray(
+        source.fields[i].key->bytes, source.fields[i].key->size, arena);
     target->fields[i].value = *DeepClone(source.fields[i].value).release();
   }
   return target;
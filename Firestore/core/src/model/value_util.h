@@ -232,7 +232,12 @@ google_firestore_v1_Value MinMap();
 nanopb::Message<google_firestore_v1_Value> RefValue(
     const DatabaseId& database_id, const DocumentKey& document_key);
 
-/** Creates a copy of the contents of the Value proto. */
+/**
+ * Creates a copy of the contents of the Value proto.
+ *
+ * If an `nanopb::ArenaScope` is active, the copy (like the copies made by the
+ * overloads below) is allocated from its arena.
+ */
 nanopb::Message<google_firestore_v1_Value> DeepClone(
     const google_firestore_v1_Value& source);
 
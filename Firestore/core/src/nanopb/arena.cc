@@ -0,0 +1,140 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/arena.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+/** Chunks grow geometrically up to this size. */
+const size_t kMaxChunkSize = 1024 * 1024;
+
+const size_t kAlignment = alignof(std::max_align_t);
+
+thread_local Arena* current_arena = nullptr;
+thread_local Arena* alive_arenas = nullptr;
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+}  // namespace
+
+Arena::Arena(size_t initial_chunk_size)
+    : next_chunk_size_(AlignUp(std::max<size_t>(initial_chunk_size, 1))) {
+  next_alive_ = alive_arenas;
+  alive_arenas = this;
+}
+
+Arena::~Arena() {
+  HARD_ASSERT(current_arena != this,
+              "Arena destroyed while an ArenaScope for it is active");
+
+  Arena** link = &alive_arenas;
+  while (*link && *link != this) {
+    link = &(*link)->next_alive_;
+  }
+  HARD_ASSERT(*link == this,
+              "Arena must be destroyed on the thread that created it");
+  *link = next_alive_;
+}
+
+void* Arena::Allocate(size_t size) {
+  size = AlignUp(std::max<size_t>(size, 1));
+  if (static_cast<size_t>(limit_ - cursor_) < size) {
+    AddChunk(size);
+  }
+
+  void* result = cursor_;
+  cursor_ += size;
+  bytes_allocated_ += size;
+  return result;
+}
+
+bool Arena::Owns(const void* ptr) const {
+  if (ptr == nullptr || chunks_.empty()) {
+    return false;
+  }
+
+  const char* p = static_cast<const char*>(ptr);
+  // Find the last chunk that starts at or before `p`.
+  auto it = std::upper_bound(chunks_.begin(), chunks_.end(), p,
+                             [](const char* p, const Chunk& chunk) {
+                               return std::less<const char*>()(
+                                   p, chunk.data.get());
+                             });
+  if (it == chunks_.begin()) {
+    return false;
+  }
+  --it;
+  return std::less<const char*>()(p, it->data.get() + it->size);
+}
+
+void Arena::AddChunk(size_t min_size) {
+  size_t size = std::max(next_chunk_size_, min_size);
+  next_chunk_size_ = std::min(next_chunk_size_ * 2, kMaxChunkSize);
+
+  // Value-initialized, so every allocation starts out zeroed like `calloc`.
+  Chunk chunk;
+  chunk.data.reset(new char[size]());
+  chunk.size = size;
+  cursor_ = chunk.data.get();
+  limit_ = cursor_ + size;
+
+  auto position = std::upper_bound(
+      chunks_.begin(), chunks_.end(), chunk.data.get(),
+      [](const char* p, const Chunk& other) {
+        return std::less<const char*>()(p, other.data.get());
+      });
+  chunks_.insert(position, std::move(chunk));
+}
+
+Arena* Arena::Current() {
+  return current_arena;
+}
+
+Arena* Arena::FindOwner(const void* ptr) {
+  for (Arena* arena = alive_arenas; arena; arena = arena->next_alive_) {
+    if (arena->Owns(ptr)) {
+      return arena;
+    }
+  }
+  return nullptr;
+}
+
+bool Arena::AnyAlive() {
+  return alive_arenas != nullptr;
+}
+
+ArenaScope::ArenaScope(Arena* arena) : previous_(current_arena) {
+  current_arena = arena;
+}
+
+ArenaScope::~ArenaScope() {
+  current_arena = previous_;
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
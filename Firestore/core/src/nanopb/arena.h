@@ -0,0 +1,126 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
+#define FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * A bump allocator for the nested fields of Nanopb protos.
+ *
+ * Allocations are carved from contiguous chunks and are never freed
+ * individually; all of them are released together when the arena is destroyed.
+ * An arena only hands out memory while an `ArenaScope` for it is active on the
+ * current thread, and only to the allocation helpers that opt in (see
+ * `MakeArray` and `MakeBytesArray` in nanopb_util.h). Nanopb's own decoder
+ * always allocates from the heap.
+ *
+ * Trees may freely mix arena and heap nodes. While an arena is alive, freeing
+ * a proto on the arena's thread (for example by destroying a `Message`) skips
+ * the nodes owned by the arena and frees the others. Consequently:
+ *
+ *   * an arena is confined to the thread that created it, and
+ *   * every proto that may reference arena memory must be destroyed on that
+ *     thread before the arena is.
+ *
+ * This class is not thread-safe.
+ */
+class Arena {
+ public:
+  static constexpr size_t kDefaultInitialChunkSize = 4 * 1024;
+
+  explicit Arena(size_t initial_chunk_size = kDefaultInitialChunkSize);
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Returns `size` zeroed bytes aligned for any scalar type. The memory stays
+   * valid until the arena is destroyed.
+   */
+  void* Allocate(size_t size);
+
+  /** Whether `ptr` points into memory handed out by this arena. */
+  bool Owns(const void* ptr) const;
+
+  /** The total number of bytes handed out by `Allocate`. */
+  size_t bytes_allocated() const {
+    return bytes_allocated_;
+  }
+
+  /**
+   * Returns the arena of the innermost `ArenaScope` on the current thread, or
+   * null if there is none.
+   */
+  static Arena* Current();
+
+  /**
+   * Returns the live arena on the current thread that owns `ptr`, or null if
+   * `ptr` is heap memory (or null).
+   */
+  static Arena* FindOwner(const void* ptr);
+
+  /** Whether any arena is alive on the current thread. */
+  static bool AnyAlive();
+
+ private:
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+  };
+
+  void AddChunk(size_t min_size);
+
+  // Sorted by address so that `Owns` can binary search.
+  std::vector<Chunk> chunks_;
+  char* cursor_ = nullptr;
+  char* limit_ = nullptr;
+  size_t next_chunk_size_ = 0;
+  size_t bytes_allocated_ = 0;
+
+  // Intrusive list of the arenas alive on this thread, newest first.
+  Arena* next_alive_ = nullptr;
+};
+
+/**
+ * Makes `arena` the current arena of this thread for the lifetime of the
+ * scope. Scopes nest; passing null suspends arena allocation.
+ */
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena* arena);
+  ~ArenaScope();
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+ private:
+  Arena* previous_ = nullptr;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
@@ -16,12 +16,99 @@
 
 #include "Firestore/core/src/nanopb/message.h"
 
+#include <pb_common.h>
+
+#include "Firestore/core/src/nanopb/arena.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
 namespace firebase {
 namespace firestore {
 namespace nanopb {
+namespace {
+
+void ReleaseSkippingArenas(const pb_field_t* fields, void* dest_struct);
+
+/**
+ * Mirrors `pb_release_single_field`, except that pointers owned by a live arena
+ * are cleared instead of freed.
+ */
+void ReleaseSingleField(const pb_field_iter_t& iter) {
+  pb_type_t type = iter.pos->type;
+
+  if (PB_HTYPE(type) == PB_HTYPE_ONEOF &&
+      *static_cast<pb_size_t*>(iter.pSize) != iter.pos->tag) {
+    // Not the active member of the oneof.
+    return;
+  }
+
+  HARD_ASSERT(PB_LTYPE(type) != PB_LTYPE_EXTENSION,
+              "Extensions are not supported");
+
+  if (PB_LTYPE(type) == PB_LTYPE_SUBMESSAGE) {
+    void* item = iter.pData;
+    pb_size_t count = 1;
+    if (PB_ATYPE(type) == PB_ATYPE_POINTER) {
+      item = *static_cast<void**>(iter.pData);
+    }
+    if (PB_HTYPE(type) == PB_HTYPE_REPEATED) {
+      count = *static_cast<pb_size_t*>(iter.pSize);
+      if (PB_ATYPE(type) == PB_ATYPE_STATIC && count > iter.pos->array_size) {
+        count = iter.pos->array_size;
+      }
+    }
+    if (item) {
+      const auto* submessage_fields =
+          static_cast<const pb_field_t*>(iter.pos->ptr);
+      while (count--) {
+        ReleaseSkippingArenas(submessage_fields, item);
+        item = static_cast<char*>(item) + iter.pos->data_size;
+      }
+    }
+  }
+
+  if (PB_ATYPE(type) == PB_ATYPE_POINTER) {
+    if (PB_HTYPE(type) == PB_HTYPE_REPEATED &&
+        (PB_LTYPE(type) == PB_LTYPE_STRING ||
+         PB_LTYPE(type) == PB_LTYPE_BYTES)) {
+      void** item = *static_cast<void***>(iter.pData);
+      pb_size_t count = *static_cast<pb_size_t*>(iter.pSize);
+      while (item && count--) {
+        Free(*item);
+        *item++ = nullptr;
+      }
+    }
+
+    if (PB_HTYPE(type) == PB_HTYPE_REPEATED) {
+      *static_cast<pb_size_t*>(iter.pSize) = 0;
+    }
+
+    Free(*static_cast<void**>(iter.pData));
+    *static_cast<void**>(iter.pData) = nullptr;
+  }
+}
+
+void ReleaseSkippingArenas(const pb_field_t* fields, void* dest_struct) {
+  pb_field_iter_t iter;
+  if (!dest_struct || !pb_field_iter_begin(&iter, fields, dest_struct)) {
+    return;
+  }
+
+  do {
+    ReleaseSingleField(iter);
+  } while (pb_field_iter_next(&iter));
+}
+
+}  // namespace
 
 void FreeNanopbMessage(const pb_field_t* fields, void* dest_struct) {
-  pb_release(fields, dest_struct);
+  // Nanopb frees every pointer it finds, so it can only be used when no arena
+  // on this thread could own part of the tree.
+  if (Arena::AnyAlive()) {
+    ReleaseSkippingArenas(fields, dest_struct);
+  } else {
+    pb_release(fields, dest_struct);
+  }
 }
 
 }  // namespace nanopb
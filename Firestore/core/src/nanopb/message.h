@@ -34,7 +34,8 @@ namespace nanopb {
 /**
  * Free the dynamically-allocated memory within a Nanopb-generated message.
  *
- * This essentially wraps calls to Nanopb's `pb_release()` function.
+ * This essentially wraps calls to Nanopb's `pb_release()` function. While an
+ * `Arena` is alive on the current thread, fields owned by it are skipped.
  */
 void FreeNanopbMessage(const pb_field_t* fields, void* dest_struct);
 
@@ -55,6 +56,10 @@ class Message;
  * Even without doing deep copies, Nanopb protos contain *a lot* of member
  * variables (at the time of writing, the largest `sizeof` of a Nanopb proto was
  * 248).
+ *
+ * Nested fields of a `Message` may be allocated from an `Arena` (see arena.h).
+ * Such a `Message` must be destroyed before the arena, on the arena's thread;
+ * destroying it leaves the arena-owned fields for the arena to release.
  */
 template <typename T>
 class Message {
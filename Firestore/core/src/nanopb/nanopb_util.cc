@@ -17,6 +17,7 @@
 #include "Firestore/core/src/nanopb/nanopb_util.h"
 
 #include <cstdlib>
+#include <cstring>
 
 #include "Firestore/core/src/util/hard_assert.h"
 
@@ -38,6 +39,12 @@ pb_bytes_array_t* _Nullable CopyBytesArray(
 
 pb_bytes_array_t* _Nullable MakeBytesArray(const void* _Nullable data,
                                            size_t size) {
+  return MakeBytesArray(data, size, /*arena=*/nullptr);
+}
+
+pb_bytes_array_t* _Nullable MakeBytesArray(const void* _Nullable data,
+                                           size_t size,
+                                           Arena* _Nullable arena) {
   if (size == 0) return nullptr;
 
   pb_size_t pb_size = CheckedSize(size);
@@ -48,8 +55,9 @@ pb_bytes_array_t* _Nullable MakeBytesArray(const void* _Nullable data,
   // essentially just to make debugging easier--actual user data can have
   // embedded nulls so we shouldn't be using this as a C string under normal
   // circumstances.
+  size_t alloc_size = PB_BYTES_ARRAY_T_ALLOCSIZE(pb_size + 1);
   auto result = static_cast<pb_bytes_array_t*>(
-      std::malloc(PB_BYTES_ARRAY_T_ALLOCSIZE(pb_size + 1)));
+      arena ? arena->Allocate(alloc_size) : std::malloc(alloc_size));
   result->size = pb_size;
   std::memcpy(result->bytes, data, pb_size);
   result->bytes[pb_size] = '\0';
@@ -57,6 +65,11 @@ pb_bytes_array_t* _Nullable MakeBytesArray(const void* _Nullable data,
   return result;
 }
 
+void Free(void* _Nullable ptr) {
+  if (Arena::AnyAlive() && Arena::FindOwner(ptr)) return;
+  std::free(ptr);
+}
+
 std::string MakeString(const pb_bytes_array_t* _Nullable str) {
   if (str == nullptr) return "";
 
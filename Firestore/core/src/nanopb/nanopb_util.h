@@ -19,12 +19,15 @@
 
 #include <pb.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/nullability.h"
@@ -78,6 +81,14 @@ inline pb_bytes_array_t* _Nullable MakeBytesArray(const std::string& str) {
   return MakeBytesArray(str.data(), str.size());
 }
 
+/**
+ * Like `MakeBytesArray`, but allocates from `arena` unless it is null. Only
+ * use this for bytes that end up in a proto, never for a `ByteString`.
+ */
+pb_bytes_array_t* _Nullable MakeBytesArray(const void* _Nullable data,
+                                           size_t size,
+                                           Arena* _Nullable arena);
+
 std::string MakeString(const pb_bytes_array_t* _Nullable str);
 
 /**
@@ -106,11 +117,37 @@ T* _Nonnull MakeArray(pb_size_t count) {
   return static_cast<T*>(calloc(count, sizeof(T)));
 }
 
+/** Like `MakeArray`, but allocates from `arena` unless it is null. */
+template <typename T>
+T* _Nonnull MakeArray(pb_size_t count, Arena* _Nullable arena) {
+  if (arena == nullptr) return MakeArray<T>(count);
+  return static_cast<T*>(arena->Allocate(count * sizeof(T)));
+}
+
+/**
+ * Grows or shrinks an array of `old_count` elements to `new_count` elements.
+ * Arrays owned by an arena are copied into a new allocation from that arena;
+ * all others are reallocated on the heap.
+ */
 template <typename T>
-T* _Nonnull ResizeArray(void* _Nonnull ptr, size_t count) {
-  return static_cast<T*>(realloc(ptr, CheckedSize(count) * sizeof(T)));
+T* _Nonnull ResizeArray(T* _Nullable ptr, size_t old_count, size_t new_count) {
+  Arena* arena = Arena::FindOwner(ptr);
+  if (arena == nullptr) {
+    return static_cast<T*>(realloc(ptr, CheckedSize(new_count) * sizeof(T)));
+  }
+
+  auto* result =
+      static_cast<T*>(arena->Allocate(CheckedSize(new_count) * sizeof(T)));
+  std::memcpy(result, ptr, std::min(old_count, new_count) * sizeof(T));
+  return result;
 }
 
+/**
+ * Frees memory allocated by the helpers above. Memory owned by a live arena on
+ * the current thread is left for the arena to release.
+ */
+void Free(void* _Nullable ptr);
+
 /**
  * Initializes a repeated field with a list of values. Applies `converter` to
  * each value before assigning.
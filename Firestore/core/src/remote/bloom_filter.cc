@@ -60,10 +60,14 @@ bool HasSameBits(const BloomFilter& lhs, const BloomFilter& rhs) {
 }  // namespace
 
 BloomFilter::Hash BloomFilter::Md5HashDigest(absl::string_view key) const {
-  std::array<uint8_t, 16> md5_digest{util::CalculateMd5Digest(key)};
+  return HashFromDigest(util::CalculateMd5Digest(key));
+}
 
+BloomFilter::Hash BloomFilter::HashFromDigest(
+    const std::array<uint8_t, 16>& md5_digest) {
   // TODO(Mila): Handle big endian processor b/271174523.
-  uint64_t* hash128 = reinterpret_cast<uint64_t*>(md5_digest.data());
+  const uint64_t* hash128 =
+      reinterpret_cast<const uint64_t*>(md5_digest.data());
   static_assert(sizeof(uint64_t[2]) == sizeof(uint8_t[16]), "");
 
   return Hash{hash128[0], hash128[1]};
@@ -141,6 +145,46 @@ bool BloomFilter::MightContain(absl::string_view value) const {
   return true;
 }
 
+std::vector<bool> BloomFilter::MightContainAll(
+    const std::vector<absl::string_view>& values) const {
+  // Empty bitmap should return false on membership check.
+  if (bit_count_ == 0) {
+    return std::vector<bool>(values.size(), false);
+  }
+
+  std::vector<Hash> hashes;
+  hashes.reserve(values.size());
+  for (const std::array<uint8_t, 16>& digest :
+       util::CalculateMd5Digests(values)) {
+    hashes.push_back(HashFromDigest(digest));
+  }
+
+  // Probe the bitmap breadth-first: check the first bit of every candidate,
+  // then the second bit of those that are left, and so on. The probes of one
+  // pass do not depend on each other, so their loads overlap instead of each
+  // waiting on the previous early exit, and most strings that are not
+  // members are eliminated by the first pass.
+  std::vector<size_t> candidates(values.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    candidates[i] = i;
+  }
+  for (int32_t i = 0; i < hash_count_ && !candidates.empty(); ++i) {
+    size_t remaining = 0;
+    for (size_t candidate : candidates) {
+      if (IsBitSet(GetBitIndex(hashes[candidate], i))) {
+        candidates[remaining++] = candidate;
+      }
+    }
+    candidates.resize(remaining);
+  }
+
+  std::vector<bool> result(values.size(), false);
+  for (size_t candidate : candidates) {
+    result[candidate] = true;
+  }
+  return result;
+}
+
 bool operator==(const BloomFilter& lhs, const BloomFilter& rhs) {
   return lhs.hash_count() == rhs.hash_count() && HasSameBits(lhs, rhs);
 }
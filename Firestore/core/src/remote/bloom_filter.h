@@ -17,7 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_BLOOM_FILTER_H_
 #define FIRESTORE_CORE_SRC_REMOTE_BLOOM_FILTER_H_
 
+#include <array>
+#include <cstdint>
 #include <string>
+#include <vector>
+
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "absl/strings/string_view.h"
@@ -57,6 +61,19 @@ class BloomFilter final {
    */
   bool MightContain(absl::string_view value) const;
 
+  /**
+   * Checks the membership of many strings at once. Equivalent to calling
+   * `MightContain` on each of the given strings, but hashes them in batches
+   * and probes the bitmap one hash function at a time, which is considerably
+   * faster for large inputs.
+   *
+   * @param values the strings to be tested for membership.
+   * @return for each of the given strings, in the same order, whether it might
+   * be contained in the bloom filter.
+   */
+  std::vector<bool> MightContainAll(
+      const std::vector<absl::string_view>& values) const;
+
   /**
    * The number of bits in the bloom filter. Guaranteed to be non-negative, and
    * less than the max number of bits the bitmap can represent, i.e.,
@@ -95,6 +112,9 @@ class BloomFilter final {
    */
   Hash Md5HashDigest(absl::string_view key) const;
 
+  /** Converts an MD5 digest into a Hash object. */
+  static Hash HashFromDigest(const std::array<uint8_t, 16>& md5_digest);
+
   /**
    * Calculate the ith hash value based on the hashed 64 bit unsigned integers,
    * and calculate its corresponding bit index in the bitmap to be checked.
@@ -105,8 +105,9 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
 
   void CommitMutations(const std::vector<model::Mutation>& mutations,
                        CommitCallback&& callback);
-  void LookupDocuments(const std::vector<model::DocumentKey>& keys,
-                       LookupCallback&& user_callback);
+  virtual /*virtual for tests only*/ void LookupDocuments(
+      const std::vector<model::DocumentKey>& keys,
+      LookupCallback&& user_callback);
 
   void RunAggregateQuery(const core::Query& query,
                          const std::vector<model::AggregateField>& aggregates,
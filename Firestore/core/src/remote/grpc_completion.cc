@@ -85,6 +85,12 @@ void GrpcCompletion::Complete(bool ok) {
   // objects to be valid).
   off_queue_.set_value();
 
+  // Decoding only touches the message owned by this completion, so it can run
+  // here, taking the work off the Firestore async queue.
+  if (ok && message_decoder_) {
+    decoded_message_ = message_decoder_(message_);
+  }
+
   // The queued operation needs to also retain this completion. It's possible
   // for Complete to fire, shutdown to start, and then have this queued
   // operation run. If this weren't a retain that ordering would have the
@@ -23,6 +23,7 @@
 #include <memory>
 #include <utility>
 
+#include "Firestore/core/src/remote/grpc_stream_observer.h"
 #include "Firestore/core/src/util/async_queue.h"
 #include "Firestore/core/src/util/status_fwd.h"
 #include "grpcpp/support/byte_buffer.h"
@@ -118,6 +119,22 @@ class GrpcCompletion : public std::enable_shared_from_this<GrpcCompletion> {
     return type_;
   }
 
+  /**
+   * Sets a decoder that `Complete` runs on the received `message()` before
+   * scheduling the callback, i.e. outside of the Firestore async queue.
+   */
+  void SetMessageDecoder(MessageDecoder decoder) {
+    message_decoder_ = std::move(decoder);
+  }
+
+  /**
+   * Returns the result of running the message decoder, or null if there was no
+   * decoder or the operation failed. Ownership is transferred to the caller.
+   */
+  std::unique_ptr<DecodedMessage> TakeDecodedMessage() {
+    return std::move(decoded_message_);
+  }
+
  private:
   GrpcCompletion(Type type,
                  const std::shared_ptr<util::AsyncQueue>& worker_queue,
@@ -152,6 +169,9 @@ class GrpcCompletion : public std::enable_shared_from_this<GrpcCompletion> {
   grpc::ByteBuffer message_;
   grpc::Status status_;
 
+  MessageDecoder message_decoder_;
+  std::unique_ptr<DecodedMessage> decoded_message_;
+
   std::promise<void> off_queue_;
   std::future<void> off_queue_future_;
 
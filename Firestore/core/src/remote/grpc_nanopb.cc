@@ -16,11 +16,15 @@
 
 #include "Firestore/core/src/remote/grpc_nanopb.h"
 
+#include <pb_encode.h>
+
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
-#include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/remote/grpc_util.h"
+#include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/status.h"
 #include "grpcpp/support/status.h"
 
@@ -28,13 +32,11 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
-using nanopb::ByteString;
-using nanopb::ByteStringWriter;
 using util::Status;
 
 ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
-  std::vector<grpc::Slice> slices;
-  grpc::Status status = buffer.Dump(&slices);
+  // `Dump` only takes references to the slices; no bytes are copied.
+  grpc::Status status = buffer.Dump(&slices_);
   // Conversion may fail if compression is used and gRPC tries to decompress an
   // ill-formed buffer.
   if (!status.ok()) {
@@ -45,14 +47,15 @@ ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
     return;
   }
 
-  ByteStringWriter writer;
-  writer.Reserve(buffer.Length());
-  for (const auto& slice : slices) {
-    writer.Append(slice.begin(), slice.size());
+  if (slices_.size() == 1) {
+    // The common case: nanopb's own buffer stream is the fastest way to read a
+    // contiguous message.
+    stream_ = pb_istream_from_buffer(slices_[0].begin(), slices_[0].size());
+  } else {
+    stream_.callback = ReadFromSlices;
+    stream_.state = this;
+    stream_.bytes_left = buffer.Length();
   }
-
-  bytes_ = writer.Release();
-  stream_ = pb_istream_from_buffer(bytes_.data(), bytes_.size());
 }
 
 void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
@@ -63,28 +66,49 @@ void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
   }
 }
 
-namespace {
-
-bool AppendToGrpcBuffer(pb_ostream_t* stream,
-                        const pb_byte_t* buf,
-                        size_t count) {
-  auto buffer = static_cast<std::vector<grpc::Slice>*>(stream->state);
-  buffer->emplace_back(buf, count);
+bool ByteBufferReader::ReadFromSlices(pb_istream_t* stream,
+                                      pb_byte_t* buf,
+                                      size_t count) {
+  auto reader = static_cast<ByteBufferReader*>(stream->state);
+  while (count > 0) {
+    if (reader->slice_index_ == reader->slices_.size()) {
+      return false;
+    }
+
+    const grpc::Slice& slice = reader->slices_[reader->slice_index_];
+    size_t available = slice.size() - reader->slice_offset_;
+    size_t n = std::min(count, available);
+    // A null `buf` means the bytes are being skipped.
+    if (buf) {
+      std::memcpy(buf, slice.begin() + reader->slice_offset_, n);
+      buf += n;
+    }
+    count -= n;
+
+    reader->slice_offset_ += n;
+    if (reader->slice_offset_ == slice.size()) {
+      ++reader->slice_index_;
+      reader->slice_offset_ = 0;
+    }
+  }
   return true;
 }
 
-}  // namespace
-
-ByteBufferWriter::ByteBufferWriter() {
-  stream_.callback = AppendToGrpcBuffer;
-  stream_.state = &buffer_;
-  stream_.max_size = SIZE_MAX;
-}
-
-grpc::ByteBuffer ByteBufferWriter::Release() {
-  grpc::ByteBuffer result{buffer_.data(), buffer_.size()};
-  buffer_.clear();
-  return result;
+grpc::ByteBuffer MakeByteBuffer(const pb_field_t* fields,
+                                const void* src_struct) {
+  size_t size = 0;
+  bool ok = pb_get_encoded_size(&size, fields, src_struct);
+  HARD_ASSERT(ok, "Unable to compute the size of a nanopb message");
+
+  // The slice was just allocated and isn't shared, so it's safe to write to.
+  grpc::Slice slice{size};
+  auto bytes = const_cast<pb_byte_t*>(slice.begin());
+  pb_ostream_t stream = pb_ostream_from_buffer(bytes, size);
+  ok = pb_encode(&stream, fields, src_struct);
+  HARD_ASSERT(ok, "Unable to encode a nanopb message: %s",
+              PB_GET_ERROR(&stream));
+
+  return grpc::ByteBuffer{&slice, 1};
 }
 
 }  // namespace remote
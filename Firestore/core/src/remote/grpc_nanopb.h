@@ -22,43 +22,50 @@
 
 #include <vector>
 
-#include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
-#include "Firestore/core/src/nanopb/writer.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
-/** A `Reader` that reads from the given `grpc::ByteBuffer`. */
+/**
+ * A `Reader` that reads from the given `grpc::ByteBuffer`.
+ *
+ * The reader shares the slices of the buffer rather than copying them, and
+ * messages are decoded from the slices in place.
+ */
 class ByteBufferReader : public nanopb::Reader {
  public:
-  /**
-   * Copies the given `buffer` and associates the resulting stream with this
-   * `ByteBufferReader`.
-   */
-  // TODO(varconst): avoid copying the buffer.
   explicit ByteBufferReader(const grpc::ByteBuffer& buffer);
 
+  ByteBufferReader(const ByteBufferReader&) = delete;
+  ByteBufferReader& operator=(const ByteBufferReader&) = delete;
+
   void Read(const pb_field_t* fields, void* dest_struct) override;
 
  private:
-  nanopb::ByteString bytes_;
+  /**
+   * A nanopb input stream callback that reads `count` bytes that may span
+   * several slices.
+   */
+  static bool ReadFromSlices(pb_istream_t* stream,
+                             pb_byte_t* buf,
+                             size_t count);
+
+  std::vector<grpc::Slice> slices_;
+  size_t slice_index_ = 0;
+  size_t slice_offset_ = 0;
   pb_istream_t stream_{};
 };
 
-/** A `Writer` that writes into a `grpc::ByteBuffer`. */
-class ByteBufferWriter : public nanopb::Writer {
- public:
-  ByteBufferWriter();
-
-  grpc::ByteBuffer Release();
-
- private:
-  std::vector<grpc::Slice> buffer_;
-};
+/**
+ * Serializes the given nanopb struct into a `grpc::ByteBuffer` consisting of
+ * a single slice that the message is encoded into directly.
+ */
+grpc::ByteBuffer MakeByteBuffer(const pb_field_t* fields,
+                                const void* src_struct);
 
 /**
  * Serializes the given `message` into a `grpc::ByteBuffer`.
@@ -67,9 +74,7 @@ class ByteBufferWriter : public nanopb::Writer {
  */
 template <typename T>
 grpc::ByteBuffer MakeByteBuffer(const nanopb::Message<T>& message) {
-  ByteBufferWriter writer;
-  writer.Write(message.fields(), message.get());
-  return writer.Release();
+  return MakeByteBuffer(message.fields(), message.get());
 }
 
 }  // namespace remote
@@ -130,8 +130,11 @@ void GrpcStream::Read() {
 
   auto completion = NewCompletion(
       Type::Read, [this](const std::shared_ptr<GrpcCompletion>& completion) {
-        OnRead(*completion->message());
+        OnRead(*completion->message(), completion->TakeDecodedMessage());
       });
+  if (message_decoder_) {
+    completion->SetMessageDecoder(message_decoder_);
+  }
   call_->Read(completion->message(), completion.get());
 }
 
@@ -291,14 +294,19 @@ GrpcStream::Metadata GrpcStream::GetResponseHeaders() const {
 
 // Callbacks
 
-void GrpcStream::OnRead(const grpc::ByteBuffer& message) {
+void GrpcStream::OnRead(const grpc::ByteBuffer& message,
+                        std::unique_ptr<DecodedMessage> decoded) {
   if (observer_) {
     // Continue waiting for new messages indefinitely as long as there is an
     // interested observer.
     // Order is important here -- any call to observer can potentially end this
     // stream's lifetime, so call `Read` before notifying.
     Read();
-    observer_->OnStreamRead(message);
+    if (decoded) {
+      observer_->OnStreamReadDecoded(std::move(decoded));
+    } else {
+      observer_->OnStreamRead(message);
+    }
   }
 }
 
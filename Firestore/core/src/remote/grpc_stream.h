@@ -129,6 +129,17 @@ class GrpcStream : public GrpcCall {
              GrpcStreamObserver* observer);
   ~GrpcStream() override;
 
+  /**
+   * Installs a decoder that is run on every received message before the
+   * observer is notified; see `MessageDecoder`. The observer then receives
+   * `OnStreamReadDecoded` instead of `OnStreamRead`.
+   *
+   * Must be called before `Start`.
+   */
+  void SetMessageDecoder(MessageDecoder decoder) {
+    message_decoder_ = std::move(decoder);
+  }
+
   void Start();
 
   // Can only be called once the stream has opened.
@@ -193,7 +204,8 @@ class GrpcStream : public GrpcCall {
   void MaybeUnregister();
 
   void OnStart();
-  void OnRead(const grpc::ByteBuffer& message);
+  void OnRead(const grpc::ByteBuffer& message,
+              std::unique_ptr<DecodedMessage> decoded);
   void OnWrite();
   void OnOperationFailed();
   void RemoveCompletion(const std::shared_ptr<GrpcCompletion>& to_remove);
@@ -233,6 +245,7 @@ class GrpcStream : public GrpcCall {
   GrpcConnection* grpc_connection_ = nullptr;
 
   GrpcStreamObserver* observer_ = nullptr;
+  MessageDecoder message_decoder_;
   internal::BufferedWriter buffered_writer_;
 
   std::vector<std::shared_ptr<GrpcCompletion>> completions_;
@@ -17,6 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_GRPC_STREAM_OBSERVER_H_
 #define FIRESTORE_CORE_SRC_REMOTE_GRPC_STREAM_OBSERVER_H_
 
+#include <functional>
+#include <memory>
+
+#include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/status_fwd.h"
 #include "grpcpp/support/byte_buffer.h"
 
@@ -24,6 +28,23 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+/**
+ * The result of decoding a message received on a gRPC stream. Concrete types
+ * are defined by the observers that install a `MessageDecoder`.
+ */
+class DecodedMessage {
+ public:
+  virtual ~DecodedMessage() = default;
+};
+
+/**
+ * Decodes a message received on a gRPC stream. The decoder runs on the thread
+ * polling the gRPC completion queue, not on the Firestore async queue, so it
+ * must not touch any state owned by the worker queue.
+ */
+using MessageDecoder =
+    std::function<std::unique_ptr<DecodedMessage>(const grpc::ByteBuffer&)>;
+
 /** Observer that gets notified of events on a gRPC stream. */
 class GrpcStreamObserver {
  public:
@@ -33,6 +54,12 @@ class GrpcStreamObserver {
   virtual void OnStreamStart() = 0;
   // A message has been received from the server.
   virtual void OnStreamRead(const grpc::ByteBuffer& message) = 0;
+  // A message has been received from the server and decoded by the stream's
+  // `MessageDecoder`. Only called on observers that installed a decoder.
+  virtual void OnStreamReadDecoded(std::unique_ptr<DecodedMessage> message) {
+    (void)message;
+    HARD_FAIL("Received a decoded message without installing a decoder");
+  }
   // Connection has been broken, perhaps by the server.
   virtual void OnStreamFinish(const util::Status& status) = 0;
 };
@@ -18,6 +18,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/util/log.h"
@@ -341,15 +342,27 @@ int WatchChangeAggregator::FilterRemovedDocuments(
     const BloomFilter& bloom_filter, int target_id) {
   const DocumentKeySet existing_keys =
       target_metadata_provider_->GetRemoteKeysForTarget(target_id);
-  int removalCount = 0;
+  const DatabaseId& database_id = target_metadata_provider_->GetDatabaseId();
+
+  std::vector<DocumentKey> keys;
+  std::vector<std::string> document_paths;
+  keys.reserve(existing_keys.size());
+  document_paths.reserve(existing_keys.size());
   for (const DocumentKey& key : existing_keys) {
-    const DatabaseId& database_id = target_metadata_provider_->GetDatabaseId();
-    std::string document_path = util::StringFormat(
+    keys.push_back(key);
+    document_paths.push_back(util::StringFormat(
         "projects/%s/databases/%s/documents/%s", database_id.project_id(),
-        database_id.database_id(), key.ToString());
+        database_id.database_id(), key.ToString()));
+  }
 
-    if (!bloom_filter.MightContain(document_path)) {
-      RemoveDocumentFromTarget(target_id, key,
+  std::vector<bool> might_contain = bloom_filter.MightContainAll(
+      std::vector<absl::string_view>(document_paths.begin(),
+                                     document_paths.end()));
+
+  int removalCount = 0;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!might_contain[i]) {
+      RemoveDocumentFromTarget(target_id, keys[i],
                                /*updatedDocument=*/absl::nullopt);
       removalCount++;
     }
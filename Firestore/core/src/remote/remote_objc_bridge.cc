@@ -24,6 +24,7 @@
 #include "Firestore/core/src/model/aggregate_field.h"
 #include "Firestore/core/src/model/document.h"
 #include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/mutation.h"
 #include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
@@ -49,6 +50,7 @@ using local::TargetData;
 using model::AggregateField;
 using model::Document;
 using model::DocumentKey;
+using model::MutableDocument;
 using model::Mutation;
 using model::MutationResult;
 using model::ObjectValue;
@@ -254,12 +256,18 @@ DatastoreSerializer::MergeLookupResponses(
         Message<google_firestore_v1_BatchGetDocumentsResponse>::TryParse(
             &reader);
 
-    Document doc = serializer_.DecodeMaybeDocument(reader.context(), *message);
+    MutableDocument doc =
+        serializer_.DecodeMaybeDocument(reader.context(), *message);
+    SnapshotVersion read_time =
+        serializer_.DecodeVersion(reader.context(), message->read_time);
     if (!reader.ok()) {
       return reader.status();
     }
 
-    results[doc->key()] = std::move(doc);
+    // Found documents only carry their update time; keep the time they were
+    // read at so that they can be cached at it.
+    doc.WithReadTime(read_time);
+    results[doc.key()] = std::move(doc);
   }
 
   std::vector<Document> docs;
@@ -131,7 +131,8 @@ class DatastoreSerializer {
 
   /**
    * Merges results of the streaming read together. The array is sorted by the
-   * document key.
+   * document key, and each document's read time is the `read_time` of the
+   * response it came in.
    */
   util::StatusOr<std::vector<model::Document>> MergeLookupResponses(
       const std::vector<grpc::ByteBuffer>& responses) const;
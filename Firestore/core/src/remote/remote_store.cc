@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/remote/remote_store.h"
 
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <utility>
 
@@ -41,8 +43,10 @@ using local::QueryPurpose;
 using local::TargetData;
 using model::AggregateField;
 using model::BatchId;
+using model::DocumentKey;
 using model::DocumentKeySet;
 using model::kBatchIdUnknown;
+using model::Mutation;
 using model::MutationBatch;
 using model::MutationBatchResult;
 using model::MutationResult;
@@ -54,10 +58,20 @@ using util::AsyncQueue;
 using util::Status;
 
 /**
- * The maximum number of pending writes to allow.
- * TODO(b/35853402): Negotiate this value with the backend.
+ * The maximum number of mutations to coalesce into a single write request,
+ * matching the backend's limit on the number of writes in a commit.
  */
-constexpr int kMaxPendingWrites = 10;
+constexpr size_t kMaxMutationsPerWriteRequest = 500;
+
+/** Returns true if none of the mutations in `batch` touch `keys`. */
+bool IsDisjoint(const DocumentKeySet& keys, const MutationBatch& batch) {
+  for (const Mutation& mutation : batch.mutations()) {
+    if (keys.contains(mutation.key())) {
+      return false;
+    }
+  }
+  return true;
+}
 
 RemoteStore::RemoteStore(
     LocalStore* local_store,
@@ -390,6 +404,16 @@ void RemoteStore::RunAggregateQuery(
   }
 }
 
+void RemoteStore::LookupDocuments(const std::vector<DocumentKey>& keys,
+                                  Datastore::LookupCallback&& callback) {
+  if (CanUseNetwork()) {
+    datastore_->LookupDocuments(keys, std::move(callback));
+  } else {
+    callback(Status{Error::kErrorUnavailable,
+                    "Failed to get documents from server."});
+  }
+}
+
 // Write Stream
 
 void RemoteStore::FillWritePipeline() {
@@ -405,17 +429,19 @@ void RemoteStore::FillWritePipeline() {
       }
       break;
     }
-    AddToWritePipeline(*batch);
     last_batch_id_retrieved = batch->batch_id();
+    write_pipeline_.push_back(std::move(*batch));
   }
 
+  WriteUnsentBatches();
+
   if (ShouldStartWriteStream()) {
     StartWriteStream();
   }
 }
 
 bool RemoteStore::CanAddToWritePipeline() const {
-  return CanUseNetwork() && write_pipeline_.size() < kMaxPendingWrites;
+  return CanUseNetwork() && write_pipeline_.size() < write_window_.size();
 }
 
 void RemoteStore::AddToWritePipeline(const MutationBatch& batch) {
@@ -423,9 +449,57 @@ void RemoteStore::AddToWritePipeline(const MutationBatch& batch) {
               "AddToWritePipeline called when pipeline is full");
 
   write_pipeline_.push_back(batch);
+  WriteUnsentBatches();
+}
+
+void RemoteStore::WriteUnsentBatches() {
+  if (!write_stream_->IsOpen() || !write_stream_->handshake_complete()) {
+    return;
+  }
+
+  size_t next = 0;
+  for (const WriteRequest& request : write_requests_) {
+    next += request.batch_count;
+  }
+
+  while (next < write_pipeline_.size()) {
+    const MutationBatch& first = write_pipeline_[next];
+    size_t end = next + 1;
+
+    // Batches are only combined when they write disjoint documents, so that
+    // committing them together can't change the outcome of any precondition
+    // or transform.
+    if (write_stream_->CanCoalesceBatches() &&
+        first.batch_id() > split_batches_through_) {
+      DocumentKeySet keys = first.keys();
+      size_t mutation_count = first.mutations().size();
+      while (end < write_pipeline_.size()) {
+        const MutationBatch& batch = write_pipeline_[end];
+        mutation_count += batch.mutations().size();
+        if (mutation_count > kMaxMutationsPerWriteRequest ||
+            !IsDisjoint(keys, batch)) {
+          break;
+        }
+        for (const Mutation& mutation : batch.mutations()) {
+          keys = keys.insert(mutation.key());
+        }
+        ++end;
+      }
+    }
 
-  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
-    write_stream_->WriteMutations(batch.mutations());
+    if (end == next + 1) {
+      write_stream_->WriteMutations(first.mutations());
+    } else {
+      std::vector<Mutation> mutations;
+      for (size_t i = next; i < end; ++i) {
+        const std::vector<Mutation>& batch = write_pipeline_[i].mutations();
+        mutations.insert(mutations.end(), batch.begin(), batch.end());
+      }
+      write_stream_->WriteMutations(mutations);
+    }
+
+    write_requests_.push_back({end - next, std::chrono::steady_clock::now()});
+    next = end;
   }
 }
 
@@ -449,25 +523,56 @@ void RemoteStore::OnWriteStreamHandshakeComplete() {
   local_store_->SetLastStreamToken(write_stream_->last_stream_token());
 
   // Send the write pipeline now that the stream is established.
-  for (const MutationBatch& write : write_pipeline_) {
-    write_stream_->WriteMutations(write.mutations());
-  }
+  WriteUnsentBatches();
 }
 
 void RemoteStore::OnWriteStreamMutationResult(
     SnapshotVersion commit_version,
     std::vector<MutationResult> mutation_results) {
   // This is a response to a write containing mutations and should be correlated
-  // to the first write in our write pipeline.
-  HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
-
-  MutationBatch batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
+  // to the first request in flight, which carries one or more batches from the
+  // front of our write pipeline.
+  HARD_ASSERT(!write_requests_.empty(), "Got result for empty write pipeline");
+
+  WriteRequest request = write_requests_.front();
+  write_requests_.pop_front();
+  write_window_.RecordLatency(std::chrono::steady_clock::now() -
+                              request.sent_at);
+
+  HARD_ASSERT(request.batch_count <= write_pipeline_.size(),
+              "Write request covers more batches than are pending");
+  auto batches_begin = std::make_move_iterator(write_pipeline_.begin());
+  auto batches_end = batches_begin + request.batch_count;
+  std::vector<MutationBatch> batches(batches_begin, batches_end);
+  write_pipeline_.erase(batches_begin.base(), batches_end.base());
+
+  if (batches.size() > 1) {
+    size_t mutation_count = 0;
+    for (const MutationBatch& batch : batches) {
+      mutation_count += batch.mutations().size();
+    }
+    HARD_ASSERT(mutation_results.size() == mutation_count,
+                "Coalesced write request with %s mutations got %s results",
+                mutation_count, mutation_results.size());
+  }
 
-  MutationBatchResult batch_result(std::move(batch), commit_version,
-                                   std::move(mutation_results),
-                                   write_stream_->last_stream_token());
-  sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+  // The results of a coalesced request are in the order of the mutations it
+  // carried, so each batch takes the next `mutations().size()` of them.
+  auto next_result = mutation_results.begin();
+  for (MutationBatch& batch : batches) {
+    auto results_end = batches.size() == 1
+                           ? mutation_results.end()
+                           : next_result + batch.mutations().size();
+    std::vector<MutationResult> batch_results(
+        std::make_move_iterator(next_result),
+        std::make_move_iterator(results_end));
+    next_result = results_end;
+
+    MutationBatchResult batch_result(std::move(batch), commit_version,
+                                     std::move(batch_results),
+                                     write_stream_->last_stream_token());
+    sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+  }
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
@@ -482,6 +587,14 @@ void RemoteStore::OnWriteStreamClose(const Status& status) {
                 "Write stream was stopped gracefully while still needed.");
   }
 
+  // Requests in flight are lost with the stream. Their batches remain in the
+  // pipeline and are sent again once a new stream completes its handshake,
+  // which may well be on a different connection.
+  size_t failed_batch_count =
+      write_requests_.empty() ? 1 : write_requests_.front().batch_count;
+  write_requests_.clear();
+  write_window_.Reset();
+
   // If the write stream closed due to an error, invoke the error callbacks if
   // there are pending writes.
   if (!status.ok() && !write_pipeline_.empty()) {
@@ -489,7 +602,7 @@ void RemoteStore::OnWriteStreamClose(const Status& status) {
     // go/firestore-client-errors
     if (write_stream_->handshake_complete()) {
       // This error affects the actual writes.
-      HandleWriteError(status);
+      HandleWriteError(status, failed_batch_count);
     } else {
       // If there was an error before the handshake finished, it's possible that
       // the server is unable to process the stream token we're sending.
@@ -526,7 +639,8 @@ void RemoteStore::HandleHandshakeError(const Status& status) {
   }
 }
 
-void RemoteStore::HandleWriteError(const Status& status) {
+void RemoteStore::HandleWriteError(const Status& status,
+                                   size_t failed_batch_count) {
   HARD_ASSERT(!status.ok(), "Handling write error with status OK.");
 
   // Only handle permanent errors here. If it's transient, just let the retry
@@ -535,6 +649,16 @@ void RemoteStore::HandleWriteError(const Status& status) {
     return;
   }
 
+  if (failed_batch_count > 1) {
+    // The backend rejected a coalesced request as a whole, so it's unknown
+    // which of its batches is at fault. Resend them one per request so that
+    // only the offending batch is rejected.
+    size_t last = std::min(failed_batch_count, write_pipeline_.size()) - 1;
+    split_batches_through_ = write_pipeline_[last].batch_id();
+    write_stream_->InhibitBackoff();
+    return;
+  }
+
   // If this was a permanent error, the request itself was the problem so it's
   // not going to succeed if we resend it.
   MutationBatch batch = write_pipeline_.front();
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_REMOTE_STORE_H_
 #define FIRESTORE_CORE_SRC_REMOTE_REMOTE_STORE_H_
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -31,6 +33,7 @@
 #include "Firestore/core/src/remote/remote_event.h"
 #include "Firestore/core/src/remote/watch_change.h"
 #include "Firestore/core/src/remote/watch_stream.h"
+#include "Firestore/core/src/remote/write_pipeline_window.h"
 #include "Firestore/core/src/remote/write_stream.h"
 #include "Firestore/core/src/util/async_queue.h"
 #include "Firestore/core/src/util/status_fwd.h"
@@ -203,6 +206,13 @@ class RemoteStore : public TargetMetadataProvider,
                          const std::vector<model::AggregateField>& aggregates,
                          api::AggregateQueryCallback&& result_callback);
 
+  /**
+   * Looks up the given documents on the backend, bypassing the watch stream.
+   * Fails immediately if the network is disabled.
+   */
+  void LookupDocuments(const std::vector<model::DocumentKey>& keys,
+                       Datastore::LookupCallback&& callback);
+
   void OnWatchStreamOpen() override;
   void OnWatchStreamChange(
       const WatchChange& change,
@@ -238,6 +248,16 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool CanAddToWritePipeline() const;
 
+  /**
+   * Sends the batches in `write_pipeline_` that haven't been written to the
+   * write stream yet, if the stream is ready to accept them.
+   *
+   * Consecutive batches that touch disjoint documents are coalesced into one
+   * request, so that a backlog built up while offline drains in fewer round
+   * trips.
+   */
+  void WriteUnsentBatches();
+
   void StartWriteStream();
 
   /**
@@ -247,7 +267,11 @@ class RemoteStore : public TargetMetadataProvider,
   bool ShouldStartWriteStream() const;
 
   void HandleHandshakeError(const util::Status& status);
-  void HandleWriteError(const util::Status& status);
+  /**
+   * Handles an error on the write stream that closed it while the request
+   * carrying the first `failed_batch_count` batches was in flight.
+   */
+  void HandleWriteError(const util::Status& status, size_t failed_batch_count);
 
   void StartWatchStream();
 
@@ -296,7 +320,7 @@ class RemoteStore : public TargetMetadataProvider,
   std::unique_ptr<WatchChangeAggregator> watch_change_aggregator_;
 
   /**
-   * A list of up to `kMaxPendingWrites` writes that we have fetched from the
+   * A list of up to `write_window_.size()` writes that we have fetched from the
    * `LocalStore` via `FillWritePipeline` and have or will send to the write
    * stream.
    *
@@ -313,6 +337,30 @@ class RemoteStore : public TargetMetadataProvider,
    * the `write_pipeline_` as we receive responses.
    */
   std::vector<model::MutationBatch> write_pipeline_;
+
+  /** A request written to the write stream and not yet acknowledged. */
+  struct WriteRequest {
+    /** The number of batches from `write_pipeline_` the request carries. */
+    size_t batch_count = 0;
+    std::chrono::steady_clock::time_point sent_at;
+  };
+
+  /**
+   * The requests in flight on the current write stream, in the order they
+   * were sent. Together they cover a prefix of `write_pipeline_`; the batches
+   * after it are yet to be sent.
+   */
+  std::deque<WriteRequest> write_requests_;
+
+  /** Limits the size of `write_pipeline_` based on acknowledgement latency. */
+  WritePipelineWindow write_window_;
+
+  /**
+   * Batches up to and including this ID are sent one per request. Set when a
+   * coalesced request is rejected, so that the failure can be attributed to
+   * the batch that caused it.
+   */
+  model::BatchId split_batches_through_ = model::kBatchIdUnknown;
 };
 
 }  // namespace remote
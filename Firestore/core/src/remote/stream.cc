@@ -248,6 +248,19 @@ void Stream::CancelIdleCheck() {
 // Read/write
 
 void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
+  HandleStreamResponse([&] { return NotifyStreamResponse(message); });
+}
+
+void Stream::OnStreamReadDecoded(std::unique_ptr<DecodedMessage> message) {
+  HandleStreamResponse(
+      [&] { return NotifyDecodedStreamResponse(std::move(message)); });
+}
+
+Status Stream::NotifyDecodedStreamResponse(std::unique_ptr<DecodedMessage>) {
+  HARD_FAIL("%s does not install a message decoder", GetDebugName());
+}
+
+void Stream::HandleStreamResponse(const std::function<Status()>& notify) {
   EnsureOnQueue();
 
   HARD_ASSERT(IsStarted(), "OnStreamRead called for a stopped stream.");
@@ -258,7 +271,7 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
                   grpc_stream_->GetResponseHeaders()));
   }
 
-  Status read_status = NotifyStreamResponse(message);
+  Status read_status = notify();
   if (!read_status.ok()) {
     grpc_stream_->FinishImmediately();
     // Don't expect gRPC to produce status -- since the error happened on the
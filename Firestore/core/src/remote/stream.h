@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_STREAM_H_
 #define FIRESTORE_CORE_SRC_REMOTE_STREAM_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -201,6 +202,7 @@ class Stream : public GrpcStreamObserver,
   // `GrpcStreamObserver` interface -- do not use.
   void OnStreamStart() override;
   void OnStreamRead(const grpc::ByteBuffer& message) override;
+  void OnStreamReadDecoded(std::unique_ptr<DecodedMessage> message) override;
   void OnStreamFinish(const util::Status& status) override;
 
  protected:
@@ -228,11 +230,16 @@ class Stream : public GrpcStreamObserver,
   virtual void NotifyStreamOpen() = 0;
   virtual util::Status NotifyStreamResponse(
       const grpc::ByteBuffer& message) = 0;
+  // Only called if `CreateGrpcStream` installed a `MessageDecoder` on the
+  // created stream.
+  virtual util::Status NotifyDecodedStreamResponse(
+      std::unique_ptr<DecodedMessage> message);
   virtual void NotifyStreamClose(const util::Status& status) = 0;
   // PORTING NOTE: C++ cannot rely on RTTI, unlike other platforms.
   virtual std::string GetDebugName() const = 0;
 
   void Close(const util::Status& status);
+  void HandleStreamResponse(const std::function<util::Status()>& notify);
   void HandleErrorStatus(const util::Status& status);
 
   void RequestCredentials();
@@ -16,15 +16,18 @@
 
 #include "Firestore/core/src/remote/watch_stream.h"
 
+#include <string>
 #include <utility>
 
 #include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/remote/grpc_nanopb.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/status.h"
+#include "absl/memory/memory.h"
 
 namespace firebase {
 namespace firestore {
@@ -39,6 +42,24 @@ using util::AsyncQueue;
 using util::Status;
 using util::TimerId;
 
+namespace {
+
+/**
+ * A `ListenResponse` that has been decoded off the worker queue. If
+ * `parse_status` is ok but `decode_status` is not, the message was well-formed
+ * but could not be converted into a `WatchChange`.
+ */
+struct DecodedWatchResponse : public DecodedMessage {
+  Status parse_status;
+  Status decode_status;
+  // Only filled in if debug logging is enabled.
+  std::string description;
+  std::unique_ptr<WatchChange> watch_change;
+  model::SnapshotVersion version;
+};
+
+}  // namespace
+
 WatchStream::WatchStream(
     const std::shared_ptr<AsyncQueue>& async_queue,
     std::shared_ptr<credentials::AuthCredentialsProvider>
@@ -56,9 +77,35 @@ WatchStream::WatchStream(
              TimerId::ListenStreamIdle,
              TimerId::HealthCheckTimeout},
       watch_serializer_{std::move(serializer)},
+      response_decoder_{CreateResponseDecoder(watch_serializer_)},
       callback_{NOT_NULL(callback)} {
 }
 
+MessageDecoder WatchStream::CreateResponseDecoder(
+    WatchStreamSerializer serializer) {
+  // The decoder runs on the gRPC polling thread and may outlive the stream, so
+  // it owns its copy of the serializer.
+  return [serializer](const grpc::ByteBuffer& message) {
+    auto result = absl::make_unique<DecodedWatchResponse>();
+
+    ByteBufferReader reader{message};
+    auto response = serializer.ParseResponse(&reader);
+    result->parse_status = reader.status();
+    if (!reader.ok()) {
+      return std::unique_ptr<DecodedMessage>(std::move(result));
+    }
+
+    if (util::LogIsDebugEnabled()) {
+      result->description = response.ToString();
+    }
+
+    result->watch_change = serializer.DecodeWatchChange(&reader, *response);
+    result->version = serializer.DecodeSnapshotVersion(&reader, *response);
+    result->decode_status = reader.status();
+    return std::unique_ptr<DecodedMessage>(std::move(result));
+  };
+}
+
 void WatchStream::WatchQuery(const TargetData& query) {
   EnsureOnQueue();
 
@@ -80,8 +127,11 @@ std::unique_ptr<GrpcStream> WatchStream::CreateGrpcStream(
     GrpcConnection* grpc_connection,
     const AuthToken& auth_token,
     const std::string& app_check_token) {
-  return grpc_connection->CreateStream("/google.firestore.v1.Firestore/Listen",
-                                       auth_token, app_check_token, this);
+  auto grpc_stream = grpc_connection->CreateStream(
+      "/google.firestore.v1.Firestore/Listen", auth_token, app_check_token,
+      this);
+  grpc_stream->SetMessageDecoder(response_decoder_);
+  return grpc_stream;
 }
 
 void WatchStream::TearDown(GrpcStream* grpc_stream) {
@@ -93,24 +143,29 @@ void WatchStream::NotifyStreamOpen() {
 }
 
 Status WatchStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
-  ByteBufferReader reader{message};
-  auto response = watch_serializer_.ParseResponse(&reader);
-  if (!reader.ok()) {
-    return reader.status();
+  // Only reached if the message wasn't decoded on the gRPC polling thread.
+  return NotifyDecodedStreamResponse(response_decoder_(message));
+}
+
+Status WatchStream::NotifyDecodedStreamResponse(
+    std::unique_ptr<DecodedMessage> message) {
+  // PORTING NOTE: C++ cannot rely on RTTI; only `response_decoder_` produces
+  // messages for this stream.
+  auto& response = static_cast<DecodedWatchResponse&>(*message);
+  if (!response.parse_status.ok()) {
+    return response.parse_status;
   }
 
-  LOG_DEBUG("%s response: %s", GetDebugDescription(), response.ToString());
+  LOG_DEBUG("%s response: %s", GetDebugDescription(), response.description);
 
   // A successful response means the stream is healthy.
   backoff_.Reset();
 
-  auto watch_change = watch_serializer_.DecodeWatchChange(&reader, *response);
-  auto version = watch_serializer_.DecodeSnapshotVersion(&reader, *response);
-  if (!reader.ok()) {
-    return reader.status();
+  if (!response.decode_status.ok()) {
+    return response.decode_status;
   }
 
-  callback_->OnWatchStreamChange(*watch_change, version);
+  callback_->OnWatchStreamChange(*response.watch_change, response.version);
 
   return Status::OK();
 }
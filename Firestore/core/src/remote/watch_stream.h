@@ -108,6 +108,13 @@ class WatchStream : public Stream {
   virtual /*virtual for tests only*/ void UnwatchTargetId(
       model::TargetId target_id);
 
+  /**
+   * Creates a decoder that parses `ListenResponse` messages into
+   * `WatchChange`s. It is installed on every gRPC stream the `WatchStream`
+   * creates, so that decoding large responses doesn't occupy the worker queue.
+   */
+  static MessageDecoder CreateResponseDecoder(WatchStreamSerializer serializer);
+
  private:
   std::unique_ptr<GrpcStream> CreateGrpcStream(
       GrpcConnection* grpc_connection,
@@ -117,6 +124,8 @@ class WatchStream : public Stream {
 
   void NotifyStreamOpen() override;
   util::Status NotifyStreamResponse(const grpc::ByteBuffer& message) override;
+  util::Status NotifyDecodedStreamResponse(
+      std::unique_ptr<DecodedMessage> message) override;
   void NotifyStreamClose(const util::Status& status) override;
 
   std::string GetDebugName() const override {
@@ -124,6 +133,7 @@ class WatchStream : public Stream {
   }
 
   WatchStreamSerializer watch_serializer_;
+  MessageDecoder response_decoder_;
   WatchStreamCallback* callback_;
 };
 
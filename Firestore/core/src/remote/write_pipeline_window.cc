@@ -0,0 +1,61 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/write_pipeline_window.h"
+
+#include <algorithm>
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+/**
+ * Acknowledgements within this multiple of the fastest one seen mean the
+ * backend is keeping up and the window may grow.
+ */
+constexpr int kGrowLatencyFactor = 2;
+
+/**
+ * Acknowledgements slower than this multiple of the fastest one seen mean
+ * requests are queuing and the window must shrink.
+ */
+constexpr int kShrinkLatencyFactor = 4;
+
+}  // namespace
+
+constexpr size_t WritePipelineWindow::kMinPendingWrites;
+constexpr size_t WritePipelineWindow::kMaxPendingWrites;
+
+void WritePipelineWindow::RecordLatency(Duration latency) {
+  min_latency_ = std::min(min_latency_, latency);
+
+  if (latency <= min_latency_ * kGrowLatencyFactor) {
+    size_ = std::min(size_ + 1, kMaxPendingWrites);
+  } else if (latency > min_latency_ * kShrinkLatencyFactor) {
+    size_ = std::max(size_ / 2, kMinPendingWrites);
+  }
+}
+
+void WritePipelineWindow::Reset() {
+  size_ = kMinPendingWrites;
+  min_latency_ = Duration::max();
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_WINDOW_H_
+#define FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_WINDOW_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * Decides how many mutation batches the `RemoteStore` may have in flight on
+ * the write stream, adapting the limit to the acknowledgement latency of the
+ * current connection.
+ *
+ * The window starts at `kMinPendingWrites`. While acknowledgements arrive
+ * close to the fastest latency seen on the connection, the backend is keeping
+ * up, and the window grows by one batch per acknowledgement up to
+ * `kMaxPendingWrites`. Once latency climbs well above that baseline, requests
+ * are queuing up somewhere and the window is halved, though never below the
+ * minimum.
+ */
+class WritePipelineWindow {
+ public:
+  using Duration = std::chrono::steady_clock::duration;
+
+  /** The initial and smallest window; the limit used before adaptation. */
+  static constexpr size_t kMinPendingWrites = 10;
+
+  /** Caps the window so that a fast connection can't flood the backend. */
+  static constexpr size_t kMaxPendingWrites = 100;
+
+  /** The maximum number of batches currently allowed in flight. */
+  size_t size() const {
+    return size_;
+  }
+
+  /** Adjusts the window for a write request acknowledged after `latency`. */
+  void RecordLatency(Duration latency);
+
+  /**
+   * Forgets the latency baseline and shrinks the window back to its minimum.
+   * Called whenever the write stream closes, since the next stream may be on a
+   * different connection.
+   */
+  void Reset();
+
+ private:
+  size_t size_ = kMinPendingWrites;
+  Duration min_latency_ = Duration::max();
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_WINDOW_H_
@@ -129,6 +129,15 @@ class WriteStream : public Stream {
   /** Sends a group of mutations to the Firestore backend to apply. */
   virtual void WriteMutations(const std::vector<model::Mutation>& mutations);
 
+  /**
+   * Whether the mutations of several batches may be sent in a single call to
+   * `WriteMutations`. The backend commits such a request atomically and
+   * acknowledges it with one response carrying a result for every mutation.
+   */
+  virtual bool CanCoalesceBatches() const {
+    return true;
+  }
+
  protected:
   // For tests only
   void SetHandshakeComplete(bool value = true) {
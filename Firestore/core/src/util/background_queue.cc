@@ -16,35 +16,61 @@
 
 #include "Firestore/core/src/util/background_queue.h"
 
-#include "Firestore/core/src/util/executor.h"
+#include <utility>
+
+#include "Firestore/core/src/util/work_stealing_pool.h"
 
 namespace firebase {
 namespace firestore {
 namespace util {
 
-BackgroundQueue::BackgroundQueue(Executor* executor) : executor_(executor) {
+BackgroundQueue::BackgroundQueue()
+    : BackgroundQueue(&WorkStealingPool::Shared()) {
+}
+
+BackgroundQueue::BackgroundQueue(WorkStealingPool* pool) : pool_(pool) {
 }
 
 void BackgroundQueue::Execute(std::function<void()>&& operation) {
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    pending_tasks_ += 1;
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->queued.push_back(std::move(operation));
+    state_->pending_tasks += 1;
   }
 
-  executor_->Execute([this, operation]() {
-    operation();
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    pending_tasks_ -= 1;
-    if (pending_tasks_ == 0) {
-      done_.notify_all();
-    }
+  // Each pool task claims whichever operation is next; if `AwaitAll` already
+  // ran them all, it has nothing left to do.
+  std::shared_ptr<State> state = state_;
+  pool_->Execute([state] {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->RunQueued(&lock);
   });
 }
 
 void BackgroundQueue::AwaitAll() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  done_.wait(lock, [this] { return pending_tasks_ == 0; });
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  while (state_->RunQueued(&lock)) {
+  }
+
+  // Every remaining operation is already running on some worker.
+  state_->done.wait(lock, [this] { return state_->pending_tasks == 0; });
+}
+
+bool BackgroundQueue::State::RunQueued(std::unique_lock<std::mutex>* lock) {
+  if (queued.empty()) return false;
+
+  std::function<void()> operation = std::move(queued.front());
+  queued.pop_front();
+
+  lock->unlock();
+  operation();
+  lock->lock();
+
+  pending_tasks -= 1;
+  if (pending_tasks == 0) {
+    done.notify_all();
+  }
+  return true;
 }
 
 }  // namespace util
@@ -18,36 +18,56 @@
 #define FIRESTORE_CORE_SRC_UTIL_BACKGROUND_QUEUE_H_
 
 #include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>  // NOLINT(build/c++11)
 
 namespace firebase {
 namespace firestore {
 namespace util {
 
-class Executor;
+class WorkStealingPool;
 
 /**
- * A simple queue that executes tasks in parallel on an Executor and supports
- * blocking on their completion.
+ * A simple queue that executes tasks in parallel on a WorkStealingPool and
+ * supports blocking on their completion.
  *
  * This class is thread-safe.
  */
 class BackgroundQueue {
  public:
-  explicit BackgroundQueue(Executor* executor);
+  /** Creates a queue that runs its tasks on the process-wide pool. */
+  BackgroundQueue();
 
-  /** Enqueue a task on the Executor. */
+  explicit BackgroundQueue(WorkStealingPool* pool);
+
+  /** Enqueue a task on the pool. */
   void Execute(std::function<void()>&& operation);
 
-  /** Wait for all currently scheduled tasks to complete. */
+  /**
+   * Wait for all currently scheduled tasks to complete. While waiting, the
+   * calling thread runs this queue's tasks that no worker has started yet, so
+   * this may also be called from a task running on the same pool. Tasks of
+   * other queues never run on the waiting thread.
+   */
   void AwaitAll();
 
  private:
-  Executor* executor_ = nullptr;
-  int pending_tasks_ = 0;
-  std::mutex mutex_;
-  std::condition_variable done_;
+  // Shared with the pool tasks, which may outlive the queue once all of its
+  // operations have been claimed.
+  struct State {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::deque<std::function<void()>> queued;
+    int pending_tasks = 0;
+
+    /** Runs one queued operation, if any. Called with `mutex` locked. */
+    bool RunQueued(std::unique_lock<std::mutex>* lock);
+  };
+
+  WorkStealingPool* pool_ = nullptr;
+  std::shared_ptr<State> state_ = std::make_shared<State>();
 };
 
 }  // namespace util
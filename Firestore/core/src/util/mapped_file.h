@@ -0,0 +1,70 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_UTIL_MAPPED_FILE_H_
+#define FIRESTORE_CORE_SRC_UTIL_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/util/status_fwd.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class Path;
+
+/**
+ * The read-only contents of a file, mapped into memory where the platform
+ * supports it.
+ *
+ * On POSIX platforms, the pages of the file are loaded lazily as they are
+ * touched, so reading parts of a large file does not copy all of it. On other
+ * platforms, the whole file is read into memory when it is opened.
+ */
+class MappedFile {
+ public:
+  /** Opens and maps the file at the given `path`. */
+  static StatusOr<std::unique_ptr<MappedFile>> Open(const Path& path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /** The contents of the file, valid for the lifetime of this object. */
+  absl::string_view data() const {
+    return {data_, size_};
+  }
+
+ private:
+  MappedFile() = default;
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+
+  // Holds the contents of the file on platforms that do not map it.
+  std::string contents_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_UTIL_MAPPED_FILE_H_
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "Firestore/core/src/util/defer.h"
+#include "Firestore/core/src/util/path.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/src/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+StatusOr<std::unique_ptr<MappedFile>> MappedFile::Open(const Path& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not open file '%s'", path.ToUtf8String()));
+  }
+  // The mapping stays valid after the descriptor is closed.
+  Defer close_fd([fd] { close(fd); });
+
+  struct stat st {};
+  if (fstat(fd, &st) == -1) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not stat file '%s'", path.ToUtf8String()));
+  }
+
+  std::unique_ptr<MappedFile> result(new MappedFile());
+  result->size_ = static_cast<size_t>(st.st_size);
+  if (result->size_ == 0) {
+    // `mmap` rejects empty mappings.
+    return std::move(result);
+  }
+
+  void* data = mmap(nullptr, result->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not map file '%s'", path.ToUtf8String()));
+  }
+  result->data_ = static_cast<const char*>(data);
+  return std::move(result);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/mapped_file.h"
+
+#if defined(_WIN32)
+
+#include <utility>
+
+#include "Firestore/core/src/util/filesystem.h"
+#include "Firestore/core/src/util/path.h"
+#include "Firestore/core/src/util/statusor.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+StatusOr<std::unique_ptr<MappedFile>> MappedFile::Open(const Path& path) {
+  StatusOr<std::string> contents = Filesystem::Default()->ReadFile(path);
+  if (!contents.ok()) {
+    return contents.status();
+  }
+
+  std::unique_ptr<MappedFile> result(new MappedFile());
+  result->contents_ = std::move(contents).ValueOrDie();
+  result->data_ = result->contents_.data();
+  result->size_ = result->contents_.size();
+  return std::move(result);
+}
+
+MappedFile::~MappedFile() = default;
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // defined(_WIN32)
@@ -17,6 +17,8 @@
 #include "Firestore/core/src/util/md5.h"
 
 #include <algorithm>
+#include <cstring>
+#include <numeric>
 
 namespace firebase {
 namespace firestore {
@@ -291,6 +293,208 @@ void MD5Final(MD5Digest* digest, MD5Context* context) {
 
 }  // namespace
 
+namespace {
+
+// The number of strings that `CalculateMd5Digests` hashes in lockstep.
+constexpr size_t kLanes = 8;
+
+#if defined(__GNUC__) || defined(__clang__)
+
+// A vector of one 32-bit word per lane. With the GCC and Clang vector
+// extensions, each arithmetic operation on it compiles to SIMD instructions
+// (SSE/AVX on x86, NEON on ARM) without any platform-specific code.
+typedef uint32_t Lanes __attribute__((vector_size(sizeof(uint32_t) * kLanes)));
+
+#else
+
+// A portable stand-in for the vector type above, for other compilers.
+struct Lanes {
+  uint32_t& operator[](size_t i) {
+    return words[i];
+  }
+  uint32_t operator[](size_t i) const {
+    return words[i];
+  }
+
+  uint32_t words[kLanes];
+};
+
+#define FIRESTORE_MD5_LANES_OPERATOR(op)                \
+  inline Lanes operator op(const Lanes& x, const Lanes& y) { \
+    Lanes result;                                        \
+    for (size_t l = 0; l < kLanes; ++l) {                \
+      result[l] = x[l] op y[l];                          \
+    }                                                    \
+    return result;                                       \
+  }
+FIRESTORE_MD5_LANES_OPERATOR(+)
+FIRESTORE_MD5_LANES_OPERATOR(^)
+FIRESTORE_MD5_LANES_OPERATOR(&)
+FIRESTORE_MD5_LANES_OPERATOR(|)
+#undef FIRESTORE_MD5_LANES_OPERATOR
+
+inline Lanes operator+(const Lanes& x, uint32_t y) {
+  Lanes result;
+  for (size_t l = 0; l < kLanes; ++l) {
+    result[l] = x[l] + y;
+  }
+  return result;
+}
+
+inline Lanes operator~(const Lanes& x) {
+  Lanes result;
+  for (size_t l = 0; l < kLanes; ++l) {
+    result[l] = ~x[l];
+  }
+  return result;
+}
+
+inline Lanes operator<<(const Lanes& x, int shift) {
+  Lanes result;
+  for (size_t l = 0; l < kLanes; ++l) {
+    result[l] = x[l] << shift;
+  }
+  return result;
+}
+
+inline Lanes operator>>(const Lanes& x, int shift) {
+  Lanes result;
+  for (size_t l = 0; l < kLanes; ++l) {
+    result[l] = x[l] >> shift;
+  }
+  return result;
+}
+
+#endif
+
+// The per-step additive constants of MD5, in step order.
+constexpr uint32_t kStepConstants[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+    0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+    0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+    0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+    0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+    0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+// The per-step rotation amounts of MD5, four for each round.
+constexpr int kRotations[4][4] = {
+    {7, 12, 17, 22}, {5, 9, 14, 20}, {4, 11, 16, 23}, {6, 10, 15, 21}};
+
+/** The index of the message word used by the given step of the given round. */
+template <int Round>
+constexpr int WordIndex(int step) {
+  return Round == 0   ? step
+         : Round == 1 ? (5 * step + 1) % 16
+         : Round == 2 ? (3 * step + 5) % 16
+                      : (7 * step) % 16;
+}
+
+struct LaneState {
+  Lanes a;
+  Lanes b;
+  Lanes c;
+  Lanes d;
+};
+
+/** Runs a single MD5STEP of the given round on all lanes. */
+template <int Round>
+inline void LaneStep(Lanes& w,
+                     const Lanes& x,
+                     const Lanes& y,
+                     const Lanes& z,
+                     const Lanes& word,
+                     int i) {
+  Lanes f = Round == 0   ? F1(x, y, z)
+            : Round == 1 ? F2(x, y, z)
+            : Round == 2 ? F3(x, y, z)
+                         : F4(x, y, z);
+  Lanes t = w + f + word + kStepConstants[i];
+  int shift = kRotations[Round][i % 4];
+  w = x + ((t << shift) | (t >> (32 - shift)));
+}
+
+/**
+ * Runs the 16 steps of the given round of MD5 on all lanes, in the same order
+ * as MD5Transform.
+ */
+template <int Round>
+inline void LaneRound(LaneState& s, const Lanes words[16]) {
+  for (int step = 0; step < 16; step += 4) {
+    int i = Round * 16 + step;
+    LaneStep<Round>(s.a, s.b, s.c, s.d, words[WordIndex<Round>(step)], i);
+    LaneStep<Round>(s.d, s.a, s.b, s.c, words[WordIndex<Round>(step + 1)],
+                    i + 1);
+    LaneStep<Round>(s.c, s.d, s.a, s.b, words[WordIndex<Round>(step + 2)],
+                    i + 2);
+    LaneStep<Round>(s.b, s.c, s.d, s.a, words[WordIndex<Round>(step + 3)],
+                    i + 3);
+  }
+}
+
+/** Runs MD5Transform on a block of 16 words in each lane. */
+void TransformLanes(LaneState* state, const Lanes words[16]) {
+  LaneState s = *state;
+  LaneRound<0>(s, words);
+  LaneRound<1>(s, words);
+  LaneRound<2>(s, words);
+  LaneRound<3>(s, words);
+
+  state->a = state->a + s.a;
+  state->b = state->b + s.b;
+  state->c = state->c + s.c;
+  state->d = state->d + s.d;
+}
+
+/** Returns the number of 64-byte blocks in the padded MD5 message for `s`. */
+size_t BlockCount(absl::string_view s) {
+  // The message is followed by a 0x80 byte and the 8-byte bit length.
+  return (s.size() + 8) / 64 + 1;
+}
+
+/**
+ * Loads the words of the `block`th block of the padded MD5 message for `s`
+ * into lane `lane` of `words`.
+ */
+void LoadBlock(absl::string_view s,
+               size_t block,
+               size_t lane,
+               Lanes words[16]) {
+  uint8_t bytes[64] = {};
+  size_t start = block * 64;
+  if (start < s.size()) {
+    memcpy(bytes, s.data() + start, std::min<size_t>(64, s.size() - start));
+  }
+  if (s.size() >= start && s.size() < start + 64) {
+    bytes[s.size() - start] = 0x80;
+  }
+  if (block == BlockCount(s) - 1) {
+    uint64_t bit_length = static_cast<uint64_t>(s.size()) << 3;
+    for (int j = 0; j < 8; ++j) {
+      bytes[56 + j] = static_cast<uint8_t>(bit_length >> (8 * j));
+    }
+  }
+
+  for (int w = 0; w < 16; ++w) {
+    words[w][lane] = static_cast<uint32_t>(bytes[4 * w]) |
+                     static_cast<uint32_t>(bytes[4 * w + 1]) << 8 |
+                     static_cast<uint32_t>(bytes[4 * w + 2]) << 16 |
+                     static_cast<uint32_t>(bytes[4 * w + 3]) << 24;
+  }
+}
+
+}  // namespace
+
 std::array<uint8_t, 16> CalculateMd5Digest(absl::string_view s) {
   MD5Context ctx;
   MD5Init(&ctx);
@@ -301,6 +505,69 @@ std::array<uint8_t, 16> CalculateMd5Digest(absl::string_view s) {
   return digest;
 }
 
+std::vector<std::array<uint8_t, 16>> CalculateMd5Digests(
+    const std::vector<absl::string_view>& values) {
+  std::vector<std::array<uint8_t, 16>> digests(values.size());
+
+  // Hash strings of the same length in the same group of lanes, so that lanes
+  // rarely sit idle while the others finish their remaining blocks.
+  std::vector<size_t> order(values.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    return BlockCount(values[lhs]) < BlockCount(values[rhs]);
+  });
+
+  for (size_t group = 0; group < order.size(); group += kLanes) {
+    size_t lane_count = std::min(kLanes, order.size() - group);
+    size_t block_counts[kLanes] = {};
+    size_t max_blocks = 0;
+    for (size_t l = 0; l < lane_count; ++l) {
+      block_counts[l] = BlockCount(values[order[group + l]]);
+      max_blocks = std::max(max_blocks, block_counts[l]);
+    }
+
+    LaneState state;
+    state.a = Lanes{} + uint32_t{0x67452301};
+    state.b = Lanes{} + uint32_t{0xefcdab89};
+    state.c = Lanes{} + uint32_t{0x98badcfe};
+    state.d = Lanes{} + uint32_t{0x10325476};
+
+    Lanes words[16] = {};
+    for (size_t block = 0; block < max_blocks; ++block) {
+      for (size_t l = 0; l < lane_count; ++l) {
+        if (block < block_counts[l]) {
+          LoadBlock(values[order[group + l]], block, l, words);
+        }
+      }
+
+      // Lanes that have already finished are transformed too, since that is
+      // cheaper than branching, but keep their final state.
+      LaneState previous = state;
+      TransformLanes(&state, words);
+      for (size_t l = 0; l < kLanes; ++l) {
+        if (block >= block_counts[l]) {
+          state.a[l] = previous.a[l];
+          state.b[l] = previous.b[l];
+          state.c[l] = previous.c[l];
+          state.d[l] = previous.d[l];
+        }
+      }
+    }
+
+    for (size_t l = 0; l < lane_count; ++l) {
+      std::array<uint8_t, 16>& digest = digests[order[group + l]];
+      uint32_t result[4] = {state.a[l], state.b[l], state.c[l], state.d[l]};
+      for (int w = 0; w < 4; ++w) {
+        for (int j = 0; j < 4; ++j) {
+          digest[4 * w + j] = static_cast<uint8_t>(result[w] >> (8 * j));
+        }
+      }
+    }
+  }
+
+  return digests;
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -19,6 +19,7 @@
 
 #include <array>
 #include <cstdint>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 
@@ -31,6 +32,14 @@ namespace util {
  */
 std::array<uint8_t, 16> CalculateMd5Digest(absl::string_view);
 
+/**
+ * Calculates and returns the md5 digests of the given strings, in the same
+ * order. Produces the same digests as `CalculateMd5Digest`, but hashes several
+ * strings at once, which is considerably faster for many short strings.
+ */
+std::vector<std::array<uint8_t, 16>> CalculateMd5Digests(
+    const std::vector<absl::string_view>& values);
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -41,6 +41,24 @@
 #define UNALIGNED_STORE32 ABSL_INTERNAL_UNALIGNED_STORE32
 #define UNALIGNED_STORE64 ABSL_INTERNAL_UNALIGNED_STORE64
 
+// Vectorized scanning for special bytes is enabled whenever the target
+// instruction set guarantees the required extensions at compile time. There
+// is no runtime dispatch: AVX2 is only used when the whole build targets it.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ORDERED_CODE_USE_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ORDERED_CODE_USE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__) && \
+    defined(ABSL_IS_LITTLE_ENDIAN)
+#include <arm_neon.h>
+#define ORDERED_CODE_USE_NEON 1
+#endif
+
 // We encode a string in different ways depending on whether the item
 // should be in lexicographically increasing or decreasing order.
 //
@@ -263,6 +281,17 @@ inline int AdvanceIfNoSpecialBytes(uint32_t v_32, const char* p) {
   }
 }
 
+// Returns the index of the lowest set bit in "mask".
+//
+// REQUIRES: mask != 0
+inline int LowestSetBit(uint32_t mask) {
+  return Bits::Log2FloorNonZero(mask & (~mask + 1));
+}
+
+inline int LowestSetBit64(uint64_t mask) {
+  return Bits::Log2FloorNonZero64(mask & (~mask + 1));
+}
+
 // Return a pointer to the first byte in the range "[start..limit)"
 // whose value is 0 or 255 (kEscape1 or kEscape2).  If no such byte
 // exists in the range, returns "limit".
@@ -271,6 +300,52 @@ inline const char* SkipToNextSpecialByte(const char* start, const char* limit) {
   static_assert(kEscape1 == 0, "bit fiddling needs readjusting");
   static_assert((kEscape2 & 0xff) == 255, "bit fiddling needs readjusting");
   const char* p = start;
+
+  // Long strings (document paths, string index values) are scanned a whole
+  // vector register at a time: compare every byte against both special
+  // values and turn the result into a bitmask whose lowest set bit is the
+  // first special byte. Whatever is left over falls through to the 8-byte
+  // loop below.
+#if defined(ORDERED_CODE_USE_AVX2)
+  const __m256i zeros_32 = _mm256_setzero_si256();
+  const __m256i ones_32 = _mm256_set1_epi8(static_cast<char>(0xff));
+  while (p + 32 <= limit) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(v, zeros_32),
+                                      _mm256_cmpeq_epi8(v, ones_32));
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+    if (mask != 0) return p + LowestSetBit(mask);
+    p += 32;
+  }
+#endif
+
+#if defined(ORDERED_CODE_USE_SSE2)
+  const __m128i zeros_16 = _mm_setzero_si128();
+  const __m128i ones_16 = _mm_set1_epi8(static_cast<char>(0xff));
+  while (p + 16 <= limit) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, zeros_16),
+                                   _mm_cmpeq_epi8(v, ones_16));
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+    if (mask != 0) return p + LowestSetBit(mask);
+    p += 16;
+  }
+#elif defined(ORDERED_CODE_USE_NEON)
+  const uint8x16_t zeros_16 = vdupq_n_u8(0);
+  const uint8x16_t ones_16 = vdupq_n_u8(0xff);
+  while (p + 16 <= limit) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t special =
+        vorrq_u8(vceqq_u8(v, zeros_16), vceqq_u8(v, ones_16));
+    // NEON has no movemask: narrowing each 16-bit lane by 4 bits leaves one
+    // nibble per input byte, all ones for the special bytes.
+    uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+    if (mask != 0) return p + (LowestSetBit64(mask) >> 2);
+    p += 16;
+  }
+#endif
+
   while (p + 8 <= limit) {
     // Find out if any of the next 8 bytes are either 0 or 255 (our
     // two characters that require special handling).  We do this using
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/work_stealing_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/no_destructor.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+// The pool whose worker is running on the current thread, if any, and the
+// index of that worker.
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+int DefaultThreadCount() {
+  return static_cast<int>(
+      std::max(1u, std::thread::hardware_concurrency()));
+}
+
+}  // namespace
+
+class WorkStealingPool::Worker {
+ public:
+  ~Worker() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DrainInboxLocked();
+  }
+
+  /** Adds the `operation` to the inbox. Never blocks. */
+  void Push(Operation&& operation) {
+    auto* node = new Node{std::move(operation), nullptr};
+    Node* head = inbox_.load(std::memory_order_relaxed);
+    do {
+      node->next = head;
+    } while (!inbox_.compare_exchange_weak(head, node,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  }
+
+  /**
+   * Takes a task. The owner takes the oldest task, while thieves take the
+   * newest one so that they rarely contend with the owner over the same end.
+   */
+  bool Pop(bool steal, Operation* operation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DrainInboxLocked();
+    if (deque_.empty()) {
+      return false;
+    }
+
+    if (steal) {
+      *operation = std::move(deque_.back());
+      deque_.pop_back();
+    } else {
+      *operation = std::move(deque_.front());
+      deque_.pop_front();
+    }
+    return true;
+  }
+
+ private:
+  struct Node {
+    Operation operation;
+    Node* next;
+  };
+
+  // Moves every task in the inbox to the back of the deque. The inbox is a
+  // stack, so its contents are reversed to preserve submission order.
+  void DrainInboxLocked() {
+    Node* node = inbox_.exchange(nullptr, std::memory_order_acquire);
+    Node* reversed = nullptr;
+    while (node) {
+      Node* next = node->next;
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+
+    while (reversed) {
+      Node* next = reversed->next;
+      deque_.push_back(std::move(reversed->operation));
+      delete reversed;
+      reversed = next;
+    }
+  }
+
+  std::atomic<Node*> inbox_{nullptr};
+
+  // Guards `deque_`. Held only while moving tasks, never while running them.
+  std::mutex mutex_;
+  std::deque<Operation> deque_;
+};
+
+WorkStealingPool& WorkStealingPool::Shared() {
+  static NoDestructor<WorkStealingPool> pool(DefaultThreadCount());
+  return *pool;
+}
+
+WorkStealingPool::WorkStealingPool(int threads) {
+  HARD_ASSERT(threads > 0);
+
+  for (int i = 0; i < threads; ++i) {
+    workers_.push_back(absl::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  HARD_ASSERT(!IsCurrentPool(),
+              "WorkStealingPool cannot be destroyed by one of its own tasks");
+
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    shutting_down_ = true;
+  }
+  wake_.notify_all();
+
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::Execute(Operation&& operation) {
+  // Count the task before publishing it so that a worker can never observe
+  // `pending_` as zero while the task is queued.
+  pending_.fetch_add(1);
+
+  // Tasks spawned by a worker stay on that worker, where their inputs are
+  // likely still in cache. Others are spread round-robin.
+  size_t index = IsCurrentPool() ? current_worker
+                                 : next_worker_.fetch_add(
+                                       1, std::memory_order_relaxed) %
+                                       workers_.size();
+  workers_[index]->Push(std::move(operation));
+
+  // Pairs with the increment of `sleepers_` in `WorkerLoop`: either this
+  // thread sees the sleeper, or the sleeper sees the new value of `pending_`.
+  if (sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wake_.notify_one();
+  }
+}
+
+bool WorkStealingPool::IsCurrentPool() const {
+  return current_pool == this;
+}
+
+void WorkStealingPool::WorkerLoop(size_t index) {
+  current_pool = this;
+  current_worker = index;
+
+  for (;;) {
+    Operation operation;
+    if (TakeTask(index, &operation)) {
+      operation();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleepers_.fetch_add(1);
+    wake_.wait(lock, [this] { return pending_.load() > 0 || shutting_down_; });
+    sleepers_.fetch_sub(1);
+    if (shutting_down_ && pending_.load() == 0) {
+      break;
+    }
+  }
+
+  current_pool = nullptr;
+}
+
+bool WorkStealingPool::TakeTask(size_t index, Operation* operation) {
+  if (pending_.load() <= 0) {
+    return false;
+  }
+
+  size_t size = workers_.size();
+  if (index < size && workers_[index]->Pop(/*steal=*/false, operation)) {
+    pending_.fetch_sub(1);
+    return true;
+  }
+
+  // Visit the other workers starting from a neighbor, so that thieves spread
+  // out instead of all contending for the first worker.
+  size_t start = index < size
+                     ? index + 1
+                     : next_worker_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < size; ++i) {
+    size_t victim = (start + i) % size;
+    if (victim == index) {
+      continue;
+    }
+    if (workers_[victim]->Pop(/*steal=*/true, operation)) {
+      pending_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
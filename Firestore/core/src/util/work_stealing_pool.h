@@ -0,0 +1,108 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_UTIL_WORK_STEALING_POOL_H_
+#define FIRESTORE_CORE_SRC_UTIL_WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A fixed-size pool of threads for short, CPU-bound tasks that may run in any
+ * order, such as decoding a batch of documents.
+ *
+ * Every worker owns a deque of tasks. Tasks are submitted without taking a
+ * lock by pushing them onto a worker's inbox, which the worker (or a thief)
+ * moves into the deque in submission order. Idle workers steal from the other
+ * workers before going to sleep, so a burst of tasks submitted to a single
+ * worker is spread across the pool.
+ *
+ * Unlike `Executor`, the pool has no notion of delayed operations or of
+ * cancellation, and makes no ordering guarantees between tasks. All Firestore
+ * instances in a process share the pool returned by `Shared()`.
+ *
+ * This class is thread-safe.
+ */
+class WorkStealingPool {
+ public:
+  using Operation = std::function<void()>;
+
+  /**
+   * Returns the process-wide pool, which has one thread per hardware thread.
+   * The pool is created on first use and never destroyed.
+   */
+  static WorkStealingPool& Shared();
+
+  explicit WorkStealingPool(int threads);
+
+  /**
+   * Runs all tasks that are still queued and then joins the worker threads.
+   * Must not be called from one of the pool's own threads.
+   */
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  /** Schedules the `operation` to run on one of the pool's threads. */
+  void Execute(Operation&& operation);
+
+  /** Whether the caller is running on one of the pool's threads. */
+  bool IsCurrentPool() const;
+
+  size_t thread_count() const {
+    return workers_.size();
+  }
+
+ private:
+  class Worker;
+
+  void WorkerLoop(size_t index);
+
+  /**
+   * Takes a task from the worker at `index`, or from any other worker if that
+   * one has none. Pass an out-of-range `index` to only steal.
+   */
+  bool TakeTask(size_t index, Operation* operation);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // The number of tasks that have been submitted but not yet taken by a
+  // thread. Sleeping workers wait for this to become positive.
+  std::atomic<int64_t> pending_{0};
+  std::atomic<size_t> next_worker_{0};
+
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::atomic<int> sleepers_{0};
+  bool shutting_down_ = false;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_UTIL_WORK_STEALING_POOL_H_
@@ -33,6 +33,7 @@ TEST(Settings, CopyConstructor) {
     settings.set_ssl_enabled(true);
     settings.set_persistence_enabled(true);
     settings.set_cache_size_bytes(100);
+    settings.set_limbo_lookups_enabled(true);
 
     Settings copy(settings);
 
@@ -41,6 +42,7 @@ TEST(Settings, CopyConstructor) {
     EXPECT_EQ(settings.persistence_enabled(), copy.persistence_enabled());
     EXPECT_EQ(settings.cache_size_bytes(), copy.cache_size_bytes());
     EXPECT_EQ(settings.local_cache_settings(), copy.local_cache_settings());
+    EXPECT_TRUE(copy.limbo_lookups_enabled());
   }
   {
     Settings settings;
@@ -149,6 +151,14 @@ TEST(Settings, EqualityAndHash) {
     EXPECT_NE(settings1, settings2);
     EXPECT_NE(settings1.Hash(), settings2.Hash());
   }
+  {
+    Settings settings1;
+    Settings settings2;
+    settings2.set_limbo_lookups_enabled(true);
+
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
   {
     Settings settings1;
     settings1.set_host("host");
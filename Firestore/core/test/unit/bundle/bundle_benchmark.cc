@@ -0,0 +1,151 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/bundle/bundle_reader.h"
+#include "Firestore/core/src/bundle/bundle_serializer.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/byte_stream_cpp.h"
+#include "Firestore/core/src/util/mapped_file.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/src/util/string_format.h"
+#include "Firestore/core/test/unit/testutil/filesystem_testing.h"
+#include "absl/memory/memory.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::bundle::BundleElement;
+using firebase::firestore::bundle::BundleReader;
+using firebase::firestore::bundle::BundleSerializer;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::remote::Serializer;
+using firebase::firestore::testutil::TestTempDir;
+using firebase::firestore::util::ByteStreamCpp;
+using firebase::firestore::util::MappedFile;
+using firebase::firestore::util::Path;
+using firebase::firestore::util::StringFormat;
+
+namespace {
+
+BundleSerializer MakeSerializer() {
+  return BundleSerializer(Serializer(DatabaseId("p", "default")));
+}
+
+std::string LengthPrefixed(const std::string& element) {
+  return std::to_string(element.size()) + element;
+}
+
+/**
+ * Builds a JSON bundle with `document_count` documents, each with a handful
+ * of fields, and their metadata.
+ */
+std::string JsonBundle(int64_t document_count) {
+  std::string elements;
+  for (int64_t i = 0; i < document_count; ++i) {
+    std::string name = StringFormat(
+        "projects/p/databases/default/documents/coll/doc%s", i);
+    elements += LengthPrefixed(StringFormat(
+        R"({"documentMetadata":{"name":"%s","readTime":{"seconds":"1000",)"
+        R"("nanos":0},"exists":true,"queries":["query"]}})",
+        name));
+    elements += LengthPrefixed(StringFormat(
+        R"({"document":{"name":"%s","updateTime":{"seconds":"1000",)"
+        R"("nanos":0},"fields":{"count":{"integerValue":"%s"},)"
+        R"("title":{"stringValue":"Document number %s"},)"
+        R"("score":{"doubleValue":0.5},"tags":{"arrayValue":{"values":[)"
+        R"({"stringValue":"a"},{"stringValue":"b"}]}},)"
+        R"("nested":{"mapValue":{"fields":{"flag":{"booleanValue":true}}}}}}})",
+        name, i, i));
+  }
+
+  std::string metadata = StringFormat(
+      R"({"metadata":{"id":"bundle","createTime":{"seconds":"1000",)"
+      R"("nanos":0},"version":1,"totalDocuments":%s,"totalBytes":"%s"}})",
+      document_count, elements.size());
+  return LengthPrefixed(metadata) + elements;
+}
+
+std::unique_ptr<BundleReader> JsonReader(const std::string& bundle) {
+  auto input = absl::make_unique<std::istringstream>(bundle);
+  return absl::make_unique<BundleReader>(
+      MakeSerializer(), absl::make_unique<ByteStreamCpp>(std::move(input)));
+}
+
+/** Reads every element of the bundle, and returns how many there are. */
+int64_t ReadAll(BundleReader& reader) {
+  reader.GetBundleMetadata();
+  int64_t count = 0;
+  while (reader.GetNextElement() != nullptr) {
+    ++count;
+  }
+  if (!reader.reader_status().ok()) {
+    abort();
+  }
+  return count;
+}
+
+/** Converts the given JSON bundle into a binary bundle. */
+std::string BinaryBundle(const std::string& json_bundle) {
+  std::unique_ptr<BundleReader> reader = JsonReader(json_bundle);
+  auto metadata = reader->GetBundleMetadata();
+  std::vector<std::unique_ptr<BundleElement>> elements;
+  for (auto element = reader->GetNextElement(); element != nullptr;
+       element = reader->GetNextElement()) {
+    elements.push_back(std::move(element));
+  }
+  return MakeSerializer().EncodeBinaryBundle(metadata, elements);
+}
+
+}  // namespace
+
+static void BM_ReadJsonBundle(benchmark::State& state) {
+  std::string bundle = JsonBundle(state.range(0));
+
+  for (auto _ : state) {
+    std::unique_ptr<BundleReader> reader = JsonReader(bundle);
+    benchmark::DoNotOptimize(ReadAll(*reader));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(bundle.size()));
+}
+BENCHMARK(BM_ReadJsonBundle)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void BM_ReadBinaryBundle(benchmark::State& state) {
+  std::string bundle = BinaryBundle(JsonBundle(state.range(0)));
+  TestTempDir dir;
+  Path path = dir.RandomChild();
+  {
+    std::ofstream out{path.native_value(), std::ios::out | std::ios::binary};
+    out << bundle;
+  }
+
+  for (auto _ : state) {
+    BundleReader reader(MakeSerializer(),
+                        MappedFile::Open(path).ConsumeValueOrDie());
+    benchmark::DoNotOptimize(ReadAll(reader));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(bundle.size()));
+}
+BENCHMARK(BM_ReadBinaryBundle)->Arg(100)->Arg(1000)->Arg(10000);
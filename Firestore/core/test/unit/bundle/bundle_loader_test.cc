@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/bundle/bundle_callback.h"
@@ -63,6 +64,14 @@ class BundleLoaderTest : public ::testing::Test {
       return DocumentMap{};
     }
 
+    model::DocumentMap ApplyBundledDocumentsChunk(
+        const model::MutableDocumentMap& documents,
+        const std::string& bundle_id,
+        bool first_chunk) override {
+      parent_.chunks_.push_back({documents.size(), first_chunk});
+      return ApplyBundledDocuments(documents, bundle_id);
+    }
+
     void SaveNamedQuery(const NamedQuery& query,
                         const model::DocumentKeySet& keys) override {
       parent_.last_queries_.insert({query.query_name(), keys});
@@ -99,9 +108,25 @@ class BundleLoaderTest : public ::testing::Test {
     return BundleMetadata("bundle-1", 1, create_time_, documents, 10);
   }
 
+  /** Adds the metadata and contents of an existing document to the loader. */
+  void AddDocument(BundleLoader& loader,
+                   const std::string& path,
+                   std::vector<std::string> queries = {}) {
+    EXPECT_OK(loader.AddElement(
+        absl::make_unique<BundledDocumentMetadata>(
+            testutil::Key(path), create_time_,
+            /*exists=*/true, std::move(queries)),
+        /*byte_size=*/1));
+    EXPECT_OK(loader.AddElement(
+        absl::make_unique<BundleDocument>(testutil::Doc(path, 1)),
+        /*byte_size=*/1));
+  }
+
  protected:
   std::unique_ptr<BundleCallback> callback_ = nullptr;
   DocumentKeySet last_documents_;
+  // The size and `first_chunk` flag of each applied chunk.
+  std::vector<std::pair<size_t, bool>> chunks_;
   std::unordered_map<std::string, DocumentKeySet> last_queries_;
   std::unordered_map<std::string, BundleMetadata> last_bundles_;
   model::SnapshotVersion create_time_ =
@@ -250,6 +275,94 @@ TEST_F(BundleLoaderTest, VerifiesDocumentCount) {
   EXPECT_NOT_OK(loader.ApplyChanges());
 }
 
+TEST_F(BundleLoaderTest, StreamingLoaderAppliesDocumentsInChunks) {
+  BundleLoader loader(callback_.get(), CreateMetadata(5), /*chunk_size=*/2);
+
+  AddDocument(loader, "coll/doc1");
+  EXPECT_FALSE(loader.chunk_ready());
+  AddDocument(loader, "coll/doc2");
+  ASSERT_TRUE(loader.chunk_ready());
+  loader.ApplyChunk();
+  EXPECT_FALSE(loader.chunk_ready());
+  AssertProgress(loader.progress(), /*documents_loaded=*/2,
+                 /*total_documents=*/5, /*bytes_loaded*/ 4, /*total_bytes*/ 10,
+                 LoadBundleTaskState::kInProgress);
+
+  AddDocument(loader, "coll/doc3");
+  AddDocument(loader, "coll/doc4");
+  ASSERT_TRUE(loader.chunk_ready());
+  loader.ApplyChunk();
+
+  AddDocument(loader, "coll/doc5");
+  EXPECT_FALSE(loader.chunk_ready());
+  EXPECT_OK(loader.ApplyChanges());
+
+  EXPECT_EQ(chunks_, (std::vector<std::pair<size_t, bool>>{
+                         {2, true}, {2, false}, {1, false}}));
+  EXPECT_EQ(last_documents_.size(), 5u);
+  EXPECT_EQ(last_bundles_["bundle-1"], CreateMetadata(5));
+}
+
+TEST_F(BundleLoaderTest, StreamingLoaderReportsProgressPerChunk) {
+  BundleLoader loader(callback_.get(), CreateMetadata(2), /*chunk_size=*/2);
+
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<BundledDocumentMetadata>(
+          testutil::Key("coll/doc1"), create_time_,
+          /*exists=*/false, /*queries=*/std::vector<std::string>{}),
+      /*byte_size*/ 5));
+  BundleLoader::AddElementResult result = loader.AddElement(
+      absl::make_unique<BundledDocumentMetadata>(
+          testutil::Key("coll/doc2"), create_time_,
+          /*exists=*/false, /*queries=*/std::vector<std::string>{}),
+      /*byte_size*/ 5);
+  EXPECT_OK(result);
+  EXPECT_EQ(result.ValueOrDie(), absl::nullopt);
+  AssertProgress(loader.progress(), /*documents_loaded=*/2,
+                 /*total_documents=*/2, /*bytes_loaded*/ 10, /*total_bytes*/ 10,
+                 LoadBundleTaskState::kInProgress);
+}
+
+TEST_F(BundleLoaderTest, StreamingLoaderAppliesNamedQueriesAcrossChunks) {
+  BundleLoader loader(callback_.get(), CreateMetadata(3), /*chunk_size=*/1);
+
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<NamedQuery>(
+          "query-1",
+          BundledQuery(testutil::Query("coll").ToTarget(), LimitType::First),
+          create_time_),
+      /*byte_size=*/1));
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<NamedQuery>(
+          "query-2",
+          BundledQuery(testutil::Query("coll").ToTarget(), LimitType::First),
+          create_time_),
+      /*byte_size=*/1));
+  AddDocument(loader, "coll/doc1", {"query-1"});
+  loader.ApplyChunk();
+  AddDocument(loader, "coll/doc2");
+  loader.ApplyChunk();
+  AddDocument(loader, "coll/doc3", {"query-1"});
+  EXPECT_OK(loader.ApplyChanges());
+
+  EXPECT_EQ(last_queries_["query-1"],
+            (DocumentKeySet{testutil::Key("coll/doc1"),
+                            testutil::Key("coll/doc3")}));
+  EXPECT_EQ(last_queries_["query-2"], DocumentKeySet{});
+}
+
+TEST_F(BundleLoaderTest, StreamingLoaderVerifiesDocumentCount) {
+  BundleLoader loader(callback_.get(), CreateMetadata(3), /*chunk_size=*/1);
+
+  AddDocument(loader, "coll/doc1");
+  loader.ApplyChunk();
+  AddDocument(loader, "coll/doc2");
+  loader.ApplyChunk();
+  // BundleMetadata says there are 3 documents, but only 2 are found.
+  EXPECT_NOT_OK(loader.ApplyChanges());
+  EXPECT_TRUE(last_bundles_.empty());
+}
+
 }  //  namespace
 }  //  namespace bundle
 }  //  namespace firestore
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/bundle/bundle_reader.h"
 
+#include <fstream>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -25,6 +26,7 @@
 #include "Firestore/Protos/cpp/firestore/bundle.pb.h"
 #include "Firestore/Protos/cpp/firestore/local/maybe_document.pb.h"
 #include "Firestore/Protos/cpp/google/firestore/v1/document.pb.h"
+#include "Firestore/core/src/bundle/binary_bundle.h"
 #include "Firestore/core/src/bundle/named_query.h"
 #include "Firestore/core/src/core/field_filter.h"
 #include "Firestore/core/src/local/local_serializer.h"
@@ -33,7 +35,10 @@
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/src/util/byte_stream_cpp.h"
+#include "Firestore/core/src/util/mapped_file.h"
+#include "Firestore/core/src/util/statusor.h"
 #include "Firestore/core/test/unit/nanopb/nanopb_testing.h"
+#include "Firestore/core/test/unit/testutil/filesystem_testing.h"
 #include "Firestore/core/test/unit/testutil/status_testing.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
 #include "google/protobuf/util/json_util.h"
@@ -58,6 +63,7 @@ using model::DatabaseId;
 using nanopb::ProtobufParse;
 using util::ByteStream;
 using util::ByteStreamCpp;
+using util::MappedFile;
 
 void MessageToJsonString(const Message& message, std::string* output) {
   auto status = google::protobuf::util::MessageToJsonString(message, output);
@@ -138,6 +144,31 @@ class BundleReaderTest : public ::testing::Test {
         ByteStreamCpp(std::move(bundle_istream)));
   }
 
+  /**
+   * Converts the given JSON bundle into a binary bundle, by reading its
+   * elements and encoding them again.
+   */
+  std::string ToBinaryBundle(const std::string& json_bundle) {
+    BundleReader reader(bundle_serializer, ToByteStream(json_bundle));
+    BundleMetadata metadata = reader.GetBundleMetadata();
+    std::vector<std::unique_ptr<BundleElement>> elements;
+    for (auto element = reader.GetNextElement(); element != nullptr;
+         element = reader.GetNextElement()) {
+      elements.push_back(std::move(element));
+    }
+    HARD_ASSERT(reader.reader_status().ok());
+    return bundle_serializer.EncodeBinaryBundle(metadata, elements);
+  }
+
+  std::unique_ptr<MappedFile> ToMappedFile(const std::string& bundle) {
+    util::Path path = temp_dir_.RandomChild();
+    {
+      std::ofstream out{path.native_value(), std::ios::out | std::ios::binary};
+      out << bundle;
+    }
+    return MappedFile::Open(path).ConsumeValueOrDie();
+  }
+
   ProtoNamedQuery LimitQuery() {
     core::Query original = testutil::Query("bundles/docs/colls")
                                .AddingFilter(testutil::Filter("foo", "==", 3))
@@ -334,6 +365,7 @@ class BundleReaderTest : public ::testing::Test {
   std::string message_differences;
 
  private:
+  testutil::TestTempDir temp_dir_;
   std::vector<std::string> elements_;
 };
 
@@ -501,6 +533,58 @@ TEST_F(BundleReaderTest, ReadsLargeDocument) {
       *static_cast<BundleDocument*>(elements[1].get()), LargeDocument2());
 }
 
+TEST_F(BundleReaderTest, ReadsManyElementsInOrder) {
+  // Spans several batches of elements that are decoded in parallel.
+  const int document_count = 150;
+  for (int i = 0; i < document_count; ++i) {
+    ProtoBundledDocumentMetadata metadata = DocumentMetadata2();
+    metadata.set_name(FullPath("bundle/docs/colls/doc-" + std::to_string(i)));
+    ProtoDocument document = Document2();
+    document.set_name(FullPath("bundle/docs/colls/doc-" + std::to_string(i)));
+    AddDocumentMetadata(metadata);
+    AddDocument(document);
+  }
+
+  const auto& bundle = BuildBundle("bundle-1", testutil::Version(6000004000),
+                                   document_count);
+  BundleReader reader(bundle_serializer, ToByteStream(bundle));
+
+  std::vector<std::unique_ptr<BundleElement>> elements =
+      VerifyFullBundleParsed(reader, "bundle-1", testutil::Version(6000004000));
+
+  ASSERT_EQ(elements.size(), static_cast<size_t>(2 * document_count));
+  for (int i = 0; i < document_count; ++i) {
+    const auto& metadata =
+        static_cast<const BundledDocumentMetadata&>(*elements[2 * i]);
+    EXPECT_EQ(metadata.key(),
+              testutil::Key("bundle/docs/colls/doc-" + std::to_string(i)));
+    const auto& document =
+        static_cast<const BundleDocument&>(*elements[2 * i + 1]);
+    EXPECT_EQ(document.key(),
+              testutil::Key("bundle/docs/colls/doc-" + std::to_string(i)));
+  }
+}
+
+TEST_F(BundleReaderTest, ReturnsElementsBeforeAnError) {
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+  AddDocumentMetadata(DocumentMetadata2());
+
+  const auto& bundle =
+      BuildBundle("bundle-1", testutil::Version(6000004000), 2);
+  BundleReader reader(bundle_serializer, ToByteStream(bundle + "10{"));
+
+  EXPECT_NE(reader.GetNextElement(), nullptr);
+  EXPECT_OK(reader.reader_status());
+  EXPECT_NE(reader.GetNextElement(), nullptr);
+  EXPECT_OK(reader.reader_status());
+  EXPECT_NE(reader.GetNextElement(), nullptr);
+  EXPECT_OK(reader.reader_status());
+
+  EXPECT_EQ(reader.GetNextElement(), nullptr);
+  EXPECT_NOT_OK(reader.reader_status());
+}
+
 TEST_F(BundleReaderTest, FailsWithBadLengthPrefix) {
   const auto& bundle =
       BuildBundle("bundle-1", testutil::Version(6000004000), 0);
@@ -578,6 +662,107 @@ TEST_F(BundleReaderTest, FailsWhenBundleIsSomehowCorrupted) {
   }
 }
 
+TEST_F(BundleReaderTest, ReadsBinaryBundle) {
+  AddNamedQuery(LimitQuery());
+  AddNamedQuery(LimitToLastQuery());
+  AddDocumentMetadata(DeletedDocumentMetadata());
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+  AddDocumentMetadata(DocumentMetadata2());
+  AddDocument(LargeDocument2());
+
+  const auto& bundle = ToBinaryBundle(
+      BuildBundle("bundle-1", testutil::Version(6000004000), 2));
+  ASSERT_TRUE(IsBinaryBundle(bundle));
+  BundleReader reader(bundle_serializer, ToMappedFile(bundle));
+
+  std::vector<std::unique_ptr<BundleElement>> elements =
+      VerifyFullBundleParsed(reader, "bundle-1", testutil::Version(6000004000));
+
+  ASSERT_EQ(elements.size(), 7);
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[0].get()), LimitQuery());
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[1].get()), LimitToLastQuery());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[2].get()),
+      DeletedDocumentMetadata());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[3].get()),
+      DocumentMetadata1());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[4].get()), Document1());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[5].get()),
+      DocumentMetadata2());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[6].get()), LargeDocument2());
+}
+
+TEST_F(BundleReaderTest, ReadsManyElementsFromBinaryBundleInOrder) {
+  const int document_count = 150;
+  for (int i = 0; i < document_count; ++i) {
+    ProtoDocument document = Document2();
+    document.set_name(FullPath("bundle/docs/colls/doc-" + std::to_string(i)));
+    AddDocument(document);
+  }
+
+  const auto& bundle = ToBinaryBundle(
+      BuildBundle("bundle-1", testutil::Version(6000004000), document_count));
+  BundleReader reader(bundle_serializer, ToMappedFile(bundle));
+
+  std::vector<std::unique_ptr<BundleElement>> elements =
+      VerifyFullBundleParsed(reader, "bundle-1", testutil::Version(6000004000));
+
+  ASSERT_EQ(elements.size(), static_cast<size_t>(document_count));
+  for (int i = 0; i < document_count; ++i) {
+    EXPECT_EQ(static_cast<const BundleDocument&>(*elements[i]).key(),
+              testutil::Key("bundle/docs/colls/doc-" + std::to_string(i)));
+  }
+}
+
+TEST_F(BundleReaderTest, FailsWhenBinaryBundleIsTruncated) {
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+
+  const auto& bundle = ToBinaryBundle(
+      BuildBundle("bundle-1", testutil::Version(6000004000), 1));
+
+  for (size_t size = 0; size < bundle.size(); ++size) {
+    BundleReader reader(bundle_serializer,
+                        ToMappedFile(bundle.substr(0, size)));
+    reader.GetBundleMetadata();
+    while (reader.GetNextElement() != nullptr) {
+    }
+    EXPECT_NOT_OK(reader.reader_status());
+  }
+}
+
+TEST_F(BundleReaderTest, FailsWhenBinaryBundleHasUnknownVersion) {
+  std::string bundle = ToBinaryBundle(
+      BuildBundle("bundle-1", testutil::Version(6000004000), 0));
+  bundle[4] = static_cast<char>(kBinaryBundleVersion + 1);
+
+  BundleReader reader(bundle_serializer, ToMappedFile(bundle));
+
+  EXPECT_EQ(reader.GetBundleMetadata(), BundleMetadata());
+  EXPECT_NOT_OK(reader.reader_status());
+}
+
+TEST_F(BundleReaderTest, FailsWhenBinaryBundleStartsWithoutMetadata) {
+  auto element = absl::make_unique<BundledDocumentMetadata>(
+      testutil::Key("bundle/docs/colls/doc-1"), testutil::Version(1000), false,
+      std::vector<std::string>{});
+  std::string bundle =
+      WriteBinaryBundle({bundle_serializer.EncodeBinaryElement(*element)});
+
+  BundleReader reader(bundle_serializer, ToMappedFile(bundle));
+
+  EXPECT_EQ(reader.GetBundleMetadata(), BundleMetadata());
+  EXPECT_EQ(reader.GetNextElement(), nullptr);
+  EXPECT_NOT_OK(reader.reader_status());
+}
+
 }  //  namespace
 }  //  namespace bundle
 }  //  namespace firestore
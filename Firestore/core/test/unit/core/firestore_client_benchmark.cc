@@ -0,0 +1,300 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/api/settings.h"
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/core/event_listener.h"
+#include "Firestore/core/src/core/firestore_client.h"
+#include "Firestore/core/src/core/listen_options.h"
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/core/query_listener.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/test/unit/remote/fake_firestore_backend.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/types/optional.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::api::Settings;
+using firebase::firestore::core::DatabaseInfo;
+using firebase::firestore::core::EventListener;
+using firebase::firestore::core::FirestoreClient;
+using firebase::firestore::core::ListenOptions;
+using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::credentials::EmptyAppCheckCredentialsProvider;
+using firebase::firestore::credentials::EmptyAuthCredentialsProvider;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::Document;
+using firebase::firestore::model::MutableDocument;
+using firebase::firestore::model::Mutation;
+using firebase::firestore::remote::CreateFirebaseMetadataProviderNoOp;
+using firebase::firestore::remote::FakeFirestoreBackend;
+using firebase::firestore::testutil::Doc;
+using firebase::firestore::testutil::Field;
+using firebase::firestore::testutil::Key;
+using firebase::firestore::testutil::Map;
+using firebase::firestore::testutil::Query;
+using firebase::firestore::testutil::SetMutation;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::Executor;
+using firebase::firestore::util::Status;
+using firebase::firestore::util::StatusOr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* const kCollection = "coll";
+
+DatabaseId BenchmarkDatabaseId() {
+  return DatabaseId("project", "(default)");
+}
+
+double SecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::vector<MutableDocument> MakeDocuments(int64_t document_count) {
+  std::vector<MutableDocument> documents;
+  for (int64_t i = 0; i < document_count; ++i) {
+    documents.push_back(Doc(std::string(kCollection) + "/doc" +
+                                std::to_string(i),
+                            0,
+                            Map("count", i, "title",
+                                "Document number " + std::to_string(i),
+                                "score", 0.5, "marker", 0)));
+  }
+  return documents;
+}
+
+/** Keeps the latest snapshot of a query and lets the caller wait on it. */
+class SnapshotWaiter {
+ public:
+  std::shared_ptr<EventListener<ViewSnapshot>> CreateListener() {
+    return EventListener<ViewSnapshot>::Create(
+        [this](StatusOr<ViewSnapshot> maybe_snapshot) {
+          if (!maybe_snapshot.ok()) return;
+
+          std::lock_guard<std::mutex> lock{mutex_};
+          snapshot_ = std::move(maybe_snapshot).ValueOrDie();
+          condition_.notify_all();
+        });
+  }
+
+  /**
+   * Blocks until the latest snapshot is in sync with the backend and
+   * satisfies `predicate`.
+   */
+  void WaitFor(const std::function<bool(const ViewSnapshot&)>& predicate) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    condition_.wait(lock, [&] {
+      return snapshot_ && !snapshot_->from_cache() && predicate(*snapshot_);
+    });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  absl::optional<ViewSnapshot> snapshot_;
+};
+
+/** A `FirestoreClient` with memory persistence talking to `backend`. */
+class BenchmarkClient {
+ public:
+  explicit BenchmarkClient(const FakeFirestoreBackend& backend) {
+    Settings settings;
+    settings.set_host(backend.host());
+    settings.set_ssl_enabled(false);
+    settings.set_persistence_enabled(false);
+
+    client_ = FirestoreClient::Create(
+        DatabaseInfo(BenchmarkDatabaseId(), "benchmark", backend.host(),
+                     /*ssl_enabled=*/false),
+        settings, std::make_shared<EmptyAuthCredentialsProvider>(),
+        std::make_shared<EmptyAppCheckCredentialsProvider>(),
+        Executor::CreateSerial("com.google.firebase.firestore.benchmark.user"),
+        AsyncQueue::Create(Executor::CreateSerial(
+            "com.google.firebase.firestore.benchmark.worker")),
+        CreateFirebaseMetadataProviderNoOp());
+  }
+
+  ~BenchmarkClient() {
+    client_->Dispose();
+  }
+
+  /** Starts listening to all documents in `kCollection`. */
+  void Listen(SnapshotWaiter* waiter) {
+    client_->ListenToQuery(Query(kCollection), ListenOptions::DefaultOptions(),
+                           waiter->CreateListener());
+  }
+
+  FirestoreClient* operator->() {
+    return client_.get();
+  }
+
+ private:
+  std::shared_ptr<FirestoreClient> client_;
+};
+
+bool HasDocumentCount(const ViewSnapshot& snapshot, size_t count) {
+  return snapshot.documents().size() == count;
+}
+
+}  // namespace
+
+/**
+ * Time from starting a listen on a fresh client until the first snapshot
+ * from the backend, for `range(0)` documents and `range(1)` milliseconds of
+ * latency per message.
+ */
+static void BM_InitialSync(benchmark::State& state) {
+  int64_t document_count = state.range(0);
+  FakeFirestoreBackend backend{BenchmarkDatabaseId()};
+  backend.SetDocuments(MakeDocuments(document_count));
+  backend.SetLatency(Executor::Milliseconds(state.range(1)));
+
+  for (auto _ : state) {
+    // The waiter must outlive the client that delivers snapshots to it.
+    SnapshotWaiter waiter;
+    BenchmarkClient client{backend};
+
+    Clock::time_point start = Clock::now();
+    client.Listen(&waiter);
+    waiter.WaitFor([&](const ViewSnapshot& snapshot) {
+      return HasDocumentCount(snapshot, static_cast<size_t>(document_count));
+    });
+    state.SetIterationTime(SecondsSince(start));
+  }
+  state.SetItemsProcessed(state.iterations() * document_count);
+}
+BENCHMARK(BM_InitialSync)
+    ->Args({100, 0})
+    ->Args({1000, 0})
+    ->Args({10000, 0})
+    ->Args({1000, 10})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Time until `range(0)` writes issued back to back have all been
+ * acknowledged, with `range(1)` milliseconds of latency per message.
+ */
+static void BM_WriteDrain(benchmark::State& state) {
+  int64_t write_count = state.range(0);
+  FakeFirestoreBackend backend{BenchmarkDatabaseId()};
+  backend.SetLatency(Executor::Milliseconds(state.range(1)));
+
+  for (auto _ : state) {
+    BenchmarkClient client{backend};
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    int64_t acknowledged = 0;
+    Status first_error;
+
+    Clock::time_point start = Clock::now();
+    for (int64_t i = 0; i < write_count; ++i) {
+      std::vector<Mutation> mutations;
+      mutations.push_back(SetMutation("writes/doc" + std::to_string(i),
+                                      Map("count", i)));
+      client->WriteMutations(std::move(mutations), [&](Status status) {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!status.ok() && first_error.ok()) first_error = status;
+        ++acknowledged;
+        condition.notify_all();
+      });
+    }
+
+    std::unique_lock<std::mutex> lock{mutex};
+    condition.wait(lock, [&] { return acknowledged == write_count; });
+    state.SetIterationTime(SecondsSince(start));
+
+    if (!first_error.ok()) {
+      state.SkipWithError(first_error.error_message().c_str());
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * write_count);
+}
+BENCHMARK(BM_WriteDrain)
+    ->Args({100, 0})
+    ->Args({1000, 0})
+    ->Args({100, 10})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Time for a listen over `range(0)` documents to come back in sync after the
+ * backend drops all streams and one document changes in the meantime. With
+ * resume tokens this should not grow with the size of the result set.
+ */
+static void BM_ReconnectResume(benchmark::State& state) {
+  int64_t document_count = state.range(0);
+  FakeFirestoreBackend backend{BenchmarkDatabaseId()};
+  backend.SetDocuments(MakeDocuments(document_count));
+  backend.SetLatency(Executor::Milliseconds(state.range(1)));
+
+  SnapshotWaiter waiter;
+  BenchmarkClient client{backend};
+  client.Listen(&waiter);
+  waiter.WaitFor([&](const ViewSnapshot& snapshot) {
+    return HasDocumentCount(snapshot, static_cast<size_t>(document_count));
+  });
+
+  int64_t marker = 0;
+  for (auto _ : state) {
+    ++marker;
+    std::string path = std::string(kCollection) + "/doc0";
+
+    Clock::time_point start = Clock::now();
+    backend.CloseStreams();
+    backend.SetDocuments({Doc(path, 0, Map("marker", marker))});
+    waiter.WaitFor([&](const ViewSnapshot& snapshot) {
+      absl::optional<Document> document =
+          snapshot.documents().GetDocument(Key(path));
+      if (!document) return false;
+
+      auto value = (*document)->field(Field("marker"));
+      return value && value->integer_value == marker;
+    });
+    state.SetIterationTime(SecondsSince(start));
+  }
+}
+BENCHMARK(BM_ReconnectResume)
+    ->Args({100, 0})
+    ->Args({10000, 0})
+    ->Args({1000, 10})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,537 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/core/sync_engine.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/core/sync_engine_callback.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/remote_document_cache.h"
+#include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/remote/datastore.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/remote/remote_store.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/remote/watch_stream.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "Firestore/core/test/unit/testutil/view_testing.h"
+#include "absl/types/optional.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace {
+
+using credentials::EmptyAppCheckCredentialsProvider;
+using credentials::EmptyAuthCredentialsProvider;
+using credentials::User;
+using local::LocalStore;
+using local::MemoryPersistence;
+using local::QueryEngine;
+using local::TargetData;
+using model::DatabaseId;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::MutableDocumentMap;
+using model::OnlineState;
+using model::TargetId;
+using remote::ConnectivityMonitor;
+using remote::Datastore;
+using remote::FirebaseMetadataProvider;
+using remote::GrpcConnection;
+using remote::RemoteEvent;
+using remote::RemoteStore;
+using remote::Serializer;
+using remote::WatchStream;
+using remote::WatchStreamCallback;
+using testing::IsEmpty;
+using testing::SizeIs;
+using testutil::DeletedDoc;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
+using testutil::Version;
+using util::AsyncQueue;
+using util::Status;
+using util::StatusOr;
+
+/** A watch stream that opens right away and never hears from the backend. */
+class FakeWatchStream : public WatchStream {
+ public:
+  FakeWatchStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                  GrpcConnection* grpc_connection,
+                  WatchStreamCallback* callback)
+      : WatchStream{worker_queue,
+                    std::make_shared<EmptyAuthCredentialsProvider>(),
+                    std::make_shared<EmptyAppCheckCredentialsProvider>(),
+                    Serializer{DatabaseId{"p", "d"}},
+                    grpc_connection,
+                    callback},
+        callback_{callback} {
+  }
+
+  void Start() override {
+    open_ = true;
+    callback_->OnWatchStreamOpen();
+  }
+
+  void Stop() override {
+    WatchStream::Stop();
+    open_ = false;
+  }
+
+  bool IsStarted() const override {
+    return open_;
+  }
+  bool IsOpen() const override {
+    return open_;
+  }
+
+  void WatchQuery(const TargetData&) override {
+  }
+  void UnwatchTargetId(TargetId) override {
+  }
+
+ private:
+  bool open_ = false;
+  WatchStreamCallback* callback_ = nullptr;
+};
+
+/**
+ * A datastore whose document lookups stay pending until the test completes
+ * them.
+ */
+class FakeDatastore : public Datastore {
+ public:
+  struct Lookup {
+    std::vector<DocumentKey> keys;
+    LookupCallback callback;
+  };
+
+  FakeDatastore(const DatabaseInfo& database_info,
+                const std::shared_ptr<AsyncQueue>& worker_queue,
+                ConnectivityMonitor* connectivity_monitor,
+                FirebaseMetadataProvider* firebase_metadata_provider)
+      : Datastore{database_info,
+                  worker_queue,
+                  std::make_shared<EmptyAuthCredentialsProvider>(),
+                  std::make_shared<EmptyAppCheckCredentialsProvider>(),
+                  connectivity_monitor,
+                  firebase_metadata_provider},
+        worker_queue_{worker_queue} {
+  }
+
+  std::shared_ptr<WatchStream> CreateWatchStream(
+      WatchStreamCallback* callback) override {
+    return std::make_shared<FakeWatchStream>(worker_queue_, grpc_connection(),
+                                             callback);
+  }
+
+  void LookupDocuments(const std::vector<DocumentKey>& keys,
+                       LookupCallback&& callback) override {
+    lookups.push_back({keys, std::move(callback)});
+  }
+
+  /** Completes the oldest pending lookup with `result`. */
+  void CompleteLookup(const StatusOr<std::vector<Document>>& result) {
+    Lookup lookup = std::move(lookups.front());
+    lookups.erase(lookups.begin());
+    lookup.callback(result);
+  }
+
+  std::vector<Lookup> lookups;
+
+ private:
+  std::shared_ptr<AsyncQueue> worker_queue_;
+};
+
+class FakeSyncEngineCallback : public SyncEngineCallback {
+ public:
+  void HandleOnlineStateChange(OnlineState) override {
+  }
+
+  void OnViewSnapshots(std::vector<ViewSnapshot>&& new_snapshots) override {
+    for (ViewSnapshot& snapshot : new_snapshots) {
+      snapshots.push_back(snapshot);
+      last_snapshot = std::move(snapshot);
+    }
+  }
+
+  void OnError(const Query&, const Status&) override {
+  }
+
+  /** Every snapshot raised so far, in the order they were raised. */
+  std::vector<ViewSnapshot> snapshots;
+  absl::optional<ViewSnapshot> last_snapshot;
+};
+
+/** Returns a document in "coll" that matches the test query. */
+model::MutableDocument CollectionDoc(const std::string& id, int64_t version) {
+  return Doc("coll/" + id, version, Map("id", id));
+}
+
+/** Returns `doc` as a lookup that read it at `read_time` would. */
+model::MutableDocument LookedUp(model::MutableDocument doc, int64_t read_time) {
+  doc.WithReadTime(Version(read_time));
+  return doc;
+}
+
+/** Marks `target_id` as current without changing the documents in it. */
+RemoteEvent MarkCurrentEvent(TargetId target_id, int64_t version) {
+  RemoteEvent::TargetChangeMap target_changes;
+  target_changes[target_id] = testutil::MarkCurrent();
+  return RemoteEvent{Version(version), std::move(target_changes),
+                     RemoteEvent::TargetMismatchMap{},
+                     model::DocumentUpdateMap{}, DocumentKeySet{}};
+}
+
+/**
+ * A `SyncEngine` that looks up documents in limbo, over memory persistence and
+ * a `FakeDatastore`, with a worker queue of its own.
+ */
+class SyncEngineStack {
+ public:
+  SyncEngineStack()
+      : worker_queue{testutil::AsyncQueueForTesting()},
+        connectivity_monitor{remote::CreateNoOpConnectivityMonitor()},
+        firebase_metadata_provider{
+            remote::CreateFirebaseMetadataProviderNoOp()},
+        persistence{local::MemoryPersistenceWithEagerGcForTesting()},
+        local_store{persistence.get(), &query_engine, User::Unauthenticated()},
+        datastore{std::make_shared<FakeDatastore>(
+            DatabaseInfo{DatabaseId{"p", "d"}, "", "localhost", false},
+            worker_queue,
+            connectivity_monitor.get(),
+            firebase_metadata_provider.get())},
+        remote_store{&local_store, datastore, worker_queue,
+                     connectivity_monitor.get(), [](OnlineState) {}},
+        sync_engine{&local_store, &remote_store, User::Unauthenticated(),
+                    /*max_concurrent_limbo_resolutions=*/100,
+                    LimboResolutionMode::kBatchedLookup} {
+    local_store.Start();
+    remote_store.set_sync_engine(&sync_engine);
+    sync_engine.SetCallback(&callback);
+    worker_queue->EnqueueBlocking([&] { remote_store.Start(); });
+  }
+
+  ~SyncEngineStack() {
+    worker_queue->EnqueueBlocking([&] { remote_store.Shutdown(); });
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider;
+
+  std::unique_ptr<MemoryPersistence> persistence;
+  QueryEngine query_engine;
+  LocalStore local_store;
+
+  std::shared_ptr<FakeDatastore> datastore;
+  RemoteStore remote_store;
+  SyncEngine sync_engine;
+  FakeSyncEngineCallback callback;
+};
+
+}  // namespace
+
+class SyncEngineTest : public testing::Test, public SyncEngineStack {
+ public:
+  /**
+   * Listens to "coll", which has `document_count` documents in the cache that
+   * the backend then leaves out of the query's results, putting all of them in
+   * limbo.
+   */
+  void PutDocumentsInLimbo(int document_count) {
+    MutableDocumentMap documents;
+    for (int i = 0; i < document_count; ++i) {
+      model::MutableDocument doc = CollectionDoc(std::to_string(i), 1);
+      documents = documents.insert(doc.key(), doc);
+    }
+    local_store.ApplyBundledDocuments(documents, "bundle");
+
+    target_id = sync_engine.Listen(testutil::Query("coll"));
+    sync_engine.ApplyRemoteEvent(MarkCurrentEvent(target_id, 2));
+  }
+
+  TargetId target_id = 0;
+};
+
+TEST_F(SyncEngineTest, LooksUpLimboDocumentsInBatches) {
+  worker_queue->EnqueueBlocking([&] {
+    PutDocumentsInLimbo(501);
+
+    // Only one lookup runs at a time, with at most 500 documents.
+    ASSERT_THAT(datastore->lookups, SizeIs(1));
+    EXPECT_THAT(datastore->lookups[0].keys, SizeIs(500));
+    EXPECT_THAT(sync_engine.GetActiveLimboDocumentLookups(), SizeIs(500));
+    EXPECT_THAT(sync_engine.GetEnqueuedLimboDocumentLookups(), SizeIs(1));
+    EXPECT_THAT(sync_engine.GetActiveLimboDocumentResolutions(), IsEmpty());
+
+    std::vector<Document> deleted;
+    for (const DocumentKey& key : datastore->lookups[0].keys) {
+      deleted.push_back(LookedUp(DeletedDoc(key, 3), 4));
+    }
+    datastore->CompleteLookup(deleted);
+
+    ASSERT_THAT(datastore->lookups, SizeIs(1));
+    EXPECT_THAT(datastore->lookups[0].keys, SizeIs(1));
+    EXPECT_THAT(sync_engine.GetEnqueuedLimboDocumentLookups(), IsEmpty());
+    EXPECT_THAT(sync_engine.GetActiveLimboDocumentResolutions(), IsEmpty());
+  });
+}
+
+TEST_F(SyncEngineTest, AppliesLookupResultAsRemoteEvent) {
+  worker_queue->EnqueueBlocking([&] {
+    PutDocumentsInLimbo(2);
+    ASSERT_THAT(datastore->lookups, SizeIs(1));
+
+    datastore->CompleteLookup(std::vector<Document>{
+        LookedUp(DeletedDoc("coll/0", 3), 4),
+        LookedUp(CollectionDoc("1", 3), 4)});
+
+    ASSERT_TRUE(callback.last_snapshot.has_value());
+    const model::DocumentSet& documents = callback.last_snapshot->documents();
+    EXPECT_FALSE(documents.ContainsKey(Key("coll/0")));
+    ASSERT_TRUE(documents.ContainsKey(Key("coll/1")));
+    EXPECT_EQ((*documents.GetDocument(Key("coll/1")))->version(), Version(3));
+
+    // The lookup isn't part of a consistent snapshot of the watch stream, so
+    // it must not move the global snapshot version forward.
+    EXPECT_EQ(local_store.GetLastRemoteSnapshotVersion(), Version(2));
+    EXPECT_THAT(sync_engine.GetActiveLimboDocumentLookups(), IsEmpty());
+    EXPECT_THAT(sync_engine.GetActiveLimboDocumentResolutions(), IsEmpty());
+  });
+}
+
+TEST_F(SyncEngineTest, StoresLookedUpDocumentsAtLookupReadTime) {
+  worker_queue->EnqueueBlocking([&] {
+    PutDocumentsInLimbo(2);
+    ASSERT_THAT(datastore->lookups, SizeIs(1));
+
+    datastore->CompleteLookup(std::vector<Document>{
+        LookedUp(DeletedDoc("coll/0", 3), 5),
+        LookedUp(CollectionDoc("1", 3), 5)});
+
+    // The documents' versions are their update times, which say nothing about
+    // how fresh the cached copies are.
+    local::RemoteDocumentCache* cache = persistence->remote_document_cache();
+    EXPECT_EQ(cache->Get(Key("coll/1")).read_time(), Version(5));
+    EXPECT_EQ(cache->Get(Key("coll/1")).version(), Version(3));
+  });
+}
+
+TEST_F(SyncEngineTest, ResolvesLimboDocumentsWithListensWhenLookupFails) {
+  worker_queue->EnqueueBlocking([&] {
+    PutDocumentsInLimbo(2);
+    ASSERT_THAT(datastore->lookups, SizeIs(1));
+
+    datastore->CompleteLookup(Status{Error::kErrorUnavailable, "Offline"});
+
+    auto resolutions = sync_engine.GetActiveLimboDocumentResolutions();
+    EXPECT_THAT(resolutions, SizeIs(2));
+    EXPECT_EQ(resolutions.count(Key("coll/0")), 1u);
+    EXPECT_EQ(resolutions.count(Key("coll/1")), 1u);
+    EXPECT_THAT(sync_engine.GetActiveLimboDocumentLookups(), IsEmpty());
+  });
+}
+
+TEST_F(SyncEngineTest, DoesNotListenToDocumentsThatLeftLimboDuringLookup) {
+  worker_queue->EnqueueBlocking([&] {
+    PutDocumentsInLimbo(2);
+    ASSERT_THAT(datastore->lookups, SizeIs(1));
+
+    // The backend now says "coll/0" is part of the query after all.
+    sync_engine.ApplyRemoteEvent(
+        testutil::AddedRemoteEvent(CollectionDoc("0", 3), {target_id}));
+
+    datastore->CompleteLookup(Status{Error::kErrorUnavailable, "Offline"});
+
+    auto resolutions = sync_engine.GetActiveLimboDocumentResolutions();
+    EXPECT_THAT(resolutions, SizeIs(1));
+    EXPECT_EQ(resolutions.count(Key("coll/1")), 1u);
+  });
+}
+
+TEST_F(SyncEngineTest, RoutesChangesToCollectionGroupQueries) {
+  worker_queue->EnqueueBlocking([&] {
+    TargetId collection_target = sync_engine.Listen(testutil::Query("a/1/c"));
+    sync_engine.Listen(testutil::CollectionGroupQuery("c"));
+    callback.snapshots.clear();
+
+    // Only the collection's target hears of the document, so the collection
+    // group query has to be found through the collection ID.
+    sync_engine.ApplyRemoteEvent(testutil::AddedRemoteEvent(
+        Doc("a/1/c/x", 2, Map("id", "x")), {collection_target}));
+
+    ASSERT_THAT(callback.snapshots, SizeIs(2));
+    const ViewSnapshot& group_snapshot = callback.snapshots[1];
+    EXPECT_EQ(group_snapshot.query(), testutil::CollectionGroupQuery("c"));
+    EXPECT_TRUE(group_snapshot.documents().ContainsKey(Key("a/1/c/x")));
+  });
+}
+
+TEST_F(SyncEngineTest, RoutesChangesToDocumentQueries) {
+  worker_queue->EnqueueBlocking([&] {
+    TargetId collection_target = sync_engine.Listen(testutil::Query("coll"));
+    sync_engine.Listen(testutil::Query("coll/a"));
+    sync_engine.Listen(testutil::Query("coll/b"));
+    callback.snapshots.clear();
+
+    // Document queries are indexed by their parent collection. The one on
+    // "coll/b" is handed the change too, but it doesn't match, so its view
+    // raises no snapshot.
+    sync_engine.ApplyRemoteEvent(
+        testutil::AddedRemoteEvent(CollectionDoc("a", 2), {collection_target}));
+
+    ASSERT_THAT(callback.snapshots, SizeIs(2));
+    const ViewSnapshot& document_snapshot = callback.snapshots[1];
+    EXPECT_EQ(document_snapshot.query(), testutil::Query("coll/a"));
+    EXPECT_TRUE(document_snapshot.documents().ContainsKey(Key("coll/a")));
+  });
+}
+
+TEST_F(SyncEngineTest, RoutesTargetChangesWithoutDocumentChanges) {
+  worker_queue->EnqueueBlocking([&] {
+    TargetId target = sync_engine.Listen(testutil::Query("coll"));
+    ASSERT_THAT(callback.snapshots, SizeIs(1));
+    EXPECT_TRUE(callback.snapshots[0].from_cache());
+
+    sync_engine.ApplyRemoteEvent(MarkCurrentEvent(target, 2));
+
+    ASSERT_THAT(callback.snapshots, SizeIs(2));
+    EXPECT_FALSE(callback.snapshots[1].from_cache());
+    EXPECT_TRUE(callback.snapshots[1].sync_state_changed());
+  });
+}
+
+TEST_F(SyncEngineTest, DoesNotRouteChangesToQueriesNoLongerListenedTo) {
+  worker_queue->EnqueueBlocking([&] {
+    std::vector<Query> queries{testutil::Query("coll"),
+                               testutil::Query("coll/a"),
+                               testutil::CollectionGroupQuery("coll")};
+    std::vector<TargetId> targets;
+    for (const Query& query : queries) {
+      targets.push_back(sync_engine.Listen(query));
+    }
+    sync_engine.ApplyRemoteEvent(
+        testutil::AddedRemoteEvent(CollectionDoc("a", 2), targets));
+    ASSERT_THAT(callback.snapshots, SizeIs(6));
+
+    for (const Query& query : queries) {
+      sync_engine.StopListening(query);
+    }
+    callback.snapshots.clear();
+
+    sync_engine.ApplyRemoteEvent(
+        testutil::AddedRemoteEvent(CollectionDoc("a", 3), targets));
+    EXPECT_THAT(callback.snapshots, IsEmpty());
+  });
+}
+
+TEST_F(SyncEngineTest, DoesNotRouteChangesToQueriesOfRejectedListens) {
+  worker_queue->EnqueueBlocking([&] {
+    std::vector<TargetId> targets{
+        sync_engine.Listen(testutil::Query("coll")),
+        sync_engine.Listen(testutil::Query("coll/a")),
+        sync_engine.Listen(testutil::CollectionGroupQuery("coll"))};
+
+    for (TargetId target : targets) {
+      sync_engine.HandleRejectedListen(
+          target, Status{Error::kErrorPermissionDenied, "Permission denied"});
+    }
+    callback.snapshots.clear();
+
+    sync_engine.ApplyRemoteEvent(
+        testutil::AddedRemoteEvent(CollectionDoc("a", 2), targets));
+    EXPECT_THAT(callback.snapshots, IsEmpty());
+  });
+}
+
+TEST_F(SyncEngineTest, ComputesViewsInParallelLikeOneAtATime) {
+  std::vector<Query> queries{
+      testutil::Query("coll"),
+      testutil::Query("coll").AddingFilter(testutil::Filter("id", ">=", "5")),
+      testutil::Query("coll").AddingOrderBy(testutil::OrderBy("id", "desc"))};
+  std::vector<model::MutableDocument> docs;
+  for (int i = 0; i < 600; ++i) {
+    docs.push_back(CollectionDoc(std::to_string(i), 2));
+  }
+
+  // Routed to all three views, the changes are enough for them to be computed
+  // in parallel.
+  std::vector<ViewSnapshot> parallel_snapshots;
+  worker_queue->EnqueueBlocking([&] {
+    std::vector<TargetId> targets;
+    for (const Query& query : queries) {
+      targets.push_back(sync_engine.Listen(query));
+    }
+    callback.snapshots.clear();
+
+    sync_engine.ApplyRemoteEvent(testutil::AddedRemoteEvent(docs, targets));
+    parallel_snapshots = callback.snapshots;
+  });
+
+  // A view that is the only one affected is always computed on its own. The
+  // views were listened to in order, so their snapshots are raised in it too.
+  std::vector<ViewSnapshot> serial_snapshots;
+  for (const Query& query : queries) {
+    SyncEngineStack stack;
+    stack.worker_queue->EnqueueBlocking([&] {
+      TargetId target = stack.sync_engine.Listen(query);
+      stack.callback.snapshots.clear();
+
+      stack.sync_engine.ApplyRemoteEvent(
+          testutil::AddedRemoteEvent(docs, {target}));
+      ASSERT_THAT(stack.callback.snapshots, SizeIs(1));
+      serial_snapshots.push_back(stack.callback.snapshots[0]);
+    });
+  }
+
+  ASSERT_THAT(parallel_snapshots, SizeIs(queries.size()));
+  EXPECT_EQ(parallel_snapshots, serial_snapshots);
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -466,6 +466,154 @@ TEST(ViewTest, DoesntNeedRefillOnReorderAfterLimitQuery) {
   view.ApplyChanges(changes);
 }
 
+TEST(ViewTest, DoesntSpillInitialDocsPastLimit) {
+  Query query = QueryForMessages().WithLimitToFirst(2);
+  Document doc1 = Doc("rooms/eros/messages/0", 0, Map());
+  Document doc2 = Doc("rooms/eros/messages/1", 0, Map());
+  Document doc3 = Doc("rooms/eros/messages/2", 0, Map());
+  View view(query, DocumentKeySet{});
+
+  // The initial results may skip docs past the limit, so none are spilled.
+  ViewDocumentChanges changes =
+      view.ComputeDocumentChanges(DocUpdates({doc1, doc2, doc3}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc1, doc2}));
+  ASSERT_THAT(changes.spilled_documents(), ContainsDocs({}));
+  view.ApplyChanges(changes);
+
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/0")}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc2}));
+  ASSERT_TRUE(changes.needs_refill());
+}
+
+TEST(ViewTest, RefillsFromSpilledDocsOnDeleteInLimitQuery) {
+  Query query = QueryForMessages().WithLimitToFirst(2);
+  Document doc1 = Doc("rooms/eros/messages/0", 0, Map());
+  Document doc2 = Doc("rooms/eros/messages/1", 0, Map());
+  Document doc3 = Doc("rooms/eros/messages/2", 0, Map());
+  Document doc4 = Doc("rooms/eros/messages/3", 0, Map());
+  View view(query, DocumentKeySet{});
+
+  ViewDocumentChanges changes =
+      view.ComputeDocumentChanges(DocUpdates({doc1, doc2}));
+  view.ApplyChanges(changes);
+
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/0")}));
+  ASSERT_TRUE(changes.needs_refill());
+
+  // The refill reads past the limit and fills the spill buffer.
+  changes =
+      view.ComputeDocumentChanges(DocUpdates({doc2, doc3, doc4}), changes);
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc2, doc3}));
+  ASSERT_THAT(changes.spilled_documents(), ContainsDocs({doc4}));
+  ASSERT_FALSE(changes.needs_refill());
+  view.ApplyChanges(changes);
+
+  // The spilled doc takes the place of the deleted one.
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/1")}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc3, doc4}));
+  ASSERT_THAT(changes.spilled_documents(), ContainsDocs({}));
+  ASSERT_FALSE(changes.needs_refill());
+  ASSERT_THAT(
+      changes.change_set().GetChanges(),
+      ElementsAre(DocumentViewChange{doc2, DocumentViewChange::Type::Removed},
+                  DocumentViewChange{doc4, DocumentViewChange::Type::Added}));
+  view.ApplyChanges(changes);
+
+  // Once the spill buffer runs out, the view needs a refill.
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/2")}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc4}));
+  ASSERT_TRUE(changes.needs_refill());
+}
+
+TEST(ViewTest, RefillsFromSpilledDocsOnReorderInLimitQuery) {
+  Query query =
+      QueryForMessages().AddingOrderBy(OrderBy("order")).WithLimitToFirst(2);
+  Document doc1 = Doc("rooms/eros/messages/0", 0, Map("order", 1));
+  Document doc2 = Doc("rooms/eros/messages/1", 0, Map("order", 2));
+  Document doc3 = Doc("rooms/eros/messages/2", 0, Map("order", 3));
+  Document doc4 = Doc("rooms/eros/messages/3", 0, Map("order", 4));
+  View view(query, DocumentKeySet{});
+
+  // Refill the initial changes with the docs past the limit as well.
+  ViewDocumentChanges changes =
+      view.ComputeDocumentChanges(DocUpdates({doc1, doc2}));
+  changes = view.ComputeDocumentChanges(DocUpdates({doc1, doc2, doc3, doc4}),
+                                        changes);
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc1, doc2}));
+  ASSERT_THAT(changes.spilled_documents(), ContainsDocs({doc3, doc4}));
+  view.ApplyChanges(changes);
+
+  // Moving doc1 between the spilled docs swaps it with doc3.
+  doc1 = Doc("rooms/eros/messages/0", 1, Map("order", 3.5));
+  changes = view.ComputeDocumentChanges(DocUpdates({doc1}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc2, doc3}));
+  ASSERT_THAT(changes.spilled_documents(), ContainsDocs({doc1, doc4}));
+  ASSERT_FALSE(changes.needs_refill());
+  ASSERT_EQ(2, changes.change_set().GetChanges().size());
+  view.ApplyChanges(changes);
+
+  // Moving doc2 past the last spilled doc drops it, since other docs in the
+  // local cache may belong in between.
+  doc2 = Doc("rooms/eros/messages/1", 1, Map("order", 2000));
+  changes = view.ComputeDocumentChanges(DocUpdates({doc2}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc3, doc1}));
+  ASSERT_THAT(changes.spilled_documents(), ContainsDocs({doc4}));
+  ASSERT_FALSE(changes.needs_refill());
+  view.ApplyChanges(changes);
+}
+
+TEST(ViewTest, RefillsFromSpilledDocsInLimitToLastQuery) {
+  Query query =
+      QueryForMessages().AddingOrderBy(OrderBy("order")).WithLimitToLast(2);
+  Document doc1 = Doc("rooms/eros/messages/0", 0, Map("order", 1));
+  Document doc2 = Doc("rooms/eros/messages/1", 0, Map("order", 2));
+  Document doc3 = Doc("rooms/eros/messages/2", 0, Map("order", 3));
+  View view(query, DocumentKeySet{});
+
+  ViewDocumentChanges changes =
+      view.ComputeDocumentChanges(DocUpdates({doc2, doc3}));
+  changes =
+      view.ComputeDocumentChanges(DocUpdates({doc1, doc2, doc3}), changes);
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc2, doc3}));
+  ASSERT_THAT(changes.spilled_documents(), ContainsDocs({doc1}));
+  view.ApplyChanges(changes);
+
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/2")}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc1, doc2}));
+  ASSERT_FALSE(changes.needs_refill());
+}
+
+TEST(ViewTest, SpillsOnlyDocsWithinRefillLimit) {
+  Query query = QueryForMessages().WithLimitToFirst(1);
+  Document doc1 = Doc("rooms/eros/messages/0", 0, Map());
+  Document doc2 = Doc("rooms/eros/messages/1", 0, Map());
+  Document doc3 = Doc("rooms/eros/messages/2", 0, Map());
+  View view(query, DocumentKeySet{});
+
+  // A refill of a limit 1 query only reads two docs, so any further docs in
+  // its results are not known to be gapless.
+  ViewDocumentChanges changes =
+      view.ComputeDocumentChanges(DocUpdates({doc1}));
+  changes =
+      view.ComputeDocumentChanges(DocUpdates({doc1, doc2, doc3}), changes);
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc1}));
+  ASSERT_THAT(changes.spilled_documents(), ContainsDocs({doc2}));
+}
+
+TEST(ViewTest, RefillQueryReadsSpilledDocs) {
+  Query query = QueryForMessages().AddingOrderBy(OrderBy("order"));
+  ASSERT_EQ(View(query, DocumentKeySet{}).RefillQuery(), query);
+  ASSERT_EQ(View(query.WithLimitToFirst(2), DocumentKeySet{}).RefillQuery(),
+            query.WithLimitToFirst(4));
+  ASSERT_EQ(View(query.WithLimitToLast(500), DocumentKeySet{}).RefillQuery(),
+            query.WithLimitToLast(600));
+}
+
 TEST(ViewTest, DoesntNeedRefillForAdditionAfterTheLimit) {
   Query query = QueryForMessages().WithLimitToFirst(2);
   Document doc1 = Doc("rooms/eros/messages/0", 0, Map());
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/document_key_filter.h"
+
+#include <string>
+
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::DocumentKey;
+using testutil::Key;
+
+DocumentKey NumberedKey(int i) {
+  return Key("coll/doc" + std::to_string(i));
+}
+
+}  // namespace
+
+TEST(DocumentKeyFilterTest, HasNoFalseNegatives) {
+  DocumentKeyFilter filter(1000);
+  for (int i = 0; i < 1000; ++i) {
+    filter.Add(NumberedKey(i));
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(filter.MightContain(NumberedKey(i)));
+  }
+  EXPECT_EQ(filter.added_count(), 1000u);
+}
+
+TEST(DocumentKeyFilterTest, RulesOutMostAbsentKeys) {
+  DocumentKeyFilter filter(1000);
+  for (int i = 0; i < 1000; ++i) {
+    filter.Add(NumberedKey(i));
+  }
+
+  int false_positives = 0;
+  for (int i = 1000; i < 11000; ++i) {
+    if (filter.MightContain(NumberedKey(i))) {
+      false_positives++;
+    }
+  }
+  // The filter is sized for about 1% false positives.
+  EXPECT_LT(false_positives, 500);
+}
+
+TEST(DocumentKeyFilterTest, DistinguishesSegmentBoundaries) {
+  DocumentKeyFilter filter(1);
+  filter.Add(Key("a/bc"));
+  EXPECT_TRUE(filter.MightContain(Key("a/bc")));
+  EXPECT_FALSE(filter.MightContain(Key("ab/c")));
+}
+
+TEST(DocumentKeyFilterTest, EncodeDecodeCycle) {
+  DocumentKeyFilter filter(100);
+  for (int i = 0; i < 100; ++i) {
+    filter.Add(NumberedKey(i));
+  }
+
+  auto decoded = DocumentKeyFilter::Decode(filter.Encode());
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_EQ(decoded->added_count(), 100u);
+  EXPECT_EQ(decoded->Encode(), filter.Encode());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(decoded->MightContain(NumberedKey(i)));
+  }
+}
+
+TEST(DocumentKeyFilterTest, RejectsInvalidEncodings) {
+  EXPECT_FALSE(DocumentKeyFilter::Decode("").has_value());
+  EXPECT_FALSE(DocumentKeyFilter::Decode("too short").has_value());
+
+  std::string encoded = DocumentKeyFilter(1).Encode();
+  encoded[0] = '\0';  // Zero hash functions.
+  EXPECT_FALSE(DocumentKeyFilter::Decode(encoded).has_value());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -930,6 +930,42 @@ TEST_F(LevelDbIndexManagerTest, IndexEntriesAreUpdatedWithDeletedDoc) {
   });
 }
 
+TEST_F(LevelDbIndexManagerTest, ArrayIndexEntriesAreUpdated) {
+  persistence_->Run("TestArrayIndexEntriesAreUpdated", [&]() {
+    index_manager_->Start();
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "values", model::Segment::kContains));
+    auto contains = [](int value) {
+      return Query("coll").AddingFilter(
+          Filter("values", "array-contains", value));
+    };
+
+    AddDoc("coll/doc", Map("values", Array(1, 2, 2, 3)));
+    {
+      SCOPED_TRACE("With [1, 2, 2, 3]");
+      VerifyResults(contains(1), {"coll/doc"});
+      VerifyResults(contains(2), {"coll/doc"});
+      VerifyResults(contains(3), {"coll/doc"});
+    }
+
+    AddDoc("coll/doc", Map("values", Array(2, 3, 4)));
+    {
+      SCOPED_TRACE("With [2, 3, 4]");
+      VerifyResults(contains(1), {});
+      VerifyResults(contains(2), {"coll/doc"});
+      VerifyResults(contains(4), {"coll/doc"});
+    }
+
+    AddDoc("coll/doc", Map("values", Array(3)));
+    {
+      SCOPED_TRACE("With [3]");
+      VerifyResults(contains(2), {});
+      VerifyResults(contains(3), {"coll/doc"});
+      VerifyResults(contains(4), {});
+    }
+  });
+}
+
 TEST_F(LevelDbIndexManagerTest, IndexVectorValueFields) {
   persistence_->Run("TestIndexVectorValueFields", [&]() {
     index_manager_->Start();
@@ -1653,6 +1689,118 @@ TEST_F(LevelDbIndexManagerTest,
       });
 }
 
+TEST_F(LevelDbIndexManagerTest, TracksIndexStatistics) {
+  persistence_->Run("TestTracksIndexStatistics", [&]() {
+    index_manager_->Start();
+    SetUpArrayValueFilter();
+
+    std::vector<FieldIndex> indexes = index_manager_->GetFieldIndexes("coll");
+    ASSERT_EQ(indexes.size(), 1);
+    absl::optional<IndexStatistics> statistics =
+        index_manager_->GetIndexStatistics(indexes[0]);
+    ASSERT_TRUE(statistics.has_value());
+    EXPECT_EQ(statistics->document_count, 3);
+    EXPECT_EQ(statistics->entry_count, 9);
+
+    AddDoc("coll/arr1", Map());
+    AddDoc("coll/arr2", Map("values", Array(4, 5)));
+    statistics = index_manager_->GetIndexStatistics(indexes[0]);
+    EXPECT_EQ(statistics->document_count, 2);
+    EXPECT_EQ(statistics->entry_count, 5);
+    EXPECT_EQ(index_manager_->GetCollectionGroupSizeEstimate("coll"), 2);
+  });
+}
+
+TEST_F(LevelDbIndexManagerTest, EstimatesDocumentsMatchingTarget) {
+  persistence_->Run("TestEstimatesDocumentsMatchingTarget", [&]() {
+    index_manager_->Start();
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "count", model::Segment::kAscending));
+    for (int i = 0; i < 30; ++i) {
+      AddDoc("coll/doc" + std::to_string(i), Map("count", i));
+    }
+
+    auto equality = Query("coll").AddingFilter(Filter("count", "==", 1));
+    EXPECT_EQ(index_manager_->EstimateDocumentsMatchingTarget(
+                  equality.ToTarget()),
+              3);
+
+    auto range = Query("coll").AddingFilter(Filter("count", ">", 1));
+    EXPECT_EQ(
+        index_manager_->EstimateDocumentsMatchingTarget(range.ToTarget()), 10);
+    EXPECT_EQ(index_manager_->EstimateDocumentsMatchingTarget(
+                  range.WithLimitToFirst(2).ToTarget()),
+              2);
+
+    auto unindexed = Query("coll").AddingFilter(Filter("other", "==", 1));
+    EXPECT_FALSE(
+        index_manager_->EstimateDocumentsMatchingTarget(unindexed.ToTarget())
+            .has_value());
+  });
+}
+
+TEST_F(LevelDbIndexManagerTest, IndexCursorMergesRangesInOrder) {
+  persistence_->Run("TestIndexCursorMergesRangesInOrder", [&]() {
+    index_manager_->Start();
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "count", model::Segment::kDescending));
+    AddDoc("coll/val1", Map("count", 1));
+    AddDoc("coll/val2", Map("count", 2));
+    AddDoc("coll/val3", Map("count", 3));
+    AddDoc("coll/val4", Map("count", 3));
+    AddDoc("coll/val5", Map("count", 4));
+
+    // NOT_IN scans the ranges on either side of the excluded value.
+    auto query = Query("coll")
+                     .AddingFilter(Filter("count", "not-in", Array(2)))
+                     .AddingOrderBy(OrderBy("count", "desc"))
+                     .WithLimitToFirst(4);
+    std::unique_ptr<IndexCursor> cursor =
+        index_manager_->CreateIndexCursor(query.ToTarget());
+    ASSERT_NE(cursor, nullptr);
+
+    std::vector<model::DocumentKey> keys;
+    for (; cursor->Valid(); cursor->Next()) {
+      keys.push_back(cursor->key());
+    }
+    EXPECT_EQ(keys, (std::vector<model::DocumentKey>{
+                        Key("coll/val5"), Key("coll/val4"), Key("coll/val3"),
+                        Key("coll/val1")}));
+  });
+}
+
+TEST_F(LevelDbIndexManagerTest, IndexCursorReturnsEachDocumentOnce) {
+  persistence_->Run("TestIndexCursorReturnsEachDocumentOnce", [&]() {
+    index_manager_->Start();
+    SetUpArrayValueFilter();
+
+    auto query = Query("coll").AddingFilter(
+        Filter("values", "array-contains-any", Array(1, 2, 4)));
+    std::unique_ptr<IndexCursor> cursor =
+        index_manager_->CreateIndexCursor(query.ToTarget());
+    ASSERT_NE(cursor, nullptr);
+
+    std::vector<model::DocumentKey> keys;
+    for (; cursor->Valid(); cursor->Next()) {
+      keys.push_back(cursor->key());
+    }
+    EXPECT_EQ(keys, (std::vector<model::DocumentKey>{Key("coll/arr1"),
+                                                     Key("coll/arr2")}));
+  });
+}
+
+TEST_F(LevelDbIndexManagerTest, NoIndexCursorForPartialIndex) {
+  persistence_->Run("TestNoIndexCursorForPartialIndex", [&]() {
+    index_manager_->Start();
+    SetUpSingleValueFilter();
+
+    auto query = Query("coll")
+                     .AddingFilter(Filter("count", "==", 1))
+                     .AddingFilter(Filter("other", "==", 1));
+    EXPECT_EQ(index_manager_->CreateIndexCursor(query.ToTarget()), nullptr);
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -226,6 +226,70 @@ TEST(LevelDbDocumentMutationKeyTest, Description) {
       "[document_mutation: user_id=user1 path=foo/bar batch_id=42]", key);
 }
 
+TEST(LevelDbCollectionMutationKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionMutationKey key;
+  std::string user("foo");
+
+  std::vector<DocumentKey> document_keys{testutil::Key("a/b"),
+                                         testutil::Key("a/b/c/d")};
+
+  std::vector<BatchId> batch_ids{0, 1, 100, INT_MAX - 1, INT_MAX};
+
+  for (BatchId batch_id : batch_ids) {
+    for (auto&& document_key : document_keys) {
+      auto encoded =
+          LevelDbCollectionMutationKey::Key(user, document_key, batch_id);
+
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(user, key.user_id());
+      ASSERT_EQ(document_key, key.document_key());
+      ASSERT_EQ(document_key.path().PopLast(), key.collection());
+      ASSERT_EQ(batch_id, key.batch_id());
+    }
+  }
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Ordering) {
+  auto key = [](absl::string_view path, BatchId batch_id) {
+    return LevelDbCollectionMutationKey::Key("1", testutil::Key(path),
+                                             batch_id);
+  };
+
+  // Within a collection, rows are ordered by batch_id before document.
+  ASSERT_LT(key("foo/baz", 1), key("foo/bar", 2));
+  ASSERT_LT(key("foo/bar", 1), key("foo/baz", 1));
+
+  // Subcollections sort after all rows of their parent collection.
+  ASSERT_LT(key("foo/bar", 100), key("foo/bar/suffix/key", 0));
+
+  // Subcollection rows share the prefix of the parent collection.
+  auto collection_prefix =
+      LevelDbCollectionMutationKey::KeyPrefix("1", testutil::Resource("foo"));
+  ASSERT_TRUE(absl::StartsWith(key("foo/bar", 1), collection_prefix));
+  ASSERT_TRUE(
+      absl::StartsWith(key("foo/bar/suffix/key", 1), collection_prefix));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Description) {
+  AssertExpectedKeyDescription("[collection_mutation: incomplete key]",
+                               LevelDbCollectionMutationKey::KeyPrefix());
+
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 incomplete key]",
+      LevelDbCollectionMutationKey::KeyPrefix("user1"));
+
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 path=foo incomplete key]",
+      LevelDbCollectionMutationKey::KeyPrefix("user1",
+                                              testutil::Resource("foo")));
+
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 path=foo batch_id=42 "
+      "document_id=bar]",
+      LevelDbCollectionMutationKey::Key("user1", testutil::Key("foo/bar"), 42));
+}
+
 TEST(LevelDbTargetGlobalKeyTest, EncodeDecodeCycle) {
   LevelDbTargetGlobalKey key;
 
@@ -239,6 +303,19 @@ TEST(LevelDbTargetGlobalKeyTest, Description) {
                                LevelDbTargetGlobalKey::Key());
 }
 
+TEST(LevelDbTargetDocumentFilterKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetDocumentFilterKey key;
+
+  auto encoded = LevelDbTargetDocumentFilterKey::Key();
+  bool ok = key.Decode(encoded);
+  ASSERT_TRUE(ok);
+}
+
+TEST(LevelDbTargetDocumentFilterKeyTest, Description) {
+  AssertExpectedKeyDescription("[target_document_filter:]",
+                               LevelDbTargetDocumentFilterKey::Key());
+}
+
 TEST(LevelDbTargetKeyTest, EncodeDecodeCycle) {
   LevelDbTargetKey key;
   TargetId target_id = 42;
@@ -253,7 +253,7 @@ TEST_F(LevelDbLocalStoreTest, UsesPartiallyIndexedOverlaysWhenAvailable) {
   FSTAssertQueryReturned("coll/a", "coll/b");
 }
 
-TEST_F(LevelDbLocalStoreTest, DoesNotUseLimitWhenIndexIsOutdated) {
+TEST_F(LevelDbLocalStoreTest, ScansPastOutdatedIndexEntriesForLimitQuery) {
   FieldIndex index = MakeFieldIndex("coll", 0, FieldIndex::InitialState(),
                                     "count", model::Segment::Kind::kAscending);
   ConfigureFieldIndexes({index});
@@ -273,10 +273,11 @@ TEST_F(LevelDbLocalStoreTest, DoesNotUseLimitWhenIndexIsOutdated) {
 
   ExecuteQuery(query);
 
-  // The query engine first reads the documents by key and then re-runs the
-  // query without limit.
-  FSTAssertRemoteDocumentsRead(/* byKey= */ 5, /* byCollection= */ 0);
-  FSTAssertOverlaysRead(/* byKey= */ 5, /* byCollection= */ 1);
+  // The query engine reads the first two documents by key, drops the deleted
+  // document and continues the index scan for one more document instead of
+  // re-running the query without limit.
+  FSTAssertRemoteDocumentsRead(/* byKey= */ 3, /* byCollection= */ 0);
+  FSTAssertOverlaysRead(/* byKey= */ 3, /* byCollection= */ 1);
   FSTAssertOverlayTypes(
       OverlayTypeMap({{Key("coll/b"), model::Mutation::Type::Delete}}));
 
@@ -548,6 +548,156 @@ TEST_F(LevelDbMigrationsTest, SetsOverlayMigrationFlag) {
   ASSERT_TRUE(status.ok());
 }
 
+TEST_F(LevelDbMigrationsTest, CreatesCollectionMutationsIndex) {
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(db_.get(), 8, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write Mutations");
+    // Only the document-mutation index entries are used by the migration.
+    transaction.Put(
+        LevelDbDocumentMutationKey::Key("user", Key("rooms/a"), 1),
+        empty_buffer);
+    transaction.Put(
+        LevelDbDocumentMutationKey::Key("user", Key("rooms/a/messages/m"), 2),
+        empty_buffer);
+    transaction.Put(
+        LevelDbDocumentMutationKey::Key("user", Key("rooms/b"), 3),
+        empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+
+    std::vector<std::string> actual;
+    auto it = transaction.NewIterator();
+    std::string prefix = LevelDbCollectionMutationKey::KeyPrefix("user");
+    LevelDbCollectionMutationKey row_key;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      ASSERT_TRUE(row_key.Decode(it->key()));
+      actual.push_back(row_key.document_key().ToString() + "@" +
+                       std::to_string(row_key.batch_id()));
+    }
+
+    std::vector<std::string> expected{"rooms/a@1", "rooms/b@3",
+                                      "rooms/a/messages/m@2"};
+    ASSERT_EQ(actual, expected);
+  }
+}
+
+TEST_F(LevelDbMigrationsTest, RebuildsCollectionMutationsIndexAfterDowngrade) {
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(db_.get(), 8, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write Mutations");
+    transaction.Put(
+        LevelDbDocumentMutationKey::Key("user", Key("rooms/a"), 1),
+        empty_buffer);
+    transaction.Commit();
+  }
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+
+  // An older client acknowledges batch 1 and adds batch 2 without touching
+  // the collection-mutation index.
+  LevelDbMigrations::RunMigrations(db_.get(), 8, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Replace Mutations");
+    transaction.Delete(
+        LevelDbDocumentMutationKey::Key("user", Key("rooms/a"), 1));
+    transaction.Put(
+        LevelDbDocumentMutationKey::Key("user", Key("rooms/b"), 2),
+        empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+
+    std::vector<std::string> actual;
+    auto it = transaction.NewIterator();
+    std::string prefix = LevelDbCollectionMutationKey::KeyPrefix();
+    LevelDbCollectionMutationKey row_key;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      ASSERT_TRUE(row_key.Decode(it->key()));
+      actual.push_back(row_key.document_key().ToString() + "@" +
+                       std::to_string(row_key.batch_id()));
+    }
+
+    std::vector<std::string> expected{"rooms/b@2"};
+    ASSERT_EQ(actual, expected);
+  }
+}
+
+TEST_F(LevelDbMigrationsTest, DropsTargetDocumentFilter) {
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write filter");
+    transaction.Put(LevelDbTargetDocumentFilterKey::Key(), "filter");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+    std::string value;
+    Status status =
+        transaction.Get(LevelDbTargetDocumentFilterKey::Key(), &value);
+    ASSERT_TRUE(status.IsNotFound());
+  }
+}
+
+TEST_F(LevelDbMigrationsTest, DropsTableSizesWheneverSchemaVersionChanges) {
+  auto write_sizes = [&] {
+    LevelDbTransaction transaction(db_.get(), "Write sizes");
+    transaction.Put(LevelDbTableSizesKey::Key(), "sizes");
+    transaction.Commit();
+  };
+  auto has_sizes = [&] {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+    std::string value;
+    return transaction.Get(LevelDbTableSizesKey::Key(), &value).ok();
+  };
+
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  write_sizes();
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  ASSERT_TRUE(has_sizes());
+
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  ASSERT_FALSE(has_sizes());
+  ASSERT_EQ(LevelDbMigrations::ReadSchemaVersion(db_.get()), 11);
+
+  write_sizes();
+  LevelDbMigrations::RunMigrations(db_.get(), *serializer_);
+  ASSERT_FALSE(has_sizes());
+
+  write_sizes();
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  ASSERT_FALSE(has_sizes());
+}
+
+TEST_F(LevelDbMigrationsTest, DropsSequenceNumberHistogram) {
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write histogram");
+    transaction.Put(LevelDbSequenceNumberHistogramKey::Key(), "histogram");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 12, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+    std::string value;
+    Status status =
+        transaction.Get(LevelDbSequenceNumberHistogramKey::Key(), &value);
+    ASSERT_TRUE(status.IsNotFound());
+  }
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -14,11 +14,13 @@
  * limitations under the License.
  */
 
+#include <string>
 #include <vector>
 
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
 #include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/query_plan.h"
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/mutable_document.h"
@@ -34,6 +36,7 @@ namespace firestore {
 namespace local {
 namespace {
 
+using model::DocumentKeySet;
 using model::DocumentSet;
 using model::SnapshotVersion;
 using testutil::AndFilters;
@@ -638,6 +641,79 @@ TEST_F(LevelDbQueryEngineTest, OrderByEquality) {
   });
 }
 
+TEST_F(LevelDbQueryEngineTest, PlansInFixedOrderWithoutStatistics) {
+  persistence_->Run("PlansInFixedOrderWithoutStatistics", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/a", 1, Map("foo", true));
+    auto doc2 = Doc("coll/b", 1, Map("foo", false));
+    AddDocuments({doc1, doc2});
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "foo", model::Segment::kAscending));
+    index_manager_->UpdateIndexEntries(DocumentMap({doc1, doc2}));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(doc2));
+
+    // The collection is too small for cost-based planning.
+    core::Query query = Query("coll").AddingFilter(Filter("foo", ">=", false));
+    QueryPlan plan =
+        query_engine_.Explain(query, Version(10), DocumentKeySet{});
+    EXPECT_FALSE(plan.cost_based());
+    ASSERT_EQ(plan.candidates().size(), 3);
+    EXPECT_EQ(plan.candidates()[0].strategy, QueryPlan::Strategy::IndexScan);
+    EXPECT_EQ(plan.candidates()[1].strategy,
+              QueryPlan::Strategy::TargetMapping);
+    EXPECT_EQ(plan.candidates()[2].strategy, QueryPlan::Strategy::FullScan);
+  });
+}
+
+TEST_F(LevelDbQueryEngineTest, PlansByCostWithStatistics) {
+  persistence_->Run("PlansByCostWithStatistics", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+
+    std::vector<model::MutableDocument> docs;
+    for (int i = 0; i < 150; ++i) {
+      docs.push_back(Doc("coll/" + std::to_string(i), 1, Map("a", i % 10)));
+    }
+    AddDocuments(docs);
+    index_manager_->UpdateIndexEntries(DocumentMap(docs));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(docs.back()));
+
+    // A range filter reads too much of the index, so a scan is cheaper.
+    core::Query unselective = Query("coll").AddingFilter(Filter("a", ">=", 1));
+    QueryPlan unselective_plan = query_engine_.Explain(
+        unselective, SnapshotVersion::None(), DocumentKeySet{});
+    EXPECT_TRUE(unselective_plan.cost_based());
+    EXPECT_EQ(unselective_plan.index_result_estimate(), 50);
+    ASSERT_EQ(unselective_plan.candidates().size(), 1);
+    EXPECT_EQ(unselective_plan.strategy(), QueryPlan::Strategy::FullScan);
+
+    DocumentSet unselective_docs =
+        RunQuery(unselective, SnapshotVersion::None());
+    EXPECT_EQ(unselective_docs.size(), 135);
+
+    // An equality filter is selective enough to be served from the index.
+    core::Query selective = Query("coll").AddingFilter(Filter("a", "==", 1));
+    QueryPlan selective_plan = query_engine_.Explain(
+        selective, SnapshotVersion::None(), DocumentKeySet{});
+    EXPECT_TRUE(selective_plan.cost_based());
+    EXPECT_EQ(selective_plan.collection_size_estimate(), 150);
+    EXPECT_EQ(selective_plan.index_result_estimate(), 15);
+    EXPECT_EQ(selective_plan.strategy(), QueryPlan::Strategy::IndexScan);
+
+    DocumentSet selective_docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(selective, SnapshotVersion::None()); });
+    EXPECT_EQ(selective_docs.size(), 15);
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_table_sizes.h"
+
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/util/path.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using leveldb::DB;
+using testutil::Key;
+using util::Path;
+
+class LevelDbTableSizesTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    leveldb::Options options;
+    options.error_if_exists = true;
+    options.create_if_missing = true;
+
+    Path dir = LevelDbDir();
+    DB* db = nullptr;
+    leveldb::Status status = DB::Open(options, dir.ToUtf8String(), &db);
+    ASSERT_TRUE(status.ok()) << "Failed to create db: " << status.ToString();
+    db_.reset(db);
+  }
+
+  std::unique_ptr<DB> db_;
+};
+
+TEST_F(LevelDbTableSizesTest, GroupsTables) {
+  EXPECT_EQ(TableGroupForKey(LevelDbRemoteDocumentKey::Key(Key("a/b"))),
+            LevelDbTableGroup::kDocuments);
+  EXPECT_EQ(TableGroupForKey(LevelDbTargetKey::Key(1)),
+            LevelDbTableGroup::kTargets);
+  EXPECT_EQ(TableGroupForKey(LevelDbTargetDocumentKey::Key(1, Key("a/b"))),
+            LevelDbTableGroup::kTargets);
+  EXPECT_EQ(TableGroupForKey(LevelDbMutationKey::Key("user", 1)),
+            LevelDbTableGroup::kMutations);
+  EXPECT_EQ(TableGroupForKey(LevelDbVersionKey::Key()),
+            LevelDbTableGroup::kOther);
+  EXPECT_EQ(TableGroupForKey("not a key"), LevelDbTableGroup::kOther);
+}
+
+TEST_F(LevelDbTableSizesTest, EncodeDecodeCycle) {
+  LevelDbTableSizes sizes;
+  sizes.AddRow(LevelDbRemoteDocumentKey::Key(Key("a/b")), 100);
+  sizes.AddRow(LevelDbTargetKey::Key(1), 1000);
+
+  auto decoded = LevelDbTableSizes::Decode(sizes.Encode());
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_EQ(*decoded, sizes);
+  EXPECT_EQ(decoded->total_size(), sizes.total_size());
+}
+
+TEST_F(LevelDbTableSizesTest, RejectsInvalidEncodings) {
+  EXPECT_FALSE(LevelDbTableSizes::Decode("").has_value());
+  EXPECT_FALSE(LevelDbTableSizes::Decode("too short").has_value());
+
+  std::string encoded = LevelDbTableSizes().Encode();
+  encoded[7] = '\x80';  // A negative size.
+  EXPECT_FALSE(LevelDbTableSizes::Decode(encoded).has_value());
+}
+
+TEST_F(LevelDbTableSizesTest, CommitTracksSizes) {
+  LevelDbTableSizes sizes;
+  std::string doc_key = LevelDbRemoteDocumentKey::Key(Key("a/b"));
+  std::string target_key = LevelDbTargetKey::Key(1);
+  std::string mutation_key = LevelDbMutationKey::Key("user", 1);
+
+  {
+    LevelDbTransaction transaction(db_.get(), "Add rows");
+    transaction.TrackTableSizes(&sizes);
+    transaction.Put(doc_key, std::string(100, 'a'));
+    transaction.Put(target_key, "target");
+    transaction.Put(mutation_key, "mutation");
+    transaction.Commit();
+  }
+  EXPECT_EQ(sizes.size(LevelDbTableGroup::kDocuments),
+            static_cast<int64_t>(doc_key.size() + 100));
+  EXPECT_EQ(sizes, LevelDbTableSizes::Compute(db_.get()));
+
+  {
+    LevelDbTransaction transaction(db_.get(), "Overwrite and delete rows");
+    transaction.TrackTableSizes(&sizes);
+    transaction.Put(doc_key, "small");
+    transaction.Delete(target_key);
+    transaction.Delete(LevelDbTargetKey::Key(2));  // Doesn't exist.
+    transaction.Commit();
+  }
+  EXPECT_EQ(sizes.size(LevelDbTableGroup::kDocuments),
+            static_cast<int64_t>(doc_key.size() + 5));
+  EXPECT_EQ(sizes.size(LevelDbTableGroup::kTargets), 0);
+  EXPECT_EQ(sizes, LevelDbTableSizes::Compute(db_.get()));
+
+  // The sizes are saved along with the rows they account for.
+  std::string encoded;
+  ASSERT_TRUE(db_->Get(LevelDbTransaction::DefaultReadOptions(),
+                       LevelDbTableSizesKey::Key(), &encoded)
+                  .ok());
+  EXPECT_EQ(LevelDbTableSizes::Decode(encoded), sizes);
+}
+
+TEST_F(LevelDbTableSizesTest, CommitTracksSizesOfRowsReadInTransaction) {
+  LevelDbTableSizes sizes;
+  std::string doc_key = LevelDbRemoteDocumentKey::Key(Key("a/b"));
+  std::string other_doc_key = LevelDbRemoteDocumentKey::Key(Key("a/c"));
+
+  {
+    LevelDbTransaction transaction(db_.get(), "Add rows");
+    transaction.TrackTableSizes(&sizes);
+    transaction.Put(doc_key, std::string(100, 'a'));
+    transaction.Commit();
+  }
+
+  {
+    LevelDbTransaction transaction(db_.get(), "Read and overwrite rows");
+    transaction.TrackTableSizes(&sizes);
+    std::string value;
+    ASSERT_TRUE(transaction.Get(doc_key, &value).ok());
+    ASSERT_TRUE(transaction.Get(other_doc_key, &value).IsNotFound());
+    transaction.Put(doc_key, "small");
+    transaction.Put(other_doc_key, "other");
+    transaction.Commit();
+  }
+  EXPECT_EQ(sizes.size(LevelDbTableGroup::kDocuments),
+            static_cast<int64_t>(doc_key.size() + other_doc_key.size() + 10));
+  EXPECT_EQ(sizes, LevelDbTableSizes::Compute(db_.get()));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
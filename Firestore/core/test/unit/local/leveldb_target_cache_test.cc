@@ -17,11 +17,14 @@
 #include "Firestore/core/src/local/leveldb_target_cache.h"
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/local/document_key_filter.h"
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
 #include "Firestore/core/src/local/persistence.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/util/path.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
@@ -36,6 +39,7 @@ namespace {
 
 using core::Query;
 using model::DocumentKey;
+using model::DocumentKeySet;
 using model::ListenSequenceNumber;
 using model::SnapshotVersion;
 using model::TargetId;
@@ -135,6 +139,91 @@ TEST_F(LevelDbTargetCacheTest, RemoveMatchingKeysForTargetID) {
   });
 }
 
+TEST_F(LevelDbTargetCacheTest, DocumentFilterPersistedAcrossRestarts) {
+  persistence_->Shutdown();
+  persistence_.reset();
+
+  Path dir = LevelDbDir();
+  DocumentKey key1 = testutil::Key("foo/bar");
+  DocumentKey key2 = testutil::Key("foo/baz");
+  std::string filter_key = LevelDbTargetDocumentFilterKey::Key();
+
+  auto db1 = LevelDbPersistenceForTesting(dir);
+  db1->Run("add matching keys", [&] {
+    db1->target_cache()->AddMatchingKeys(DocumentKeySet{key1}, 1);
+    // Rebuilds the filter and saves it.
+    db1->target_cache()->EnumerateOrphanedDocuments(
+        [](const DocumentKey&, ListenSequenceNumber) {});
+  });
+  db1->Shutdown();
+  db1.reset();
+
+  auto db2 = LevelDbPersistenceForTesting(dir);
+  db2->Run("verify filter", [&] {
+    std::string value;
+    ASSERT_TRUE(db2->current_transaction()->Get(filter_key, &value).ok());
+    ASSERT_TRUE(db2->target_cache()->Contains(key1));
+    ASSERT_FALSE(db2->target_cache()->Contains(key2));
+
+    // Adding a key invalidates the persisted copy.
+    db2->target_cache()->AddMatchingKeys(DocumentKeySet{key2}, 1);
+    ASSERT_TRUE(
+        db2->current_transaction()->Get(filter_key, &value).IsNotFound());
+    ASSERT_TRUE(db2->target_cache()->Contains(key2));
+  });
+  db2->Shutdown();
+  db2.reset();
+
+  // Shutdown saves the filter again.
+  auto db3 = LevelDbPersistenceForTesting(dir);
+  db3->Run("verify filter saved on shutdown", [&] {
+    std::string value;
+    ASSERT_TRUE(db3->current_transaction()->Get(filter_key, &value).ok());
+    ASSERT_TRUE(db3->target_cache()->Contains(key1));
+    ASSERT_TRUE(db3->target_cache()->Contains(key2));
+  });
+  db3->Shutdown();
+  db3.reset();
+}
+
+TEST_F(LevelDbTargetCacheTest, DocumentFilterRebuiltAcrossSlices) {
+  persistence_->Run("test_document_filter_rebuilt_across_slices", [&]() {
+    DocumentKey key0 = testutil::Key("foo/0");
+    DocumentKey key1 = testutil::Key("foo/a");
+    DocumentKey key2 = testutil::Key("foo/c");
+    std::string filter_key = LevelDbTargetDocumentFilterKey::Key();
+    auto ignore = [](const DocumentKey&, ListenSequenceNumber) {};
+
+    LevelDbTargetCache* cache = leveldb_cache();
+    cache->AddMatchingKeys(DocumentKeySet{key1, key2}, 1);
+    cache->EnumerateOrphanedDocuments(ignore);
+    cache->RemoveMatchingKeys(DocumentKeySet{key2}, 1);
+
+    // Stop right after the first document.
+    absl::optional<DocumentKey> last_visited =
+        cache->EnumerateOrphanedDocuments(
+            absl::nullopt, [] { return true; }, ignore);
+    ASSERT_EQ(last_visited, key1);
+
+    // The walk is already past this key.
+    cache->AddMatchingKeys(DocumentKeySet{key0}, 1);
+
+    last_visited = cache->EnumerateOrphanedDocuments(
+        key1, [] { return false; }, ignore);
+    ASSERT_EQ(last_visited, absl::nullopt);
+
+    std::string value;
+    LevelDbTransaction* transaction =
+        leveldb_persistence()->current_transaction();
+    ASSERT_TRUE(transaction->Get(filter_key, &value).ok());
+    absl::optional<DocumentKeyFilter> filter = DocumentKeyFilter::Decode(value);
+    ASSERT_TRUE(filter.has_value());
+    ASSERT_EQ(filter->added_count(), 2u);
+    ASSERT_TRUE(filter->MightContain(key0));
+    ASSERT_TRUE(filter->MightContain(key1));
+  });
+}
+
 // We see user issues where target data is missing for some reason, and the root
 // cause is unknown. This test makes sure the SDK proceeds even when this
 // happens. See: https://github.com/firebase/firebase-ios-sdk/issues/6644
@@ -290,6 +290,28 @@ TEST_F(LevelDbTransactionTest, DeletingAheadOfAnIterator) {
   ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(LevelDbTransactionTest, ValueIsStableAfterOverwriteInTransaction) {
+  Status status =
+      db_->Put(LevelDbTransaction::DefaultWriteOptions(), "key_0", "committed");
+  ASSERT_TRUE(status.ok());
+
+  // The committed value is read lazily, but must still reflect the entry the
+  // iterator was positioned on rather than a later write in the transaction.
+  LevelDbTransaction transaction(db_.get(),
+                                 "ValueIsStableAfterOverwriteInTransaction");
+  auto it = transaction.NewIterator();
+  it->Seek("key_0");
+  ASSERT_TRUE(it->Valid());
+  transaction.Put("key_0", "mutated");
+  ASSERT_EQ("committed", it->value_view());
+  ASSERT_EQ("committed", it->value());
+
+  it->Seek("key_0");
+  ASSERT_TRUE(it->Valid());
+  ASSERT_EQ("mutated", it->value_view());
+  ASSERT_EQ("mutated", it->value());
+}
+
 TEST_F(LevelDbTransactionTest, ToString) {
   std::string key = LevelDbMutationKey::Key("user1", 42);
   Message<firestore_client_WriteBatch> message;
@@ -67,6 +67,7 @@ using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
+using model::DocumentUpdateMap;
 using model::ListenSequenceNumber;
 using model::MutableDocument;
 using model::MutableDocumentMap;
@@ -104,6 +105,7 @@ using testutil::UpdateRemoteEvent;
 using testutil::UpdateRemoteEventWithLimboTargets;
 using testutil::Value;
 using testutil::Vector;
+using testutil::Version;
 
 std::vector<Document> DocMapToVector(const DocumentMap& docs) {
   std::vector<Document> result;
@@ -737,6 +739,36 @@ TEST_P(LocalStoreTest, CollectsGarbageAfterChangeBatchWithNoTargetIDs) {
   FSTAssertNotContains("foo/bar");
 }
 
+TEST_P(LocalStoreTest, AppliesLookedUpLimboDocumentsAtTheirVersions) {
+  core::Query query = Query("foo");
+  TargetId target_id = AllocateQuery(query);
+
+  ApplyRemoteEvent(AddedRemoteEvent({Doc("foo/bar", 1, Map("it", "base")),
+                                     Doc("foo/baz", 1, Map("it", "base"))},
+                                    {target_id}));
+  EXPECT_EQ(local_store_.GetLastRemoteSnapshotVersion(), Version(1));
+
+  // The event a batched limbo resolution synthesizes: no snapshot version, no
+  // target changes.
+  DocumentUpdateMap document_updates{
+      {Key("foo/bar"), Doc("foo/bar", 3, Map("it", "changed"))},
+      {Key("foo/baz"), DeletedDoc("foo/baz", 4)}};
+  DocumentKeySet limbo_documents{Key("foo/bar"), Key("foo/baz")};
+  RemoteEvent::TargetChangeMap target_changes;
+  RemoteEvent::TargetMismatchMap target_mismatches;
+  ApplyRemoteEvent(RemoteEvent{SnapshotVersion::None(),
+                               std::move(target_changes),
+                               std::move(target_mismatches),
+                               std::move(document_updates),
+                               std::move(limbo_documents)});
+
+  FSTAssertChanged(Doc("foo/bar", 3, Map("it", "changed")),
+                   DeletedDoc("foo/baz", 4));
+  FSTAssertContains(Doc("foo/bar", 3, Map("it", "changed")));
+  FSTAssertContains(DeletedDoc("foo/baz", 4));
+  EXPECT_EQ(local_store_.GetLastRemoteSnapshotVersion(), Version(1));
+}
+
 TEST_P(LocalStoreTest, CollectsGarbageAfterChangeBatch) {
   if (!IsGcEager()) return;
 
@@ -1252,6 +1284,35 @@ TEST_P(LocalStoreTest, QueriesFilterDocumentsThatNoLongerMatch) {
   FSTAssertQueryReturned("foo/a");
 }
 
+TEST_P(LocalStoreTest, RepeatedQueriesReadOnlyCachedResults) {
+  if (IsGcEager()) return;
+
+  local_store_.SetQueryResultCacheEnabled(true);
+
+  core::Query query =
+      Query("foo").AddingFilter(testutil::Filter("matches", "==", true));
+  TargetId target_id = AllocateQuery(query);
+
+  ApplyRemoteEvent(AddedRemoteEvent({Doc("foo/a", 10, Map("matches", true)),
+                                     Doc("foo/b", 10, Map("matches", false))},
+                                    {target_id}));
+
+  ExecuteQuery(query);
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 0, /* by_query= */ 2);
+  FSTAssertQueryReturned("foo/a");
+
+  // A local write makes one document match, and a remote change makes the
+  // other one stop matching.
+  WriteMutation(testutil::SetMutation("foo/b", Map("matches", true)));
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/a", 20, Map("matches", false)),
+                                     {target_id}, {}));
+
+  // Only the cached result is read.
+  ExecuteQuery(query);
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 1, /* by_query= */ 0);
+  FSTAssertQueryReturned("foo/b");
+}
+
 TEST_P(LocalStoreTest,
        HandlesSetMutationThenTransformThenRemoteEventThenTransform) {  // NOLINT
   core::Query query = Query("foo");
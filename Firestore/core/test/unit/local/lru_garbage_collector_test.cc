@@ -766,6 +766,43 @@ TEST_P(LruGarbageCollectorTest, GCRan) {
   ASSERT_EQ(100, results.documents_removed);
 }
 
+TEST_P(LruGarbageCollectorTest, GCRanInSteps) {
+  LruParams params = LruParams::Default();
+  params.min_bytes_threshold = 100;
+  params.use_sequence_number_histogram = true;
+  NewTestResources(params);
+
+  for (int i = 0; i < 100; i++) {
+    persistence_->Run("Add a target and some documents", [&] {
+      TargetData target_data = AddNextQueryInTransaction();
+      for (int j = 0; j < 10; j++) {
+        MutableDocument doc = CacheADocumentInTransaction();
+        AddDocument(doc.key(), target_data.target_id());
+      }
+    });
+  }
+
+  // A deadline that has already passed makes every step do the minimum amount
+  // of work, so the pass is spread over as many steps as possible.
+  absl::optional<LruResults> results;
+  int steps = 0;
+  while (!results) {
+    results = persistence_->Run("GC step", [&] {
+      return gc_->CollectStep({}, std::chrono::steady_clock::now());
+    });
+    steps++;
+  }
+
+  ASSERT_GT(steps, 0);
+  ASSERT_TRUE(results->did_run);
+  ASSERT_EQ(10, results->targets_removed);
+  ASSERT_EQ(100, results->documents_removed);
+
+  // The histogram now holds the surviving orphaned documents, and agrees with
+  // the targets that remain.
+  ASSERT_EQ(9, QueryCountForPercentile(10));
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
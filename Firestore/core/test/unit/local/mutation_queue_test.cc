@@ -346,6 +346,39 @@ TEST_P(MutationQueueTest, AllMutationBatchesAffectingQuery) {
   });
 }
 
+TEST_P(MutationQueueTest,
+       AllMutationBatchesAffectingQueryWithMultiDocumentBatches) {
+  persistence_->Run(
+      "AllMutationBatchesAffectingQueryWithMultiDocumentBatches", [&] {
+        std::vector<Mutation> group1 = {
+            testutil::SetMutation("foo/bar", Map("a", 1)),
+            testutil::SetMutation("foo/baz", Map("a", 1)),
+            testutil::SetMutation("foo/bar/suffix/key", Map("a", 1)),
+        };
+        MutationBatch batch1 = mutation_queue_->AddMutationBatch(
+            Timestamp::Now(), {}, std::move(group1));
+
+        std::vector<Mutation> group2 = {
+            testutil::SetMutation("foo/bar/suffix/key", Map("b", 1)),
+        };
+        mutation_queue_->AddMutationBatch(Timestamp::Now(), {},
+                                          std::move(group2));
+
+        std::vector<Mutation> group3 = {
+            testutil::SetMutation("foo/qux", Map("b", 1)),
+            testutil::SetMutation("foo/bar", Map("b", 1)),
+        };
+        MutationBatch batch3 = mutation_queue_->AddMutationBatch(
+            Timestamp::Now(), {}, std::move(group3));
+
+        std::vector<MutationBatch> expected{batch1, batch3};
+        std::vector<MutationBatch> matches =
+            mutation_queue_->AllMutationBatchesAffectingQuery(Query("foo"));
+
+        EXPECT_EQ(matches, expected);
+      });
+}
+
 TEST_P(MutationQueueTest, RemoveMutationBatches) {
   persistence_->Run("RemoveMutationBatches", [&] {
     std::vector<MutationBatch> batches = CreateBatches(10);
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/query_result_cache.h"
+
+#include <initializer_list>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using core::Query;
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::MutableDocument;
+using testutil::DeletedDoc;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
+
+DocumentMap Docs(std::initializer_list<MutableDocument> docs) {
+  DocumentMap result;
+  for (const MutableDocument& doc : docs) {
+    result = result.insert(doc.key(), doc);
+  }
+  return result;
+}
+
+Query MatchingQuery() {
+  return testutil::Query("coll").AddingFilter(
+      testutil::Filter("matches", "==", true));
+}
+
+}  // namespace
+
+TEST(QueryResultCacheTest, ReturnsCachedKeys) {
+  QueryResultCache cache;
+  Query query = MatchingQuery();
+  EXPECT_FALSE(cache.Get(query).has_value());
+
+  cache.Put(query, Docs({Doc("coll/a", 1, Map("matches", true))}));
+  EXPECT_EQ(cache.Get(query), DocumentKeySet{Key("coll/a")});
+
+  // Equivalent queries share an entry.
+  EXPECT_EQ(cache.Get(MatchingQuery()), DocumentKeySet{Key("coll/a")});
+}
+
+TEST(QueryResultCacheTest, DoesNotCacheLimitQueries) {
+  EXPECT_TRUE(QueryResultCache::IsCacheable(MatchingQuery()));
+  EXPECT_FALSE(
+      QueryResultCache::IsCacheable(MatchingQuery().WithLimitToFirst(1)));
+}
+
+TEST(QueryResultCacheTest, AppliesChanges) {
+  QueryResultCache cache;
+  Query query = MatchingQuery();
+  cache.Put(query, Docs({Doc("coll/a", 1, Map("matches", true)),
+                         Doc("coll/b", 1, Map("matches", true))}));
+
+  cache.ApplyChanges(Docs({Doc("coll/a", 2, Map("matches", false)),
+                           DeletedDoc("coll/b", 2),
+                           Doc("coll/c", 2, Map("matches", true)),
+                           Doc("other/d", 2, Map("matches", true))}));
+
+  EXPECT_EQ(cache.Get(query), DocumentKeySet{Key("coll/c")});
+}
+
+TEST(QueryResultCacheTest, InvalidatesByTarget) {
+  QueryResultCache cache;
+  Query query = MatchingQuery();
+  cache.Put(query, Docs({Doc("coll/a", 1, Map("matches", true))}));
+  cache.Put(testutil::Query("coll"), DocumentMap{});
+
+  cache.Invalidate(query.ToTarget());
+  EXPECT_FALSE(cache.Get(query).has_value());
+  EXPECT_TRUE(cache.Get(testutil::Query("coll")).has_value());
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(QueryResultCacheTest, EvictsLeastRecentlyUsedEntries) {
+  QueryResultCache cache(/* max_entries= */ 2);
+  Query a = testutil::Query("a");
+  Query b = testutil::Query("b");
+  Query c = testutil::Query("c");
+
+  cache.Put(a, DocumentMap{});
+  cache.Put(b, DocumentMap{});
+  // Touch `a` so that `b` becomes the least recently used entry.
+  cache.Get(a);
+  cache.Put(c, DocumentMap{});
+
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_TRUE(cache.Get(a).has_value());
+  EXPECT_FALSE(cache.Get(b).has_value());
+  EXPECT_TRUE(cache.Get(c).has_value());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -16,7 +16,9 @@
 
 #include "Firestore/core/test/unit/local/remote_document_cache_test.h"
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "Firestore/core/src/core/query.h"
@@ -153,6 +155,31 @@ TEST_P(RemoteDocumentCacheTest,
       });
 }
 
+TEST_P(RemoteDocumentCacheTest, ReadManyDocumentsWithGaps) {
+  persistence_->Run("test_read_many_documents_with_gaps", [=] {
+    std::vector<MutableDocument> written;
+    DocumentKeySet keys;
+    for (int i = 0; i < 300; ++i) {
+      std::string path = "coll" + std::to_string(i % 3) + "/doc" +
+                         std::to_string(i) + (i % 5 == 0 ? "/sub/doc" : "");
+      keys = keys.insert(Key(path));
+      // Leave every seventh document out to create gaps in the table.
+      if (i % 7 != 0) {
+        written.push_back(SetTestDocument(path));
+      }
+    }
+
+    MutableDocumentMap read = cache_->GetAll(keys);
+    EXPECT_EQ(read.size(), keys.size());
+    EXPECT_THAT(read, HasAtLeastDocs(written));
+    for (const auto& entry : read) {
+      EXPECT_EQ(entry.second.is_valid_document(),
+                std::find(written.begin(), written.end(), entry.second) !=
+                    written.end());
+    }
+  });
+}
+
 TEST_P(RemoteDocumentCacheTest, SetAndReadADocumentAtDeepPath) {
   SetAndReadTestDocument(kLongDocPath);
 }
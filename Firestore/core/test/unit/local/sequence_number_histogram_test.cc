@@ -0,0 +1,107 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/sequence_number_histogram.h"
+
+#include <string>
+
+#include "Firestore/core/src/local/lru_garbage_collector.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+TEST(SequenceNumberHistogramTest, IsExactWithFewSequenceNumbers) {
+  SequenceNumberHistogram histogram;
+  histogram.Add(5, 2);
+  histogram.Add(3);
+  histogram.Add(9);
+
+  EXPECT_EQ(histogram.total_count(), 4);
+  EXPECT_EQ(histogram.bucket_width(), 1);
+  EXPECT_EQ(histogram.NthSequenceNumber(1), 3);
+  EXPECT_EQ(histogram.NthSequenceNumber(2), 5);
+  EXPECT_EQ(histogram.NthSequenceNumber(3), 5);
+  EXPECT_EQ(histogram.NthSequenceNumber(4), 9);
+  EXPECT_EQ(histogram.NthSequenceNumber(100), 9);
+}
+
+TEST(SequenceNumberHistogramTest, WideningOverestimates) {
+  SequenceNumberHistogram histogram(4);
+  for (model::ListenSequenceNumber i = 0; i < 100; ++i) {
+    histogram.Add(i);
+  }
+
+  EXPECT_EQ(histogram.total_count(), 100);
+  EXPECT_GT(histogram.bucket_width(), 1);
+  for (int64_t n = 1; n <= 100; ++n) {
+    model::ListenSequenceNumber estimate = histogram.NthSequenceNumber(n);
+    EXPECT_GE(estimate, n - 1);
+    EXPECT_LT(estimate, n - 1 + histogram.bucket_width());
+  }
+}
+
+TEST(SequenceNumberHistogramTest, HandlesEmptyHistogram) {
+  SequenceNumberHistogram histogram;
+  EXPECT_EQ(histogram.NthSequenceNumber(1), kListenSequenceNumberInvalid);
+
+  histogram.Add(7);
+  EXPECT_EQ(histogram.NthSequenceNumber(0), kListenSequenceNumberInvalid);
+}
+
+TEST(SequenceNumberHistogramTest, AddAllMergesCounts) {
+  SequenceNumberHistogram narrow;
+  narrow.Add(1);
+  SequenceNumberHistogram wide(2);
+  wide.Add(10);
+  wide.Add(20);
+  wide.Add(30);
+
+  narrow.AddAll(wide);
+  EXPECT_EQ(narrow.total_count(), 4);
+  EXPECT_EQ(narrow.bucket_width(), wide.bucket_width());
+  EXPECT_EQ(narrow.NthSequenceNumber(1), narrow.bucket_width() - 1);
+}
+
+TEST(SequenceNumberHistogramTest, EncodeDecodeCycle) {
+  SequenceNumberHistogram histogram(8);
+  for (model::ListenSequenceNumber i = 0; i < 50; ++i) {
+    histogram.Add(i * 3, i + 1);
+  }
+
+  auto decoded = SequenceNumberHistogram::Decode(histogram.Encode());
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_EQ(decoded->total_count(), histogram.total_count());
+  EXPECT_EQ(decoded->bucket_width(), histogram.bucket_width());
+  EXPECT_EQ(decoded->Encode(), histogram.Encode());
+  for (int64_t n = 1; n <= histogram.total_count(); n += 17) {
+    EXPECT_EQ(decoded->NthSequenceNumber(n), histogram.NthSequenceNumber(n));
+  }
+}
+
+TEST(SequenceNumberHistogramTest, RejectsInvalidEncodings) {
+  EXPECT_FALSE(SequenceNumberHistogram::Decode("").has_value());
+  EXPECT_FALSE(SequenceNumberHistogram::Decode("too short").has_value());
+
+  std::string encoded = SequenceNumberHistogram().Encode();
+  encoded[0] = '\0';  // Zero-width buckets.
+  EXPECT_FALSE(SequenceNumberHistogram::Decode(encoded).has_value());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/model/object_value.h"
 
 #include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
 #include "gtest/gtest.h"
@@ -31,6 +32,7 @@ const char kBarString[] = "bar";
 namespace {
 
 using absl::nullopt;
+using testutil::Array;
 using testutil::DbId;
 using testutil::Field;
 using testutil::Map;
@@ -335,6 +337,30 @@ TEST_F(ObjectValueTest, DoesNotRequireSortedInserts) {
   EXPECT_EQ(*Value(2), *object_value.Get(Field("nested.nested.c")));
 }
 
+TEST_F(ObjectValueTest, SetsAndDeletesFieldsInArenaScope) {
+  nanopb::Arena arena;
+  ObjectValue object_value =
+      WrapObject("a", Map("b", kFooString, "c", Map("d", kFooString)), "e", 1);
+  {
+    nanopb::ArenaScope scope(&arena);
+    object_value.Set(Field("a.b"), Value(kBarString));
+    object_value.Set(Field("a.c.f"), Value(kBarString));
+    object_value.Delete(Field("e"));
+    object_value.Set(Field("g"), Value(Array(1, 2)));
+  }
+  EXPECT_GT(arena.bytes_allocated(), 0u);
+
+  EXPECT_EQ(WrapObject("a",
+                       Map("b", kBarString, "c",
+                           Map("d", kFooString, "f", kBarString)),
+                       "g", Array(1, 2)),
+            object_value);
+
+  // Changes after the scope ends replace arena-owned fields with heap ones.
+  object_value.Set(Field("a"), Value(kFooString));
+  EXPECT_EQ(WrapObject("a", kFooString, "g", Array(1, 2)), object_value);
+}
+
 }  // namespace
 
 }  // namespace model
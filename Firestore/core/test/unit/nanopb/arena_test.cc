@@ -0,0 +1,139 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/arena.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+using model::DeepClone;
+using testutil::Array;
+using testutil::Map;
+using testutil::Value;
+
+TEST(ArenaTest, AllocatesZeroedAlignedMemory) {
+  Arena arena(/*initial_chunk_size=*/64);
+  for (size_t size : {1, 7, 64, 1000}) {
+    auto* bytes = static_cast<uint8_t*>(arena.Allocate(size));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(bytes) % alignof(std::max_align_t),
+              0u);
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(bytes[i], 0);
+    }
+    EXPECT_TRUE(arena.Owns(bytes));
+    EXPECT_TRUE(arena.Owns(bytes + size - 1));
+  }
+
+  int on_stack = 0;
+  EXPECT_FALSE(arena.Owns(&on_stack));
+  EXPECT_FALSE(arena.Owns(nullptr));
+}
+
+TEST(ArenaTest, ScopesNest) {
+  EXPECT_EQ(Arena::Current(), nullptr);
+
+  Arena outer;
+  Arena inner;
+  {
+    ArenaScope outer_scope(&outer);
+    EXPECT_EQ(Arena::Current(), &outer);
+    {
+      ArenaScope inner_scope(&inner);
+      EXPECT_EQ(Arena::Current(), &inner);
+      ArenaScope suspended(nullptr);
+      EXPECT_EQ(Arena::Current(), nullptr);
+    }
+    EXPECT_EQ(Arena::Current(), &outer);
+  }
+  EXPECT_EQ(Arena::Current(), nullptr);
+}
+
+TEST(ArenaTest, FindsOwnerAmongLiveArenas) {
+  Arena first;
+  Arena second;
+  void* from_first = first.Allocate(8);
+  void* from_second = second.Allocate(8);
+  void* from_heap = MakeArray<google_firestore_v1_Value>(1);
+
+  EXPECT_EQ(Arena::FindOwner(from_first), &first);
+  EXPECT_EQ(Arena::FindOwner(from_second), &second);
+  EXPECT_EQ(Arena::FindOwner(from_heap), nullptr);
+
+  Free(from_first);
+  Free(from_heap);
+}
+
+TEST(ArenaTest, DeepCloneAllocatesFromCurrentArena) {
+  Arena arena;
+  Message<google_firestore_v1_Value> original =
+      Value(Map("a", "foo", "b", Array(1, "bar")));
+
+  Message<google_firestore_v1_Value> clone;
+  {
+    ArenaScope scope(&arena);
+    clone = DeepClone(*original);
+  }
+
+  EXPECT_EQ(*original, *clone);
+  EXPECT_TRUE(arena.Owns(clone->map_value.fields));
+  EXPECT_TRUE(arena.Owns(clone->map_value.fields[0].key));
+  EXPECT_TRUE(arena.Owns(clone->map_value.fields[0].value.string_value));
+  EXPECT_GT(arena.bytes_allocated(), 0u);
+}
+
+TEST(ArenaTest, FreesHeapNodesOfMixedTrees) {
+  Arena arena;
+  Message<google_firestore_v1_Value> arena_value;
+  {
+    ArenaScope scope(&arena);
+    arena_value = DeepClone(*Value(Array("foo", Map("bar", 1))));
+  }
+
+  // A heap array that holds an arena value, which in turn gets a heap value
+  // appended. Destroying the outer message must free exactly the heap nodes.
+  Message<google_firestore_v1_Value> heap_value = Value(Array("baz"));
+  auto& array = heap_value->array_value;
+  array.values = ResizeArray<google_firestore_v1_Value>(
+      array.values, array.values_count, array.values_count + 1);
+  array.values[array.values_count++] = *arena_value.release();
+
+  auto& nested = array.values[1].array_value;
+  EXPECT_TRUE(arena.Owns(nested.values));
+  nested.values = ResizeArray<google_firestore_v1_Value>(
+      nested.values, nested.values_count, nested.values_count + 1);
+  EXPECT_TRUE(arena.Owns(nested.values));
+  nested.values[nested.values_count++] = *Value("qux").release();
+
+  EXPECT_EQ(*heap_value,
+            *Value(Array("baz", Array("foo", Map("bar", 1), "qux"))));
+}
+
+}  // namespace
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -22,7 +22,6 @@
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
-#include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/remote/grpc_nanopb.h"
 #include "Firestore/core/test/unit/testutil/status_testing.h"
 #include "grpcpp/support/byte_buffer.h"
@@ -34,7 +33,6 @@ namespace nanopb {
 namespace {
 
 using remote::ByteBufferReader;
-using remote::ByteBufferWriter;
 
 // This proto is chosen mostly because it's relatively small but still has some
 // dynamically-allocated members.
@@ -51,9 +49,7 @@ class MessageTest : public testing::Test {
     message->stream_id = MakeBytesArray("stream_id");
     message->stream_token = MakeBytesArray("stream_token");
 
-    ByteBufferWriter writer;
-    writer.Write(message.fields(), message.get());
-    return writer.Release();
+    return remote::MakeByteBuffer(message);
   }
 
   grpc::ByteBuffer BadProto() const {
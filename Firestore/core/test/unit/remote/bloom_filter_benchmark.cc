@@ -0,0 +1,109 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/remote/bloom_filter.h"
+#include "Firestore/core/src/util/md5.h"
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::nanopb::ByteString;
+using firebase::firestore::remote::BloomFilter;
+using firebase::firestore::util::CalculateMd5Digest;
+
+namespace {
+
+// Roughly what the backend sends for a 1% false positive rate.
+const int32_t kBitsPerDocument = 10;
+const int32_t kHashCount = 7;
+
+std::string DocumentPath(int64_t i) {
+  return "projects/project-1/databases/database-1/documents/coll/doc" +
+         std::to_string(i);
+}
+
+/**
+ * Builds a bloom filter the same way the backend does, containing the first
+ * `document_count` document paths.
+ */
+BloomFilter CreateBloomFilter(int64_t document_count) {
+  int32_t bit_count = static_cast<int32_t>(document_count) * kBitsPerDocument;
+  std::vector<uint8_t> bitmap((bit_count + 7) / 8);
+  for (int64_t i = 0; i < document_count; ++i) {
+    std::array<uint8_t, 16> digest = CalculateMd5Digest(DocumentPath(i));
+    uint64_t h1;
+    uint64_t h2;
+    memcpy(&h1, digest.data(), sizeof(h1));
+    memcpy(&h2, digest.data() + sizeof(h1), sizeof(h2));
+    for (int32_t j = 0; j < kHashCount; ++j) {
+      uint64_t index = (h1 + static_cast<uint64_t>(j) * h2) %
+                       static_cast<uint64_t>(bit_count);
+      bitmap[index / 8] |= static_cast<uint8_t>(1 << (index % 8));
+    }
+  }
+  int32_t padding = static_cast<int32_t>(bitmap.size()) * 8 - bit_count;
+  return BloomFilter(ByteString(bitmap.data(), bitmap.size()), padding,
+                     kHashCount);
+}
+
+/**
+ * Returns the paths checked during existence filter recovery: the documents
+ * in the filter, and as many that were deleted from the target.
+ */
+std::vector<std::string> CandidatePaths(int64_t document_count) {
+  std::vector<std::string> paths;
+  for (int64_t i = 0; i < document_count * 2; ++i) {
+    paths.push_back(DocumentPath(i));
+  }
+  return paths;
+}
+
+}  // namespace
+
+static void BM_MightContain(benchmark::State& state) {
+  BloomFilter bloom_filter = CreateBloomFilter(state.range(0));
+  std::vector<std::string> paths = CandidatePaths(state.range(0));
+
+  for (auto _ : state) {
+    int64_t count = 0;
+    for (const std::string& path : paths) {
+      count += bloom_filter.MightContain(path);
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(paths.size()));
+}
+BENCHMARK(BM_MightContain)->Arg(1000)->Arg(10000)->Arg(100000);
+
+static void BM_MightContainAll(benchmark::State& state) {
+  BloomFilter bloom_filter = CreateBloomFilter(state.range(0));
+  std::vector<std::string> paths = CandidatePaths(state.range(0));
+  std::vector<absl::string_view> views(paths.begin(), paths.end());
+
+  for (auto _ : state) {
+    std::vector<bool> results = bloom_filter.MightContainAll(views);
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(paths.size()));
+}
+BENCHMARK(BM_MightContainAll)->Arg(1000)->Arg(10000)->Arg(100000);
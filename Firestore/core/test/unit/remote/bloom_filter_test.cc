@@ -18,6 +18,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/json_reader.h"
@@ -201,18 +203,52 @@ TEST(BloomFilterUnitTest,
   }
 }
 
+TEST(BloomFilterUnitTest, MightContainAllOnEmptyBloomFilterShouldReturnFalse) {
+  BloomFilter bloom_filter(ByteString{}, 0, 0);
+  EXPECT_EQ(bloom_filter.MightContainAll({"", "a"}),
+            std::vector<bool>({false, false}));
+}
+
+TEST(BloomFilterUnitTest, MightContainAllOnEmptyInputShouldReturnEmpty) {
+  BloomFilter bloom_filter(ByteString{255}, 0, 16);
+  EXPECT_TRUE(bloom_filter.MightContainAll({}).empty());
+}
+
+TEST(BloomFilterUnitTest, MightContainAllMatchesMightContain) {
+  BloomFilter bloom_filter(ByteString{0x5a, 0x3c, 0x81}, 3, 4);
+  std::vector<std::string> values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(std::string(i, 'x') + std::to_string(i));
+  }
+  std::vector<bool> results = bloom_filter.MightContainAll(
+      std::vector<absl::string_view>(values.begin(), values.end()));
+  ASSERT_EQ(results.size(), values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(results[i], bloom_filter.MightContain(values[i])) << values[i];
+  }
+}
+
 class BloomFilterGoldenTest : public ::testing::Test {
  public:
   static void RunGoldenTest(const std::string& test_file) {
     BloomFilter bloom_filter = LoadBloomFilter(test_file);
     std::string membership_result = LoadMembershipResult(test_file);
 
+    std::vector<std::string> document_paths;
+    for (size_t i = 0; i < membership_result.length(); i++) {
+      document_paths.push_back(kGoldenDocumentPrefix + std::to_string(i));
+    }
+    std::vector<bool> mightContainAllResult = bloom_filter.MightContainAll(
+        std::vector<absl::string_view>(document_paths.begin(),
+                                       document_paths.end()));
+    ASSERT_EQ(mightContainAllResult.size(), membership_result.length());
+
     for (size_t i = 0; i < membership_result.length(); i++) {
       bool expectedResult = membership_result[i] == '1';
-      bool mightContainResult =
-          bloom_filter.MightContain(kGoldenDocumentPrefix + std::to_string(i));
+      bool mightContainResult = bloom_filter.MightContain(document_paths[i]);
 
       EXPECT_EQ(mightContainResult, expectedResult);
+      EXPECT_EQ(mightContainAllResult[i], expectedResult);
     }
   }
 
@@ -0,0 +1,875 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/unit/remote/fake_firestore_backend.h"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/model/field_path.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/transform_operation.h"
+#include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+#include "Firestore/core/src/util/comparison.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/read_context.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/src/util/string_format.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "grpcpp/generic/async_generic_service.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using core::LimitType;
+using model::DeepClone;
+using model::Document;
+using model::DocumentKey;
+using model::FieldPath;
+using model::IsDouble;
+using model::IsInteger;
+using model::MutableDocument;
+using model::Mutation;
+using model::MutationResult;
+using model::SnapshotVersion;
+using model::TargetId;
+using model::TransformOperation;
+using nanopb::CheckedSize;
+using nanopb::MakeArray;
+using nanopb::Message;
+using util::ReadContext;
+using util::Status;
+using util::StatusOr;
+
+const char* const kListenMethod = "/google.firestore.v1.Firestore/Listen";
+const char* const kWriteMethod = "/google.firestore.v1.Firestore/Write";
+const char* const kCommitMethod = "/google.firestore.v1.Firestore/Commit";
+const char* const kBatchGetDocumentsMethod =
+    "/google.firestore.v1.Firestore/BatchGetDocuments";
+const char* const kRunAggregationQueryMethod =
+    "/google.firestore.v1.Firestore/RunAggregationQuery";
+
+const char* const kStreamToken = "fake-stream-token";
+
+// Commit versions start one second past the epoch so that the very first
+// snapshot already has a version the client will raise.
+const int64_t kInitialVersionMicros = 1000000;
+
+grpc::Status ToGrpcStatus(const Status& status) {
+  return grpc::Status{static_cast<grpc::StatusCode>(status.code()),
+                      status.error_message()};
+}
+
+int64_t ToMicros(const SnapshotVersion& version) {
+  const Timestamp& timestamp = version.timestamp();
+  return timestamp.seconds() * 1000000 + timestamp.nanoseconds() / 1000;
+}
+
+SnapshotVersion FromMicros(int64_t micros) {
+  return SnapshotVersion{Timestamp{micros / 1000000,
+                                   static_cast<int32_t>(micros % 1000000) *
+                                       1000}};
+}
+
+core::Query ToQuery(const core::Target& target) {
+  // Targets store limit-to-last queries with their ordering already flipped,
+  // so every limit can be applied from the front.
+  return core::Query(target.path(), target.collection_group(),
+                     target.filters(), target.order_bys(), target.limit(),
+                     target.HasLimit() ? LimitType::First : LimitType::None,
+                     target.start_at(), target.end_at());
+}
+
+/**
+ * Returns whether `key` lives where `query` looks for documents, regardless
+ * of whether it matches the query's filters.
+ */
+bool IsInScope(const core::Query& query, const DocumentKey& key) {
+  if (query.IsDocumentQuery()) {
+    return query.path() == key.path();
+  }
+  if (query.IsCollectionGroupQuery()) {
+    return key.HasCollectionGroup(*query.collection_group()) &&
+           query.path().IsPrefixOf(key.path());
+  }
+  return query.path().IsImmediateParentOf(key.path());
+}
+
+int32_t* MakeTargetIds(TargetId target_id) {
+  int32_t* target_ids = MakeArray<int32_t>(1);
+  target_ids[0] = target_id;
+  return target_ids;
+}
+
+void ReleaseWriteResults(
+    std::vector<Message<google_firestore_v1_WriteResult>>* results,
+    google_firestore_v1_WriteResult** write_results,
+    pb_size_t* write_results_count) {
+  *write_results_count = CheckedSize(results->size());
+  *write_results =
+      MakeArray<google_firestore_v1_WriteResult>(*write_results_count);
+  for (pb_size_t i = 0; i < *write_results_count; ++i) {
+    (*write_results)[i] = *(*results)[i].release();
+  }
+}
+
+/**
+ * Computes the values the backend reports for the field transforms of
+ * `mutation` when applied to `document` at `version`.
+ */
+Message<google_firestore_v1_ArrayValue> ComputeTransformResults(
+    const Mutation& mutation,
+    const MutableDocument& document,
+    const SnapshotVersion& version) {
+  const std::vector<model::FieldTransform>& transforms =
+      mutation.field_transforms();
+
+  Message<google_firestore_v1_ArrayValue> results;
+  results->values_count = CheckedSize(transforms.size());
+  results->values = MakeArray<google_firestore_v1_Value>(results->values_count);
+  if (transforms.empty()) {
+    return results;
+  }
+
+  // Transforms apply on top of the rest of the write, which the local view
+  // already accounts for.
+  MutableDocument local_view = document.Clone();
+  mutation.ApplyToLocalView(local_view, absl::nullopt, version.timestamp());
+
+  for (size_t i = 0; i < transforms.size(); ++i) {
+    google_firestore_v1_Value& result = results->values[i];
+    if (transforms[i].transformation().type() ==
+        TransformOperation::Type::ServerTimestamp) {
+      result.which_value_type = google_firestore_v1_Value_timestamp_value_tag;
+      result.timestamp_value = Serializer::EncodeVersion(version);
+    } else {
+      absl::optional<google_firestore_v1_Value> value =
+          local_view.field(transforms[i].path());
+      result = value ? *DeepClone(*value).release() : model::NullValue();
+    }
+  }
+  return results;
+}
+
+google_firestore_v1_Value Aggregate(
+    ReadContext* context,
+    const google_firestore_v1_StructuredAggregationQuery_Aggregation&
+        aggregation,
+    const std::vector<Document>& documents) {
+  google_firestore_v1_Value result{};
+  if (aggregation.which_operator ==
+      google_firestore_v1_StructuredAggregationQuery_Aggregation_count_tag) {
+    result.which_value_type = google_firestore_v1_Value_integer_value_tag;
+    result.integer_value = static_cast<int64_t>(documents.size());
+    return result;
+  }
+
+  bool is_sum =
+      aggregation.which_operator ==
+      google_firestore_v1_StructuredAggregationQuery_Aggregation_sum_tag;
+  FieldPath path = Serializer::DecodeFieldPath(
+      context, is_sum ? aggregation.sum.field.field_path
+                      : aggregation.avg.field.field_path);
+
+  int64_t integer_sum = 0;
+  double double_sum = 0;
+  int64_t count = 0;
+  bool has_double = false;
+  for (const Document& document : documents) {
+    absl::optional<google_firestore_v1_Value> value = document->field(path);
+    if (IsInteger(value)) {
+      integer_sum += value->integer_value;
+      ++count;
+    } else if (IsDouble(value)) {
+      double_sum += value->double_value;
+      has_double = true;
+      ++count;
+    }
+  }
+
+  if (is_sum && !has_double) {
+    result.which_value_type = google_firestore_v1_Value_integer_value_tag;
+    result.integer_value = integer_sum;
+  } else if (is_sum) {
+    result.which_value_type = google_firestore_v1_Value_double_value_tag;
+    result.double_value = static_cast<double>(integer_sum) + double_sum;
+  } else if (count == 0) {
+    result = model::NullValue();
+  } else {
+    result.which_value_type = google_firestore_v1_Value_double_value_tag;
+    result.double_value =
+        (static_cast<double>(integer_sum) + double_sum) / count;
+  }
+  return result;
+}
+
+}  // namespace
+
+/**
+ * A single RPC. Responses are queued and sent one at a time; `Finish` waits
+ * for the queue to drain. The call keeps itself alive until gRPC is done
+ * with it, after which writes are dropped.
+ */
+class FakeFirestoreBackend::Call : public grpc::ServerGenericBidiReactor {
+ public:
+  Call(FakeFirestoreBackend* backend, std::string method)
+      : backend_{backend}, method_{std::move(method)} {
+  }
+
+  void Start(std::shared_ptr<Call> self) {
+    self_ = std::move(self);
+    StartRead(&read_buffer_);
+  }
+
+  const std::string& method() const {
+    return method_;
+  }
+
+  template <typename T>
+  void Write(const Message<T>& message) {
+    WriteBuffer(MakeByteBuffer(message));
+  }
+
+  void Finish(grpc::Status status) {
+    std::lock_guard<std::recursive_mutex> lock{mutex_};
+    if (finishing_) return;
+
+    finishing_ = true;
+    finish_status_ = std::move(status);
+    if (!writing_) {
+      grpc::ServerGenericBidiReactor::Finish(finish_status_);
+    }
+  }
+
+  // Only accessed on the backend's executor.
+  std::map<TargetId, ListenTarget> targets;
+  bool handshake_complete = false;
+
+ private:
+  bool IsStreaming() const {
+    return method_ == kListenMethod || method_ == kWriteMethod;
+  }
+
+  void WriteBuffer(grpc::ByteBuffer buffer) {
+    std::lock_guard<std::recursive_mutex> lock{mutex_};
+    if (finishing_) return;
+
+    outbox_.push_back(std::move(buffer));
+    if (!writing_) {
+      writing_ = true;
+      StartWrite(&outbox_.front());
+    }
+  }
+
+  void OnReadDone(bool ok) override {
+    if (!ok) {
+      // The client half-closed the stream or the call is over.
+      Finish(grpc::Status::OK);
+      return;
+    }
+
+    backend_->Dispatch(self_, read_buffer_);
+
+    std::lock_guard<std::recursive_mutex> lock{mutex_};
+    if (IsStreaming() && !finishing_) {
+      read_buffer_.Clear();
+      StartRead(&read_buffer_);
+    }
+  }
+
+  void OnWriteDone(bool ok) override {
+    std::lock_guard<std::recursive_mutex> lock{mutex_};
+    outbox_.pop_front();
+    if (ok && !outbox_.empty()) {
+      StartWrite(&outbox_.front());
+      return;
+    }
+
+    outbox_.clear();
+    writing_ = false;
+    if (finishing_) {
+      grpc::ServerGenericBidiReactor::Finish(finish_status_);
+    }
+  }
+
+  void OnCancel() override {
+    Finish(grpc::Status::CANCELLED);
+  }
+
+  void OnDone() override {
+    backend_->RemoveCall(std::move(self_));
+  }
+
+  FakeFirestoreBackend* backend_ = nullptr;
+  std::string method_;
+  std::shared_ptr<Call> self_;
+  grpc::ByteBuffer read_buffer_;
+
+  std::recursive_mutex mutex_;
+  std::deque<grpc::ByteBuffer> outbox_;
+  bool writing_ = false;
+  bool finishing_ = false;
+  grpc::Status finish_status_;
+};
+
+class FakeFirestoreBackend::Service : public grpc::CallbackGenericService {
+ public:
+  explicit Service(FakeFirestoreBackend* backend) : backend_{backend} {
+  }
+
+  grpc::ServerGenericBidiReactor* CreateReactor(
+      grpc::GenericCallbackServerContext* context) override {
+    auto call = std::make_shared<Call>(backend_, context->method());
+    call->Start(call);
+    return call.get();
+  }
+
+ private:
+  FakeFirestoreBackend* backend_ = nullptr;
+};
+
+FakeFirestoreBackend::FakeFirestoreBackend(model::DatabaseId database_id)
+    : serializer_{std::move(database_id)},
+      executor_{util::Executor::CreateSerial(
+          "com.google.firebase.firestore.fake_backend")},
+      service_{absl::make_unique<Service>(this)},
+      last_version_micros_{kInitialVersionMicros} {
+  int port = 0;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials(),
+                           &port);
+  builder.RegisterCallbackGenericService(service_.get());
+  server_ = builder.BuildAndStart();
+  HARD_ASSERT(server_ && port != 0, "Failed to start the fake backend");
+
+  host_ = absl::StrCat("localhost:", port);
+}
+
+FakeFirestoreBackend::~FakeFirestoreBackend() {
+  CloseStreams();
+  server_->Shutdown();
+  executor_->Dispose();
+}
+
+SnapshotVersion FakeFirestoreBackend::SetDocuments(
+    std::vector<MutableDocument> documents) {
+  SnapshotVersion version = SnapshotVersion::None();
+  executor_->ExecuteBlocking([&] {
+    version = NextVersion();
+    std::map<DocumentKey, MutableDocument> changed;
+    for (const MutableDocument& document : documents) {
+      changed[document.key()] =
+          document.is_found_document()
+              ? MutableDocument::FoundDocument(document.key(), version,
+                                               document.data())
+              : MutableDocument::NoDocument(document.key(), version);
+    }
+    CommitDocuments(changed);
+  });
+  return version;
+}
+
+void FakeFirestoreBackend::SetLatency(util::Executor::Milliseconds latency) {
+  latency_ms_ = latency.count();
+}
+
+void FakeFirestoreBackend::CloseStreams() {
+  executor_->ExecuteBlocking([&] {
+    for (const std::shared_ptr<Call>& call : calls_) {
+      call->Finish(grpc::Status{grpc::StatusCode::UNAVAILABLE,
+                                "Stream closed by the fake backend"});
+    }
+    calls_.clear();
+  });
+}
+
+void FakeFirestoreBackend::Dispatch(std::shared_ptr<Call> call,
+                                    grpc::ByteBuffer message) {
+  // Removal goes through the same delay, so a call is never handled after it
+  // has been removed.
+  executor_->Schedule(
+      util::Executor::Milliseconds(latency_ms_), util::Executor::kNoTag,
+      [this, call, message] {
+        const std::string& method = call->method();
+        if (method == kListenMethod) {
+          HandleListen(call, message);
+        } else if (method == kWriteMethod) {
+          HandleWrite(call, message);
+        } else if (method == kCommitMethod) {
+          HandleCommit(call, message);
+        } else if (method == kBatchGetDocumentsMethod) {
+          HandleBatchGetDocuments(call, message);
+        } else if (method == kRunAggregationQueryMethod) {
+          HandleRunAggregationQuery(call, message);
+        } else {
+          call->Finish(grpc::Status{grpc::StatusCode::UNIMPLEMENTED, method});
+        }
+      });
+}
+
+void FakeFirestoreBackend::RemoveCall(std::shared_ptr<Call> call) {
+  executor_->Schedule(util::Executor::Milliseconds(latency_ms_),
+                      util::Executor::kNoTag,
+                      [this, call] { calls_.erase(call); });
+}
+
+void FakeFirestoreBackend::HandleListen(const std::shared_ptr<Call>& call,
+                                        const grpc::ByteBuffer& message) {
+  ByteBufferReader reader{message};
+  auto request = Message<google_firestore_v1_ListenRequest>::TryParse(&reader);
+  if (!reader.ok()) {
+    call->Finish(ToGrpcStatus(reader.status()));
+    return;
+  }
+
+  calls_.insert(call);
+  if (request->which_target_change ==
+      google_firestore_v1_ListenRequest_add_target_tag) {
+    AddTarget(call, request->add_target);
+  } else {
+    TargetId target_id = request->remove_target;
+    call->targets.erase(target_id);
+    WriteTargetChange(call.get(),
+                      google_firestore_v1_TargetChange_TargetChangeType_REMOVE,
+                      {target_id});
+  }
+}
+
+void FakeFirestoreBackend::AddTarget(const std::shared_ptr<Call>& call,
+                                     google_firestore_v1_Target& target) {
+  ReadContext context;
+  core::Target decoded =
+      target.which_target_type == google_firestore_v1_Target_documents_tag
+          ? serializer_.DecodeDocumentsTarget(&context,
+                                              target.target_type.documents)
+          : serializer_.DecodeQueryTarget(&context, target.target_type.query);
+
+  int64_t resume_micros = 0;
+  if (target.which_resume_type == google_firestore_v1_Target_resume_token_tag) {
+    if (!absl::SimpleAtoi(nanopb::MakeStringView(
+                              target.resume_type.resume_token),
+                          &resume_micros)) {
+      context.Fail("Invalid resume token");
+    }
+  } else if (target.which_resume_type ==
+             google_firestore_v1_Target_read_time_tag) {
+    resume_micros = ToMicros(
+        Serializer::DecodeVersion(&context, target.resume_type.read_time));
+  }
+  if (!context.ok()) {
+    call->Finish(ToGrpcStatus(context.status()));
+    return;
+  }
+
+  TargetId target_id = target.target_id;
+  ListenTarget& listen = call->targets[target_id];
+  listen.query = ToQuery(decoded);
+  listen.keys.clear();
+
+  WriteTargetChange(call.get(),
+                    google_firestore_v1_TargetChange_TargetChangeType_ADD,
+                    {target_id});
+
+  for (const Document& document : RunQuery(listen.query)) {
+    listen.keys.insert(document->key());
+    if (ToMicros(document->version()) > resume_micros) {
+      WriteDocumentChange(call.get(), document.get(), target_id,
+                          /*removed=*/false);
+    }
+  }
+
+  if (resume_micros > 0) {
+    // Catch the client up on documents that left the result set while it
+    // was away.
+    for (const auto& entry : documents_) {
+      const MutableDocument& document = entry.second;
+      if (ToMicros(document.version()) <= resume_micros ||
+          listen.keys.count(entry.first) > 0 ||
+          !IsInScope(listen.query, entry.first)) {
+        continue;
+      }
+      if (document.is_found_document()) {
+        WriteDocumentChange(call.get(), document, target_id,
+                            /*removed=*/true);
+      } else {
+        WriteDocumentDelete(call.get(), entry.first, target_id);
+      }
+    }
+  }
+
+  WriteTargetChange(call.get(),
+                    google_firestore_v1_TargetChange_TargetChangeType_CURRENT,
+                    {target_id});
+  WriteGlobalSnapshot(call.get());
+}
+
+void FakeFirestoreBackend::HandleWrite(const std::shared_ptr<Call>& call,
+                                       const grpc::ByteBuffer& message) {
+  ByteBufferReader reader{message};
+  auto request = Message<google_firestore_v1_WriteRequest>::TryParse(&reader);
+  if (!reader.ok()) {
+    call->Finish(ToGrpcStatus(reader.status()));
+    return;
+  }
+
+  calls_.insert(call);
+
+  Message<google_firestore_v1_WriteResponse> response;
+  response->stream_token = nanopb::MakeBytesArray(kStreamToken);
+  if (!call->handshake_complete) {
+    call->handshake_complete = true;
+    call->Write(response);
+    return;
+  }
+
+  std::vector<Message<google_firestore_v1_WriteResult>> results;
+  StatusOr<SnapshotVersion> version =
+      ApplyWrites(request->writes, request->writes_count, &results);
+  if (!version.ok()) {
+    call->Finish(ToGrpcStatus(version.status()));
+    return;
+  }
+
+  ReleaseWriteResults(&results, &response->write_results,
+                      &response->write_results_count);
+  response->commit_time = Serializer::EncodeVersion(version.ValueOrDie());
+  call->Write(response);
+}
+
+void FakeFirestoreBackend::HandleCommit(const std::shared_ptr<Call>& call,
+                                        const grpc::ByteBuffer& message) {
+  ByteBufferReader reader{message};
+  auto request = Message<google_firestore_v1_CommitRequest>::TryParse(&reader);
+  if (!reader.ok()) {
+    call->Finish(ToGrpcStatus(reader.status()));
+    return;
+  }
+
+  std::vector<Message<google_firestore_v1_WriteResult>> results;
+  StatusOr<SnapshotVersion> version =
+      ApplyWrites(request->writes, request->writes_count, &results);
+  if (!version.ok()) {
+    call->Finish(ToGrpcStatus(version.status()));
+    return;
+  }
+
+  Message<google_firestore_v1_CommitResponse> response;
+  ReleaseWriteResults(&results, &response->write_results,
+                      &response->write_results_count);
+  response->commit_time = Serializer::EncodeVersion(version.ValueOrDie());
+  call->Write(response);
+  call->Finish(grpc::Status::OK);
+}
+
+void FakeFirestoreBackend::HandleBatchGetDocuments(
+    const std::shared_ptr<Call>& call, const grpc::ByteBuffer& message) {
+  ByteBufferReader reader{message};
+  auto request =
+      Message<google_firestore_v1_BatchGetDocumentsRequest>::TryParse(&reader);
+  if (!reader.ok()) {
+    call->Finish(ToGrpcStatus(reader.status()));
+    return;
+  }
+
+  ReadContext context;
+  for (pb_size_t i = 0; i < request->documents_count; ++i) {
+    DocumentKey key = serializer_.DecodeKey(&context, request->documents[i]);
+    if (!context.ok()) {
+      call->Finish(ToGrpcStatus(context.status()));
+      return;
+    }
+
+    Message<google_firestore_v1_BatchGetDocumentsResponse> response;
+    auto found = documents_.find(key);
+    if (found != documents_.end() && found->second.is_found_document()) {
+      response->which_result =
+          google_firestore_v1_BatchGetDocumentsResponse_found_tag;
+      response->found = EncodeFoundDocument(found->second);
+    } else {
+      response->which_result =
+          google_firestore_v1_BatchGetDocumentsResponse_missing_tag;
+      response->missing = serializer_.EncodeKey(key);
+    }
+    response->read_time = Serializer::EncodeVersion(CurrentVersion());
+    call->Write(response);
+  }
+  call->Finish(grpc::Status::OK);
+}
+
+void FakeFirestoreBackend::HandleRunAggregationQuery(
+    const std::shared_ptr<Call>& call, const grpc::ByteBuffer& message) {
+  ByteBufferReader reader{message};
+  auto request =
+      Message<google_firestore_v1_RunAggregationQueryRequest>::TryParse(
+          &reader);
+  if (!reader.ok()) {
+    call->Finish(ToGrpcStatus(reader.status()));
+    return;
+  }
+
+  ReadContext context;
+  google_firestore_v1_StructuredAggregationQuery& aggregation_query =
+      request->query_type.structured_aggregation_query;
+  core::Target target = serializer_.DecodeStructuredQuery(
+      &context, request->parent, aggregation_query.structured_query);
+  if (!context.ok()) {
+    call->Finish(ToGrpcStatus(context.status()));
+    return;
+  }
+
+  std::vector<Document> documents = RunQuery(ToQuery(target));
+
+  Message<google_firestore_v1_RunAggregationQueryResponse> response;
+  google_firestore_v1_AggregationResult& result = response->result;
+  result.aggregate_fields_count = aggregation_query.aggregations_count;
+  result.aggregate_fields =
+      MakeArray<google_firestore_v1_AggregationResult_AggregateFieldsEntry>(
+          result.aggregate_fields_count);
+  for (pb_size_t i = 0; i < aggregation_query.aggregations_count; ++i) {
+    const auto& aggregation = aggregation_query.aggregations[i];
+    result.aggregate_fields[i].key = nanopb::CopyBytesArray(aggregation.alias);
+    result.aggregate_fields[i].value =
+        Aggregate(&context, aggregation, documents);
+  }
+  if (!context.ok()) {
+    call->Finish(ToGrpcStatus(context.status()));
+    return;
+  }
+
+  response->read_time = Serializer::EncodeVersion(CurrentVersion());
+  call->Write(response);
+  call->Finish(grpc::Status::OK);
+}
+
+StatusOr<SnapshotVersion> FakeFirestoreBackend::ApplyWrites(
+    google_firestore_v1_Write* writes,
+    pb_size_t writes_count,
+    std::vector<Message<google_firestore_v1_WriteResult>>* results) {
+  ReadContext context;
+  std::vector<Mutation> mutations;
+  for (pb_size_t i = 0; i < writes_count; ++i) {
+    mutations.push_back(serializer_.DecodeMutation(&context, writes[i]));
+  }
+  if (!context.ok()) {
+    return context.status();
+  }
+
+  SnapshotVersion version = NextVersion();
+  std::map<DocumentKey, MutableDocument> changed;
+  for (const Mutation& mutation : mutations) {
+    const DocumentKey& key = mutation.key();
+
+    // Work on copies so that a failed precondition leaves the store as is.
+    MutableDocument document = MutableDocument::InvalidDocument(key);
+    auto pending = changed.find(key);
+    auto stored = documents_.find(key);
+    if (pending != changed.end()) {
+      document = pending->second.Clone();
+    } else if (stored != documents_.end()) {
+      document = stored->second.Clone();
+    }
+
+    if (!mutation.precondition().IsValidFor(document)) {
+      return Status{Error::kErrorFailedPrecondition,
+                    util::StringFormat("Precondition failed for document %s",
+                                       key.ToString())};
+    }
+
+    Message<google_firestore_v1_WriteResult> result;
+    result->has_update_time = true;
+    result->update_time = Serializer::EncodeVersion(version);
+
+    if (mutation.type() != Mutation::Type::Verify) {
+      Message<google_firestore_v1_ArrayValue> transform_results =
+          ComputeTransformResults(mutation, document, version);
+      result->transform_results_count = transform_results->values_count;
+      result->transform_results =
+          MakeArray<google_firestore_v1_Value>(transform_results->values_count);
+      for (pb_size_t i = 0; i < transform_results->values_count; ++i) {
+        result->transform_results[i] =
+            *DeepClone(transform_results->values[i]).release();
+      }
+
+      mutation.ApplyToRemoteDocument(
+          document, MutationResult(version, std::move(transform_results)));
+      changed[key] = document.is_found_document()
+                         ? MutableDocument::FoundDocument(key, version,
+                                                          document.data())
+                         : MutableDocument::NoDocument(key, version);
+    }
+
+    results->push_back(std::move(result));
+  }
+
+  CommitDocuments(changed);
+  committed_write_count_ += writes_count;
+  return version;
+}
+
+void FakeFirestoreBackend::CommitDocuments(
+    const std::map<DocumentKey, MutableDocument>& documents) {
+  for (const auto& entry : documents) {
+    documents_[entry.first] = entry.second;
+  }
+
+  for (const std::shared_ptr<Call>& call : calls_) {
+    if (call->targets.empty()) continue;
+
+    for (auto& target_entry : call->targets) {
+      TargetId target_id = target_entry.first;
+      ListenTarget& target = target_entry.second;
+      for (const auto& entry : documents) {
+        const MutableDocument& document = entry.second;
+        if (document.is_found_document() && target.query.Matches(document)) {
+          target.keys.insert(entry.first);
+          WriteDocumentChange(call.get(), document, target_id,
+                              /*removed=*/false);
+        } else if (target.keys.erase(entry.first) > 0) {
+          if (document.is_found_document()) {
+            WriteDocumentChange(call.get(), document, target_id,
+                                /*removed=*/true);
+          } else {
+            WriteDocumentDelete(call.get(), entry.first, target_id);
+          }
+        }
+      }
+    }
+    WriteGlobalSnapshot(call.get());
+  }
+}
+
+std::vector<Document> FakeFirestoreBackend::RunQuery(
+    const core::Query& query) const {
+  std::vector<Document> result;
+  for (const auto& entry : documents_) {
+    if (entry.second.is_found_document() && query.Matches(entry.second)) {
+      result.emplace_back(entry.second);
+    }
+  }
+
+  model::DocumentComparator comparator = query.Comparator();
+  std::sort(result.begin(), result.end(),
+            [&](const Document& lhs, const Document& rhs) {
+              return comparator.Compare(lhs, rhs) ==
+                     util::ComparisonResult::Ascending;
+            });
+  if (query.has_limit() && result.size() > static_cast<size_t>(query.limit())) {
+    result.resize(query.limit());
+  }
+  return result;
+}
+
+SnapshotVersion FakeFirestoreBackend::CurrentVersion() const {
+  return FromMicros(last_version_micros_);
+}
+
+SnapshotVersion FakeFirestoreBackend::NextVersion() {
+  ++last_version_micros_;
+  return CurrentVersion();
+}
+
+google_firestore_v1_Document FakeFirestoreBackend::EncodeFoundDocument(
+    const MutableDocument& document) const {
+  google_firestore_v1_Document result =
+      serializer_.EncodeDocument(document.key(), document.data());
+  result.has_update_time = true;
+  result.update_time = Serializer::EncodeVersion(document.version());
+  return result;
+}
+
+void FakeFirestoreBackend::WriteTargetChange(
+    Call* call,
+    google_firestore_v1_TargetChange_TargetChangeType type,
+    const std::vector<TargetId>& target_ids) {
+  Message<google_firestore_v1_ListenResponse> response;
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_target_change_tag;
+  google_firestore_v1_TargetChange& change = response->target_change;
+  change.target_change_type = type;
+  change.target_ids_count = CheckedSize(target_ids.size());
+  change.target_ids = MakeArray<int32_t>(change.target_ids_count);
+  std::copy(target_ids.begin(), target_ids.end(), change.target_ids);
+  call->Write(response);
+}
+
+void FakeFirestoreBackend::WriteGlobalSnapshot(Call* call) {
+  // A change without target IDs applies its resume token to every target and
+  // marks a consistent snapshot at its read time.
+  Message<google_firestore_v1_ListenResponse> response;
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_target_change_tag;
+  google_firestore_v1_TargetChange& change = response->target_change;
+  change.target_change_type =
+      google_firestore_v1_TargetChange_TargetChangeType_NO_CHANGE;
+  change.resume_token =
+      nanopb::MakeBytesArray(std::to_string(last_version_micros_));
+  change.read_time = Serializer::EncodeVersion(CurrentVersion());
+  call->Write(response);
+}
+
+void FakeFirestoreBackend::WriteDocumentChange(Call* call,
+                                               const MutableDocument& document,
+                                               TargetId target_id,
+                                               bool removed) {
+  Message<google_firestore_v1_ListenResponse> response;
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_document_change_tag;
+  google_firestore_v1_DocumentChange& change = response->document_change;
+  change.document = EncodeFoundDocument(document);
+  if (removed) {
+    change.removed_target_ids_count = 1;
+    change.removed_target_ids = MakeTargetIds(target_id);
+  } else {
+    change.target_ids_count = 1;
+    change.target_ids = MakeTargetIds(target_id);
+  }
+  call->Write(response);
+}
+
+void FakeFirestoreBackend::WriteDocumentDelete(Call* call,
+                                               const DocumentKey& key,
+                                               TargetId target_id) {
+  Message<google_firestore_v1_ListenResponse> response;
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_document_delete_tag;
+  google_firestore_v1_DocumentDelete& change = response->document_delete;
+  change.document = serializer_.EncodeKey(key);
+  change.has_read_time = true;
+  change.read_time = Serializer::EncodeVersion(CurrentVersion());
+  change.removed_target_ids_count = 1;
+  change.removed_target_ids = MakeTargetIds(target_id);
+  call->Write(response);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
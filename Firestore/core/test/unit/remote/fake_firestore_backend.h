@@ -0,0 +1,180 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_FIRESTORE_BACKEND_H_
+#define FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_FIRESTORE_BACKEND_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/status_fwd.h"
+
+namespace grpc {
+class ByteBuffer;
+class Server;
+}  // namespace grpc
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * An in-process stand-in for the Firestore backend that serves the `Listen`,
+ * `Write`, `Commit`, `BatchGetDocuments` and `RunAggregationQuery` RPCs over
+ * an insecure local port. Point a client at `host()` with SSL disabled to
+ * exercise the full sync path without a network.
+ *
+ * The backend keeps a single versioned copy of every document it has seen.
+ * Queries are evaluated with the client's own `core::Query` logic, resume
+ * tokens encode the commit version they were issued at, and every commit is
+ * pushed to the active listens followed by a global snapshot. It does not
+ * send existence filters and does not re-apply limits to incremental updates.
+ *
+ * All RPC handling happens on a single serial executor; `SetLatency` delays
+ * the handling of every incoming message by the given amount.
+ */
+class FakeFirestoreBackend {
+ public:
+  explicit FakeFirestoreBackend(model::DatabaseId database_id);
+  ~FakeFirestoreBackend();
+
+  FakeFirestoreBackend(const FakeFirestoreBackend&) = delete;
+  FakeFirestoreBackend& operator=(const FakeFirestoreBackend&) = delete;
+
+  /** The "host:port" address the backend is listening on. */
+  const std::string& host() const {
+    return host_;
+  }
+
+  /**
+   * Stores the given documents in a single commit and notifies the active
+   * listens. Found documents replace the stored data; no-documents delete.
+   * The versions of the given documents are ignored in favor of the commit
+   * version, which is returned.
+   */
+  model::SnapshotVersion SetDocuments(
+      std::vector<model::MutableDocument> documents);
+
+  /** Delays the handling of every subsequent incoming message. */
+  void SetLatency(util::Executor::Milliseconds latency);
+
+  /**
+   * Finishes all open `Listen` and `Write` streams with UNAVAILABLE, as a
+   * dropped connection would.
+   */
+  void CloseStreams();
+
+  /** The number of writes applied through `Write` and `Commit` so far. */
+  int64_t committed_write_count() const {
+    return committed_write_count_;
+  }
+
+ private:
+  class Call;
+  class Service;
+
+  struct ListenTarget {
+    core::Query query;
+    std::set<model::DocumentKey> keys;
+  };
+
+  void Dispatch(std::shared_ptr<Call> call, grpc::ByteBuffer message);
+  void RemoveCall(std::shared_ptr<Call> call);
+
+  void HandleListen(const std::shared_ptr<Call>& call,
+                    const grpc::ByteBuffer& message);
+  void AddTarget(const std::shared_ptr<Call>& call,
+                 google_firestore_v1_Target& target);
+  void HandleWrite(const std::shared_ptr<Call>& call,
+                   const grpc::ByteBuffer& message);
+  void HandleCommit(const std::shared_ptr<Call>& call,
+                    const grpc::ByteBuffer& message);
+  void HandleBatchGetDocuments(const std::shared_ptr<Call>& call,
+                               const grpc::ByteBuffer& message);
+  void HandleRunAggregationQuery(const std::shared_ptr<Call>& call,
+                                 const grpc::ByteBuffer& message);
+
+  /**
+   * Applies the given writes atomically at a new commit version, filling in
+   * one `WriteResult` per write. Fails without applying anything if any
+   * precondition does not hold.
+   */
+  util::StatusOr<model::SnapshotVersion> ApplyWrites(
+      google_firestore_v1_Write* writes,
+      pb_size_t writes_count,
+      std::vector<nanopb::Message<google_firestore_v1_WriteResult>>* results);
+
+  /** Stores the given documents and pushes them to the active listens. */
+  void CommitDocuments(
+      const std::map<model::DocumentKey, model::MutableDocument>& documents);
+
+  /** Returns the stored documents that match `query`, sorted and limited. */
+  std::vector<model::Document> RunQuery(const core::Query& query) const;
+
+  model::SnapshotVersion CurrentVersion() const;
+  model::SnapshotVersion NextVersion();
+
+  google_firestore_v1_Document EncodeFoundDocument(
+      const model::MutableDocument& document) const;
+
+  void WriteTargetChange(Call* call,
+                         google_firestore_v1_TargetChange_TargetChangeType type,
+                         const std::vector<model::TargetId>& target_ids);
+  void WriteGlobalSnapshot(Call* call);
+  void WriteDocumentChange(Call* call,
+                           const model::MutableDocument& document,
+                           model::TargetId target_id,
+                           bool removed);
+  void WriteDocumentDelete(Call* call,
+                           const model::DocumentKey& key,
+                           model::TargetId target_id);
+
+  Serializer serializer_;
+
+  std::unique_ptr<util::Executor> executor_;
+  std::unique_ptr<Service> service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::string host_;
+
+  std::atomic<int64_t> latency_ms_{0};
+  std::atomic<int64_t> committed_write_count_{0};
+
+  // Only accessed on `executor_`.
+  int64_t last_version_micros_ = 0;
+  std::map<model::DocumentKey, model::MutableDocument> documents_;
+  std::set<std::shared_ptr<Call>> calls_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_FIRESTORE_BACKEND_H_
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+
+#include <pb_encode.h>
+
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using nanopb::Message;
+using testutil::Array;
+using testutil::Map;
+
+Message<google_firestore_v1_Value> TestValue() {
+  return Map("name", "projects/p/databases/d/documents/coll/doc", "values",
+             Array(1, 2.5, "three", true), "nested", Map("a", "b"));
+}
+
+std::string ToString(const grpc::ByteBuffer& buffer) {
+  std::vector<grpc::Slice> slices;
+  EXPECT_TRUE(buffer.Dump(&slices).ok());
+  std::string result;
+  for (const grpc::Slice& slice : slices) {
+    result.append(reinterpret_cast<const char*>(slice.begin()), slice.size());
+  }
+  return result;
+}
+
+/** Builds a buffer holding `bytes` split into slices at the given offsets. */
+grpc::ByteBuffer SplitIntoSlices(const std::string& bytes,
+                                 const std::vector<size_t>& offsets) {
+  std::vector<grpc::Slice> slices;
+  size_t begin = 0;
+  for (size_t end : offsets) {
+    slices.emplace_back(bytes.data() + begin, end - begin);
+    begin = end;
+  }
+  slices.emplace_back(bytes.data() + begin, bytes.size() - begin);
+  return grpc::ByteBuffer{slices.data(), slices.size()};
+}
+
+}  // namespace
+
+TEST(GrpcNanopbTest, EncodesIntoSingleSlice) {
+  Message<google_firestore_v1_Value> value = TestValue();
+  grpc::ByteBuffer buffer = MakeByteBuffer(value);
+
+  std::vector<grpc::Slice> slices;
+  ASSERT_TRUE(buffer.Dump(&slices).ok());
+  EXPECT_EQ(slices.size(), 1u);
+
+  size_t size = 0;
+  ASSERT_TRUE(pb_get_encoded_size(&size, value.fields(), value.get()));
+  EXPECT_EQ(buffer.Length(), size);
+}
+
+TEST(GrpcNanopbTest, DecodesSingleSlice) {
+  Message<google_firestore_v1_Value> value = TestValue();
+  ByteBufferReader reader{MakeByteBuffer(value)};
+  auto decoded = Message<google_firestore_v1_Value>::TryParse(&reader);
+
+  ASSERT_TRUE(reader.ok()) << reader.status().ToString();
+  EXPECT_EQ(*decoded, *value);
+}
+
+TEST(GrpcNanopbTest, DecodesAcrossSlices) {
+  Message<google_firestore_v1_Value> value = TestValue();
+  std::string bytes = ToString(MakeByteBuffer(value));
+
+  // Every split point, including ones inside tags, lengths and strings.
+  for (size_t split = 0; split <= bytes.size(); ++split) {
+    SCOPED_TRACE(split);
+    ByteBufferReader reader{SplitIntoSlices(bytes, {split})};
+    auto decoded = Message<google_firestore_v1_Value>::TryParse(&reader);
+
+    ASSERT_TRUE(reader.ok()) << reader.status().ToString();
+    EXPECT_EQ(*decoded, *value);
+  }
+
+  // One byte per slice.
+  std::vector<size_t> offsets;
+  for (size_t i = 1; i < bytes.size(); ++i) {
+    offsets.push_back(i);
+  }
+  ByteBufferReader reader{SplitIntoSlices(bytes, offsets)};
+  auto decoded = Message<google_firestore_v1_Value>::TryParse(&reader);
+
+  ASSERT_TRUE(reader.ok()) << reader.status().ToString();
+  EXPECT_EQ(*decoded, *value);
+}
+
+TEST(GrpcNanopbTest, FailsOnTruncatedSlices) {
+  std::string bytes = ToString(MakeByteBuffer(TestValue()));
+  bytes.pop_back();
+
+  ByteBufferReader reader{SplitIntoSlices(bytes, {bytes.size() / 2})};
+  Message<google_firestore_v1_Value>::TryParse(&reader);
+  EXPECT_FALSE(reader.ok());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -20,6 +20,7 @@
 #include <initializer_list>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -48,6 +49,10 @@ using Type = GrpcCompletion::Type;
 
 namespace {
 
+struct DecodedString : public DecodedMessage {
+  std::string value;
+};
+
 class Observer : public GrpcStreamObserver {
  public:
   void OnStreamStart() override {
@@ -61,6 +66,11 @@ class Observer : public GrpcStreamObserver {
       observed_states.push_back(StringFormat("OnStreamRead(%s)", str));
     }
   }
+  void OnStreamReadDecoded(std::unique_ptr<DecodedMessage> message) override {
+    observed_states.push_back(
+        StringFormat("OnStreamReadDecoded(%s)",
+                     static_cast<DecodedString&>(*message).value));
+  }
   void OnStreamFinish(const util::Status& status) override {
     observed_states.push_back(StringFormat(
         "OnStreamFinish(%s)", GetFirestoreErrorName(status.code())));
@@ -202,6 +212,49 @@ TEST_F(GrpcStreamTest, ReadIsAutomaticallyReadded) {
                                        "OnStreamRead(bar)"}));
 }
 
+TEST_F(GrpcStreamTest, MessageDecoderRunsOffWorkerQueue) {
+  std::thread::id worker_thread;
+  std::vector<std::thread::id> decoder_threads;
+  stream->SetMessageDecoder([&](const grpc::ByteBuffer& message) {
+    decoder_threads.push_back(std::this_thread::get_id());
+    auto decoded = absl::make_unique<DecodedString>();
+    decoded->value = ByteBufferToString(message);
+    return std::unique_ptr<DecodedMessage>(std::move(decoded));
+  });
+
+  worker_queue->EnqueueBlocking([&] {
+    worker_thread = std::this_thread::get_id();
+    stream->Start();
+  });
+
+  ForceFinish({{Type::Read, MakeByteBuffer("foo")}});
+  ForceFinish({{Type::Read, MakeByteBuffer("bar")}});
+  EXPECT_EQ(observed_states(),
+            States({"OnStreamStart", "OnStreamReadDecoded(foo)",
+                    "OnStreamReadDecoded(bar)"}));
+
+  ASSERT_EQ(decoder_threads.size(), 2u);
+  for (const std::thread::id& decoder_thread : decoder_threads) {
+    EXPECT_NE(decoder_thread, worker_thread);
+  }
+}
+
+TEST_F(GrpcStreamTest, FailedReadIsNotDecoded) {
+  int decoded_count = 0;
+  stream->SetMessageDecoder([&](const grpc::ByteBuffer&) {
+    ++decoded_count;
+    return absl::make_unique<DecodedString>();
+  });
+
+  worker_queue->EnqueueBlocking([&] { stream->Start(); });
+  ForceFinish({{Type::Read, CompletionResult::Error},
+               {Type::Finish, grpc::Status{grpc::RESOURCE_EXHAUSTED, ""}}});
+
+  EXPECT_EQ(decoded_count, 0);
+  EXPECT_EQ(observed_states(),
+            States({"OnStreamStart", "OnStreamFinish(ResourceExhausted)"}));
+}
+
 TEST_F(GrpcStreamTest, CanAddSeveralWrites) {
   worker_queue->EnqueueBlocking([&] { stream->Start(); });
 
@@ -0,0 +1,344 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/remote_store.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/local_write_result.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/mutation_batch_result.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/remote/write_stream.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+using core::DatabaseInfo;
+using credentials::EmptyAppCheckCredentialsProvider;
+using credentials::EmptyAuthCredentialsProvider;
+using credentials::User;
+using local::LocalStore;
+using local::MemoryPersistence;
+using local::QueryEngine;
+using model::BatchId;
+using model::DatabaseId;
+using model::DocumentKeySet;
+using model::Mutation;
+using model::MutationBatchResult;
+using model::MutationResult;
+using model::OnlineState;
+using model::TargetId;
+using testing::ElementsAre;
+using testutil::Map;
+using testutil::SetMutation;
+using testutil::Version;
+using util::AsyncQueue;
+using util::Status;
+
+/**
+ * A write stream that records the requests it is asked to send instead of
+ * sending them. Unlike the spec tests' mock, it lets the `RemoteStore`
+ * coalesce batches.
+ */
+class FakeWriteStream : public WriteStream {
+ public:
+  FakeWriteStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                  GrpcConnection* grpc_connection,
+                  WriteStreamCallback* callback)
+      : WriteStream{worker_queue,
+                    std::make_shared<EmptyAuthCredentialsProvider>(),
+                    std::make_shared<EmptyAppCheckCredentialsProvider>(),
+                    Serializer{DatabaseId{"p", "d"}},
+                    grpc_connection,
+                    callback},
+        callback_{callback} {
+  }
+
+  void Start() override {
+    open_ = true;
+    requests_.clear();
+    acked_ = 0;
+    callback_->OnWriteStreamOpen();
+  }
+
+  void Stop() override {
+    WriteStream::Stop();
+
+    requests_.clear();
+    open_ = false;
+    SetHandshakeComplete(false);
+  }
+
+  bool IsStarted() const override {
+    return open_;
+  }
+  bool IsOpen() const override {
+    return open_;
+  }
+
+  void WriteHandshake() override {
+    SetHandshakeComplete();
+    callback_->OnWriteStreamHandshakeComplete();
+  }
+
+  void WriteMutations(const std::vector<Mutation>& mutations) override {
+    requests_.push_back(mutations);
+  }
+
+  /** Acknowledges the oldest unacknowledged request. */
+  void AckWrite(int64_t version) {
+    std::vector<MutationResult> results;
+    for (size_t i = 0; i != requests_[acked_].size(); ++i) {
+      results.push_back(testutil::MutationResult(version));
+    }
+    ++acked_;
+    callback_->OnWriteStreamMutationResult(Version(version),
+                                           std::move(results));
+  }
+
+  /** Closes the stream with an error as though the backend had failed it. */
+  void FailStream(const Status& error) {
+    open_ = false;
+    callback_->OnWriteStreamClose(error);
+  }
+
+  /** The number of mutations in each request sent on the current stream. */
+  std::vector<size_t> RequestSizes() const {
+    std::vector<size_t> sizes;
+    for (const std::vector<Mutation>& request : requests_) {
+      sizes.push_back(request.size());
+    }
+    return sizes;
+  }
+
+ private:
+  bool open_ = false;
+  size_t acked_ = 0;
+  std::vector<std::vector<Mutation>> requests_;
+  WriteStreamCallback* callback_ = nullptr;
+};
+
+class FakeDatastore : public Datastore {
+ public:
+  FakeDatastore(const DatabaseInfo& database_info,
+                const std::shared_ptr<AsyncQueue>& worker_queue,
+                ConnectivityMonitor* connectivity_monitor,
+                FirebaseMetadataProvider* firebase_metadata_provider)
+      : Datastore{database_info,
+                  worker_queue,
+                  std::make_shared<EmptyAuthCredentialsProvider>(),
+                  std::make_shared<EmptyAppCheckCredentialsProvider>(),
+                  connectivity_monitor,
+                  firebase_metadata_provider},
+        worker_queue_{worker_queue} {
+  }
+
+  std::shared_ptr<WriteStream> CreateWriteStream(
+      WriteStreamCallback* callback) override {
+    write_stream_ = std::make_shared<FakeWriteStream>(
+        worker_queue_, grpc_connection(), callback);
+    return write_stream_;
+  }
+
+  FakeWriteStream* write_stream() {
+    return write_stream_.get();
+  }
+
+ private:
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  std::shared_ptr<FakeWriteStream> write_stream_;
+};
+
+/**
+ * Passes write results on to the `LocalStore`, as the `SyncEngine` would, and
+ * records the batches acknowledged and rejected.
+ */
+class FakeSyncEngine : public RemoteStoreCallback {
+ public:
+  explicit FakeSyncEngine(LocalStore* local_store) : local_store_{local_store} {
+  }
+
+  void ApplyRemoteEvent(const RemoteEvent&) override {
+  }
+  void HandleRejectedListen(TargetId, Status) override {
+  }
+
+  void HandleSuccessfulWrite(MutationBatchResult batch_result) override {
+    acked_batches.push_back(batch_result.batch().batch_id());
+    ack_result_counts.push_back(batch_result.mutation_results().size());
+    local_store_->AcknowledgeBatch(batch_result);
+  }
+
+  void HandleRejectedWrite(BatchId batch_id, Status) override {
+    rejected_batches.push_back(batch_id);
+    local_store_->RejectBatch(batch_id);
+  }
+
+  void HandleOnlineStateChange(OnlineState) override {
+  }
+  DocumentKeySet GetRemoteKeys(TargetId) const override {
+    return DocumentKeySet{};
+  }
+
+  std::vector<BatchId> acked_batches;
+  std::vector<size_t> ack_result_counts;
+  std::vector<BatchId> rejected_batches;
+
+ private:
+  LocalStore* local_store_ = nullptr;
+};
+
+}  // namespace
+
+class RemoteStoreTest : public testing::Test {
+ public:
+  RemoteStoreTest()
+      : worker_queue{testutil::AsyncQueueForTesting()},
+        connectivity_monitor{CreateNoOpConnectivityMonitor()},
+        firebase_metadata_provider{CreateFirebaseMetadataProviderNoOp()},
+        persistence{local::MemoryPersistenceWithEagerGcForTesting()},
+        local_store{persistence.get(), &query_engine, User::Unauthenticated()},
+        datastore{std::make_shared<FakeDatastore>(
+            DatabaseInfo{DatabaseId{"p", "d"}, "", "localhost", false},
+            worker_queue,
+            connectivity_monitor.get(),
+            firebase_metadata_provider.get())},
+        remote_store{&local_store, datastore, worker_queue,
+                     connectivity_monitor.get(), [](OnlineState) {}},
+        sync_engine{&local_store} {
+    local_store.Start();
+    remote_store.set_sync_engine(&sync_engine);
+  }
+
+  ~RemoteStoreTest() override {
+    worker_queue->EnqueueBlocking([&] { remote_store.Shutdown(); });
+  }
+
+  BatchId WriteLocally(const std::string& path) {
+    std::vector<Mutation> mutations{SetMutation(path, Map("foo", "bar"))};
+    return local_store.WriteLocally(std::move(mutations)).batch_id();
+  }
+
+  /** Starts the `RemoteStore` once all pending writes are in the queue. */
+  void Start() {
+    worker_queue->EnqueueBlocking([&] { remote_store.Start(); });
+  }
+
+  FakeWriteStream& write_stream() {
+    return *datastore->write_stream();
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider;
+
+  std::unique_ptr<MemoryPersistence> persistence;
+  QueryEngine query_engine;
+  LocalStore local_store;
+
+  std::shared_ptr<FakeDatastore> datastore;
+  RemoteStore remote_store;
+  FakeSyncEngine sync_engine;
+};
+
+TEST_F(RemoteStoreTest, CoalescesBatchesThatWriteDisjointDocuments) {
+  WriteLocally("coll/a");
+  WriteLocally("coll/b");
+  WriteLocally("coll/a");
+  Start();
+
+  // The third batch writes a document the first one does, so it has to go in
+  // a request of its own.
+  worker_queue->EnqueueBlocking([&] {
+    EXPECT_THAT(write_stream().RequestSizes(), ElementsAre(2, 1));
+  });
+}
+
+TEST_F(RemoteStoreTest, SplitsResultsOfCoalescedRequestAcrossBatches) {
+  BatchId first = WriteLocally("coll/a");
+  BatchId second = WriteLocally("coll/b");
+  BatchId third = WriteLocally("coll/a");
+  Start();
+
+  worker_queue->EnqueueBlocking([&] {
+    write_stream().AckWrite(1);
+    EXPECT_THAT(sync_engine.acked_batches, ElementsAre(first, second));
+    EXPECT_THAT(sync_engine.ack_result_counts, ElementsAre(1, 1));
+
+    write_stream().AckWrite(2);
+    EXPECT_THAT(sync_engine.acked_batches, ElementsAre(first, second, third));
+    EXPECT_THAT(sync_engine.rejected_batches, ElementsAre());
+  });
+}
+
+TEST_F(RemoteStoreTest, ResendsRejectedCoalescedRequestOneBatchAtATime) {
+  BatchId first = WriteLocally("coll/a");
+  BatchId second = WriteLocally("coll/b");
+  BatchId third = WriteLocally("coll/c");
+  Start();
+
+  worker_queue->EnqueueBlocking([&] {
+    EXPECT_THAT(write_stream().RequestSizes(), ElementsAre(3));
+
+    // It's unknown which batch the backend objected to, so none is rejected
+    // yet and each is sent again on its own.
+    Status error{Error::kErrorInvalidArgument, "Invalid write"};
+    write_stream().FailStream(error);
+    EXPECT_THAT(sync_engine.rejected_batches, ElementsAre());
+    EXPECT_THAT(write_stream().RequestSizes(), ElementsAre(1, 1, 1));
+
+    // Now only the batch at the front of the pipeline is at fault. The others
+    // are still sent separately after the stream restarts.
+    write_stream().FailStream(error);
+    EXPECT_THAT(sync_engine.rejected_batches, ElementsAre(first));
+    EXPECT_THAT(write_stream().RequestSizes(), ElementsAre(1, 1));
+
+    write_stream().AckWrite(1);
+    write_stream().AckWrite(2);
+    EXPECT_THAT(sync_engine.acked_batches, ElementsAre(second, third));
+  });
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
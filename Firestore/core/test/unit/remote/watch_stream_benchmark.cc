@@ -0,0 +1,164 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/remote/grpc_completion.h"
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+#include "Firestore/core/src/remote/remote_objc_bridge.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/remote/watch_stream.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::google_firestore_v1_DocumentChange;
+using firebase::firestore::google_firestore_v1_ListenResponse;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::nanopb::Message;
+using firebase::firestore::nanopb::SetRepeatedField;
+using firebase::firestore::remote::GrpcCompletion;
+using firebase::firestore::remote::MakeByteBuffer;
+using firebase::firestore::remote::MessageDecoder;
+using firebase::firestore::remote::Serializer;
+using firebase::firestore::remote::WatchStream;
+using firebase::firestore::remote::WatchStreamSerializer;
+using firebase::firestore::testutil::Array;
+using firebase::firestore::testutil::Key;
+using firebase::firestore::testutil::Map;
+using firebase::firestore::testutil::Version;
+using firebase::firestore::testutil::WrapObject;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::Executor;
+
+namespace {
+
+const int32_t kTargetId = 2;
+
+Serializer MakeSerializer() {
+  return Serializer(DatabaseId("p", "default"));
+}
+
+/**
+ * Builds the `ListenResponse` messages of an initial sync: one document change
+ * per document, each with a handful of fields.
+ */
+std::vector<grpc::ByteBuffer> InitialSync(int64_t document_count) {
+  Serializer serializer = MakeSerializer();
+  std::vector<grpc::ByteBuffer> messages;
+  for (int64_t i = 0; i < document_count; ++i) {
+    Message<google_firestore_v1_ListenResponse> response;
+    response->which_response_type =
+        google_firestore_v1_ListenResponse_document_change_tag;
+
+    google_firestore_v1_DocumentChange& change = response->document_change;
+    change.document = serializer.EncodeDocument(
+        Key("coll/doc" + std::to_string(i)),
+        WrapObject("count", i, "title", "Document number " + std::to_string(i),
+                   "score", 0.5, "tags", Array("a", "b"), "nested",
+                   Map("flag", true)));
+    change.document.has_update_time = true;
+    change.document.update_time = Serializer::EncodeVersion(Version(1000));
+    SetRepeatedField(&change.target_ids, &change.target_ids_count,
+                     std::vector<int32_t>{kTargetId});
+
+    messages.push_back(MakeByteBuffer(response));
+  }
+  return messages;
+}
+
+/**
+ * Delivers `messages` through `GrpcCompletion`s the way the gRPC polling
+ * thread does and returns how long the worker queue spent handling them.
+ *
+ * If `decode_off_queue` is true, the decoder is installed on the completions,
+ * so it runs on the calling thread; otherwise it runs in the queued callback,
+ * which is how `WatchStream` handled responses before decoders existed.
+ */
+std::chrono::nanoseconds DeliverMessages(
+    const std::shared_ptr<AsyncQueue>& worker_queue,
+    const MessageDecoder& decoder,
+    const std::vector<grpc::ByteBuffer>& messages,
+    bool decode_off_queue) {
+  std::chrono::nanoseconds queue_time{0};
+
+  for (const grpc::ByteBuffer& message : messages) {
+    auto completion = GrpcCompletion::Create(
+        GrpcCompletion::Type::Read, worker_queue,
+        [&](bool, const std::shared_ptr<GrpcCompletion>& completion) {
+          auto start = std::chrono::steady_clock::now();
+          auto decoded = completion->TakeDecodedMessage();
+          if (!decoded) {
+            decoded = decoder(*completion->message());
+          }
+          benchmark::DoNotOptimize(decoded);
+          decoded.reset();
+          queue_time += std::chrono::steady_clock::now() - start;
+        });
+    *completion->message() = message;
+    if (decode_off_queue) {
+      completion->SetMessageDecoder(decoder);
+    }
+    completion->Complete(true);
+  }
+
+  // Wait for the worker queue to drain.
+  worker_queue->EnqueueBlocking([] {});
+  return queue_time;
+}
+
+void InitialSyncBenchmark(benchmark::State& state, bool decode_off_queue) {
+  auto worker_queue =
+      AsyncQueue::Create(Executor::CreateSerial("watch_stream_benchmark"));
+  MessageDecoder decoder = WatchStream::CreateResponseDecoder(
+      WatchStreamSerializer(MakeSerializer()));
+  std::vector<grpc::ByteBuffer> messages = InitialSync(state.range(0));
+
+  std::chrono::nanoseconds queue_time{0};
+  for (auto _ : state) {
+    queue_time +=
+        DeliverMessages(worker_queue, decoder, messages, decode_off_queue);
+  }
+
+  // The time the worker queue was occupied per initial sync, which is what
+  // delays user callbacks and local writes during a large sync.
+  state.counters["queue_ms"] = benchmark::Counter(
+      std::chrono::duration<double, std::milli>(queue_time).count(),
+      benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(messages.size()));
+}
+
+}  // namespace
+
+static void BM_InitialSyncDecodeOnQueue(benchmark::State& state) {
+  InitialSyncBenchmark(state, /*decode_off_queue=*/false);
+}
+BENCHMARK(BM_InitialSyncDecodeOnQueue)->Arg(1000)->Arg(10000)->Arg(50000);
+
+static void BM_InitialSyncDecodeOffQueue(benchmark::State& state) {
+  InitialSyncBenchmark(state, /*decode_off_queue=*/true);
+}
+BENCHMARK(BM_InitialSyncDecodeOffQueue)->Arg(1000)->Arg(10000)->Arg(50000);
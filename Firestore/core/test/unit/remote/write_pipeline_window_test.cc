@@ -0,0 +1,97 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/write_pipeline_window.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace chr = std::chrono;
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+constexpr size_t kMin = WritePipelineWindow::kMinPendingWrites;
+constexpr size_t kMax = WritePipelineWindow::kMaxPendingWrites;
+
+}  // namespace
+
+TEST(WritePipelineWindowTest, StartsAtMinimum) {
+  WritePipelineWindow window;
+  EXPECT_EQ(window.size(), kMin);
+}
+
+TEST(WritePipelineWindowTest, GrowsWhileLatencyIsSteady) {
+  WritePipelineWindow window;
+  for (int i = 0; i < 5; ++i) {
+    window.RecordLatency(chr::milliseconds(50));
+  }
+  EXPECT_EQ(window.size(), kMin + 5);
+
+  window.RecordLatency(chr::milliseconds(90));
+  EXPECT_EQ(window.size(), kMin + 6);
+}
+
+TEST(WritePipelineWindowTest, StopsGrowingAtMaximum) {
+  WritePipelineWindow window;
+  for (size_t i = 0; i < kMax * 2; ++i) {
+    window.RecordLatency(chr::milliseconds(50));
+  }
+  EXPECT_EQ(window.size(), kMax);
+}
+
+TEST(WritePipelineWindowTest, HoldsWhenLatencyRises) {
+  WritePipelineWindow window;
+  window.RecordLatency(chr::milliseconds(50));
+  window.RecordLatency(chr::milliseconds(150));
+  EXPECT_EQ(window.size(), kMin + 1);
+}
+
+TEST(WritePipelineWindowTest, ShrinksWhenRequestsQueue) {
+  WritePipelineWindow window;
+  for (size_t i = 0; i < kMax; ++i) {
+    window.RecordLatency(chr::milliseconds(50));
+  }
+  ASSERT_EQ(window.size(), kMax);
+
+  window.RecordLatency(chr::milliseconds(500));
+  EXPECT_EQ(window.size(), kMax / 2);
+
+  for (int i = 0; i < 10; ++i) {
+    window.RecordLatency(chr::milliseconds(500));
+  }
+  EXPECT_EQ(window.size(), kMin);
+}
+
+TEST(WritePipelineWindowTest, ResetForgetsLatencyBaseline) {
+  WritePipelineWindow window;
+  window.RecordLatency(chr::milliseconds(10));
+  window.RecordLatency(chr::milliseconds(10));
+  window.Reset();
+  EXPECT_EQ(window.size(), kMin);
+
+  // A slower connection establishes its own baseline.
+  window.RecordLatency(chr::milliseconds(100));
+  EXPECT_EQ(window.size(), kMin + 1);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/mapped_file.h"
+
+#include <fstream>
+#include <string>
+
+#include "Firestore/core/src/util/path.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/test/unit/testutil/filesystem_testing.h"
+#include "Firestore/core/test/unit/testutil/status_testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+using testutil::TestTempDir;
+
+void WriteStringToFile(const Path& path, const std::string& text) {
+  std::ofstream out{path.native_value(), std::ios::out | std::ios::binary};
+  ASSERT_TRUE(out.good());
+  out << text;
+  out.close();
+  ASSERT_TRUE(out.good());
+}
+
+TEST(MappedFileTest, MapsContents) {
+  TestTempDir dir;
+  Path file = dir.RandomChild();
+  std::string contents("binary\0contents", 15);
+  WriteStringToFile(file, contents);
+
+  StatusOr<std::unique_ptr<MappedFile>> mapped = MappedFile::Open(file);
+  ASSERT_OK(mapped.status());
+  EXPECT_EQ(mapped.ValueOrDie()->data(), contents);
+}
+
+TEST(MappedFileTest, MapsEmptyFile) {
+  TestTempDir dir;
+  Path file = dir.RandomChild();
+  WriteStringToFile(file, "");
+
+  StatusOr<std::unique_ptr<MappedFile>> mapped = MappedFile::Open(file);
+  ASSERT_OK(mapped.status());
+  EXPECT_TRUE(mapped.ValueOrDie()->data().empty());
+}
+
+TEST(MappedFileTest, FailsForMissingFile) {
+  TestTempDir dir;
+
+  StatusOr<std::unique_ptr<MappedFile>> mapped =
+      MappedFile::Open(dir.RandomChild());
+  EXPECT_EQ(mapped.status().code(), Error::kErrorNotFound);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
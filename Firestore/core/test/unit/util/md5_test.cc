@@ -15,6 +15,7 @@
  */
 
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/util/md5.h"
 #include "Firestore/core/test/unit/testutil/md5_testing.h"
@@ -23,6 +24,7 @@
 
 using firebase::firestore::testutil::md5::Uint8ArrayFromHexDigest;
 using firebase::firestore::util::CalculateMd5Digest;
+using firebase::firestore::util::CalculateMd5Digests;
 
 namespace {
 
@@ -92,4 +94,45 @@ TEST(CalculateMd5DigestTest, ShouldReturnMd5DigestOfLongStringWithAllChars) {
             Uint8ArrayFromHexDigest("6556112372898c69e1de0bf689d8db26"));
 }
 
+TEST(CalculateMd5DigestsTest, ShouldReturnEmptyForNoStrings) {
+  EXPECT_TRUE(CalculateMd5Digests({}).empty());
+}
+
+TEST(CalculateMd5DigestsTest, ShouldReturnMd5DigestsInOrder) {
+  std::vector<std::array<uint8_t, 16>> digests =
+      CalculateMd5Digests({"abc", "", "hello world!", "a"});
+  ASSERT_EQ(digests.size(), 4u);
+  EXPECT_EQ(digests[0],
+            Uint8ArrayFromHexDigest("900150983cd24fb0d6963f7d28e17f72"));
+  EXPECT_EQ(digests[1],
+            Uint8ArrayFromHexDigest("d41d8cd98f00b204e9800998ecf8427e"));
+  EXPECT_EQ(digests[2],
+            Uint8ArrayFromHexDigest("fc3ff98e8c6a0d3087d515c0473f8677"));
+  EXPECT_EQ(digests[3],
+            Uint8ArrayFromHexDigest("0cc175b9c0f1b6a831c399e269772661"));
+}
+
+TEST(CalculateMd5DigestsTest, ShouldMatchCalculateMd5DigestForMixedLengths) {
+  // Covers the padding boundaries at 55 and 56 bytes, and strings whose
+  // lengths differ by several blocks within one group of lanes.
+  std::vector<std::string> strings;
+  for (int length = 0; length < 300; length += 7) {
+    std::string s;
+    for (int i = 0; i < length; ++i) {
+      s += static_cast<char>(length * 31 + i);
+    }
+    strings.push_back(s);
+  }
+  strings.push_back(std::string(55, 'x'));
+  strings.push_back(std::string(56, 'y'));
+  strings.push_back(std::string(64, 'z'));
+
+  std::vector<std::array<uint8_t, 16>> digests = CalculateMd5Digests(
+      std::vector<absl::string_view>(strings.begin(), strings.end()));
+  ASSERT_EQ(digests.size(), strings.size());
+  for (size_t i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(digests[i], CalculateMd5Digest(strings[i])) << strings[i].size();
+  }
+}
+
 }  // namespace
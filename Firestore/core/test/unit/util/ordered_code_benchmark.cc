@@ -14,8 +14,13 @@
  * limitations under the License.
  */
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/util/ordered_code.h"
 #include "Firestore/core/src/util/secure_random.h"
+#include "absl/strings/string_view.h"
 #include "benchmark/benchmark.h"
 
 using firebase::firestore::util::OrderedCode;
@@ -61,3 +66,105 @@ BENCHMARK(BM_SkipToNextSpecialByte)
     ->Arg(1 << 9)
     ->Arg(1 << 10)
     ->Arg(1 << 15);
+
+namespace {
+
+const int kNumValues = 1024;
+
+// Paths of the shape stored in remote document and index keys, with a mix of
+// collection depths and auto-generated document IDs.
+std::vector<std::string> DocumentPaths() {
+  SecureRandom rnd;
+  std::vector<std::string> paths;
+  for (int i = 0; i < kNumValues; ++i) {
+    std::string path = "projects/project-1/databases/(default)/documents";
+    int depth = 1 + static_cast<int>(rnd.Uniform(3));
+    for (int j = 0; j < depth; ++j) {
+      path += "/coll" + std::to_string(j) + "/";
+      for (int k = 0; k < 20; ++k) {
+        path += static_cast<char>('a' + rnd.Uniform(26));
+      }
+    }
+    paths.push_back(std::move(path));
+  }
+  return paths;
+}
+
+// String index values of roughly `len` bytes. Values are mostly text, but
+// occasionally contain an embedded 0 byte that has to be escaped.
+std::vector<std::string> IndexValues(int64_t len) {
+  SecureRandom rnd;
+  std::vector<std::string> values;
+  for (int i = 0; i < kNumValues; ++i) {
+    std::string value;
+    int64_t size = len - len / 4 + rnd.Uniform(static_cast<uint32_t>(len / 2));
+    for (int64_t j = 0; j < size; ++j) {
+      value += rnd.OneIn(256) ? '\0' : static_cast<char>(' ' + rnd.Uniform(95));
+    }
+    values.push_back(std::move(value));
+  }
+  return values;
+}
+
+std::vector<std::string> Encode(const std::vector<std::string>& values) {
+  std::vector<std::string> encoded;
+  for (const std::string& value : values) {
+    std::string dest;
+    OrderedCode::WriteString(&dest, value);
+    encoded.push_back(std::move(dest));
+  }
+  return encoded;
+}
+
+void WriteStrings(benchmark::State& state,
+                  const std::vector<std::string>& values) {
+  int64_t total_bytes = 0;
+  std::string dest;
+  for (auto _ : state) {
+    for (const std::string& value : values) {
+      dest.clear();
+      OrderedCode::WriteString(&dest, value);
+      total_bytes += static_cast<int64_t>(value.size());
+    }
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+
+void ReadStrings(benchmark::State& state,
+                 const std::vector<std::string>& encoded) {
+  int64_t total_bytes = 0;
+  std::string result;
+  for (auto _ : state) {
+    for (const std::string& value : encoded) {
+      absl::string_view src(value);
+      result.clear();
+      bool ok = OrderedCode::ReadString(&src, &result);
+      benchmark::DoNotOptimize(ok);
+      total_bytes += static_cast<int64_t>(value.size());
+    }
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+
+}  // namespace
+
+static void BM_WriteDocumentPath(benchmark::State& state) {
+  WriteStrings(state, DocumentPaths());
+}
+BENCHMARK(BM_WriteDocumentPath);
+
+static void BM_ReadDocumentPath(benchmark::State& state) {
+  ReadStrings(state, Encode(DocumentPaths()));
+}
+BENCHMARK(BM_ReadDocumentPath);
+
+static void BM_WriteIndexValue(benchmark::State& state) {
+  WriteStrings(state, IndexValues(state.range(0)));
+}
+BENCHMARK(BM_WriteIndexValue)->Arg(1 << 3)->Arg(1 << 6)->Arg(1 << 10);
+
+static void BM_ReadIndexValue(benchmark::State& state) {
+  ReadStrings(state, Encode(IndexValues(state.range(0))));
+}
+BENCHMARK(BM_ReadIndexValue)->Arg(1 << 3)->Arg(1 << 6)->Arg(1 << 10);
@@ -412,6 +412,29 @@ TEST(OrderedCode, ExhaustiveFindSpecial) {
   EXPECT_EQ(count, 256 * 256 * 256 * 2);
 }
 
+TEST(OrderedCode, SkipToNextSpecialByteUnaligned) {
+  // Exercise every alignment of the start pointer against every vector width
+  // the scan may use, with the special byte on either side of each boundary.
+  SecureRandom rnd;
+  std::string buf;
+  for (int i = 0; i < 128; i++) {
+    buf += static_cast<char>(1 + rnd.Uniform(254));  // No special bytes
+  }
+  for (size_t start = 0; start < 32; start++) {
+    const char* p = buf.data() + start;
+    const char* limit = buf.data() + buf.size();
+    EXPECT_EQ(limit, OrderedCode::TEST_SkipToNextSpecialByte(p, limit));
+    for (size_t pos = start; pos < buf.size(); pos++) {
+      std::string y = buf;
+      y[pos] = rnd.OneIn(2) ? 0 : '\xff';
+      p = y.data() + start;
+      limit = y.data() + y.size();
+      EXPECT_EQ(y.data() + pos,
+                OrderedCode::TEST_SkipToNextSpecialByte(p, limit));
+    }
+  }
+}
+
 TEST(OrderedCodeUint64, EncodeDecode) {
   TestNumbers<uint64_t>(1);
 }
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/work_stealing_pool.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/util/background_queue.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+using testutil::Expectation;
+
+}  // namespace
+
+class WorkStealingPoolTest : public testing::Test,
+                             public testutil::AsyncTest {};
+
+TEST_F(WorkStealingPoolTest, Execute) {
+  WorkStealingPool pool(2);
+  Expectation ran;
+  pool.Execute(ran.AsCallback());
+  Await(ran);
+}
+
+TEST_F(WorkStealingPoolTest, RunsOnPoolThreads) {
+  WorkStealingPool pool(2);
+  EXPECT_FALSE(pool.IsCurrentPool());
+
+  Expectation ran;
+  pool.Execute([&] {
+    EXPECT_TRUE(pool.IsCurrentPool());
+    ran.Fulfill();
+  });
+  Await(ran);
+}
+
+TEST_F(WorkStealingPoolTest, DestructorRunsQueuedTasks) {
+  std::atomic<int> count{0};
+  {
+    WorkStealingPool pool(2);
+    for (int i = 0; i < 1000; ++i) {
+      pool.Execute([&] { count += 1; });
+    }
+  }
+  EXPECT_EQ(count, 1000);
+}
+
+TEST_F(WorkStealingPoolTest, IdleWorkersStealTasksSpawnedByAWorker) {
+  WorkStealingPool pool(4);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+
+  // All tasks are spawned by a single worker, so they land on its deque. Any
+  // other thread that runs one must have stolen it.
+  BackgroundQueue tasks(&pool);
+  Expectation spawned;
+  pool.Execute([&] {
+    for (int i = 0; i < 200; ++i) {
+      tasks.Execute([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+      });
+    }
+    spawned.Fulfill();
+  });
+  Await(spawned);
+  tasks.AwaitAll();
+
+  EXPECT_GT(threads.size(), 1u);
+}
+
+TEST_F(WorkStealingPoolTest, BackgroundQueueCanAwaitFromAPoolThread) {
+  // With a single worker, the nested AwaitAll can only finish if the waiting
+  // worker runs the nested tasks itself.
+  WorkStealingPool pool(1);
+  std::atomic<int> count{0};
+  Expectation done;
+  pool.Execute([&] {
+    BackgroundQueue nested(&pool);
+    for (int i = 0; i < 10; ++i) {
+      nested.Execute([&] { count += 1; });
+    }
+    nested.AwaitAll();
+    done.Fulfill();
+  });
+  Await(done);
+  EXPECT_EQ(count, 10);
+}
+
+TEST_F(WorkStealingPoolTest, SharedPoolIsProcessWide) {
+  EXPECT_EQ(&WorkStealingPool::Shared(), &WorkStealingPool::Shared());
+  EXPECT_GE(WorkStealingPool::Shared().thread_count(), 1u);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase